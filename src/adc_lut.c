@@ -0,0 +1,125 @@
+// ADC linearization table implementation
+#include "adc_lut.h"
+#include <stdlib.h>
+
+#define MV_FRAC 16                      // Intermediate voltages in 1/16 mV
+
+static uint16_t to_frac(float mv) {
+    float v = mv * MV_FRAC + 0.5f;
+    if (v < 0.0f) {
+        return 0;
+    }
+    return v > UINT16_MAX ? UINT16_MAX : (uint16_t)v;
+}
+
+// The calibration returns whole millivolts, about 1.4 raw codes per step at
+// 12 dB, so a table taken code by code would be a staircase. Average
+// ADC_LUT_BLOCK codes into one knot at the block's mean position and
+// interpolate linearly between knots (extrapolate past the first and last).
+// Writes 1/16 mV into lut->code.
+static bool fill_mv(adc_lut_t *lut, adc_lut_cali_fn_t cali, void *ctx) {
+    int size = lut->size;
+    float prev_pos = 0.0f;
+    float prev_mv = 0.0f;
+    int next = 0;                       // First entry not written yet
+    for (int first = 0; first < size; first += ADC_LUT_BLOCK) {
+        int n = size - first < ADC_LUT_BLOCK ? size - first : ADC_LUT_BLOCK;
+        int32_t sum = 0;
+        for (int i = 0; i < n; i++) {
+            int mv = 0;
+            if (!cali(ctx, first + i, &mv)) {
+                return false;
+            }
+            sum += mv;
+        }
+        float pos = first + (n - 1) * 0.5f;
+        float mv = (float)sum / n;
+        if (first == 0) {
+            prev_pos = pos;
+            prev_mv = mv;
+            continue;
+        }
+        float slope = (mv - prev_mv) / (pos - prev_pos);
+        int end = first + n >= size ? size : (int)pos + 1;
+        for (; next < end; next++) {
+            lut->code[next] = to_frac(prev_mv + slope * (next - prev_pos));
+        }
+        prev_pos = pos;
+        prev_mv = mv;
+    }
+    return true;
+}
+
+// 1/16 mV -> 0..ADC_MAX_VALUE between the voltages at raw 0 and full scale.
+// Non-decreasing by construction, so the stick never steps backwards.
+static bool normalize(adc_lut_t *lut) {
+    uint32_t lo = lut->code[0];
+    uint32_t hi = lut->code[lut->size - 1];
+    if (hi <= lo) {
+        return false;
+    }
+    uint32_t span = hi - lo;
+    uint16_t floor = 0;
+    for (int r = 0; r < lut->size; r++) {
+        uint32_t v = lut->code[r] > lo ? lut->code[r] - lo : 0;
+        uint32_t out = (v * ADC_MAX_VALUE + span / 2) / span;
+        if (out > ADC_MAX_VALUE) {
+            out = ADC_MAX_VALUE;
+        }
+        if (out < floor) {
+            out = floor;
+        }
+        floor = (uint16_t)out;
+        lut->code[r] = floor;
+    }
+    lut->mv_lo = (uint16_t)((lo + MV_FRAC / 2) / MV_FRAC);
+    lut->mv_hi = (uint16_t)((hi + MV_FRAC / 2) / MV_FRAC);
+    return true;
+}
+
+static int clamp_bits(int bits) {
+    if (bits < ADC_LUT_BITS_MIN) {
+        return ADC_LUT_BITS_MIN;
+    }
+    return bits > ADC_LUT_BITS_MAX ? ADC_LUT_BITS_MAX : bits;
+}
+
+void adc_lut_init_shift(adc_lut_t *lut, int bits) {
+    bits = clamp_bits(bits);
+    free(lut->code);
+    lut->code = NULL;
+    lut->size = (uint16_t)(1 << bits);
+    lut->shift = (int8_t)(bits - 12);
+    lut->calibrated = false;
+    lut->mv_lo = 0;
+    lut->mv_hi = 0;
+}
+
+bool adc_lut_build(adc_lut_t *lut, int bits, adc_lut_cali_fn_t cali, void *ctx) {
+    bits = clamp_bits(bits);
+    int size = 1 << bits;
+    if (lut->code == NULL || lut->size != size) {
+        free(lut->code);
+        lut->code = malloc(size * sizeof(uint16_t));
+        if (lut->code == NULL) {
+            adc_lut_init_shift(lut, bits);
+            return false;
+        }
+    }
+    lut->size = (uint16_t)size;
+    lut->calibrated = cali != NULL && fill_mv(lut, cali, ctx) && normalize(lut);
+    if (!lut->calibrated) {
+        for (int r = 0; r < size; r++) {
+            lut->code[r] = (uint16_t)(((uint32_t)r * ADC_MAX_VALUE + (size - 1) / 2) / (size - 1));
+        }
+        lut->mv_lo = 0;
+        lut->mv_hi = 0;
+    }
+    return true;
+}
+
+void adc_lut_free(adc_lut_t *lut) {
+    free(lut->code);
+    lut->code = NULL;
+    lut->size = 0;
+}
@@ -0,0 +1,61 @@
+// ADC linearization table (raw code -> linear stick position)
+// At 12 dB attenuation the ADC transfer curve bends near both ends of the
+// range, so equal stick travel gives unequal code steps there. The chip's
+// factory calibration (eFuse curve or line fitting, see sender.c) is evaluated
+// once per raw code into a table rescaled to 0..ADC_MAX_VALUE, so conditioning,
+// expo and endpoints all see a value proportional to the stick voltage and the
+// sampler pays one table read per sample.
+// Without memory for the table (8-16 KB) the raw code is only shifted to 12 bits.
+// Has no ESP-IDF dependencies; test/test_adc_lut builds tables from a modelled curve.
+#ifndef ADC_LUT_H
+#define ADC_LUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef ADC_MAX_VALUE
+#define ADC_MAX_VALUE 4095
+#endif
+
+#define ADC_LUT_BITS_MIN 9
+#define ADC_LUT_BITS_MAX 13             // ESP32-S2 reads 13-bit codes
+#define ADC_LUT_BLOCK 16                // Raw codes averaged per knot (hides the 1 mV step of the calibration)
+
+// Calibration source: raw code -> millivolts, false if it cannot convert
+typedef bool (*adc_lut_cali_fn_t)(void *ctx, int raw, int *mv);
+
+typedef struct {
+    uint16_t *code;                     // size entries, 0..ADC_MAX_VALUE, non-decreasing; NULL: no table
+    uint16_t size;                      // 1 << bits
+    int8_t shift;                       // Without a table: raw >> shift (<< -shift below 12 bits)
+    bool calibrated;                    // false: plain rescale of the raw code
+    uint16_t mv_lo;                     // Voltage at raw 0 / full scale (calibrated only)
+    uint16_t mv_hi;
+} adc_lut_t;
+
+// Build the table for bits-wide raw codes from cali (NULL: no calibration, the
+// table only rescales to 0..ADC_MAX_VALUE). A calibration that fails or is not
+// increasing falls back to the rescale. lut must be zeroed or built before.
+// Returns false if out of memory; lut is then set up by adc_lut_init_shift()
+// and adc_lut_apply() still works, uncorrected.
+bool adc_lut_build(adc_lut_t *lut, int bits, adc_lut_cali_fn_t cali, void *ctx);
+
+// Table-free setup: bits-wide raw codes are shifted to 12 bits (frees a table)
+void adc_lut_init_shift(adc_lut_t *lut, int bits);
+
+void adc_lut_free(adc_lut_t *lut);
+
+static inline uint16_t adc_lut_apply(const adc_lut_t *lut, int raw) {
+    if (raw < 0) {
+        raw = 0;
+    } else if (raw >= lut->size) {
+        raw = lut->size - 1;
+    }
+    if (lut->code == NULL) {
+        return (uint16_t)(lut->shift >= 0 ? raw >> lut->shift : raw << -lut->shift);
+    }
+    return lut->code[raw];
+}
+
+#endif // ADC_LUT_H
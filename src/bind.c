@@ -0,0 +1,240 @@
+// Bind / discovery implementation
+#include "bind.h"
+#include "link_auth.h"
+#include "frame_rate.h"
+#include "output_stage.h"
+#include "settings.h"
+#include "task_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_now.h"
+#include "esp_random.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "bind";
+
+#define BIND_MAGIC "RCBD"
+#define BIND_QUEUE_LEN 4
+
+_Static_assert(sizeof(bind_msg_t) == 21, "bind_msg_t is a wire format");
+
+typedef struct {
+    uint8_t mac[PEER_MAC_LEN];
+    bind_msg_t msg;
+} bind_rx_t;
+
+static const uint8_t broadcast_mac[PEER_MAC_LEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static QueueHandle_t rx_queue = NULL;
+static TaskHandle_t bind_task_handle = NULL;
+static volatile bind_state_t state = BIND_IDLE;
+static volatile bool cancel_requested = false;
+static bool as_sender = false;
+static bind_msg_t local;            // What this device advertises
+static bind_rx_t found;             // Peer that completed the handshake
+
+bool bind_is_bind_frame(const uint8_t *data, int len) {
+    return len == sizeof(bind_msg_t) && memcmp(data, BIND_MAGIC, 4) == 0;
+}
+
+static void bind_recv_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
+    if (!info || !bind_is_bind_frame(data, len)) {
+        return;
+    }
+    bind_rx_t rx;
+    memcpy(rx.mac, info->src_addr, PEER_MAC_LEN);
+    memcpy(&rx.msg, data, sizeof(rx.msg));
+    xQueueSend(rx_queue, &rx, 0);
+}
+
+static void bind_send_cb(const wifi_tx_info_t *info, esp_now_send_status_t status) {
+    if (bind_task_handle != NULL) {
+        xTaskNotify(bind_task_handle, status == ESP_NOW_SEND_SUCCESS ? 1 : 2, eSetValueWithOverwrite);
+    }
+}
+
+// Register mac as a plain peer; an existing encrypted entry is downgraded because
+// the other side may not have this device as an encrypted peer (yet)
+static esp_err_t ensure_peer(const uint8_t *mac) {
+    esp_now_peer_info_t peer = {0};
+    memcpy(peer.peer_addr, mac, PEER_MAC_LEN);
+    peer.channel = ESP_NOW_CHANNEL;
+    peer.ifidx = ESP_IF_WIFI_STA;
+    peer.encrypt = false;       // Bind messages are plain; the link key never goes on air
+    esp_err_t err = esp_now_add_peer(&peer);
+    if (err == ESP_ERR_ESPNOW_EXIST) {
+        err = esp_now_mod_peer(&peer);
+    }
+    return err;
+}
+
+// Send one message and wait for its send callback (MAC-layer ack for unicast)
+static bool send_and_wait(const uint8_t *mac, uint8_t type, uint32_t nonce) {
+    bind_msg_t msg = local;
+    msg.type = type;
+    msg.nonce = nonce;
+    uint32_t status = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &status, 0);     // Drop a stale callback result
+    if (esp_now_send(mac, (const uint8_t *)&msg, sizeof(msg)) != ESP_OK) {
+        return false;
+    }
+    return xTaskNotifyWait(0, UINT32_MAX, &status, pdMS_TO_TICKS(BIND_BEACON_MS)) == pdTRUE && status == 1;
+}
+
+static bool valid_reply(const bind_rx_t *rx, uint8_t type, uint32_t nonce) {
+    return rx->msg.type == type && rx->msg.version == BIND_VERSION && rx->msg.nonce == nonce;
+}
+
+// Sender: beacon until a receiver accepts, then confirm by unicast
+static bool run_sender(int64_t deadline_us) {
+    uint32_t nonce = esp_random();
+    if (ensure_peer(broadcast_mac) != ESP_OK) {
+        return false;
+    }
+    while (!cancel_requested && esp_timer_get_time() < deadline_us) {
+        send_and_wait(broadcast_mac, BIND_MSG_BEACON, nonce);
+        bind_rx_t rx;
+        if (xQueueReceive(rx_queue, &rx, pdMS_TO_TICKS(BIND_BEACON_MS)) != pdTRUE ||
+            !valid_reply(&rx, BIND_MSG_ACCEPT, nonce)) {
+            continue;
+        }
+        if (ensure_peer(rx.mac) != ESP_OK) {
+            continue;
+        }
+        for (int i = 0; i < BIND_CONFIRM_TRIES; i++) {
+            if (send_and_wait(rx.mac, BIND_MSG_CONFIRM, nonce)) {
+                found = rx;
+                return true;
+            }
+        }
+        ESP_LOGW(TAG, "Confirm to " MACSTR " not acknowledged, still searching", MAC2STR(rx.mac));
+    }
+    return false;
+}
+
+// Receiver: answer beacons until the sender we answered confirms
+static bool run_receiver(int64_t deadline_us) {
+    bool answered = false;
+    bind_rx_t pending = {0};
+    while (!cancel_requested && esp_timer_get_time() < deadline_us) {
+        bind_rx_t rx;
+        if (xQueueReceive(rx_queue, &rx, pdMS_TO_TICKS(BIND_BEACON_MS)) != pdTRUE) {
+            continue;
+        }
+        if (rx.msg.type == BIND_MSG_BEACON && rx.msg.version == BIND_VERSION) {
+            // Answer every beacon (the accept may be lost); the latest sender wins
+            if (ensure_peer(rx.mac) == ESP_OK && send_and_wait(rx.mac, BIND_MSG_ACCEPT, rx.msg.nonce)) {
+                pending = rx;
+                answered = true;
+            }
+        } else if (answered && memcmp(rx.mac, pending.mac, PEER_MAC_LEN) == 0 &&
+                   valid_reply(&rx, BIND_MSG_CONFIRM, pending.msg.nonce)) {
+            found = pending;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void bind_task(void *arg) {
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)BIND_TIMEOUT_MS * 1000;
+    bool ok = as_sender ? run_sender(deadline_us) : run_receiver(deadline_us);
+
+    esp_now_unregister_recv_cb();
+    esp_now_unregister_send_cb();
+    if (ok) {
+        ESP_LOGI(TAG, "Bound to %s " MACSTR, as_sender ? "receiver" : "sender", MAC2STR(found.mac));
+    } else {
+        ESP_LOGW(TAG, "Bind %s", cancel_requested ? "cancelled" : "timed out");
+    }
+    state = ok ? BIND_DONE : BIND_FAILED;
+    bind_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t bind_start(const device_settings_t *settings, bool is_sender) {
+    if (state != BIND_IDLE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (rx_queue == NULL) {
+        rx_queue = xQueueCreate(BIND_QUEUE_LEN, sizeof(bind_rx_t));
+        if (rx_queue == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    xQueueReset(rx_queue);
+
+    memset(&local, 0, sizeof(local));
+    memcpy(local.magic, BIND_MAGIC, 4);
+    local.version = BIND_VERSION;
+    local.num_channels = NUM_CHANNELS;
+    local.num_lights = NUM_LIGHTS;
+    local.caps = BIND_CAP_LINK_HMAC | BIND_CAP_LINK_ENCRYPT |
+                 (is_sender ? BIND_CAP_TRAINER_IN : BIND_CAP_SERIAL_OUT);
+    if (is_sender) {
+        // Fastest frame rate of the configured bounds, rounded as the sender will
+        frame_rate_t rate;
+        frame_rate_configure(&rate, settings->rate_min_hz, settings->rate_max_hz);
+        local.max_rate_hz = rate.stats.max_hz;
+    } else {
+        local.max_rate_hz = OUTPUT_RATE_MAX_HZ;
+    }
+    local.link_security = settings->link_security;
+    local.link_key_id = link_auth_key_id(settings->link_key);
+
+    as_sender = is_sender;
+    cancel_requested = false;
+    ESP_ERROR_CHECK(esp_now_register_recv_cb(bind_recv_cb));
+    ESP_ERROR_CHECK(esp_now_register_send_cb(bind_send_cb));
+    state = BIND_ACTIVE;
+    if (xTaskCreatePinnedToCore(bind_task, "bind", TASK_STACK_BIND, NULL, TASK_PRIO_BIND, &bind_task_handle,
+                                TASK_CORE_CONTROL) != pdPASS) {
+        esp_now_unregister_recv_cb();
+        esp_now_unregister_send_cb();
+        state = BIND_IDLE;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Bind mode for %d s, %s", BIND_TIMEOUT_MS / 1000,
+             is_sender ? "broadcasting beacons" : "waiting for a sender beacon");
+    return ESP_OK;
+}
+
+void bind_cancel(void) {
+    cancel_requested = true;
+}
+
+bind_state_t bind_get_state(void) {
+    return state;
+}
+
+bool bind_finish(device_settings_t *settings) {
+    bind_state_t s = state;
+    if (s != BIND_DONE && s != BIND_FAILED) {
+        return false;
+    }
+    state = BIND_IDLE;
+    if (s == BIND_FAILED) {
+        return false;
+    }
+
+    memcpy(settings->peer_mac, found.mac, PEER_MAC_LEN);
+    settings->peer_bound = true;
+    settings->peer_num_channels = found.msg.num_channels;
+    settings->peer_caps = found.msg.caps;
+    settings_save(settings);
+
+    // Binding works regardless; mismatches would only stop the link afterwards
+    if (found.msg.link_security != settings->link_security ||
+        found.msg.link_key_id != link_auth_key_id(settings->link_key)) {
+        ESP_LOGW(TAG, "Peer link security differs (mode %u, key id %08lx), frames will be rejected",
+                 found.msg.link_security, found.msg.link_key_id);
+    }
+    if (found.msg.num_channels != NUM_CHANNELS) {
+        ESP_LOGW(TAG, "Peer has %u channels, this device %d", found.msg.num_channels, NUM_CHANNELS);
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+// Bind / discovery
+// Pairs a sender and a receiver without typing MAC addresses. While bind mode
+// runs (user button double press, radio role stopped) the sender broadcasts a
+// beacon; a receiver in bind mode answers with its MAC and capabilities and the
+// sender confirms by unicast. Both sides then store the other's MAC and
+// capabilities in settings. On later starts the sender unicasts to the cached
+// peer right away and the receiver only accepts frames from it, so no
+// discovery runs after a reboot.
+#ifndef BIND_H
+#define BIND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_now.h"
+#include "common.h"
+
+#define BIND_TIMEOUT_MS 30000       // Bind mode gives up after this long
+#define BIND_BEACON_MS 100          // Sender beacon interval
+#define BIND_CONFIRM_TRIES 5        // Unicast confirm attempts (each waits for the MAC-layer ack)
+#define BIND_VERSION 2            // 2: bit-packed control frames (channel_config.h)
+
+// Capability flags exchanged during bind
+#define BIND_CAP_SERIAL_OUT   (1 << 0)  // Receiver: SBUS/CRSF/PPM serial output
+#define BIND_CAP_LINK_HMAC    (1 << 1)  // Supports link_auth HMAC frames
+#define BIND_CAP_LINK_ENCRYPT (1 << 2)  // Supports link_auth ESP-NOW encryption
+#define BIND_CAP_TRAINER_IN   (1 << 3)  // Sender: trainer-port channel source
+
+typedef enum {
+    BIND_MSG_BEACON = 1,            // Sender -> broadcast
+    BIND_MSG_ACCEPT,                // Receiver -> sender
+    BIND_MSG_CONFIRM,               // Sender -> receiver
+} bind_msg_type_t;
+
+typedef struct __attribute__((packed)) {
+    char magic[4];                  // "RCBD"; only looked for while bind mode owns the receive callback
+    uint8_t type;                   // bind_msg_type_t
+    uint8_t version;
+    uint32_t nonce;                 // Sender's bind session, echoed in accept and confirm
+    uint8_t num_channels;
+    uint8_t num_lights;
+    uint16_t caps;                  // BIND_CAP_*
+    uint16_t max_rate_hz;           // Sender upper frame rate bound / receiver output stage limit
+    uint8_t link_security;          // Configured link_security_t
+    uint32_t link_key_id;           // link_auth_key_id() of the configured key
+} bind_msg_t;
+
+typedef enum {
+    BIND_IDLE = 0,
+    BIND_ACTIVE,
+    BIND_DONE,                      // Peer found; read it with bind_finish()
+    BIND_FAILED,                    // Timed out or ESP-NOW error
+} bind_state_t;
+
+// Start bind mode for the given role. The radio role must be stopped: bind
+// mode owns the ESP-NOW callbacks until it ends.
+esp_err_t bind_start(const device_settings_t *settings, bool is_sender);
+void bind_cancel(void);
+bind_state_t bind_get_state(void);
+
+// After BIND_DONE: store the peer in settings (MAC, capabilities, bound flag)
+// and return to BIND_IDLE. After BIND_FAILED: return to BIND_IDLE only.
+// Returns true if settings were changed.
+bool bind_finish(device_settings_t *settings);
+
+// Recognise a bind message (magic and length); for receive paths that share
+// the ESP-NOW callback
+bool bind_is_bind_frame(const uint8_t *data, int len);
+
+#endif // BIND_H
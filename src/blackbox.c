@@ -0,0 +1,559 @@
+// Receiver black-box recorder implementation
+#include "blackbox.h"
+#include "console.h"
+#include "channel_config.h"
+#include "task_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_partition.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "blackbox";
+
+#define RING_MASK (BLACKBOX_RING_LEN - 1)
+#define SEQ_NONE 0xFFFFFFFFu            // Erased or foreign sector
+#define SAMPLE_FRAME 0                  // bb_sample_t.kind of a frame, otherwise a bb_event_t
+#define STOP_TIMEOUT_MS 2000
+#define ERASE_EST_US 50000              // Sector erase time to leave room for (or the longest measured)
+
+_Static_assert((BLACKBOX_RING_LEN & RING_MASK) == 0, "BLACKBOX_RING_LEN must be a power of two");
+_Static_assert(NUM_CHANNELS <= BB_MAX_CH, "more channels than the log format carries");
+_Static_assert(BB_SECTOR_SIZE % BB_PAGE_SIZE == 0, "pages must tile a sector");
+_Static_assert(sizeof(blackbox_dump_header_t) == 16, "blackbox_dump_header_t is a wire format");
+
+typedef struct {
+    uint32_t t_ms;                      // esp_timer time of the capture
+    uint32_t arg;                       // Event argument
+    uint8_t kind;                       // SAMPLE_FRAME or a bb_event_t
+    uint8_t lights;
+    int8_t rssi;
+    uint16_t ch[NUM_CHANNELS];
+} bb_sample_t;
+
+static const esp_partition_t *part = NULL;
+static uint16_t sector_count = 0;
+static uint32_t *sector_seq = NULL;     // Sequence number per sector, SEQ_NONE without data
+static SemaphoreHandle_t log_lock = NULL;   // Flash access and the writer state below
+static SemaphoreHandle_t stop_done = NULL;
+static TaskHandle_t writer_task_handle = NULL;
+
+// Sample ring: one producer (the receiver task), one consumer (the writer)
+static bb_sample_t *ring = NULL;
+static uint32_t head = 0;
+static uint32_t tail = 0;
+static uint32_t dropped = 0;
+static volatile bool recording = false;
+static volatile bool flush_request = false;
+static volatile bool stop_request = false;
+static volatile bool link_up = false;   // Frames arriving: outputs must not wait for flash
+static volatile uint32_t frame_us = 0;  // esp_timer time of the last frame
+static volatile uint32_t frame_interval_us = 0; // Interval the sender announced with it (0: unknown)
+
+// Writer state
+static bb_enc_t enc;
+static int newest = -1;                 // Sector being written (or last written before boot)
+static int ahead = 0;                   // Erased sectors following it
+static bool sector_open = false;
+static uint32_t next_seq = 0;
+static uint32_t session = 0;
+static bool new_session = true;
+static uint32_t pos = 0;                // Bytes used in the newest sector
+static uint32_t flushed = 0;            // Bytes of them programmed
+static uint32_t dirty_ms = 0;           // Time the oldest unprogrammed byte was added
+static uint32_t dropped_logged = 0;     // Part of dropped already logged as BB_EV_DROPPED
+static uint8_t page[BB_PAGE_SIZE];      // Flash page holding pos
+
+// Stats
+static uint32_t records = 0;
+static uint32_t log_bytes = 0;
+static uint32_t write_max_us = 0;
+static uint32_t erase_max_us = 0;
+static int64_t rec_start_us = 0;
+static int64_t rec_total_us = 0;        // Recording time of earlier starts
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static uint32_t sector_addr(int s) {
+    return (uint32_t)s * BB_SECTOR_SIZE;
+}
+
+// Sectors to keep erased ahead of the log: half the partition, the rest keeps
+// the previous recording
+static int ahead_target(void) {
+    return sector_count / 2;
+}
+
+// Without auto suspend an erase pauses every task and timer callback for
+// 30-50 ms on these single-core chips. With the link up it only goes right
+// after a frame, when the announced interval leaves room for it before the
+// next one (low and keepalive rates).
+static bool erase_allowed(void) {
+#if CONFIG_SPI_FLASH_AUTO_SUSPEND
+    return true;
+#else
+    if (!link_up) {
+        return true;
+    }
+    uint32_t budget = erase_max_us > ERASE_EST_US ? erase_max_us : ERASE_EST_US;
+    uint32_t interval = frame_interval_us;
+    uint32_t since = (uint32_t)esp_timer_get_time() - frame_us;
+    return interval > budget && since < interval - budget;
+#endif
+}
+
+static void erase_sector(int s) {
+    int64_t t = esp_timer_get_time();
+    esp_err_t err = esp_partition_erase_range(part, sector_addr(s), BB_SECTOR_SIZE);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t);
+    if (us > erase_max_us) {
+        erase_max_us = us;
+    }
+    sector_seq[s] = SEQ_NONE;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Erase of sector %d failed: %s", s, esp_err_to_name(err));
+    }
+}
+
+// Program the bytes added since the last call. Called for every full page and
+// for a partial one when it is due; the rest of a partial page is programmed
+// into the still-erased bytes later.
+static void flush_page(void) {
+    if (pos == flushed) {
+        return;
+    }
+    uint32_t base = flushed - flushed % BB_PAGE_SIZE;
+    int64_t t = esp_timer_get_time();
+    esp_err_t err = esp_partition_write(part, sector_addr(newest) + flushed, page + (flushed - base), pos - flushed);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t);
+    if (us > write_max_us) {
+        write_max_us = us;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Write at sector %d + %lu failed: %s", newest, flushed, esp_err_to_name(err));
+    }
+    flushed = pos;
+    if (pos % BB_PAGE_SIZE == 0) {
+        memset(page, 0xFF, sizeof(page));
+    }
+}
+
+static void put(const void *data, size_t len) {
+    const uint8_t *p = data;
+    if (pos == flushed) {
+        dirty_ms = now_ms();
+    }
+    while (len > 0) {
+        uint32_t off = pos % BB_PAGE_SIZE;
+        size_t n = BB_PAGE_SIZE - off < len ? BB_PAGE_SIZE - off : len;
+        memcpy(page + off, p, n);
+        pos += n;
+        p += n;
+        len -= n;
+        if (pos % BB_PAGE_SIZE == 0) {
+            flush_page();
+        }
+    }
+}
+
+// Start the next sector. With none erased ahead it is erased now: one bounded
+// stall per 4 KB of log, which the outputs hold through, so the log keeps
+// rolling when the link stays up longer than the erased sectors last.
+static void open_sector(void) {
+    if (sector_open) {
+        flush_page();
+        sector_open = false;
+    }
+    int s = (newest + 1) % sector_count;
+    if (ahead > 0) {
+        ahead--;
+    } else {
+        erase_sector(s);
+    }
+    newest = s;
+    if (new_session) {
+        session = next_seq;
+        new_session = false;
+    }
+    sector_seq[s] = next_seq;
+
+    bb_sector_header_t hdr = {
+        .version = BB_VERSION,
+        .num_ch = NUM_CHANNELS,
+        .seq = next_seq,
+        .session = session,
+    };
+    memcpy(hdr.magic, BB_MAGIC, sizeof(hdr.magic));
+    next_seq++;
+    pos = 0;
+    flushed = 0;
+    memset(page, 0xFF, sizeof(page));
+    put(&hdr, sizeof(hdr));
+    bb_enc_reset(&enc);
+    sector_open = true;
+}
+
+// Encode into the open sector, or start the next one (with a key frame) if the
+// record does not fit
+static void log_sample(const bb_sample_t *s) {
+    uint8_t rec[BB_REC_MAX];
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (!sector_open) {
+            open_sector();
+        }
+        bb_enc_t e = enc;
+        size_t n = (s->kind == SAMPLE_FRAME)
+                       ? bb_encode_frame(&e, rec, s->t_ms, s->ch, s->lights, s->rssi)
+                       : bb_encode_event(&e, rec, s->t_ms, (bb_event_t)s->kind, s->arg);
+        if (pos + n <= BB_SECTOR_SIZE) {
+            enc = e;
+            put(rec, n);
+            records++;
+            log_bytes += n;
+            return;
+        }
+        flush_page();
+        sector_open = false;
+    }
+}
+
+static void drain(void) {
+    uint32_t d = __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+    if (d != dropped_logged) {
+        bb_sample_t s = {.t_ms = now_ms(), .kind = BB_EV_DROPPED, .arg = d - dropped_logged};
+        log_sample(&s);
+        dropped_logged = d;
+    }
+    uint32_t t = tail;
+    uint32_t h = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    for (; t != h; t++) {
+        log_sample(&ring[t & RING_MASK]);
+        __atomic_store_n(&tail, t + 1, __ATOMIC_RELEASE);
+    }
+}
+
+// Erase sectors ahead of the log while that cannot delay the outputs, one per
+// lock so a dump or a returning link waits for one erase at most
+static void erase_ahead(int target) {
+    while (1) {
+        xSemaphoreTake(log_lock, portMAX_DELAY);
+        bool more = ahead < target && erase_allowed();
+        if (more) {
+            erase_sector((newest + 1 + ahead) % sector_count);
+            ahead++;
+        }
+        xSemaphoreGive(log_lock);
+        if (!more) {
+            return;
+        }
+    }
+}
+
+static void writer_task(void *arg) {
+    while (1) {
+        bool timeout = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BLACKBOX_FLUSH_MS)) == 0;
+        xSemaphoreTake(log_lock, portMAX_DELAY);
+        drain();
+        bool stop = stop_request;
+        if (stop || flush_request || timeout || now_ms() - dirty_ms >= BLACKBOX_FLUSH_MS) {
+            flush_request = false;
+            if (sector_open) {
+                flush_page();
+            }
+        }
+        xSemaphoreGive(log_lock);
+        if (stop) {
+            stop_request = false;
+            xSemaphoreGive(stop_done);
+        } else {
+            erase_ahead(ahead_target());
+        }
+    }
+}
+
+// Only erased bytes (checked page by page; init runs before the writer uses page)
+static bool sector_blank(int s) {
+    for (uint32_t off = 0; off < BB_SECTOR_SIZE; off += BB_PAGE_SIZE) {
+        if (esp_partition_read(part, sector_addr(s) + off, page, BB_PAGE_SIZE) != ESP_OK) {
+            return false;
+        }
+        for (int i = 0; i < BB_PAGE_SIZE; i++) {
+            if (page[i] != 0xFF) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void blackbox_init(void) {
+    const esp_partition_t *p = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, BLACKBOX_SUBTYPE,
+                                                        BLACKBOX_PARTITION);
+    if (p == NULL) {
+        ESP_LOGW(TAG, "No '%s' partition (older partition table), recorder off", BLACKBOX_PARTITION);
+        return;
+    }
+    uint16_t count = (uint16_t)(p->size / BB_SECTOR_SIZE);
+    sector_seq = malloc(count * sizeof(uint32_t));
+    ring = malloc(BLACKBOX_RING_LEN * sizeof(bb_sample_t));
+    log_lock = xSemaphoreCreateMutex();
+    stop_done = xSemaphoreCreateBinary();
+    if (count < 2 || sector_seq == NULL || ring == NULL || log_lock == NULL || stop_done == NULL) {
+        ESP_LOGE(TAG, "Recorder off (%u sectors, out of memory?)", count);
+        free(sector_seq);
+        free(ring);
+        sector_seq = NULL;
+        ring = NULL;
+        return;
+    }
+
+    // The newest sector is the one with the highest sequence number
+    int used = 0;
+    for (int s = 0; s < count; s++) {
+        bb_sector_header_t hdr;
+        sector_seq[s] = SEQ_NONE;
+        if (esp_partition_read(p, sector_addr(s), &hdr, sizeof(hdr)) == ESP_OK &&
+            memcmp(hdr.magic, BB_MAGIC, sizeof(hdr.magic)) == 0 && hdr.version == BB_VERSION &&
+            hdr.seq != SEQ_NONE) {
+            sector_seq[s] = hdr.seq;
+            used++;
+            if (newest < 0 || hdr.seq > sector_seq[newest]) {
+                newest = s;
+            }
+        }
+    }
+    next_seq = newest >= 0 ? sector_seq[newest] + 1 : 0;
+    bb_enc_init(&enc, NUM_CHANNELS);
+    sector_count = count;
+    part = p;
+    // Sectors erased ahead before the last power-off can be used without erasing again
+    ahead = 0;
+    while (ahead < ahead_target() && sector_blank((newest + 1 + ahead) % count)) {
+        ahead++;
+    }
+    ESP_LOGI(TAG, "%lu KB log at 0x%lx, %d of %u sectors hold data, %d erased ahead", p->size / 1024,
+             p->address, used, count, ahead);
+}
+
+void blackbox_start(void) {
+    if (part == NULL || recording) {
+        return;
+    }
+    if (writer_task_handle == NULL &&
+        xTaskCreatePinnedToCore(writer_task, "blackbox", TASK_STACK_BLACKBOX, NULL, TASK_PRIO_BLACKBOX,
+                                &writer_task_handle, TASK_CORE_UI) != pdPASS) {
+        ESP_LOGE(TAG, "Writer task not started, recorder off");
+        writer_task_handle = NULL;
+        return;
+    }
+    rec_start_us = esp_timer_get_time();
+    link_up = false;
+    recording = true;
+    blackbox_record_event(BB_EV_START, (uint32_t)esp_reset_reason());
+}
+
+void blackbox_stop(void) {
+    if (!recording) {
+        return;
+    }
+    blackbox_record_event(BB_EV_STOP, 0);
+    recording = false;
+    link_up = false;
+    rec_total_us += esp_timer_get_time() - rec_start_us;
+    stop_request = true;
+    xTaskNotifyGive(writer_task_handle);
+    if (xSemaphoreTake(stop_done, pdMS_TO_TICKS(STOP_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Writer did not finish within %d ms", STOP_TIMEOUT_MS);
+    }
+}
+
+static bb_sample_t *claim(void) {
+    if (!recording) {
+        return NULL;
+    }
+    uint32_t h = head;
+    if (h - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) >= BLACKBOX_RING_LEN) {
+        __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    bb_sample_t *s = &ring[h & RING_MASK];
+    s->t_ms = now_ms();
+    return s;
+}
+
+static void publish(bool wake) {
+    uint32_t h = head + 1;
+    __atomic_store_n(&head, h, __ATOMIC_RELEASE);
+    if (wake || h % BLACKBOX_NOTIFY_EVERY == 0) {
+        xTaskNotifyGive(writer_task_handle);
+    }
+}
+
+void blackbox_record_frame(const uint16_t *ch, uint8_t lights, int8_t rssi, uint32_t interval_us) {
+    frame_us = (uint32_t)esp_timer_get_time();
+    frame_interval_us = interval_us;
+    link_up = true;
+    bb_sample_t *s = claim();
+    if (s == NULL) {
+        return;
+    }
+    s->kind = SAMPLE_FRAME;
+    s->lights = lights;
+    s->rssi = rssi;
+    memcpy(s->ch, ch, sizeof(s->ch));
+    publish(false);
+}
+
+void blackbox_record_event(bb_event_t event, uint32_t arg) {
+    bb_sample_t *s = claim();
+    if (s == NULL) {
+        return;
+    }
+    s->kind = (uint8_t)event;
+    s->arg = arg;
+    if (event == BB_EV_FAILSAFE && arg != 0) {
+        link_up = false;            // The writer may erase again
+        flush_request = true;       // The moment the link failed must survive a power cut
+    }
+    publish(event != BB_EV_RATE);   // Rate changes are frequent and ride along with the frames
+}
+
+esp_err_t blackbox_dump(bool (*emit)(void *ctx, const void *data, size_t len), void *ctx) {
+    if (part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    uint8_t *buf = malloc(BB_SECTOR_SIZE);
+    if (buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    blackbox_dump_header_t header = {
+        .version = BB_VERSION,
+        .num_ch = NUM_CHANNELS,
+        .sector_size = BB_SECTOR_SIZE,
+        .now_ms = now_ms(),
+    };
+    memcpy(header.magic, BLACKBOX_DUMP_MAGIC, sizeof(header.magic));
+
+    // Oldest first: the sectors after the newest one, around the ring
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    if (sector_open) {
+        flush_page();
+    }
+    int first = newest + 1;
+    uint32_t last_seq = newest >= 0 ? sector_seq[newest] : 0;
+    for (int i = 0; i < sector_count; i++) {
+        if (sector_seq[(first + i) % sector_count] != SEQ_NONE) {
+            header.sectors++;
+        }
+    }
+    xSemaphoreGive(log_lock);
+
+    esp_err_t err = emit(ctx, &header, sizeof(header)) ? ESP_OK : ESP_FAIL;
+    for (int i = 0; i < sector_count && err == ESP_OK; i++) {
+        int s = (first + i) % sector_count;
+        xSemaphoreTake(log_lock, portMAX_DELAY);
+        uint32_t seq = sector_seq[s];
+        bool ok = seq != SEQ_NONE && seq <= last_seq &&
+                  esp_partition_read(part, sector_addr(s), buf, BB_SECTOR_SIZE) == ESP_OK;
+        xSemaphoreGive(log_lock);
+        if (ok && !emit(ctx, buf, BB_SECTOR_SIZE)) {
+            err = ESP_FAIL;
+        }
+    }
+    free(buf);
+    return err;
+}
+
+esp_err_t blackbox_clear(void) {
+    if (part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (recording) {
+        return ESP_ERR_INVALID_STATE;   // Seconds of erasing would stall the outputs
+    }
+    // Every other sector joins the erased ones ahead, sector by sector, so a
+    // dump or the writer never waits for more than one erase
+    erase_ahead(sector_count - 1);
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    esp_err_t err = ESP_OK;
+    if (recording || ahead < sector_count - 1) {
+        err = ESP_ERR_INVALID_STATE;    // The receiver started meanwhile
+    } else {
+        // Recording goes on in a fresh sector (sequence numbers keep counting)
+        erase_sector((newest + sector_count) % sector_count);
+        sector_open = false;
+        pos = 0;
+        flushed = 0;
+    }
+    xSemaphoreGive(log_lock);
+    return err;
+}
+
+void blackbox_get_stats(blackbox_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (part == NULL) {
+        return;
+    }
+    out->available = true;
+    out->recording = recording;
+    out->capacity = part->size;
+    for (int s = 0; s < sector_count; s++) {
+        if (sector_seq[s] != SEQ_NONE) {
+            out->used += BB_SECTOR_SIZE;
+        }
+    }
+    out->records = records;
+    out->bytes = log_bytes;
+    int64_t rec_us = rec_total_us + (recording ? esp_timer_get_time() - rec_start_us : 0);
+    out->rate_bps = rec_us > 0 ? (uint32_t)((int64_t)log_bytes * 1000000 / rec_us) : 0;
+    // The erased-ahead half holds no history
+    uint32_t kept = (uint32_t)(sector_count - ahead_target()) * BB_SECTOR_SIZE;
+    out->minutes = out->rate_bps ? kept / out->rate_bps / 60 : 0;
+    out->dropped = __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+    out->write_max_us = write_max_us;
+    out->erase_max_us = erase_max_us;
+    out->ready = (uint32_t)ahead * BB_SECTOR_SIZE;
+}
+
+int blackbox_console_cmd(int argc, char **argv) {
+    if (part == NULL) {
+        printf("No '%s' partition\n", BLACKBOX_PARTITION);
+        return 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+        esp_err_t err = blackbox_clear();
+        if (err == ESP_ERR_INVALID_STATE) {
+            printf("Recording: stop the receiver first (web interface on)\n");
+            return 1;
+        }
+        printf("Black box %s\n", err == ESP_OK ? "cleared" : esp_err_to_name(err));
+        return err == ESP_OK ? 0 : 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "info") == 0) {
+        blackbox_stats_t st;
+        blackbox_get_stats(&st);
+        printf("%s, %lu of %lu KB used\n", st.recording ? "Recording" : "Stopped", st.used / 1024, st.capacity / 1024);
+        printf("%lu records, %lu bytes since boot, %lu B/s: about %lu min of history\n",
+               st.records, st.bytes, st.rate_bps, st.minutes);
+        printf("%lu KB erased ahead; dropped %lu samples; longest page write %lu us, sector erase %lu us\n",
+               st.ready / 1024, st.dropped, st.write_max_us, st.erase_max_us);
+        return 0;
+    }
+    // GET /api/blackbox over serial, for tools/blackbox_decode.py
+    printf("BLACKBOX BEGIN\n");
+    esp_err_t err = blackbox_dump(console_print_hex, NULL);
+    printf("BLACKBOX END\n");
+    if (err != ESP_OK) {
+        printf("Dump failed: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Receiver black-box recorder
+// Received frames (channels, lights, RSSI) and link events are logged to the
+// "blackbox" flash partition, used as a circular log of 4 KB sectors
+// (blackbox_codec.h): up to half of them are erased ahead of the log, so the
+// newest recording fills at least the other half. The receiver task only
+// copies a sample into a RAM ring and never waits; a low-priority writer task
+// encodes the samples and programs flash in page-sized batches, plus whatever
+// is pending once a second and on a failsafe, so a power cut loses at most
+// about a second. A sector erase stalls the single core for 30-50 ms, so the writer
+// erases ahead of the log while the link is down, the receiver is stopped or
+// the announced frame interval leaves room (at any time with
+// CONFIG_SPI_FLASH_AUTO_SUSPEND); when the erased sectors run out in flight,
+// each new sector costs one erase. The log is read back over HTTP
+// (GET /api/blackbox, binary) or the serial console ("blackbox", hex lines)
+// and decoded or replayed on the host with tools/blackbox_decode.py.
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "blackbox_codec.h"
+
+#define BLACKBOX_PARTITION "blackbox"
+#define BLACKBOX_SUBTYPE 0x40           // Custom data subtype in partitions.csv
+#define BLACKBOX_RING_LEN 128           // Power of two; 2.5 s at 50 Hz
+#define BLACKBOX_NOTIFY_EVERY 16        // Samples queued before the writer is woken
+#define BLACKBOX_FLUSH_MS 1000          // Longest time a sample stays in RAM
+
+#define BLACKBOX_DUMP_MAGIC "RCBX"
+
+// Dump header, followed by whole sectors, oldest first (little-endian, as in memory)
+typedef struct __attribute__((packed)) {
+    char magic[4];                      // BLACKBOX_DUMP_MAGIC
+    uint8_t version;                    // BB_VERSION
+    uint8_t num_ch;
+    uint16_t sector_size;               // BB_SECTOR_SIZE
+    uint16_t sectors;                   // Sectors with data when the dump started (at most this many follow)
+    uint16_t reserved;
+    uint32_t now_ms;                    // esp_timer time of the dump
+} blackbox_dump_header_t;
+
+typedef struct {
+    bool available;                     // Partition found
+    bool recording;
+    uint32_t capacity;                  // Partition size (bytes)
+    uint32_t used;                      // Bytes in sectors holding data
+    uint32_t records;                   // Records written since boot
+    uint32_t bytes;                     // Log bytes written since boot
+    uint32_t rate_bps;                  // Log rate while recording (bytes/s)
+    uint32_t minutes;                   // History the log keeps at rate_bps (erased-ahead half not counted)
+    uint32_t dropped;                   // Samples lost to a full ring
+    uint32_t write_max_us;              // Longest page program
+    uint32_t erase_max_us;              // Longest sector erase
+    uint32_t ready;                     // Bytes erased ahead of the log
+} blackbox_stats_t;
+
+// Find the partition and the newest sector. Without the partition (older
+// partition table) the recorder stays off and the calls below do nothing.
+void blackbox_init(void);
+
+// Receiver started / stopping: a stop queues BB_EV_STOP and waits until
+// everything queued is on flash
+void blackbox_start(void);
+void blackbox_stop(void);
+
+// Producer side (receiver task), timestamped on entry: never blocks, a full
+// ring drops the sample. interval_us is the frame interval the sender
+// announced (frame_rate_interval_us), 0 if unknown.
+void blackbox_record_frame(const uint16_t *ch, uint8_t lights, int8_t rssi, uint32_t interval_us);
+void blackbox_record_event(bb_event_t event, uint32_t arg);
+
+// Write the header and every sector, oldest first, through emit; stops early
+// if emit returns false. A sector the writer reuses during the dump is skipped.
+esp_err_t blackbox_dump(bool (*emit)(void *ctx, const void *data, size_t len), void *ctx);
+
+// Erase the whole log. ESP_ERR_INVALID_STATE while recording.
+esp_err_t blackbox_clear(void);
+
+void blackbox_get_stats(blackbox_stats_t *out);
+
+// "blackbox [info | clear]": dump as hex between markers, show stats or erase
+int blackbox_console_cmd(int argc, char **argv);
+
+#endif // BLACKBOX_H
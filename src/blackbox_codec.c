@@ -0,0 +1,102 @@
+// Black-box log record encoding implementation
+#include "blackbox_codec.h"
+#include <string.h>
+
+_Static_assert(sizeof(bb_sector_header_t) == 16, "bb_sector_header_t is a flash format");
+
+static size_t put_varint(uint8_t *out, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static size_t put_u32(uint8_t *out, uint32_t v) {
+    out[0] = (uint8_t)v;
+    out[1] = (uint8_t)(v >> 8);
+    out[2] = (uint8_t)(v >> 16);
+    out[3] = (uint8_t)(v >> 24);
+    return 4;
+}
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+void bb_enc_init(bb_enc_t *enc, uint8_t num_ch) {
+    memset(enc, 0, sizeof(*enc));
+    enc->num_ch = num_ch > BB_MAX_CH ? BB_MAX_CH : num_ch;
+}
+
+void bb_enc_reset(bb_enc_t *enc) {
+    enc->have_time = false;
+    enc->have_frame = false;
+}
+
+size_t bb_encode_frame(bb_enc_t *enc, uint8_t *out, uint32_t t_ms, const uint16_t *ch, uint8_t lights, int8_t rssi) {
+    size_t n = 0;
+    if (!enc->have_frame) {
+        out[n++] = BB_REC_KEY;
+        n += put_u32(out + n, t_ms);
+        for (int i = 0; i < enc->num_ch; i++) {
+            out[n++] = (uint8_t)ch[i];
+            out[n++] = (uint8_t)(ch[i] >> 8);
+        }
+        out[n++] = lights;
+        out[n++] = (uint8_t)rssi;
+    } else {
+        uint8_t tag = BB_REC_DELTA;
+        if (lights != enc->lights) {
+            tag |= BB_DELTA_LIGHTS;
+        }
+        if (rssi != enc->rssi) {
+            tag |= BB_DELTA_RSSI;
+        }
+        uint32_t mask = 0;
+        for (int i = 0; i < enc->num_ch; i++) {
+            if (ch[i] != enc->ch[i]) {
+                mask |= 1u << i;
+            }
+        }
+        out[n++] = tag;
+        n += put_varint(out + n, t_ms - enc->t_ms);
+        n += put_varint(out + n, mask);
+        for (int i = 0; i < enc->num_ch; i++) {
+            if (mask & (1u << i)) {
+                n += put_varint(out + n, zigzag((int32_t)ch[i] - enc->ch[i]));
+            }
+        }
+        if (tag & BB_DELTA_LIGHTS) {
+            out[n++] = lights;
+        }
+        if (tag & BB_DELTA_RSSI) {
+            out[n++] = (uint8_t)rssi;
+        }
+    }
+    memcpy(enc->ch, ch, enc->num_ch * sizeof(uint16_t));
+    enc->lights = lights;
+    enc->rssi = rssi;
+    enc->t_ms = t_ms;
+    enc->have_time = true;
+    enc->have_frame = true;
+    return n;
+}
+
+size_t bb_encode_event(bb_enc_t *enc, uint8_t *out, uint32_t t_ms, bb_event_t event, uint32_t arg) {
+    size_t n = 0;
+    if (!enc->have_time) {
+        out[n++] = BB_REC_TIME;
+        n += put_u32(out + n, t_ms);
+        enc->t_ms = t_ms;
+        enc->have_time = true;
+    }
+    out[n++] = BB_REC_EVENT;
+    n += put_varint(out + n, t_ms - enc->t_ms);
+    out[n++] = (uint8_t)event;
+    n += put_varint(out + n, arg);
+    enc->t_ms = t_ms;
+    return n;
+}
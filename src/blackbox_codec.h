@@ -0,0 +1,75 @@
+// Black-box log record encoding
+// The flash log (blackbox.h) is a sequence of 4 KB sectors, each starting with
+// a bb_sector_header_t and followed by variable-length records. A sector
+// decodes on its own: its first frame is a key frame with every value, later
+// frames only carry what changed since the previous one (zigzag varint channel
+// deltas, plus lights and RSSI when they differ). A tag byte of 0xFF (erased
+// flash) ends the sector. tools/blackbox_decode.py reads the same format.
+// Has no ESP-IDF dependencies so the encoder can be run on the host.
+#ifndef BLACKBOX_CODEC_H
+#define BLACKBOX_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define BB_MAGIC "RCBB"
+#define BB_VERSION 1
+#define BB_SECTOR_SIZE 4096             // Flash erase unit
+#define BB_PAGE_SIZE 256                // Flash program unit, the size of a batched write
+#define BB_MAX_CH 16
+
+typedef enum {
+    BB_REC_KEY = 0x01,                  // u32 t_ms, u16 ch[num_ch], u8 lights, i8 rssi
+    BB_REC_TIME = 0x02,                 // u32 t_ms: time base for an event before the first frame
+    BB_REC_EVENT = 0x03,                // varint dt_ms, u8 bb_event_t, varint arg
+    BB_REC_DELTA = 0x10,                // | BB_DELTA_*: varint dt_ms, varint channel mask,
+                                        // zigzag varint per channel in the mask, [u8 lights], [i8 rssi]
+    BB_REC_END = 0xFF,                  // Erased flash
+} bb_rec_t;
+
+#define BB_DELTA_LIGHTS 0x01
+#define BB_DELTA_RSSI 0x02
+
+typedef enum {
+    BB_EV_START = 1,                    // Recording started. arg: esp_reset_reason_t of this boot
+    BB_EV_STOP,                         // Receiver stopped (webserver, bind, role change)
+    BB_EV_FAILSAFE,                     // arg: 1 = link lost, 0 = link restored
+    BB_EV_DROPPED,                      // arg: samples lost to a full ring before this point
+    BB_EV_RATE,                         // Sender frame rate changed. arg: Hz, 0 = not signalled
+} bb_event_t;
+
+// Start of every sector (little-endian, as in memory)
+typedef struct __attribute__((packed)) {
+    char magic[4];                      // BB_MAGIC
+    uint8_t version;                    // BB_VERSION
+    uint8_t num_ch;                     // NUM_CHANNELS of the recording build
+    uint16_t reserved;
+    uint32_t seq;                       // Sector sequence number, +1 per sector written
+    uint32_t session;                   // seq of the first sector since the recorder started
+} bb_sector_header_t;
+
+// Longest record: a delta with every channel changed by the full range
+#define BB_REC_MAX (1 + 5 + 3 + BB_MAX_CH * 3 + 2)
+
+typedef struct {
+    uint8_t num_ch;
+    bool have_time;                     // A record in this sector set the time base
+    bool have_frame;                    // ch/lights/rssi hold the previous frame
+    uint32_t t_ms;                      // Time of the previous record
+    uint16_t ch[BB_MAX_CH];
+    uint8_t lights;
+    int8_t rssi;
+} bb_enc_t;
+
+void bb_enc_init(bb_enc_t *enc, uint8_t num_ch);
+
+// Start of a new sector: the next frame is a key frame
+void bb_enc_reset(bb_enc_t *enc);
+
+// Encode one record into out (BB_REC_MAX bytes) and return its length. Times
+// are esp_timer milliseconds; deltas are taken modulo 2^32.
+size_t bb_encode_frame(bb_enc_t *enc, uint8_t *out, uint32_t t_ms, const uint16_t *ch, uint8_t lights, int8_t rssi);
+size_t bb_encode_event(bb_enc_t *enc, uint8_t *out, uint32_t t_ms, bb_event_t event, uint32_t arg);
+
+#endif // BLACKBOX_CODEC_H
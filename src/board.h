@@ -0,0 +1,145 @@
+// Board pin maps
+// One constant table per supported board, selected at build time with
+// -D BOARD_<name> (platformio.ini build_flags); without one the board follows
+// the IDF target. Pin groups are X-macro lists, so the same list produces the
+// runtime tables (servo pins, ADC channels) and the compile-time checks at the
+// end of this file.
+//
+// Pins are grouped by role. A device runs one role at a time and a role change
+// restarts it (main.c), so sender and receiver pins may share a GPIO; pins
+// within one role, plus the common pins, must all differ.
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "sdkconfig.h"
+#include "soc/soc_caps.h"
+#include "soc/adc_channel.h"
+#include "channel_config.h"
+
+// Roles built into the image. Single-role images leave out the other role's
+// modules entirely (src/CMakeLists.txt): idf.py -DRC_ROLE_RECEIVER=0 builds a
+// sender, -DRC_ROLE_SENDER=0 a receiver.
+#ifndef RC_ROLE_SENDER
+#define RC_ROLE_SENDER 1
+#endif
+#ifndef RC_ROLE_RECEIVER
+#define RC_ROLE_RECEIVER 1
+#endif
+#if !RC_ROLE_SENDER && !RC_ROLE_RECEIVER
+#error "At least one of RC_ROLE_SENDER and RC_ROLE_RECEIVER must be enabled"
+#endif
+
+#if !defined(BOARD_LOLIN_S2_MINI) && !defined(BOARD_C3_SUPERMINI)
+#if CONFIG_IDF_TARGET_ESP32S2
+#define BOARD_LOLIN_S2_MINI
+#elif CONFIG_IDF_TARGET_ESP32C3
+#define BOARD_C3_SUPERMINI
+#else
+#error "No pin map for this target: add a board to board.h"
+#endif
+#endif
+
+#if defined(BOARD_LOLIN_S2_MINI)
+
+#define BOARD_NAME "LOLIN S2 Mini"
+
+#define PIN_USER_BUTTON 0       // GPIO0 - User button (active-low, boot button)
+#define PIN_LED 15              // GPIO15 - Status LED
+#define LED_ACTIVE_LEVEL 1
+
+// Sender: light buttons, trainer input, stick inputs (ADC1 GPIOs)
+#define PIN_LIGHT_BTN1 6
+#define PIN_LIGHT_BTN2 7
+#define PIN_LIGHT_BTN3 8
+#define PIN_LIGHT_BTN4 9
+#define PIN_TRAINER_IN 17
+#define BOARD_ADC_GPIOS(X) X(1) X(2) X(3) X(4) X(5) X(10)
+
+// Receiver: light outputs, serial output, servo PWM (LEDC)
+#define PIN_LIGHT_OUT1 10
+#define PIN_LIGHT_OUT2 11
+#define PIN_LIGHT_OUT3 12
+#define PIN_LIGHT_OUT4 13
+#define PIN_SERIAL_OUT 18
+#define BOARD_SERVO_GPIOS(X) X(4) X(5) X(16) X(33) X(14) X(34)
+
+// USB D-/D+ (19, 20) and the in-package flash/PSRAM bus (26-32)
+#define BOARD_RESERVED_MASK ((1ULL << 19) | (1ULL << 20) | (0x7FULL << 26))
+
+#elif defined(BOARD_C3_SUPERMINI)
+
+#define BOARD_NAME "ESP32-C3 SuperMini"
+
+#define PIN_USER_BUTTON 9       // GPIO9 - BOOT button (active-low)
+#define PIN_LED 8               // GPIO8 - Blue LED to 3V3
+#define LED_ACTIVE_LEVEL 0
+
+// Sender. ADC1 is GPIO0-4 only; GPIO2 is a strapping pin and is left out of
+// the stick inputs so a pot cannot hold it low at reset.
+#define PIN_LIGHT_BTN1 5
+#define PIN_LIGHT_BTN2 6
+#define PIN_LIGHT_BTN3 7
+#define PIN_LIGHT_BTN4 10
+#define PIN_TRAINER_IN 20
+#define BOARD_ADC_GPIOS(X) X(0) X(1) X(3) X(4)
+
+// Receiver. The C3 has 6 LEDC channels, one per servo output.
+#define PIN_LIGHT_OUT1 6
+#define PIN_LIGHT_OUT2 7
+#define PIN_LIGHT_OUT3 10
+#define PIN_LIGHT_OUT4 20
+#define PIN_SERIAL_OUT 21
+#define BOARD_SERVO_GPIOS(X) X(0) X(1) X(2) X(3) X(4) X(5)
+
+// SPI flash (11-17) and USB D-/D+ (18, 19). The console runs on the
+// USB-Serial-JTAG (sdkconfig.esp32c3_*), which leaves UART0's 20/21 free.
+#define BOARD_RESERVED_MASK (0x1FFULL << 11)
+
+#endif
+
+// Runtime tables, bounded by the channel count (channel_config.h)
+#define BOARD_PIN_ENTRY(p) p,
+#define BOARD_PIN_COUNT(p) +1
+#define BOARD_ADC_ENTRY(gpio) ADC1_GPIO##gpio##_CHANNEL,
+
+#define ADC_INPUT_MAP {BOARD_ADC_GPIOS(BOARD_ADC_ENTRY)}
+#define ADC_INPUT_MAP_LEN (0 BOARD_ADC_GPIOS(BOARD_PIN_COUNT))
+#define SERVO_PIN_MAP {BOARD_SERVO_GPIOS(BOARD_PIN_ENTRY)}
+#define SERVO_PIN_MAP_LEN (0 BOARD_SERVO_GPIOS(BOARD_PIN_COUNT))
+
+// Sender channels past ADC_INPUT_MAP read as centered from the sticks and are
+// only driven by the trainer input; receiver channels past SERVO_PIN_MAP are
+// only on the serial output (SBUS/CRSF; PPM carries the first 8).
+#define NUM_ADC_INPUTS (NUM_CHANNELS < ADC_INPUT_MAP_LEN ? NUM_CHANNELS : ADC_INPUT_MAP_LEN)
+#define NUM_SERVO_OUTPUTS (NUM_CHANNELS < SERVO_PIN_MAP_LEN ? NUM_CHANNELS : SERVO_PIN_MAP_LEN)
+
+// Pin groups for the checks
+#define BOARD_COMMON_PINS(X) X(PIN_USER_BUTTON) X(PIN_LED)
+#define BOARD_SENDER_PINS(X) BOARD_COMMON_PINS(X) X(PIN_LIGHT_BTN1) X(PIN_LIGHT_BTN2) X(PIN_LIGHT_BTN3) \
+    X(PIN_LIGHT_BTN4) X(PIN_TRAINER_IN) BOARD_ADC_GPIOS(X)
+#define BOARD_RECEIVER_PINS(X) BOARD_COMMON_PINS(X) X(PIN_LIGHT_OUT1) X(PIN_LIGHT_OUT2) X(PIN_LIGHT_OUT3) \
+    X(PIN_LIGHT_OUT4) X(PIN_SERIAL_OUT) BOARD_SERVO_GPIOS(X)
+#define BOARD_OUTPUT_PINS(X) X(PIN_LED) X(PIN_LIGHT_OUT1) X(PIN_LIGHT_OUT2) X(PIN_LIGHT_OUT3) \
+    X(PIN_LIGHT_OUT4) X(PIN_SERIAL_OUT) BOARD_SERVO_GPIOS(X)
+
+// A list has no duplicates when the sum of its pin bits equals their OR
+#define BOARD_PIN_OR(p) | (1ULL << (p))
+#define BOARD_PIN_SUM(p) + (1ULL << (p))
+#define BOARD_PIN_MASK(list) (0ULL list(BOARD_PIN_OR))
+#define BOARD_PINS_DISTINCT(list) ((0ULL list(BOARD_PIN_SUM)) == BOARD_PIN_MASK(list))
+
+_Static_assert(BOARD_PINS_DISTINCT(BOARD_SENDER_PINS), "board.h: two sender functions share a GPIO");
+_Static_assert(BOARD_PINS_DISTINCT(BOARD_RECEIVER_PINS), "board.h: two receiver functions share a GPIO");
+_Static_assert((BOARD_PIN_MASK(BOARD_SENDER_PINS) & ~SOC_GPIO_VALID_GPIO_MASK) == 0,
+               "board.h: sender pin is not a GPIO of this chip");
+_Static_assert((BOARD_PIN_MASK(BOARD_RECEIVER_PINS) & ~SOC_GPIO_VALID_GPIO_MASK) == 0,
+               "board.h: receiver pin is not a GPIO of this chip");
+_Static_assert((BOARD_PIN_MASK(BOARD_OUTPUT_PINS) & ~SOC_GPIO_VALID_OUTPUT_GPIO_MASK) == 0,
+               "board.h: output on an input-only GPIO");
+_Static_assert(((BOARD_PIN_MASK(BOARD_SENDER_PINS) | BOARD_PIN_MASK(BOARD_RECEIVER_PINS)) &
+                BOARD_RESERVED_MASK) == 0,
+               "board.h: pin used by USB, flash or the console");
+_Static_assert(SERVO_PIN_MAP_LEN <= SOC_LEDC_CHANNEL_NUM, "board.h: more servo outputs than LEDC channels");
+// Stick inputs not on ADC1 fail to compile in ADC_INPUT_MAP (no ADC1_GPIOn_CHANNEL)
+
+#endif // BOARD_H
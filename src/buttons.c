@@ -0,0 +1,222 @@
+// Interrupt-driven button engine implementation
+#include "buttons.h"
+#include "common.h"
+#include "trace.h"
+#include "task_config.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "esp_sleep.h"
+
+static const char *TAG = "buttons";
+
+#define DEBOUNCE_US (BUTTON_DEBOUNCE_MS * 1000UL)
+#define LONG_US (BUTTON_LONG_MS * 1000UL)
+#define DOUBLE_US (BUTTON_DOUBLE_MS * 1000UL)
+#define NO_DEADLINE UINT32_MAX
+
+typedef struct {
+    int pin;
+    bool detect_long;
+    bool detect_double;
+    // Debounced state (button task only)
+    bool pressed;
+    uint32_t change_us;         // Time of the last accepted transition
+    uint32_t press_us;
+    uint32_t release_us;
+    bool long_sent;
+    bool click_pending;         // Released once, waiting to see if a second press follows
+    bool second_press;          // Current press is the second of a possible double press
+    bool armed;                 // Level interrupt enabled
+    // Written by the ISR
+    volatile uint32_t edge_us;
+} button_state_t;
+
+static button_state_t buttons[BUTTON_COUNT] = {
+    [BUTTON_USER]   = {.pin = PIN_USER_BUTTON, .detect_long = true, .detect_double = true},
+    [BUTTON_LIGHT1] = {.pin = PIN_LIGHT_BTN1},
+    [BUTTON_LIGHT2] = {.pin = PIN_LIGHT_BTN2},
+    [BUTTON_LIGHT3] = {.pin = PIN_LIGHT_BTN3},
+    [BUTTON_LIGHT4] = {.pin = PIN_LIGHT_BTN4},
+};
+
+static QueueHandle_t event_queue = NULL;
+static int button_count = BUTTON_COUNT;     // Buttons in use: BUTTON_USER first
+static TaskHandle_t button_task_handle = NULL;
+
+// Registered without ESP_INTR_FLAG_IRAM, so it may call into the GPIO driver
+static void button_isr(void *arg) {
+    int idx = (int)(intptr_t)arg;
+    // Level interrupt: keep it off until the button task has debounced and re-armed it
+    gpio_intr_disable(buttons[idx].pin);
+    buttons[idx].edge_us = (uint32_t)esp_timer_get_time();
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(button_task_handle, 1UL << idx, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void post(int idx, button_event_type_t type, uint32_t edge_us) {
+    TRACE(TRACE_EV_BUTTON, idx, type);
+    button_event_t ev = {
+        .button = (uint8_t)idx,
+        .type = (uint8_t)type,
+        .edge_us = edge_us,
+    };
+    if (xQueueSend(event_queue, &ev, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Event queue full, dropped event %d for button %d", type, idx);
+    }
+}
+
+// Enable the interrupt for the level that ends the current debounced state.
+// gpio_wakeup_enable() sets the same level trigger and also makes it a light sleep wake-up source.
+static void arm(button_state_t *b) {
+    gpio_int_type_t level = b->pressed ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL;
+    gpio_wakeup_enable(b->pin, level);
+    gpio_intr_enable(b->pin);
+    b->armed = true;
+}
+
+static void wait_at_most(uint32_t *deadline, uint32_t us) {
+    if (us < *deadline) {
+        *deadline = us;
+    }
+}
+
+// Advance one button's state machine. fired is set when this button's ISR ran
+// (and disabled its interrupt). Returns via *deadline the time until this
+// button next needs attention (NO_DEADLINE if idle).
+static void service(int idx, bool fired, uint32_t now, uint32_t *deadline) {
+    button_state_t *b = &buttons[idx];
+    bool level_pressed = gpio_get_level(b->pin) == 0;   // Active-low
+    uint32_t since_change = now - b->change_us;
+    if (fired) {
+        b->armed = false;
+    }
+
+    if (level_pressed != b->pressed && since_change >= DEBOUNCE_US) {
+        // Use the ISR edge time when it belongs to this transition
+        uint32_t edge = (now - b->edge_us < DEBOUNCE_US) ? b->edge_us : now;
+        b->pressed = level_pressed;
+        b->change_us = now;
+        since_change = 0;
+
+        if (b->pressed) {
+            b->press_us = now;
+            b->long_sent = false;
+            if (b->click_pending && now - b->release_us <= DOUBLE_US) {
+                b->second_press = true;
+            }
+            b->click_pending = false;
+            post(idx, BUTTON_EVENT_PRESS, edge);
+        } else if (!b->long_sent) {
+            if (b->second_press) {
+                b->second_press = false;
+                post(idx, BUTTON_EVENT_DOUBLE, edge);
+            } else if (b->detect_double) {
+                b->click_pending = true;
+                b->release_us = now;
+            } else {
+                post(idx, BUTTON_EVENT_SHORT, edge);
+            }
+        } else {
+            b->second_press = false;
+        }
+    }
+
+    // Inside the debounce window: re-sample when it closes in case the
+    // final level differs from the one accepted on the leading edge.
+    // Outside it, wait for the level that ends the current state.
+    if (since_change < DEBOUNCE_US) {
+        wait_at_most(deadline, DEBOUNCE_US - since_change);
+    } else if (!b->armed) {
+        arm(b);
+    }
+
+    if (b->pressed && b->detect_long && !b->long_sent) {
+        uint32_t held = now - b->press_us;
+        if (held >= LONG_US) {
+            b->long_sent = true;
+            b->second_press = false;
+            post(idx, BUTTON_EVENT_LONG, b->press_us);
+        } else {
+            wait_at_most(deadline, LONG_US - held);
+        }
+    }
+
+    if (b->click_pending) {
+        uint32_t waited = now - b->release_us;
+        if (waited > DOUBLE_US) {
+            b->click_pending = false;
+            post(idx, BUTTON_EVENT_SHORT, b->release_us);
+        } else {
+            wait_at_most(deadline, DOUBLE_US - waited + 1);
+        }
+    }
+}
+
+static void button_task(void *arg) {
+    uint32_t deadline = NO_DEADLINE;
+    while (1) {
+        TickType_t wait = portMAX_DELAY;
+        if (deadline != NO_DEADLINE) {
+            wait = pdMS_TO_TICKS((deadline + 999) / 1000);
+            if (wait == 0) wait = 1;
+        }
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, wait);
+
+        uint32_t now = (uint32_t)esp_timer_get_time();
+        deadline = NO_DEADLINE;
+        for (int i = 0; i < button_count; i++) {
+            service(i, (bits & (1UL << i)) != 0, now, &deadline);
+        }
+    }
+}
+
+esp_err_t buttons_init(QueueHandle_t queue, bool light_buttons) {
+    event_queue = queue;
+    button_count = light_buttons ? BUTTON_COUNT : BUTTON_LIGHT1;
+
+    uint64_t mask = 0;
+    for (int i = 0; i < button_count; i++) {
+        mask |= 1ULL << buttons[i].pin;
+    }
+    gpio_config_t io = {
+        .pin_bit_mask = mask,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = 1,
+        .pull_down_en = 0,
+        .intr_type = GPIO_INTR_DISABLE,     // Armed per button by arm()
+    };
+    esp_err_t err = gpio_config(&io);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    for (int i = 0; i < button_count; i++) {
+        buttons[i].pressed = gpio_get_level(buttons[i].pin) == 0;
+        buttons[i].change_us = now - DEBOUNCE_US;
+    }
+
+    if (xTaskCreatePinnedToCore(button_task, "buttons", TASK_STACK_BUTTONS, NULL, TASK_PRIO_BUTTONS,
+                                &button_task_handle, TASK_CORE_RADIO) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {   // Already installed is fine
+        return err;
+    }
+    for (int i = 0; i < button_count; i++) {
+        err = gpio_isr_handler_add(buttons[i].pin, button_isr, (void *)(intptr_t)i);
+        if (err != ESP_OK) {
+            return err;
+        }
+        arm(&buttons[i]);
+    }
+    esp_sleep_enable_gpio_wakeup();
+    ESP_LOGI(TAG, "%d button(s) initialized (interrupt-driven, %d ms debounce)", button_count, BUTTON_DEBOUNCE_MS);
+    return ESP_OK;
+}
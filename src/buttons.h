@@ -0,0 +1,50 @@
+// Interrupt-driven button engine
+// Level-triggered GPIO interrupts wake a button task that debounces each input
+// (leading edge is accepted immediately, the interrupt stays off for
+// BUTTON_DEBOUNCE_MS, then it is re-armed for the opposite level) and classifies
+// presses. Events go to a queue; the task sleeps indefinitely while no button
+// is active, so there is no periodic polling. Level triggering also lets the
+// buttons wake the chip from light sleep.
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef enum {
+    BUTTON_USER = 0,            // Boot button: long press toggles the webserver
+    BUTTON_LIGHT1,
+    BUTTON_LIGHT2,
+    BUTTON_LIGHT3,
+    BUTTON_LIGHT4,
+    BUTTON_COUNT
+} button_id_t;
+
+typedef enum {
+    BUTTON_EVENT_PRESS = 0,     // Debounced press edge, sent immediately
+    BUTTON_EVENT_SHORT,         // Released before BUTTON_LONG_MS (after the double-press window if enabled)
+    BUTTON_EVENT_LONG,          // Held for BUTTON_LONG_MS, sent while still held
+    BUTTON_EVENT_DOUBLE,        // Second short press within BUTTON_DOUBLE_MS of the first release
+} button_event_type_t;
+
+#define BUTTON_DEBOUNCE_MS 20
+#define BUTTON_LONG_MS 3000
+#define BUTTON_DOUBLE_MS 300
+#define BUTTON_QUEUE_LEN 8
+
+typedef struct {
+    uint8_t button;             // button_id_t
+    uint8_t type;               // button_event_type_t
+    uint32_t edge_us;           // esp_timer time of the GPIO edge that caused the event
+} button_event_t;
+
+// Configure the button GPIOs, install the level interrupts and start the button
+// task. Events are posted to queue (button_event_t items, never blocking).
+// Without light_buttons only BUTTON_USER is set up (receiver: the light button
+// GPIOs may be in use by its outputs, see board.h).
+esp_err_t buttons_init(QueueHandle_t queue, bool light_buttons);
+
+#endif // BUTTONS_H
@@ -0,0 +1,90 @@
+// Stick calibration tracker implementation
+#include "calibration.h"
+#include <string.h>
+
+static void publish(calib_tracker_t *t) {
+    __atomic_store_n(&t->seq, t->seq + 1, __ATOMIC_RELEASE);   // odd: writing
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    t->pub.phase = t->phase;
+    t->pub.samples = t->samples;
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        t->pub.min[i] = t->min[i];
+        t->pub.max[i] = t->max[i];
+        t->pub.last[i] = t->last[i];
+        t->pub.center[i] = t->center_count
+            ? (uint16_t)((t->center_sum[i] + t->center_count / 2) / t->center_count)
+            : t->last[i];
+    }
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    __atomic_store_n(&t->seq, t->seq + 1, __ATOMIC_RELEASE);   // even: stable
+}
+
+void calib_tracker_start(calib_tracker_t *t) {
+    t->phase = CALIB_CENTER;
+    t->samples = 0;
+    t->center_count = 0;
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        t->center_sum[i] = 0;
+        t->min[i] = UINT16_MAX;
+        t->max[i] = 0;
+        t->last[i] = 0;
+    }
+    publish(t);
+}
+
+void calib_tracker_set_phase(calib_tracker_t *t, calib_phase_t phase) {
+    t->phase = (uint8_t)phase;
+}
+
+void calib_tracker_feed(calib_tracker_t *t, const uint16_t *raw) {
+    uint8_t phase = t->phase;
+    if (phase == CALIB_IDLE) {
+        return;
+    }
+
+    bool sum_center = (phase == CALIB_CENTER) && (t->center_count < CALIB_CENTER_MAX_SAMPLES);
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        uint16_t v = raw[i];
+        if (v < t->min[i]) t->min[i] = v;
+        if (v > t->max[i]) t->max[i] = v;
+        t->last[i] = v;
+        if (sum_center) t->center_sum[i] += v;
+    }
+    if (sum_center) t->center_count++;
+    t->samples++;
+
+    if ((t->samples % CALIB_PUBLISH_INTERVAL) == 0) {
+        publish(t);
+    }
+}
+
+void calib_tracker_read(const calib_tracker_t *t, calib_snapshot_t *out) {
+    uint32_t s0, s1;
+    do {
+        s0 = __atomic_load_n(&t->seq, __ATOMIC_ACQUIRE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        memcpy(out, (const void *)&t->pub, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        s1 = __atomic_load_n(&t->seq, __ATOMIC_ACQUIRE);
+    } while ((s0 & 1) || s0 != s1);
+}
+
+uint32_t calib_apply(const calib_snapshot_t *snap, device_settings_t *settings) {
+    uint32_t applied = 0;
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        if (snap->max[i] < snap->min[i] || (snap->max[i] - snap->min[i]) < CALIB_MIN_SPAN) {
+            continue; // Channel not moved (or not sampled): keep previous calibration
+        }
+        uint16_t center = snap->center[i];
+        if (center <= snap->min[i] || center >= snap->max[i]) {
+            center = (uint16_t)((snap->min[i] + snap->max[i] + 1) / 2);
+        }
+        settings->ch_min[i] = snap->min[i];
+        settings->ch_center[i] = center;
+        settings->ch_max[i] = snap->max[i];
+        applied |= (1u << i);
+    }
+    return applied;
+}
@@ -0,0 +1,68 @@
+// Interactive stick calibration capture (running min/max/center per channel)
+// The tracker is fed from the ADC sampling loop and publishes snapshots through
+// a sequence counter, so readers (web UI) never block the sampler.
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "settings.h"
+
+#define CALIB_PUBLISH_INTERVAL 16       // Publish a snapshot every N samples
+#define CALIB_CENTER_MAX_SAMPLES 65536  // Cap on samples averaged for center
+#define CALIB_MIN_SPAN 256              // Minimum max-min travel for a channel to be accepted
+
+typedef enum {
+    CALIB_IDLE = 0,         // Not capturing
+    CALIB_CENTER = 1,       // Sticks at rest: average center, track min/max
+    CALIB_RANGE = 2,        // Sticks moved through full travel: track min/max
+} calib_phase_t;
+
+// Published progress (copied out by readers)
+typedef struct {
+    uint8_t phase;                      // calib_phase_t
+    uint32_t samples;                   // Frames fed since start
+    uint16_t min[NUM_CHANNELS];
+    uint16_t center[NUM_CHANNELS];
+    uint16_t max[NUM_CHANNELS];
+    uint16_t last[NUM_CHANNELS];        // Most recent raw value
+} calib_snapshot_t;
+
+typedef struct {
+    volatile uint8_t phase;             // Set by controller, read by sampler
+    // Sampler-owned running state
+    uint32_t samples;
+    uint32_t center_count;
+    uint32_t center_sum[NUM_CHANNELS];
+    uint16_t min[NUM_CHANNELS];
+    uint16_t max[NUM_CHANNELS];
+    uint16_t last[NUM_CHANNELS];
+    // Published snapshot (seqlock: odd sequence = write in progress)
+    volatile uint32_t seq;
+    calib_snapshot_t pub;
+} calib_tracker_t;
+
+// Reset running state and enter CALIB_CENTER
+void calib_tracker_start(calib_tracker_t *t);
+
+// Change phase (safe to call while the sampler is feeding)
+void calib_tracker_set_phase(calib_tracker_t *t, calib_phase_t phase);
+
+// Feed one frame of raw samples (sampler context only)
+void calib_tracker_feed(calib_tracker_t *t, const uint16_t *raw);
+
+// Copy the latest published snapshot; never blocks the sampler
+void calib_tracker_read(const calib_tracker_t *t, calib_snapshot_t *out);
+
+// Write captured min/center/max into settings for every channel with enough
+// travel. Returns a bit mask of the channels that were applied.
+uint32_t calib_apply(const calib_snapshot_t *snap, device_settings_t *settings);
+
+// Capture control (implemented in sender.c, which owns the ADC)
+bool sender_calibration_start(void);
+void sender_calibration_set_phase(calib_phase_t phase);
+void sender_calibration_stop(void);
+bool sender_calibration_active(void);
+void sender_calibration_get(calib_snapshot_t *out);
+
+#endif // CALIBRATION_H
@@ -0,0 +1,28 @@
+// Compile-time channel configuration
+// The channel count, the per-channel I/O and the control frame layout follow
+// from this file. Select the count with -D RC_NUM_CHANNELS=<n> (platformio.ini
+// build_flags, or idf.py -DRC_NUM_CHANNELS=<n>); 6 (default), 8, 12 and 16 are
+// the tested builds.
+// Both devices of a link must be built with the same count.
+// Board-independent: the per-board channel limits are in board.h.
+#ifndef CHANNEL_CONFIG_H
+#define CHANNEL_CONFIG_H
+
+#ifndef RC_NUM_CHANNELS
+#define RC_NUM_CHANNELS 6
+#endif
+#if RC_NUM_CHANNELS < 1 || RC_NUM_CHANNELS > 16
+#error "RC_NUM_CHANNELS must be 1..16 (SBUS/CRSF carry at most 16 channels)"
+#endif
+
+#define NUM_CHANNELS RC_NUM_CHANNELS    // Number of proportional channels
+#define NUM_LIGHTS 4                    // Number of light outputs
+
+// Control frame on air: channels bit-packed at 12 bits (two channels in three
+// bytes, see rc_pack_12bit()), then the lights byte.
+// 6 channels: 10 bytes, 8: 13, 12: 19, 16: 25.
+#define CONTROL_CH_BITS 12
+#define CONTROL_CH_BYTES ((NUM_CHANNELS * CONTROL_CH_BITS + 7) / 8)
+#define CONTROL_WIRE_LEN (CONTROL_CH_BYTES + 1)
+
+#endif // CHANNEL_CONFIG_H
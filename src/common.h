@@ -5,10 +5,14 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "freertos/FreeRTOS.h"
+#include "board.h"
+#include "rc_protocol.h"
+#include "control_packet.h"
+#include "event_frame.h"
+#include "frame_rate.h"
+#include "tx_pipeline.h"
 
 // System configuration (must be defined before settings.h)
-#define NUM_CHANNELS 6             // Number of proportional channels
-#define NUM_LIGHTS 4               // Number of light outputs
 #define PEER_MAC_LEN 6             // MAC address length
 #define PEER_MAC_BROADCAST 0xFF    // Broadcast MAC value
 
@@ -27,57 +31,35 @@
 #define ESPNOW_LMK "lmk1234567890"
 #endif
 
-// LOLIN S2 Mini Pin Definitions
-#define PIN_USER_BUTTON 0       // GPIO0 - User button (active-low, boot button)
-#define PIN_LED 15              // GPIO15 - Status LED
-
-// Light control buttons (GPIO pins for 4 light channels)
-#define PIN_LIGHT_BTN1 6        // GPIO6 - Light 1 button
-#define PIN_LIGHT_BTN2 7        // GPIO7 - Light 2 button
-#define PIN_LIGHT_BTN3 8        // GPIO8 - Light 3 button
-#define PIN_LIGHT_BTN4 9        // GPIO9 - Light 4 button
-
-// Light output pins
-#define PIN_LIGHT_OUT1 10       // GPIO10 - Light 1 output
-#define PIN_LIGHT_OUT2 11       // GPIO11 - Light 2 output
-#define PIN_LIGHT_OUT3 12       // GPIO12 - Light 3 output
-#define PIN_LIGHT_OUT4 13       // GPIO13 - Light 4 output
-
-// ADC channels (ESP32-S2 has ADC1 and ADC2)
-// Common ADC pins on S2 Mini: GPIO1-GPIO10 (ADC1), GPIO11-GPIO20 (ADC2)
-// Proportional output pins (PWM via LEDC) - 6 channels
-#define PIN_SERVO_CH1 4    // GPIO4  - Proportional CH1 PWM
-#define PIN_SERVO_CH2 5    // GPIO5  - Proportional CH2 PWM
-#define PIN_SERVO_CH3 12   // GPIO12 - Proportional CH3 PWM
-#define PIN_SERVO_CH4 13   // GPIO13 - Proportional CH4 PWM
-#define PIN_SERVO_CH5 14   // GPIO14 - Proportional CH5 PWM
-#define PIN_SERVO_CH6 11   // GPIO11 - Proportional CH6 PWM
+// Pin assignments: see board.h (per board, selected at build time)
 
 // Servo parameters
-#define SERVO_FREQ_HZ 50           // 20 ms period
+#define SERVO_FREQ_HZ 50           // 20 ms period (default frame rate)
 #define SERVO_US_MIN 1000          // 1.0 ms
 #define SERVO_US_CENTER 1500       // 1.5 ms
 #define SERVO_US_MAX 2000          // 2.0 ms
 
 // ADC configuration
 #define ADC_MAX_VALUE 4095         // 12-bit ADC
+#define ADC_CENTER_VALUE 2048      // Stick center in packet units
 #define ADC_NORMALIZE 4095.0f      // For normalization
 
 // Connection timeout
 #define CONNECTION_TIMEOUT_MS 1000 // Timeout for connection loss
 
-// Data packet sent via ESP-NOW
-typedef struct __attribute__((packed)) {
-    uint16_t ch[NUM_CHANNELS];  // Proportional channels: 0..4095 (0-100%)
-    uint8_t lights;             // bit 0-3: light states, bit 4-7: reserved
-} control_packet_t;
-
 // Role enum for runtime selection
 typedef enum {
     ROLE_RECEIVER = 0,
     ROLE_SENDER = 1
 } device_role_t;
 
+// Single-role images (board.h) always run their role, whatever is stored
+#if !RC_ROLE_RECEIVER
+#define ROLE_FIXED ROLE_SENDER
+#elif !RC_ROLE_SENDER
+#define ROLE_FIXED ROLE_RECEIVER
+#endif
+
 // Connection status
 typedef struct {
     bool connected;          // Is peer connected
@@ -93,13 +75,40 @@ void common_espnow_init(void);
 connection_status_t get_connection_status(void);
 void update_connection_status(bool connected, int8_t rssi);
 
-// Receiver feedback
+#if RC_ROLE_RECEIVER
+// Receiver
+void receiver_start(void);
+void receiver_stop(void);
 control_packet_t get_last_control_packet(void);
 void get_servo_positions(uint16_t *positions); // Get servo positions in microseconds for all channels
 void receiver_set_settings(device_settings_t *settings); // Update receiver with servo/expo settings
+void receiver_get_light_latency(uint32_t *last_us, uint32_t *max_us); // Packet arrival to light GPIO update
+void receiver_prepare_profile(int slot, const device_settings_t *settings); // Precompile a model profile (profiles.h)
+esp_err_t receiver_select_profile(int slot, const uint8_t *peer_mac, bool peer_bound); // Publish a precompiled profile
+#endif
+
+#if RC_ROLE_SENDER
+// Sender
+void sender_start(const uint8_t *peer_mac);
+void sender_stop(void);
+void sender_set_settings(const device_settings_t *settings); // Update sender input conditioning (calibration, deadband, filter, trim)
+void sender_set_light_states(uint8_t states, uint32_t event_us); // Sends an event frame immediately; event_us = button edge time (esp_timer)
+void sender_get_light_latency(uint32_t *last_us, uint32_t *max_us); // Button edge to first event frame
+bool sender_link_verified(void); // The receiver answered this run: MAC ack to the bound peer or an authenticated ack/resync
+void sender_get_event_stats(event_stats_t *out); // Event frame counters and button-to-ack latency (event_frame.h)
+void sender_get_rate_stats(frame_rate_stats_t *out); // Adaptive frame rate state (frame_rate.h)
+int sender_rate_console_cmd(int argc, char **argv); // "rate": frame rate, ceiling and send results
+void sender_get_tx_stats(tx_pipeline_stats_t *out); // Transmit pipeline: send latency, queue depth, held-back frames (tx_pipeline.h)
+int sender_tx_console_cmd(int argc, char **argv); // "tx": transmit pipeline statistics
+void sender_prepare_profile(int slot, const device_settings_t *settings); // Precompile a model profile (profiles.h)
+esp_err_t sender_select_profile(int slot, const uint8_t *peer_mac); // Publish a precompiled profile and re-target the peer
+bool sender_scope_start(uint16_t rate_hz); // Sample sticks and conditioning into the scope ring (scope.h), sender stopped
+void sender_scope_stop(void);
+bool sender_scope_active(void);
+#endif
 
 // Utility functions
-uint32_t servo_us_to_duty(uint32_t us);
+uint32_t servo_us_to_duty(uint32_t us, uint32_t freq_hz, uint8_t resolution_bits);
 uint32_t map_adc_to_us(uint16_t adc_raw, float scale);
 uint32_t map_adc_to_us_custom(uint16_t adc_raw, float expo, uint16_t srv_min, uint16_t srv_center, uint16_t srv_max);
 
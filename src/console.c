@@ -0,0 +1,112 @@
+// Serial console implementation
+#include "console.h"
+#include "perf.h"
+#include "trace.h"
+#include "link_auth.h"
+#include "profiles.h"
+#include "blackbox.h"
+#include "common.h"
+#include "task_config.h"
+#include "esp_log.h"
+#include "esp_console.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+
+static const char *TAG = "console";
+
+static const esp_console_cmd_t commands[] = {
+    {
+        .command = "perf",
+        .help = "Task CPU and stack, heap and hot-path timing. 'perf reset' clears the histograms, "
+                "'perf load <percent>' runs a load task at the httpd priority",
+        .hint = "[reset | load <percent>]",
+        .func = &perf_console_cmd,
+    },
+    {
+        .command = "trace",
+        .help = "Dump the event trace as hex for tools/trace2perfetto.py. 'trace clear' empties it",
+        .hint = "[clear]",
+        .func = &trace_console_cmd,
+    },
+    {
+        .command = "link",
+        .help = "Link security mode and frame counters. 'link bench [n]' times n tag/verify pairs",
+        .hint = "[bench [n]]",
+        .func = &link_auth_console_cmd,
+    },
+    {
+        .command = "profile",
+        .help = "List model profiles, switch to <n>, save the current model to <n> or delete <n>",
+        .hint = "[<n> | save <n> [name] | delete <n>]",
+        .func = &profiles_console_cmd,
+    },
+#if RC_ROLE_SENDER
+    {
+        .command = "rate",
+        .help = "Sender frame rate: current rate and bounds, congestion ceiling, input velocity and send results",
+        .hint = NULL,
+        .func = &sender_rate_console_cmd,
+    },
+    {
+        .command = "tx",
+        .help = "Sender transmit pipeline: send-to-callback latency, frames in flight, held-back and replaced frames",
+        .hint = NULL,
+        .func = &sender_tx_console_cmd,
+    },
+#endif
+#if RC_ROLE_RECEIVER
+    {
+        .command = "blackbox",
+        .help = "Dump the receiver flight recorder as hex for tools/blackbox_decode.py. "
+                "'blackbox info' shows usage and rate, 'blackbox clear' erases it",
+        .hint = "[info | clear]",
+        .func = &blackbox_console_cmd,
+    },
+#endif
+};
+
+esp_err_t console_start(void) {
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = "radio>";
+    repl_config.task_priority = TASK_PRIO_CONSOLE;
+    repl_config.task_stack_size = TASK_STACK_CONSOLE;
+    esp_err_t err;
+#if CONFIG_ESP_CONSOLE_UART_DEFAULT || CONFIG_ESP_CONSOLE_UART_CUSTOM
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    err = esp_console_new_repl_uart(&hw_config, &repl_config, &repl);
+#elif CONFIG_ESP_CONSOLE_USB_CDC
+    esp_console_dev_usb_cdc_config_t hw_config = ESP_CONSOLE_DEV_CDC_CONFIG_DEFAULT();
+    err = esp_console_new_repl_usb_cdc(&hw_config, &repl_config, &repl);
+#elif CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    esp_console_dev_usb_serial_jtag_config_t hw_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    err = esp_console_new_repl_usb_serial_jtag(&hw_config, &repl_config, &repl);
+#else
+    err = ESP_ERR_NOT_SUPPORTED;
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Serial console not started: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        ESP_ERROR_CHECK(esp_console_cmd_register(&commands[i]));
+    }
+    err = esp_console_start_repl(repl);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Serial console started, type 'help' for commands");
+    }
+    return err;
+}
+
+bool console_print_hex(void *ctx, const void *data, size_t len) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i += CONSOLE_HEX_LINE) {
+        size_t n = (len - i < CONSOLE_HEX_LINE) ? len - i : CONSOLE_HEX_LINE;
+        for (size_t j = 0; j < n; j++) {
+            printf("%02x", p[i + j]);
+        }
+        printf("\n");
+    }
+    return true;
+}
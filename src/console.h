@@ -0,0 +1,20 @@
+// Serial console (esp_console REPL on the configured console port)
+// Diagnostic commands: "perf" (perf.h), "trace" (trace.h) and "link" (link_auth.h).
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CONSOLE_HEX_LINE 32         // Bytes per line of a hex dump
+
+// Start the REPL task and register the commands
+esp_err_t console_start(void);
+
+// Print bytes as hex lines, the serial form of a binary dump that a host tool
+// captures between BEGIN/END markers. Always true; the signature fits
+// blackbox_dump() as the emit callback.
+bool console_print_hex(void *ctx, const void *data, size_t len);
+
+#endif // CONSOLE_H
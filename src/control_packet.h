@@ -0,0 +1,31 @@
+// Control frame payload and its on-air packing
+// Kept out of common.h so the packing builds on the host without ESP-IDF;
+// test/test_control_packet checks it at the channel count of the build and
+// the frame lengths in channel_config.h.
+#ifndef CONTROL_PACKET_H
+#define CONTROL_PACKET_H
+
+#include <stdint.h>
+#include "channel_config.h"
+#include "rc_protocol.h"
+
+// Control data; sent via ESP-NOW bit-packed to CONTROL_WIRE_LEN bytes. Lights
+// and rate share the last byte: lights in bits 0-3, rate code in bits 4-7.
+typedef struct {
+    uint16_t ch[NUM_CHANNELS];  // Proportional channels: 0..4095 (0-100%)
+    uint8_t lights;             // bit 0-3: light states
+    uint8_t rate;               // Sender frame rate code (frame_rate.h), 0 = not signalled
+} control_packet_t;
+
+static inline void control_packet_pack(const control_packet_t *pkt, uint8_t *out) {
+    rc_pack_12bit(pkt->ch, NUM_CHANNELS, out);
+    out[CONTROL_CH_BYTES] = (uint8_t)((pkt->lights & 0x0F) | (pkt->rate << 4));
+}
+
+static inline void control_packet_unpack(const uint8_t *in, control_packet_t *pkt) {
+    rc_unpack_12bit(in, NUM_CHANNELS, pkt->ch);
+    pkt->lights = in[CONTROL_CH_BYTES] & 0x0F;
+    pkt->rate = in[CONTROL_CH_BYTES] >> 4;
+}
+
+#endif // CONTROL_PACKET_H
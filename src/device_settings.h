@@ -0,0 +1,72 @@
+// Persistent device configuration (stored by settings.c)
+// Kept apart from settings.h, which needs ESP-IDF for NVS, so the modules
+// compiled from it (input_pipeline, mixer, output_stage) also build on the host.
+#ifndef DEVICE_SETTINGS_H
+#define DEVICE_SETTINGS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "channel_config.h"
+
+// Forward declarations (defined in common.h)
+#ifndef PEER_MAC_LEN
+#define PEER_MAC_LEN 6
+#endif
+#ifndef LINK_KEY_LEN
+#define LINK_KEY_LEN 16
+#endif
+
+// Config access point WPA2 passphrase (see webserver.c)
+#define AP_PASSWORD_MIN 8
+#define AP_PASSWORD_MAX 63
+#define AP_PASSWORD_DEFAULT "radio-control"
+
+typedef struct {
+    uint8_t peer_mac[PEER_MAC_LEN];          // Target peer MAC address
+    bool peer_bound;                         // peer_mac came from bind (or was entered): receiver accepts only it
+    uint8_t peer_num_channels;               // Peer capabilities reported during bind (see bind.h)
+    uint16_t peer_caps;                      // BIND_CAP_* flags of the peer
+    uint8_t channel;              // ESP-NOW channel (1-13)
+    uint16_t ch_min[NUM_CHANNELS];           // Min ADC value for each proportional channel
+    uint16_t ch_max[NUM_CHANNELS];           // Max ADC value for each proportional channel
+    uint16_t ch_center[NUM_CHANNELS];        // Center (rest) ADC value for each proportional channel
+    // Per-channel sender input conditioning (see input_pipeline.h)
+    uint16_t ch_deadband[NUM_CHANNELS];      // Center deadband half-width (ADC counts)
+    int16_t ch_trim[NUM_CHANNELS];           // Trim offset (ADC counts, +/-)
+    uint8_t ch_filter[NUM_CHANNELS];         // Input filter (input_filter_t: 0=off, 1=low-pass, 2=median3, 3=median5)
+    uint8_t ch_filter_strength[NUM_CHANNELS]; // Low-pass strength (1-6, alpha = 1/2^n)
+    bool ch_reverse[NUM_CHANNELS];           // Reverse channel direction
+    uint8_t input_source;                    // Sender channel source (input_source_t: 0=ADC, 1=trainer PPM, 2=trainer SBUS)
+    // Sender frame rate (see frame_rate.h)
+    uint16_t rate_min_hz;                    // Keepalive rate while the sticks are still (10-300 Hz)
+    uint16_t rate_max_hz;                    // Rate for fast stick movement, and the stick sampling rate
+    // Per-channel servo configuration
+    uint16_t servo_min[NUM_CHANNELS];        // Minimum servo position (µs) for each channel
+    uint16_t servo_center[NUM_CHANNELS];     // Center servo position (µs) for each channel
+    uint16_t servo_max[NUM_CHANNELS];        // Maximum servo position (µs) for each channel
+    uint16_t ch_pwm_hz[NUM_CHANNELS];        // Servo frame rate (50/200/333/560 Hz), channels with equal rates share an LEDC timer
+    // Per-channel expo (input-side S-curve, like Betaflight)
+    float expo[NUM_CHANNELS];                // Expo value (0.0-1.0) for each channel, 0=linear, 1=strong S-curve
+    // Receiver output stage (see output_stage.h)
+    uint16_t output_rate_hz;                 // Timer-driven output rate (50-500 Hz), 0 = update on frame arrival
+    bool output_extrapolate;                 // Extrapolate across a single lost frame
+    uint16_t ch_slew[NUM_CHANNELS];          // Slew-rate limit (µs per second), 0 = unlimited
+    // Receiver serial output (see serial_output.h)
+    uint8_t serial_proto;                    // serial_proto_t: 0=off, 1=SBUS, 2=CRSF, 3=PPM
+    uint16_t serial_rate_hz;                 // Serial frame rate, 0 = protocol default
+    // Power management (see power.h)
+    uint8_t power_mode;                      // power_mode_t: 0=performance, 1=DFS, 2=DFS + light sleep
+    uint16_t power_budget_us;                // Extra latency tolerated when waking from idle
+    // Link security (see link_auth.h)
+    uint8_t link_security;                   // link_security_t: 0=off, 1=HMAC tag, 2=ESP-NOW encryption
+    uint8_t link_key[LINK_KEY_LEN];          // Shared key, all zero = not provisioned; also signs OTA images
+    char ap_password[AP_PASSWORD_MAX + 1];   // Config access point passphrase (8-63 characters)
+    // Receiver channel mixer (see mixer.h)
+    uint8_t mix_preset;                      // mix_preset_t: 0=identity, 1=custom, 2=tank, 3=elevon, 4=V-tail
+    int8_t mix_weight[NUM_CHANNELS][NUM_CHANNELS]; // Custom matrix: output x input weight in percent (-125..125)
+    int8_t mix_offset[NUM_CHANNELS];         // Custom per-output offset in percent of half range
+    uint8_t device_role;          // 0=receiver, 1=sender
+    bool is_configured;           // Has been configured at least once
+} device_settings_t;
+
+#endif // DEVICE_SETTINGS_H
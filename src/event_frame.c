@@ -0,0 +1,78 @@
+// Event frame implementation
+#include "event_frame.h"
+#include <string.h>
+
+_Static_assert(sizeof(event_msg_t) == 8, "event_msg_t is a wire format");
+
+void event_msg_init(event_msg_t *msg, event_msg_type_t type, uint16_t seq, uint8_t lights) {
+    memset(msg, 0, sizeof(*msg));
+    msg->magic[0] = EVENT_MAGIC0;
+    msg->magic[1] = EVENT_MAGIC1;
+    msg->type = (uint8_t)type;
+    msg->lights = lights;
+    msg->seq = seq;
+}
+
+bool event_msg_valid(const event_msg_t *msg, event_msg_type_t type) {
+    return msg->magic[0] == EVENT_MAGIC0 && msg->magic[1] == EVENT_MAGIC1 && msg->type == type;
+}
+
+void event_tx_init(event_tx_t *tx, uint16_t first_seq) {
+    memset(tx, 0, sizeof(*tx));
+    tx->seq = first_seq;
+}
+
+void event_tx_post(event_tx_t *tx, uint8_t lights, uint32_t event_us, uint32_t now_us) {
+    if (tx->pending && tx->sends > 0) {
+        tx->stats.superseded++;
+    }
+    tx->pending = true;
+    tx->lights = lights;
+    tx->seq++;
+    tx->sends = 0;
+    tx->event_us = event_us;
+    tx->due_us = now_us;
+    tx->stats.events++;
+}
+
+bool event_tx_next(event_tx_t *tx, uint32_t now_us, event_msg_t *msg) {
+    if (!tx->pending || (int32_t)(now_us - tx->due_us) < 0) {
+        return false;
+    }
+    if (tx->sends >= EVENT_MAX_SENDS) {
+        tx->pending = false;
+        tx->stats.expired++;
+        return false;
+    }
+    if (tx->sends > 0) {
+        tx->stats.retries++;
+    }
+    tx->sends++;
+    tx->stats.frames++;
+    tx->due_us = now_us + EVENT_RETRY_US;
+    event_msg_init(msg, EVENT_MSG_STATE, tx->seq, tx->lights);
+    return true;
+}
+
+bool event_tx_ack(event_tx_t *tx, const event_msg_t *ack, uint32_t now_us) {
+    if (!event_msg_valid(ack, EVENT_MSG_ACK) || !tx->pending || tx->sends == 0 || ack->seq != tx->seq) {
+        return false;
+    }
+    tx->pending = false;
+    tx->stats.acked++;
+    tx->stats.ack_last_us = now_us - tx->event_us;
+    if (tx->stats.ack_last_us > tx->stats.ack_max_us) {
+        tx->stats.ack_max_us = tx->stats.ack_last_us;
+    }
+    tx->stats.apply_last_us = ack->apply_us;
+    return true;
+}
+
+bool event_tx_wait_us(const event_tx_t *tx, uint32_t now_us, uint32_t *wait_us) {
+    if (!tx->pending) {
+        return false;
+    }
+    int32_t left = (int32_t)(tx->due_us - now_us);
+    *wait_us = left > 0 ? (uint32_t)left : 0;
+    return true;
+}
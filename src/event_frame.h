@@ -0,0 +1,79 @@
+// Out-of-band event frames for discrete controls
+// A light change (the discrete state in bits 0-3 of the lights byte; bits 4-7
+// of a control frame carry the frame rate, frame_rate.h) goes out at once in a
+// small event frame instead of waiting for the next periodic control frame. The receiver
+// applies it and answers with an ack; without one the sender repeats the frame
+// every EVENT_RETRY_US, up to EVENT_MAX_SENDS frames. Each event carries the
+// whole discrete state, so a newer event replaces a pending one and the
+// periodic frames (which keep carrying the state) heal an event that was lost.
+// Has no ESP-IDF dependencies; test/test_event_frame runs the retry logic on the host.
+#ifndef EVENT_FRAME_H
+#define EVENT_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EVENT_MAGIC0 'E'
+#define EVENT_MAGIC1 'V'
+#define EVENT_RETRY_US 5000         // Ack timeout before the frame is sent again
+#define EVENT_MAX_SENDS 4           // First frame + 3 retries, all within one 20 ms frame interval
+
+typedef enum {
+    EVENT_MSG_STATE = 1,            // Sender -> receiver: discrete state changed
+    EVENT_MSG_ACK = 2,              // Receiver -> sender: state applied
+    EVENT_MSG_RESYNC = 3,           // Receiver -> sender: restarted, open a new session (link_auth.h)
+} event_msg_type_t;
+
+// Message on air, sealed by link_auth like a control frame (link_event_frame_t).
+// Never CONTROL_WIRE_LEN bytes long, so the length tells the frame types apart.
+typedef struct __attribute__((packed)) {
+    uint8_t magic[2];               // EVENT_MAGIC0, EVENT_MAGIC1
+    uint8_t type;                   // event_msg_type_t
+    uint8_t lights;                 // Discrete state (control_packet_t.lights)
+    uint16_t seq;                   // Event number; the ack echoes it
+    uint16_t apply_us;              // Ack: frame arrival to outputs written (saturating)
+} event_msg_t;
+
+typedef struct {
+    uint32_t events;                // State changes posted
+    uint32_t frames;                // Event frames sent, retries included
+    uint32_t retries;
+    uint32_t acked;
+    uint32_t expired;               // No ack after EVENT_MAX_SENDS frames
+    uint32_t superseded;            // Replaced by a newer change before it was acked
+    uint32_t ack_last_us;           // Button edge to ack (outputs written + ack airtime)
+    uint32_t ack_max_us;
+    uint32_t apply_last_us;         // Receiver side of ack_last_us (from the ack)
+} event_stats_t;
+
+// Sender retry state for the newest event
+typedef struct {
+    bool pending;                   // Sent (or due) and not acked yet
+    uint8_t lights;
+    uint16_t seq;
+    uint8_t sends;                  // Frames sent for this event
+    uint32_t event_us;              // Button edge time
+    uint32_t due_us;                // Next (re)send
+    event_stats_t stats;
+} event_tx_t;
+
+void event_msg_init(event_msg_t *msg, event_msg_type_t type, uint16_t seq, uint8_t lights);
+bool event_msg_valid(const event_msg_t *msg, event_msg_type_t type);
+
+// first_seq: random per session, so an ack from an earlier session never matches
+void event_tx_init(event_tx_t *tx, uint16_t first_seq);
+
+// New discrete state at event_us; due immediately, replaces a pending event
+void event_tx_post(event_tx_t *tx, uint8_t lights, uint32_t event_us, uint32_t now_us);
+
+// If a frame is due at now_us, fill msg, schedule the retry and return true.
+// A pending event out of sends expires here.
+bool event_tx_next(event_tx_t *tx, uint32_t now_us, event_msg_t *msg);
+
+// Match an ack; returns false for a stale or unknown one
+bool event_tx_ack(event_tx_t *tx, const event_msg_t *ack, uint32_t now_us);
+
+// Time until event_tx_next() has work; false if nothing is pending
+bool event_tx_wait_us(const event_tx_t *tx, uint32_t now_us, uint32_t *wait_us);
+
+#endif // EVENT_FRAME_H
@@ -0,0 +1,186 @@
+// Sender frame rate adaptation implementation
+#include "frame_rate.h"
+#include <string.h>
+
+// Adjacent rates differ by at most 1.5x, so stepping down one code per frame
+// never stretches the gap by more than half an announced interval
+static const uint16_t rate_table[FRAME_RATE_CODES] = {
+    0, 10, 15, 20, 25, 30, 40, 50, 60, 75, 100, 125, 150, 200, 250, 300,
+};
+
+uint16_t frame_rate_hz(uint8_t code) {
+    return code < FRAME_RATE_CODES ? rate_table[code] : 0;
+}
+
+uint32_t frame_rate_interval_us(uint8_t code) {
+    uint16_t hz = frame_rate_hz(code);
+    return hz ? 1000000u / hz : 0;
+}
+
+uint8_t frame_rate_code(uint16_t hz) {
+    for (uint8_t code = 1; code < FRAME_RATE_CODES; code++) {
+        if (rate_table[code] >= hz) {
+            return code;
+        }
+    }
+    return FRAME_RATE_CODES - 1;
+}
+
+void frame_rate_configure(frame_rate_t *fr, uint16_t min_hz, uint16_t max_hz) {
+    if (min_hz > max_hz) {
+        uint16_t t = min_hz;
+        min_hz = max_hz;
+        max_hz = t;
+    }
+    fr->min_code = frame_rate_code(min_hz);
+    fr->max_code = frame_rate_code(max_hz);
+    // The upper bound rounds down, unless that would cross the lower one
+    if (rate_table[fr->max_code] > max_hz && fr->max_code > fr->min_code) {
+        fr->max_code--;
+    }
+    frame_rate_reset(fr);
+}
+
+void frame_rate_reset(frame_rate_t *fr) {
+    fr->code = fr->max_code;
+    fr->ceiling = fr->max_code;
+    fr->have_sample = false;
+    fr->have_frame = false;
+    fr->force = false;
+    fr->velocity = 0;
+    fr->window_sent = 0;
+    fr->window_failed = 0;
+    fr->window_us = 0;
+    memset(&fr->stats, 0, sizeof(fr->stats));
+    fr->stats.min_hz = rate_table[fr->min_code];
+    fr->stats.max_hz = rate_table[fr->max_code];
+    fr->stats.ceiling_hz = rate_table[fr->ceiling];
+}
+
+void frame_rate_force(frame_rate_t *fr) {
+    fr->force = true;
+}
+
+// Fastest channel since the previous sample, with a fast attack and an
+// exponential release so a short pause in a correction keeps the rate up
+static void update_velocity(frame_rate_t *fr, const uint16_t *ch, uint32_t now_us) {
+    uint32_t v = 0;
+    if (fr->have_sample) {
+        uint32_t dt = now_us - fr->sample_us;
+        uint32_t delta = 0;
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            uint32_t d = ch[i] > fr->prev[i] ? ch[i] - fr->prev[i] : fr->prev[i] - ch[i];
+            if (d > delta) delta = d;
+        }
+        if (dt > 0 && delta > FRAME_RATE_NOISE) {
+            v = (uint32_t)((uint64_t)(delta - FRAME_RATE_NOISE) * 1000000u / dt);
+        }
+        if (dt >= FRAME_RATE_RELEASE_US) {
+            fr->velocity = 0;
+        } else {
+            fr->velocity -= (uint32_t)((uint64_t)fr->velocity * dt / FRAME_RATE_RELEASE_US);
+        }
+    }
+    if (v > fr->velocity) {
+        fr->velocity = v;
+    }
+    // Anything above the upper bound's velocity only delays the release
+    uint32_t top = (uint32_t)rate_table[fr->max_code] * FRAME_RATE_STEP;
+    if (fr->velocity > top) {
+        fr->velocity = top;
+    }
+    memcpy(fr->prev, ch, sizeof(fr->prev));
+    fr->sample_us = now_us;
+    fr->have_sample = true;
+}
+
+bool frame_rate_sample(frame_rate_t *fr, const uint16_t *ch, uint32_t now_us, uint8_t *code) {
+    fr->stats.samples++;
+    update_velocity(fr, ch, now_us);
+    fr->stats.velocity = fr->velocity;
+
+    // Rate that keeps the per-frame change near FRAME_RATE_STEP, within the bounds
+    uint32_t want_hz = (fr->velocity + FRAME_RATE_STEP - 1) / FRAME_RATE_STEP;
+    uint8_t target = frame_rate_code(want_hz > 0xFFFF ? 0xFFFF : (uint16_t)want_hz);
+    if (target > fr->ceiling) target = fr->ceiling;
+    if (target > fr->max_code) target = fr->max_code;
+    if (target < fr->min_code) target = fr->min_code;
+
+    bool due = !fr->have_frame || fr->force;
+    if (!due) {
+        // A faster target shortens the wait at once; a slower one waits out the announced interval
+        uint32_t interval = frame_rate_interval_us(target > fr->code ? target : fr->code);
+        due = now_us - fr->frame_us + FRAME_RATE_SLACK_US >= interval;
+    }
+    if (!due) {
+        return false;
+    }
+    // Slow down one step per frame, so a lost frame never hides a much longer gap
+    if (fr->have_frame && target + 1 < fr->code) {
+        target = fr->code - 1;
+    }
+    if (fr->have_frame && target != fr->code) {
+        fr->stats.changes++;
+    }
+    fr->code = target;
+    fr->frame_us = now_us;
+    fr->have_frame = true;
+    fr->force = false;
+    fr->stats.frames++;
+    fr->stats.hz = rate_table[target];
+    *code = target;
+    return true;
+}
+
+uint32_t frame_rate_wait_us(const frame_rate_t *fr, uint32_t now_us) {
+    if (!fr->have_sample) {
+        return 0;
+    }
+    uint32_t next = fr->sample_us + frame_rate_interval_us(fr->max_code);
+    if (fr->have_frame) {
+        uint32_t frame_due = fr->frame_us + frame_rate_interval_us(fr->code);
+        if ((int32_t)(frame_due - next) < 0) {
+            next = frame_due;
+        }
+    }
+    int32_t wait = (int32_t)(next - now_us);
+    return wait > 0 ? (uint32_t)wait : 0;
+}
+
+void frame_rate_tx_done(frame_rate_t *fr, uint32_t sent, uint32_t failed, uint32_t now_us) {
+    fr->stats.sent += sent;
+    fr->stats.failed += failed;
+    if (fr->window_sent == 0 && sent > 0) {
+        fr->window_us = now_us;
+    }
+    fr->window_sent = (uint16_t)(fr->window_sent + sent > 0xFFFF ? 0xFFFF : fr->window_sent + sent);
+    fr->window_failed = (uint16_t)(fr->window_failed + failed > 0xFFFF ? 0xFFFF : fr->window_failed + failed);
+    if (fr->window_sent < FRAME_RATE_WINDOW_MIN || now_us - fr->window_us < FRAME_RATE_WINDOW_US) {
+        return;
+    }
+    if ((uint32_t)fr->window_failed * 100 >= (uint32_t)fr->window_sent * FRAME_RATE_BACKOFF_PCT) {
+        // Congested: halve the ceiling (multiplicative decrease)
+        uint8_t halved = frame_rate_code((rate_table[fr->ceiling] + 1) / 2);
+        if (halved < fr->min_code) halved = fr->min_code;
+        if (halved < fr->ceiling) {
+            fr->ceiling = halved;
+            fr->stats.backoffs++;
+        }
+    } else if (fr->window_failed == 0 && fr->ceiling < fr->max_code) {
+        fr->ceiling++;      // Clean window: one step back up (additive increase)
+    }
+    fr->stats.ceiling_hz = rate_table[fr->ceiling];
+    fr->window_sent = 0;
+    fr->window_failed = 0;
+}
+
+uint32_t frame_rate_timeout_ms(uint8_t code, uint32_t max_ms) {
+    uint32_t interval = frame_rate_interval_us(code);
+    if (interval == 0) {
+        return max_ms;
+    }
+    uint32_t ms = FRAME_RATE_TIMEOUT_FRAMES * interval / 1000;
+    if (ms < FRAME_RATE_TIMEOUT_MIN_MS) ms = FRAME_RATE_TIMEOUT_MIN_MS;
+    if (ms > max_ms) ms = max_ms;
+    return ms;
+}
@@ -0,0 +1,102 @@
+// Sender frame rate adaptation
+// The sender samples its sticks at the upper rate bound and this module picks
+// which samples go out as frames. The rate follows input velocity: a fast
+// stick movement raises it at once (up to the upper bound), and as the
+// movement stops the velocity estimate decays, stepping the rate down to the
+// keepalive rate (lower bound). Send results from the send callback feed a
+// congestion ceiling: a window with many failed sends halves it, a clean
+// window raises it one step.
+// Every control frame carries a 4-bit rate code (bits 4-7 of the lights byte)
+// announcing the interval until the next frame, so the receiver scales its
+// link timeout and output interpolation to it. Code 0 means not signalled
+// (trainer input, older senders): the receiver keeps its fixed timeout and
+// measures the interval itself.
+// Time is passed in by the caller (microseconds), so the controller runs on
+// the host against stick traces (test/test_frame_rate). Has no ESP-IDF
+// dependencies.
+#ifndef FRAME_RATE_H
+#define FRAME_RATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "channel_config.h"
+
+#define FRAME_RATE_CODES 16
+#define FRAME_RATE_MIN_HZ 10            // Lowest keepalive: 10 frames within CONNECTION_TIMEOUT_MS
+#define FRAME_RATE_MAX_HZ 300
+#define FRAME_RATE_DEFAULT_MIN_HZ 10
+#define FRAME_RATE_DEFAULT_MAX_HZ 100
+
+#define FRAME_RATE_STEP 16              // Channel change per frame the rate aims for (packet units)
+#define FRAME_RATE_NOISE 4              // Change per sample ignored as ADC noise (packet units)
+#define FRAME_RATE_RELEASE_US 250000    // Time constant of the velocity decay after a movement
+#define FRAME_RATE_SLACK_US 500         // A frame due this soon goes out with the current sample
+#define FRAME_RATE_WINDOW_US 250000     // Congestion decision interval
+#define FRAME_RATE_WINDOW_MIN 4         // Send results needed for a decision
+#define FRAME_RATE_BACKOFF_PCT 25       // Failed sends in a window that halve the ceiling
+#define FRAME_RATE_TIMEOUT_FRAMES 10    // Receiver: frames missed before the link counts as lost
+#define FRAME_RATE_TIMEOUT_MIN_MS 100
+
+typedef struct {
+    uint32_t samples;                   // Input samples seen
+    uint32_t frames;                    // Samples sent as frames
+    uint32_t changes;                   // Rate code changes
+    uint32_t backoffs;                  // Ceiling reductions for congestion
+    uint32_t sent;                      // Send results counted (control and event frames)
+    uint32_t failed;
+    uint32_t velocity;                  // Input velocity estimate (packet units per second)
+    uint16_t hz;                        // Rate signalled in the last frame
+    uint16_t ceiling_hz;                // Congestion ceiling
+    uint16_t min_hz;                    // Configured bounds, as rounded to the code table
+    uint16_t max_hz;
+} frame_rate_stats_t;
+
+typedef struct {
+    uint8_t min_code;
+    uint8_t max_code;
+    uint8_t code;                       // Rate signalled in the last frame
+    uint8_t ceiling;                    // Congestion ceiling (code)
+    bool have_sample;
+    bool have_frame;
+    bool force;                         // Next sample goes out whatever the rate
+    uint16_t prev[NUM_CHANNELS];        // Previous sample
+    uint32_t sample_us;                 // Time of the previous sample
+    uint32_t frame_us;                  // Time of the previous frame
+    uint32_t velocity;                  // Peak velocity with exponential release (units/s)
+    uint32_t window_us;                 // Start of the congestion window
+    uint16_t window_sent;
+    uint16_t window_failed;
+    frame_rate_stats_t stats;
+} frame_rate_t;
+
+// Code table: rate in Hz and frame interval for a code (0 for code 0), and
+// the lowest code at or above hz (clamped to the table)
+uint16_t frame_rate_hz(uint8_t code);
+uint32_t frame_rate_interval_us(uint8_t code);
+uint8_t frame_rate_code(uint16_t hz);
+
+// Set the bounds (Hz, swapped if reversed, clamped to the table) and reset.
+// Equal bounds give a fixed rate.
+void frame_rate_configure(frame_rate_t *fr, uint16_t min_hz, uint16_t max_hz);
+
+// Clear history and statistics; the next sample goes out as a frame
+void frame_rate_reset(frame_rate_t *fr);
+
+// The next sample goes out as a frame (new configuration or peer)
+void frame_rate_force(frame_rate_t *fr);
+
+// One sample of the conditioned channels (packet units) taken at now_us.
+// Returns true if it goes out as a frame, with the rate code it carries.
+bool frame_rate_sample(frame_rate_t *fr, const uint16_t *ch, uint32_t now_us, uint8_t *code);
+
+// Time from now_us until the next sample is due: one sample interval at the
+// upper bound, or earlier if the next frame is due before that
+uint32_t frame_rate_wait_us(const frame_rate_t *fr, uint32_t now_us);
+
+// Send results since the last call (control and event frames alike)
+void frame_rate_tx_done(frame_rate_t *fr, uint32_t sent, uint32_t failed, uint32_t now_us);
+
+// Receiver: link timeout for frames carrying code, at most max_ms; max_ms for code 0
+uint32_t frame_rate_timeout_ms(uint8_t code, uint32_t max_ms);
+
+#endif // FRAME_RATE_H
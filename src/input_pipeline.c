@@ -0,0 +1,146 @@
+// Sender input conditioning pipeline implementation
+#include "input_pipeline.h"
+#include <string.h>
+
+#define OUT_HALF_LOW  ((uint32_t)ADC_CENTER_VALUE)                   // counts below center
+#define OUT_HALF_HIGH ((uint32_t)(ADC_MAX_VALUE - ADC_CENTER_VALUE)) // counts above center
+#define MIN_SPAN 16                                                  // Minimum raw span per half
+
+// Q16 gain num/den rounded up, so full deflection reaches the endpoints exactly
+static uint32_t gain_q16(uint32_t num, uint32_t den) {
+    return ((num << 16) + den - 1) / den;
+}
+
+static void compile_channel(input_channel_cfg_t *c, const device_settings_t *s, int i) {
+    uint16_t in_min = s->ch_min[i];
+    uint16_t in_max = s->ch_max[i];
+    uint16_t in_center = s->ch_center[i];
+
+    // Fall back to the full ADC range if the calibration is unusable
+    if (in_max > ADC_MAX_VALUE) in_max = ADC_MAX_VALUE;
+    if (in_min >= in_max || (in_max - in_min) < 2 * MIN_SPAN) {
+        in_min = 0;
+        in_max = ADC_MAX_VALUE;
+    }
+    if (in_center < in_min + MIN_SPAN || in_center > in_max - MIN_SPAN) {
+        in_center = (uint16_t)((in_min + in_max + 1) / 2);
+    }
+
+    c->in_min = in_min;
+    c->in_center = in_center;
+    c->in_max = in_max;
+    c->gain_low = gain_q16(OUT_HALF_LOW, (uint32_t)(in_center - in_min));
+    c->gain_high = gain_q16(OUT_HALF_HIGH, (uint32_t)(in_max - in_center));
+
+    uint16_t db = s->ch_deadband[i];
+    if (db > INPUT_DEADBAND_MAX) db = INPUT_DEADBAND_MAX;
+    c->deadband = db;
+    c->db_gain_low = gain_q16(OUT_HALF_LOW, OUT_HALF_LOW - db);
+    c->db_gain_high = gain_q16(OUT_HALF_HIGH, OUT_HALF_HIGH - db);
+
+    int16_t trim = s->ch_trim[i];
+    if (trim > INPUT_TRIM_MAX) trim = INPUT_TRIM_MAX;
+    if (trim < -INPUT_TRIM_MAX) trim = -INPUT_TRIM_MAX;
+    c->trim = trim;
+
+    c->filter = (s->ch_filter[i] <= INPUT_FILTER_MEDIAN5) ? s->ch_filter[i] : INPUT_FILTER_NONE;
+    uint8_t shift = s->ch_filter_strength[i];
+    if (shift < 1) shift = 1;
+    if (shift > INPUT_LOWPASS_SHIFT_MAX) shift = INPUT_LOWPASS_SHIFT_MAX;
+    c->lowpass_shift = shift;
+
+    c->reverse = s->ch_reverse[i];
+}
+
+void input_pipeline_configure(input_pipeline_t *p, const device_settings_t *settings) {
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        compile_channel(&p->cfg[i], settings, i);
+    }
+    input_pipeline_reset(p);
+}
+
+void input_pipeline_reset(input_pipeline_t *p) {
+    memset(p->state, 0, sizeof(p->state));
+}
+
+// Median of up to INPUT_MEDIAN_MAX samples (insertion sort on a copy)
+static uint16_t median_of(const uint16_t *w, uint8_t n) {
+    uint16_t tmp[INPUT_MEDIAN_MAX];
+    for (uint8_t i = 0; i < n; i++) {
+        uint16_t v = w[i];
+        uint8_t j = i;
+        while (j > 0 && tmp[j - 1] > v) {
+            tmp[j] = tmp[j - 1];
+            j--;
+        }
+        tmp[j] = v;
+    }
+    return tmp[n / 2];
+}
+
+static uint16_t apply_filter(const input_channel_cfg_t *c, input_channel_state_t *st, uint16_t raw) {
+    switch (c->filter) {
+    case INPUT_FILTER_LOWPASS: {
+        int32_t x = (int32_t)raw << 8;
+        if (!st->primed) {
+            st->lp_acc = x;
+            st->primed = true;
+        } else {
+            st->lp_acc += (x - st->lp_acc) >> c->lowpass_shift;
+        }
+        return (uint16_t)((st->lp_acc + 128) >> 8);
+    }
+    case INPUT_FILTER_MEDIAN3:
+    case INPUT_FILTER_MEDIAN5: {
+        uint8_t len = (c->filter == INPUT_FILTER_MEDIAN3) ? 3 : 5;
+        st->window[st->window_pos] = raw;
+        st->window_pos = (uint8_t)((st->window_pos + 1) % len);
+        if (st->window_fill < len) st->window_fill++;
+        st->primed = true;
+        return median_of(st->window, st->window_fill);
+    }
+    default:
+        return raw;
+    }
+}
+
+uint16_t input_pipeline_process_channel(input_pipeline_t *p, int ch, uint16_t raw) {
+    const input_channel_cfg_t *c = &p->cfg[ch];
+    uint16_t x = apply_filter(c, &p->state[ch], raw);
+
+    // Calibration: piecewise-linear min..center..max -> 0..CENTER..MAX
+    if (x < c->in_min) x = c->in_min;
+    if (x > c->in_max) x = c->in_max;
+    int32_t d; // signed offset from output center
+    if (x < c->in_center) {
+        uint32_t span = (uint32_t)(c->in_center - x);
+        d = -(int32_t)(((uint64_t)span * c->gain_low) >> 16);
+    } else {
+        uint32_t span = (uint32_t)(x - c->in_center);
+        d = (int32_t)(((uint64_t)span * c->gain_high) >> 16);
+    }
+
+    // Center deadband, then re-expand so the endpoints are still reachable
+    if (c->deadband) {
+        if (d < 0) {
+            uint32_t m = (uint32_t)(-d);
+            d = (m <= c->deadband) ? 0 : -(int32_t)(((m - c->deadband) * c->db_gain_low) >> 16);
+        } else {
+            uint32_t m = (uint32_t)d;
+            d = (m <= c->deadband) ? 0 : (int32_t)(((m - c->deadband) * c->db_gain_high) >> 16);
+        }
+    }
+
+    if (c->reverse) d = -d;
+
+    int32_t out = (int32_t)ADC_CENTER_VALUE + d + c->trim;
+    if (out < 0) out = 0;
+    if (out > ADC_MAX_VALUE) out = ADC_MAX_VALUE;
+    return (uint16_t)out;
+}
+
+void input_pipeline_process(input_pipeline_t *p, const uint16_t *raw, uint16_t *out) {
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        out[i] = input_pipeline_process_channel(p, i, raw[i]);
+    }
+}
@@ -0,0 +1,74 @@
+// Sender input conditioning pipeline (integer math, per-channel state)
+// Raw ADC -> filter -> calibration -> center deadband -> reverse -> trim
+// Builds without ESP-IDF; test/test_input_pipeline replays a stick trace through it.
+#ifndef INPUT_PIPELINE_H
+#define INPUT_PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "device_settings.h"
+
+// Output range of the pipeline (same scale as the raw 12-bit ADC codes in control_packet_t)
+#ifndef ADC_MAX_VALUE
+#define ADC_MAX_VALUE 4095
+#endif
+#ifndef ADC_CENTER_VALUE
+#define ADC_CENTER_VALUE 2048
+#endif
+
+#define INPUT_MEDIAN_MAX 5                        // Largest median window
+#define INPUT_LOWPASS_SHIFT_MAX 6                 // EMA alpha = 1/2^shift, 1..6
+#define INPUT_DEADBAND_MAX (ADC_CENTER_VALUE / 4) // Max deadband half-width (ADC counts)
+#define INPUT_TRIM_MAX 512                        // Max trim offset (ADC counts, +/-)
+
+typedef enum {
+    INPUT_FILTER_NONE = 0,
+    INPUT_FILTER_LOWPASS = 1,   // First-order EMA, strength = shift
+    INPUT_FILTER_MEDIAN3 = 2,   // 3-sample median (spike rejection)
+    INPUT_FILTER_MEDIAN5 = 3,   // 5-sample median
+} input_filter_t;
+
+// Compiled per-channel configuration (derived from device_settings_t)
+typedef struct {
+    uint16_t in_min;            // Calibrated raw minimum
+    uint16_t in_center;         // Calibrated raw center (stick at rest)
+    uint16_t in_max;            // Calibrated raw maximum
+    uint32_t gain_low;          // Q16: ADC_CENTER_VALUE / (in_center - in_min)
+    uint32_t gain_high;         // Q16: (ADC_MAX_VALUE - ADC_CENTER_VALUE) / (in_max - in_center)
+    uint16_t deadband;          // Half-width around center in output counts
+    uint32_t db_gain_low;       // Q16 re-expansion below center after deadband
+    uint32_t db_gain_high;      // Q16 re-expansion above center after deadband
+    int16_t trim;               // Output offset in counts
+    uint8_t filter;             // input_filter_t
+    uint8_t lowpass_shift;      // EMA strength for INPUT_FILTER_LOWPASS
+    bool reverse;               // Mirror output around center
+} input_channel_cfg_t;
+
+// Per-channel filter state
+typedef struct {
+    int32_t lp_acc;                         // EMA accumulator, Q8
+    uint16_t window[INPUT_MEDIAN_MAX];      // Median ring buffer
+    uint8_t window_pos;
+    uint8_t window_fill;
+    bool primed;                            // First sample seen
+} input_channel_state_t;
+
+typedef struct {
+    input_channel_cfg_t cfg[NUM_CHANNELS];
+    input_channel_state_t state[NUM_CHANNELS];
+} input_pipeline_t;
+
+// Compile settings into fixed-point coefficients and reset filter state.
+// Out-of-range or inconsistent settings are clamped to safe values.
+void input_pipeline_configure(input_pipeline_t *p, const device_settings_t *settings);
+
+// Clear filter state (next sample primes the filters)
+void input_pipeline_reset(input_pipeline_t *p);
+
+// Process one raw sample of one channel, returns 0..ADC_MAX_VALUE
+uint16_t input_pipeline_process_channel(input_pipeline_t *p, int ch, uint16_t raw);
+
+// Process one frame: raw[NUM_CHANNELS] -> out[NUM_CHANNELS]
+void input_pipeline_process(input_pipeline_t *p, const uint16_t *raw, uint16_t *out);
+
+#endif // INPUT_PIPELINE_H
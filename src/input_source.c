@@ -0,0 +1,319 @@
+// Sender channel sources implementation
+#include "input_source.h"
+#include "rc_protocol.h"
+#include "task_config.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "driver/uart.h"
+#include "driver/rmt_rx.h"
+#include <string.h>
+
+static const char *TAG = "input_src";
+
+#define TRAINER_UART_PORT UART_NUM_1
+#define TRAINER_UART_RX_BUF 512
+#define TRAINER_UART_QUEUE_LEN 10
+#define PPM_RX_SYMBOLS 64
+#define PPM_RX_GLITCH_NS 1000
+#define PPM_RX_SYNC_NS 2800000          // A level longer than this ends the frame (sync gap)
+
+static input_source_t active_source = INPUT_SOURCE_ADC;
+static TaskHandle_t notify_handle = NULL;
+
+// Newest frame (seqlock: odd sequence = write in progress). Single writer:
+// the RMT done ISR or the SBUS task, never both.
+static input_frame_t newest;
+static volatile uint32_t newest_seq = 0;
+
+static volatile uint32_t frames_ok = 0;
+static volatile uint32_t frames_bad = 0;
+
+// Latency window (sender task only)
+static uint32_t lat_sum = 0;
+static uint32_t lat_peak = 0;
+static uint32_t lat_count = 0;
+static uint32_t lat_avg_us = 0;
+static uint32_t lat_max_us = 0;
+
+// PPM capture
+static rmt_channel_handle_t ppm_rx_chan = NULL;
+static rmt_symbol_word_t ppm_rx_symbols[PPM_RX_SYMBOLS];
+static int ppm_last_count = 0;
+static const rmt_receive_config_t ppm_rx_cfg = {
+    .signal_range_min_ns = PPM_RX_GLITCH_NS,
+    .signal_range_max_ns = PPM_RX_SYNC_NS,
+};
+
+// SBUS capture
+static QueueHandle_t sbus_queue = NULL;
+static TaskHandle_t sbus_task_handle = NULL;
+
+static void IRAM_ATTR publish_frame(const uint16_t *us, int num_ch, uint32_t capture_us) {
+    __atomic_store_n(&newest_seq, newest_seq + 1, __ATOMIC_RELEASE);   // odd: writing
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (num_ch > NUM_CHANNELS) {
+        num_ch = NUM_CHANNELS;
+    }
+    for (int i = 0; i < num_ch; i++) {
+        newest.ch[i] = us[i];
+    }
+    newest.num_ch = (uint8_t)num_ch;
+    newest.capture_us = capture_us;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    __atomic_store_n(&newest_seq, newest_seq + 1, __ATOMIC_RELEASE);   // even: stable
+    frames_ok++;
+}
+
+bool input_source_read(input_frame_t *out) {
+    uint32_t s0, s1;
+    do {
+        s0 = __atomic_load_n(&newest_seq, __ATOMIC_ACQUIRE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        memcpy(out, &newest, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        s1 = __atomic_load_n(&newest_seq, __ATOMIC_ACQUIRE);
+    } while (s0 != s1 || (s0 & 1));
+    out->seq = s0 / 2;
+    return s0 != 0;
+}
+
+// One PPM frame ends at the sync gap; widths are pulse + space of each symbol,
+// which makes the decoder independent of the signal polarity
+static bool IRAM_ATTR ppm_rx_done_cb(rmt_channel_handle_t chan, const rmt_rx_done_event_data_t *edata, void *ctx) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    uint16_t widths[PPM_MAX_CHANNELS];
+    int n = 0;
+    for (size_t i = 0; i < edata->num_symbols && n < PPM_MAX_CHANNELS; i++) {
+        const rmt_symbol_word_t *s = &edata->received_symbols[i];
+        if (s->duration1 == 0) {
+            break;      // Sync pulse: the level after it timed out
+        }
+        widths[n++] = (uint16_t)(s->duration0 + s->duration1);
+    }
+
+    BaseType_t woken = pdFALSE;
+    uint16_t us[NUM_CHANNELS];
+    // The first frame after arming may start mid-train; require a repeated channel count
+    int num_ch = ppm_decode(widths, n, us, NUM_CHANNELS);
+    if (num_ch > 0 && n == ppm_last_count) {
+        publish_frame(us, num_ch, now);
+        if (notify_handle) {
+            vTaskNotifyGiveFromISR(notify_handle, &woken);
+        }
+    } else {
+        frames_bad++;
+    }
+    ppm_last_count = n;
+
+    rmt_receive(chan, ppm_rx_symbols, sizeof(ppm_rx_symbols), &ppm_rx_cfg);
+    return woken == pdTRUE;
+}
+
+static esp_err_t ppm_capture_start(int gpio) {
+    rmt_rx_channel_config_t cfg = {
+        .gpio_num = gpio,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = 1000000,           // 1 µs per tick
+        .mem_block_symbols = 48,
+    };
+    esp_err_t err = rmt_new_rx_channel(&cfg, &ppm_rx_chan);
+    if (err != ESP_OK) {
+        return err;
+    }
+    rmt_rx_event_callbacks_t cbs = {
+        .on_recv_done = ppm_rx_done_cb,
+    };
+    err = rmt_rx_register_event_callbacks(ppm_rx_chan, &cbs, NULL);
+    if (err == ESP_OK) {
+        err = rmt_enable(ppm_rx_chan);
+    }
+    if (err == ESP_OK) {
+        ppm_last_count = 0;
+        err = rmt_receive(ppm_rx_chan, ppm_rx_symbols, sizeof(ppm_rx_symbols), &ppm_rx_cfg);
+    }
+    if (err != ESP_OK) {
+        rmt_del_channel(ppm_rx_chan);
+        ppm_rx_chan = NULL;
+    }
+    return err;
+}
+
+static void ppm_capture_stop(void) {
+    if (ppm_rx_chan != NULL) {
+        rmt_disable(ppm_rx_chan);
+        rmt_del_channel(ppm_rx_chan);
+        ppm_rx_chan = NULL;
+    }
+}
+
+// Woken by the UART driver ISR when the RX FIFO holds a frame's worth of bytes
+// or the line goes idle after a frame (rx timeout)
+static void sbus_task(void *arg) {
+    sbus_parser_t parser;
+    sbus_parser_reset(&parser);
+    uint8_t buf[64];
+
+    while (1) {
+        uart_event_t ev;
+        if (xQueueReceive(sbus_queue, &ev, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (ev.type == UART_FIFO_OVF || ev.type == UART_BUFFER_FULL) {
+            uart_flush_input(TRAINER_UART_PORT);
+            xQueueReset(sbus_queue);
+            sbus_parser_reset(&parser);
+            frames_bad++;
+            continue;
+        }
+        if (ev.type != UART_DATA) {
+            continue;
+        }
+        uint32_t now = (uint32_t)esp_timer_get_time();
+        size_t left = ev.size;
+        while (left > 0) {
+            int n = uart_read_bytes(TRAINER_UART_PORT, buf, left < sizeof(buf) ? left : sizeof(buf), 0);
+            if (n <= 0) {
+                break;
+            }
+            left -= n;
+            for (int i = 0; i < n; i++) {
+                if (!sbus_parser_feed(&parser, buf[i])) {
+                    continue;
+                }
+                uint16_t us[NUM_CHANNELS];
+                uint8_t flags = 0;
+                if (sbus_decode(parser.buf, us, NUM_CHANNELS, &flags) && !(flags & SBUS_FLAG_FAILSAFE)) {
+                    publish_frame(us, NUM_CHANNELS, now);
+                    if (notify_handle) {
+                        xTaskNotifyGive(notify_handle);
+                    }
+                } else {
+                    frames_bad++;
+                }
+            }
+        }
+    }
+}
+
+static esp_err_t sbus_capture_start(int gpio) {
+    uart_config_t cfg = {
+        .baud_rate = 100000,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_EVEN,
+        .stop_bits = UART_STOP_BITS_2,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    esp_err_t err = uart_driver_install(TRAINER_UART_PORT, TRAINER_UART_RX_BUF, 0,
+                                        TRAINER_UART_QUEUE_LEN, &sbus_queue, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = uart_param_config(TRAINER_UART_PORT, &cfg);
+    if (err == ESP_OK) {
+        err = uart_set_pin(TRAINER_UART_PORT, UART_PIN_NO_CHANGE, gpio, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    }
+    if (err == ESP_OK) {
+        err = uart_set_line_inverse(TRAINER_UART_PORT, UART_SIGNAL_RXD_INV);
+    }
+    if (err == ESP_OK) {
+        // Event on a full frame, or after 3 idle symbols (the inter-frame gap)
+        err = uart_set_rx_full_threshold(TRAINER_UART_PORT, SBUS_FRAME_LEN);
+    }
+    if (err == ESP_OK) {
+        err = uart_set_rx_timeout(TRAINER_UART_PORT, 3);
+    }
+    if (err == ESP_OK && xTaskCreatePinnedToCore(sbus_task, "sbus_in", TASK_STACK_TRAINER_IN, NULL,
+                                                   TASK_PRIO_TRAINER_IN, &sbus_task_handle, TASK_CORE_RADIO) != pdPASS) {
+        err = ESP_ERR_NO_MEM;
+    }
+    if (err != ESP_OK) {
+        uart_driver_delete(TRAINER_UART_PORT);
+        sbus_queue = NULL;
+    }
+    return err;
+}
+
+static void sbus_capture_stop(void) {
+    if (sbus_task_handle != NULL) {
+        vTaskDelete(sbus_task_handle);
+        sbus_task_handle = NULL;
+    }
+    if (sbus_queue != NULL) {
+        uart_driver_delete(TRAINER_UART_PORT);
+        sbus_queue = NULL;
+    }
+}
+
+esp_err_t input_source_start(input_source_t src, int gpio, TaskHandle_t notify_task) {
+    input_source_stop();
+    if (src >= INPUT_SOURCE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    newest_seq = 0;
+    frames_ok = 0;
+    frames_bad = 0;
+    lat_sum = 0;
+    lat_peak = 0;
+    lat_count = 0;
+    lat_avg_us = 0;
+    lat_max_us = 0;
+    notify_handle = notify_task;
+
+    esp_err_t err = ESP_OK;
+    if (src == INPUT_SOURCE_PPM) {
+        err = ppm_capture_start(gpio);
+    } else if (src == INPUT_SOURCE_SBUS) {
+        err = sbus_capture_start(gpio);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start trainer capture: %s", esp_err_to_name(err));
+        return err;
+    }
+    active_source = src;
+    if (src != INPUT_SOURCE_ADC) {
+        ESP_LOGI(TAG, "Trainer input (%s) on GPIO%d", src == INPUT_SOURCE_PPM ? "PPM" : "SBUS", gpio);
+    }
+    return ESP_OK;
+}
+
+void input_source_stop(void) {
+    if (active_source == INPUT_SOURCE_PPM) {
+        ppm_capture_stop();
+    } else if (active_source == INPUT_SOURCE_SBUS) {
+        sbus_capture_stop();
+    }
+    active_source = INPUT_SOURCE_ADC;
+    notify_handle = NULL;
+}
+
+void input_source_record_latency(uint32_t latency_us) {
+    lat_sum += latency_us;
+    if (latency_us > lat_peak) {
+        lat_peak = latency_us;
+    }
+    if (++lat_count == INPUT_LATENCY_WINDOW) {
+        lat_avg_us = lat_sum / INPUT_LATENCY_WINDOW;
+        lat_max_us = lat_peak;
+        lat_sum = 0;
+        lat_peak = 0;
+        lat_count = 0;
+    }
+}
+
+void input_source_get_stats(input_source_stats_t *out) {
+    out->source = (uint8_t)active_source;
+    out->frames = frames_ok;
+    out->errors = frames_bad;
+    out->lat_avg_us = lat_avg_us;
+    out->lat_max_us = lat_max_us;
+}
+
+uint16_t input_source_us_to_adc(uint16_t us) {
+    int32_t v = ((int32_t)us - SERVO_US_MIN) * ADC_MAX_VALUE / (SERVO_US_MAX - SERVO_US_MIN);
+    if (v < 0) v = 0;
+    if (v > ADC_MAX_VALUE) v = ADC_MAX_VALUE;
+    return (uint16_t)v;
+}
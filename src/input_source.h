@@ -0,0 +1,59 @@
+// Sender channel sources (local ADC or trainer-port capture)
+// A trainer port delivers PPM (captured by RMT RX) or SBUS (UART RX). Frames are
+// decoded where they complete (RMT done ISR / UART event task) and published
+// through a sequence counter, so the sender always reads the newest frame
+// without taking a lock. The sender task is notified on every new frame.
+#ifndef INPUT_SOURCE_H
+#define INPUT_SOURCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "common.h"
+
+typedef enum {
+    INPUT_SOURCE_ADC = 0,       // Local sticks (adc_oneshot)
+    INPUT_SOURCE_PPM = 1,       // Trainer PPM, either polarity
+    INPUT_SOURCE_SBUS = 2,      // Trainer SBUS (100000 baud 8E2, inverted)
+    INPUT_SOURCE_COUNT
+} input_source_t;
+
+#define INPUT_SOURCE_STALE_US 100000    // Captured frames older than this are not transmitted
+#define INPUT_LATENCY_WINDOW 128        // Frames per latency statistics window
+
+typedef struct {
+    uint16_t ch[NUM_CHANNELS];  // Channel positions in µs
+    uint8_t num_ch;             // Channels present in the captured frame
+    uint32_t capture_us;        // esp_timer time when the frame completed
+    uint32_t seq;               // Increments per published frame
+} input_frame_t;
+
+typedef struct {
+    uint8_t source;             // input_source_t currently running
+    uint32_t frames;            // Frames decoded
+    uint32_t errors;            // Frames rejected (framing, width range, upstream failsafe)
+    uint32_t lat_avg_us;        // Capture-to-transmit latency over the last window
+    uint32_t lat_max_us;
+} input_source_stats_t;
+
+// Start capturing on gpio; notify_task (may be NULL) is notified per frame.
+// INPUT_SOURCE_ADC needs no capture and only resets the statistics.
+esp_err_t input_source_start(input_source_t src, int gpio, TaskHandle_t notify_task);
+
+// Stop capture and release the RMT channel / UART
+void input_source_stop(void);
+
+// Copy the newest frame. Returns false if no frame has been captured yet.
+bool input_source_read(input_frame_t *out);
+
+// Record capture-to-transmit latency for one transmitted frame (sender task only)
+void input_source_record_latency(uint32_t latency_us);
+
+void input_source_get_stats(input_source_stats_t *out);
+
+// Map a captured pulse width (1000-2000 µs) into ADC units for the input pipeline
+uint16_t input_source_us_to_adc(uint16_t us);
+
+#endif // INPUT_SOURCE_H
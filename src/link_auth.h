@@ -0,0 +1,140 @@
+// Control frame authentication and replay protection
+// With link security enabled every control frame carries a session epoch and
+// a frame counter. The epoch is kept in NVS and bumped on each sender start;
+// the receiver only accepts counters it has not seen, using a sliding window.
+// A restarted receiver no longer knows which counters of the last session it
+// saw, so it refuses that session and asks the sender for a new one (resync).
+// Epochs wrap and are compared with serial number arithmetic (RFC 1982).
+// Frames are authenticated either by a truncated HMAC-SHA256 tag over the
+// frame and the sender MAC (MAC mode) or by ESP-NOW peer encryption with the
+// link key as LMK (encrypted mode, needs unicast peer MACs on both sides).
+#ifndef LINK_AUTH_H
+#define LINK_AUTH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_now.h"
+#include "common.h"
+#include "event_frame.h"
+
+#define LINK_KEY_LEN 16             // Link key: HMAC key in MAC mode, ESP-NOW LMK in encrypted mode
+#define LINK_TAG_LEN 8              // Truncated HMAC-SHA256
+#define LINK_REPLAY_WINDOW 32       // Out-of-order frames accepted behind the newest counter
+#define LINK_RESYNC_INTERVAL_US 100000  // Receiver: at most one resync request per interval
+
+typedef enum {
+    LINK_SECURITY_OFF = 0,          // Plain CONTROL_WIRE_LEN-byte frames
+    LINK_SECURITY_MAC,              // Counter + truncated HMAC tag
+    LINK_SECURITY_ENCRYPT,          // Counter inside an ESP-NOW encrypted frame
+    LINK_SECURITY_COUNT
+} link_security_t;
+
+// Frame on air; the tag is only sent in MAC mode
+typedef struct __attribute__((packed)) {
+    uint8_t payload[CONTROL_WIRE_LEN];  // control_packet_pack()
+    uint16_t epoch;                 // Sender session
+    uint32_t counter;               // Frame number within the session, never reused
+    uint8_t tag[LINK_TAG_LEN];
+} link_frame_t;
+
+#define LINK_FRAME_LEN_ENCRYPT (sizeof(link_frame_t) - LINK_TAG_LEN)
+
+// Event frame on air (event_frame.h): the same layout around an event_msg_t.
+// Acks use it too, echoing the epoch and counter of the frame they answer.
+typedef struct __attribute__((packed)) {
+    event_msg_t msg;
+    uint16_t epoch;
+    uint32_t counter;
+    uint8_t tag[LINK_TAG_LEN];
+} link_event_frame_t;
+
+// Receiver replay window for one sender
+typedef struct {
+    bool valid;                     // A counter of this epoch has been accepted
+    uint16_t epoch;                 // Current session; older epochs are rejected. Until valid,
+                                    // the last one accepted before a restart (0: none), rejected too
+    uint32_t top;                   // Newest accepted counter
+    uint32_t seen;                  // Bit i: counter top - i accepted
+} link_replay_t;
+
+typedef struct {
+    uint32_t accepted;
+    uint32_t bad_length;            // Wrong size for the configured mode (includes plain frames)
+    uint32_t bad_tag;               // Tag mismatch or unexpected source MAC
+    uint32_t replayed;              // Counter already seen, too old, or from an old epoch
+    uint32_t foreign;               // From a MAC other than the bound sender (see bind.h)
+} link_auth_stats_t;
+
+// Load the key and mode from settings and set up this side of the link.
+// Encrypted mode falls back to MAC mode if either peer MAC is broadcast.
+// Receiver: with a bound peer, frames from any other MAC are dropped.
+// Sender: bumps the persisted session epoch. Call before sender/receiver start.
+esp_err_t link_auth_configure(const device_settings_t *settings, bool is_sender);
+link_security_t link_auth_mode(void);
+
+// Fill in an ESP-NOW peer for mac (channel, interface, encryption and LMK)
+void link_auth_peer_init(esp_now_peer_info_t *peer, const uint8_t *mac);
+
+// Receiver: register the sender as an encrypted peer (no-op in other modes)
+esp_err_t link_auth_add_sender_peer(void);
+
+// Receiver: follow a new sender MAC without restarting (model profile switch).
+// The mode stays as configured; a different MAC starts a new replay window.
+// In encrypted mode the old sender's ESP-NOW peer entry is removed.
+void link_auth_set_peer(const uint8_t *mac, bool bound);
+
+// Sender: open a new session (resync request from a restarted receiver). Writes NVS, call from a task.
+void link_auth_new_session(void);
+
+// Sender: stamp epoch/counter, compute the tag and return the length to send
+size_t link_auth_seal(link_frame_t *frame);
+
+// Receiver: check a received frame and copy the control packet to out.
+// Returns false (and counts the reason) if the frame must be dropped.
+bool link_auth_open(const uint8_t *src_mac, const uint8_t *data, int len, control_packet_t *out);
+
+// Length on air of a frame with payload_len bytes of payload in the configured mode
+size_t link_auth_frame_len(size_t payload_len);
+
+// Sender: seal an event frame; it takes the next counter like a control frame
+size_t link_auth_seal_event(link_event_frame_t *frame);
+
+// Receiver: check an event frame (same source, tag and replay checks as
+// link_auth_open()) and copy it to out, epoch and counter included
+bool link_auth_open_event(const uint8_t *src_mac, const uint8_t *data, int len, link_event_frame_t *out);
+
+// Receiver: seal an ack; frame->epoch and counter hold those of the event frame
+size_t link_auth_seal_ack(link_event_frame_t *frame);
+
+// Sender: check an ack or resync request from src_mac; it must answer a frame
+// of this session. out->type tells the two apart.
+bool link_auth_open_ack(const uint8_t *src_mac, const uint8_t *data, int len, event_msg_t *out);
+
+// Receiver: true if a refused frame of the pre-restart session is waiting for
+// a resync request (checked in the receive callback to wake the task)
+bool link_auth_resync_pending(void);
+
+// Receiver: seal the pending resync request into frame and copy the sender MAC
+// to mac. Returns the length to send, 0 if none is due.
+size_t link_auth_seal_resync(link_event_frame_t *frame, uint8_t *mac);
+
+// Receiver: persist the newest accepted epoch if it changed (call from a task)
+void link_auth_persist(void);
+
+void link_auth_get_stats(link_auth_stats_t *out);
+
+// Short key fingerprint (first 4 bytes of SHA-256) to compare keys across
+// devices without showing them; 0 for an unprovisioned (all zero) key
+uint32_t link_auth_key_id(const uint8_t *key);
+
+// Replay window check; updates the window when the counter is accepted.
+// Until the window is valid, an epoch other than 0 must be strictly newer.
+bool link_replay_check(link_replay_t *w, uint16_t epoch, uint32_t counter);
+
+// Serial console command: "link" prints mode and counters, "link bench [n]"
+// times n seal/open pairs and prints the per-frame cost
+int link_auth_console_cmd(int argc, char **argv);
+
+#endif // LINK_AUTH_H
@@ -2,26 +2,32 @@
 #include "common.h"
 #include "settings.h"
 #include "webserver.h"
+#include "buttons.h"
+#include "power.h"
+#include "perf.h"
+#include "console.h"
+#include "link_auth.h"
+#include "bind.h"
+#include "profiles.h"
+#include "ota.h"
+#include "blackbox.h"
+#include "task_config.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_netif.h"
+#include "esp_system.h"
 #include "driver/gpio.h"
 #include <string.h>
 
 static const char *TAG = "main";
 
-// Forward declarations
-extern void sender_start(const uint8_t *peer_mac);
-extern void sender_stop(void);
-extern void sender_set_light_states(uint8_t states);
-extern void receiver_start(void);
-extern void receiver_stop(void);
-
 static device_settings_t current_settings;
+static uint8_t boot_role;               // Role the pins were set up for
 static bool is_running = false;
 static TaskHandle_t control_task_handle = NULL;
+static QueueHandle_t button_queue = NULL;
 
 static void led_init(void) {
     gpio_config_t io = {
@@ -35,25 +41,12 @@ static void led_init(void) {
 }
 
 static void led_set(bool on) {
-    gpio_set_level(PIN_LED, on ? 1 : 0);
-}
-
-static void button_init(void) {
-    gpio_config_t io = {
-        .pin_bit_mask = (1ULL << PIN_USER_BUTTON) | (1ULL << PIN_LIGHT_BTN1) | 
-                        (1ULL << PIN_LIGHT_BTN2) | (1ULL << PIN_LIGHT_BTN3) | 
-                        (1ULL << PIN_LIGHT_BTN4),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = 1,
-        .pull_down_en = 0,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    ESP_ERROR_CHECK(gpio_config(&io));
+    gpio_set_level(PIN_LED, on ? LED_ACTIVE_LEVEL : !LED_ACTIVE_LEVEL);
 }
 
-// LED pattern controller for 3 states
-static void led_update(void) {
-    TickType_t now = xTaskGetTickCount();
+// LED pattern controller for 3 states. Returns the time (ms) until the LED next changes.
+static uint32_t led_update(void) {
+    uint32_t now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
     connection_status_t conn_status = get_connection_status();
     bool webserver_active = webserver_is_running();
     
@@ -61,114 +54,188 @@ static void led_update(void) {
     // A: Disconnected (no ESP-NOW packets), Webserver off    -> Slow blink (1000ms on, 1000ms off)
     // B: Connected (receiving packets), Webserver off        -> Fast blink (200ms on, 200ms off)
     // C: Webserver on (regardless of connection)             -> Double blink (200ms on, 100ms off, 200ms on, 500ms off)
-    
-    bool led_on = false;
-    
-    if (webserver_active) {
-        // State C: Double blink (1000ms cycle = 100 ticks)
-        uint32_t cycle = now % 100;
-        led_on = (cycle < 20) || (cycle >= 30 && cycle < 50);
+    // Bind mode overrides them                               -> Flicker (50ms on, 50ms off)
+    static const uint16_t pattern_a[] = {1000, 2000};
+    static const uint16_t pattern_b[] = {200, 400};
+    static const uint16_t pattern_c[] = {200, 300, 500, 1000};
+    static const uint16_t pattern_bind[] = {50, 100};
+
+    // Each pattern lists the times within its cycle where the LED toggles,
+    // starting on; the last entry is the cycle length
+    const uint16_t *edges;
+    int num_edges;
+    if (bind_get_state() == BIND_ACTIVE) {
+        edges = pattern_bind;
+        num_edges = 2;
+    } else if (webserver_active) {
+        edges = pattern_c;
+        num_edges = 4;
     } else if (conn_status.connected) {
-        // State B: Fast blink (400ms cycle = 40 ticks)
-        uint32_t cycle = now % 40;
-        led_on = (cycle < 20);
+        edges = pattern_b;
+        num_edges = 2;
     } else {
-        // State A: Slow blink (2000ms cycle = 200 ticks)
-        uint32_t cycle = now % 200;
-        led_on = (cycle < 100);
+        edges = pattern_a;
+        num_edges = 2;
     }
-    
-    led_set(led_on);
+
+    uint32_t pos = now_ms % edges[num_edges - 1];
+    int i = 0;
+    while (pos >= edges[i]) {
+        i++;
+    }
+    led_set((i & 1) == 0);
+    return edges[i] - pos;
 }
 
-static void control_task(void *arg) {
-    uint32_t button_press_count = 0;
-    bool long_press_triggered = false;
-    uint8_t light_states = 0; // Bit mask for 4 lights
-    uint8_t light_btn_state[4] = {1, 1, 1, 1}; // Track previous state of each light button
-    const uint8_t light_pins[4] = {PIN_LIGHT_BTN1, PIN_LIGHT_BTN2, PIN_LIGHT_BTN3, PIN_LIGHT_BTN4};
+static void stop_role(void) {
+#if RC_ROLE_SENDER
+    if (current_settings.device_role == ROLE_SENDER) {
+        sender_stop();
+    }
+#endif
+#if RC_ROLE_RECEIVER
+    if (current_settings.device_role == ROLE_RECEIVER) {
+        receiver_stop();
+    }
+#endif
+    is_running = false;
+}
 
-    while (1) {
-        // Check user button for config mode
-        if (gpio_get_level(PIN_USER_BUTTON) == 0) {
-            // Button pressed
-            button_press_count++;
-
-            // Long press: toggle webserver (trigger only once while held)
-            if (button_press_count >= 300 && !long_press_triggered) { // ~3 seconds at 10ms poll
-                long_press_triggered = true;
-                if (webserver_is_running()) {
-                    ESP_LOGI(TAG, "Stopping webserver...");
-                    webserver_stop();
-                } else {
-                    ESP_LOGI(TAG, "Starting webserver...");
-                    webserver_start(&current_settings);
-                }
+// Start/stop the ESP-NOW role to match the webserver and bind state
+static void update_role(void) {
+    bind_state_t bind = bind_get_state();
+    if (bind == BIND_ACTIVE) {
+        return;     // Bind mode owns ESP-NOW until it ends
+    }
+    if (bind != BIND_IDLE) {
+        // Bind ended: a new peer is saved to settings and the active profile,
+        // and picked up by the restart below
+        if (bind_finish(&current_settings)) {
+            profiles_store_active();
+        }
+    }
+    if (!webserver_is_running()) {
+        if (!is_running && current_settings.device_role != boot_role) {
+            // Sender and receiver may share GPIOs (board.h): set up the new
+            // role's pins from reset. The role is already saved.
+            ESP_LOGI(TAG, "Role changed, restarting");
+            esp_restart();
+        }
+        if (!is_running) {
+            ESP_LOGI(TAG, "Starting %s", 
+                     current_settings.device_role == ROLE_SENDER ? "SENDER" : "RECEIVER");
+            // Settings may have changed in the webserver: re-apply the power mode first
+            power_configure((power_mode_t)current_settings.power_mode, current_settings.power_budget_us,
+                            current_settings.device_role == ROLE_SENDER);
+            link_auth_configure(&current_settings, current_settings.device_role == ROLE_SENDER);
+            profiles_prepare(current_settings.device_role == ROLE_SENDER);
+#if RC_ROLE_SENDER
+            if (current_settings.device_role == ROLE_SENDER) {
+                sender_set_settings(&current_settings);
+                sender_start(current_settings.peer_mac);
             }
-        } else {
-            // Button released
-            if (button_press_count > 0 && button_press_count < 300) {
-                // Short press: do nothing (removed role toggle)
-                ESP_LOGI(TAG, "Short press detected (%lu iterations)", button_press_count);
+#endif
+#if RC_ROLE_RECEIVER
+            if (current_settings.device_role == ROLE_RECEIVER) {
+                receiver_set_settings(&current_settings);
+                receiver_start();
             }
-            button_press_count = 0;
-            long_press_triggered = false;
+#endif
+            is_running = true;
         }
-
-        // Check light buttons for toggle
-        for (int i = 0; i < 4; i++) {
-            uint8_t btn_level = gpio_get_level(light_pins[i]);
-            // Detect falling edge (button press, active-low)
-            if (light_btn_state[i] == 1 && btn_level == 0) {
-                // Toggle corresponding light bit
-                light_states ^= (1 << i);
-                ESP_LOGI(TAG, "Light %d toggled, states: 0x%02x", i + 1, light_states);
-                // If running as sender, update light states
-                if (is_running && current_settings.device_role == ROLE_SENDER) {
-                    sender_set_light_states(light_states);
-                }
-            }
-            light_btn_state[i] = btn_level;
+    } else {
+        // Webserver active: stop ESP-NOW operation if it was running
+        if (is_running) {
+            ESP_LOGI(TAG, "Stopping ESP-NOW (webserver active)");
+            stop_role();
         }
+    }
+}
 
-        // Start/stop appropriate role if not in config mode
-        if (!webserver_is_running()) {
-            if (!is_running) {
-                ESP_LOGI(TAG, "Starting %s", 
-                         current_settings.device_role == ROLE_SENDER ? "SENDER" : "RECEIVER");
-                if (current_settings.device_role == ROLE_SENDER) {
-                    sender_start(current_settings.peer_mac);
-                } else {
-                    receiver_start();
-                }
-                is_running = true;
+static void handle_button_event(const button_event_t *ev, uint8_t *light_states) {
+    if (ev->button == BUTTON_USER) {
+        if (ev->type == BUTTON_EVENT_LONG) {
+            // Long press: toggle webserver
+            if (webserver_is_running()) {
+                ESP_LOGI(TAG, "Stopping webserver...");
+                webserver_stop();
+            } else {
+                ESP_LOGI(TAG, "Starting webserver...");
+                webserver_start(&current_settings);
             }
-        } else {
-            // Webserver active: stop ESP-NOW operation if it was running
-            if (is_running) {
-                ESP_LOGI(TAG, "Stopping ESP-NOW (webserver active)");
-                if (current_settings.device_role == ROLE_SENDER) {
-                    sender_stop();
-                } else {
-                    receiver_stop();
+        } else if (ev->type == BUTTON_EVENT_SHORT) {
+            // Short press: next model profile, applied without restarting the role
+            profiles_switch_next();
+        } else if (ev->type == BUTTON_EVENT_DOUBLE) {
+            // Double press: enter bind mode (again: cancel it)
+            if (bind_get_state() == BIND_ACTIVE) {
+                bind_cancel();
+            } else if (!webserver_is_running()) {
+                if (is_running) {
+                    stop_role();
                 }
-                is_running = false;
+                bind_start(&current_settings, current_settings.device_role == ROLE_SENDER);
             }
         }
+        return;
+    }
+
+    // Light buttons toggle on the debounced press edge
+    if (ev->type == BUTTON_EVENT_PRESS) {
+        int i = ev->button - BUTTON_LIGHT1;
+        *light_states ^= (1 << i);
+        ESP_LOGI(TAG, "Light %d toggled, states: 0x%02x", i + 1, *light_states);
+#if RC_ROLE_SENDER
+        // If running as sender, send the new light states immediately
+        if (is_running && current_settings.device_role == ROLE_SENDER) {
+            sender_set_light_states(*light_states, ev->edge_us);
+        }
+#endif
+    }
+}
+
+// Link check for a pending image (ota_poll). A sender's connection flag is set
+// by any send success, broadcasts included, so it needs the receiver's answer.
+static bool link_up(void) {
+#if RC_ROLE_SENDER
+    if (current_settings.device_role == ROLE_SENDER) {
+        return sender_link_verified();
+    }
+#endif
+    return get_connection_status().connected;
+}
+
+static void control_task(void *arg) {
+    uint8_t light_states = 0; // Bit mask for 4 lights
 
-        // Update LED pattern based on connection state and webserver status
-        led_update();
+    // Sleeps until a button event arrives or the LED pattern needs to change
+    while (1) {
+        update_role();
+        ota_poll(is_running, link_up());
+        uint32_t next_led_ms = led_update();
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+        button_event_t ev;
+        TickType_t wait = pdMS_TO_TICKS(next_led_ms);
+        if (xQueueReceive(button_queue, &ev, wait ? wait : 1) == pdTRUE) {
+            handle_button_event(&ev, &light_states);
+        }
     }
 }
 
 void app_main(void) {
-    ESP_LOGI(TAG, "ESP-NOW Radio Control starting...");
+    ESP_LOGI(TAG, "ESP-NOW Radio Control starting (%s)...", BOARD_NAME);
 
     // Initialize NVS and settings
     settings_init();
     settings_load(&current_settings);
+    profiles_init(&current_settings);
+    boot_role = current_settings.device_role;
+    ota_init();
+#if RC_ROLE_RECEIVER
+    if (boot_role == ROLE_RECEIVER) {
+        blackbox_init();
+    }
+#endif
 
     // Initialize WiFi and ESP-NOW
     common_wifi_init();
@@ -176,10 +243,19 @@ void app_main(void) {
 
     // Initialize hardware
     led_init();
-    button_init();
+    button_queue = xQueueCreate(BUTTON_QUEUE_LEN, sizeof(button_event_t));
+    // Light buttons are sender pins; on a receiver those GPIOs may be outputs
+    ESP_ERROR_CHECK(buttons_init(button_queue, boot_role == ROLE_SENDER));
+
+    ESP_ERROR_CHECK(perf_init());
+    // Serial console; skipped in light sleep mode, where UART input is not received
+    if (current_settings.power_mode != POWER_MODE_LIGHT_SLEEP) {
+        console_start();
+    }
 
     // Start control task
-    xTaskCreate(control_task, "control", 4096, NULL, 5, &control_task_handle);
+    xTaskCreatePinnedToCore(control_task, "control", TASK_STACK_CONTROL, NULL, TASK_PRIO_CONTROL,
+                            &control_task_handle, TASK_CORE_CONTROL);
 
     ESP_LOGI(TAG, "Initialization complete. Device role: %s", 
              current_settings.device_role == ROLE_SENDER ? "SENDER" : "RECEIVER");
@@ -0,0 +1,88 @@
+// Receiver channel mixer implementation
+#include "mixer.h"
+#include <string.h>
+
+#define Q15_ONE 32768
+
+static int8_t clamp_pct(int v) {
+    if (v > MIX_WEIGHT_MAX) return MIX_WEIGHT_MAX;
+    if (v < -MIX_WEIGHT_MAX) return -MIX_WEIGHT_MAX;
+    return (int8_t)v;
+}
+
+void mixer_build_matrix(const device_settings_t *settings,
+                        int8_t weight[NUM_CHANNELS][NUM_CHANNELS], int8_t offset[NUM_CHANNELS]) {
+    memset(offset, 0, NUM_CHANNELS);
+
+    if (settings->mix_preset == MIX_PRESET_CUSTOM) {
+        for (int o = 0; o < NUM_CHANNELS; o++) {
+            for (int i = 0; i < NUM_CHANNELS; i++) {
+                weight[o][i] = clamp_pct(settings->mix_weight[o][i]);
+            }
+            offset[o] = clamp_pct(settings->mix_offset[o]);
+        }
+        return;
+    }
+
+    // All presets start from identity and only remap CH1/CH2
+    memset(weight, 0, NUM_CHANNELS * NUM_CHANNELS);
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        weight[o][o] = 100;
+    }
+
+    switch (settings->mix_preset) {
+    case MIX_PRESET_TANK:
+        weight[0][0] = 100; weight[0][1] = 100;
+        weight[1][0] = 100; weight[1][1] = -100;
+        break;
+    case MIX_PRESET_ELEVON:
+    case MIX_PRESET_VTAIL:
+        weight[0][0] = 50; weight[0][1] = 50;
+        weight[1][0] = 50; weight[1][1] = -50;
+        break;
+    default:
+        break;
+    }
+}
+
+void mixer_compile(mixer_t *m, const device_settings_t *settings) {
+    int8_t weight[NUM_CHANNELS][NUM_CHANNELS];
+    int8_t offset[NUM_CHANNELS];
+    mixer_build_matrix(settings, weight, offset);
+
+    uint16_t n = 0;
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        m->term_start[o] = n;
+        // Offset is percent of the half range below center
+        m->offset[o] = (int32_t)(((int64_t)offset[o] * ADC_CENTER_VALUE * Q15_ONE) / 100);
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            if (weight[o][i] == 0) {
+                continue;
+            }
+            m->terms[n].in = (uint8_t)i;
+            m->terms[n].coef = ((int32_t)weight[o][i] * Q15_ONE) / 100;
+            n++;
+        }
+    }
+    m->term_start[NUM_CHANNELS] = n;
+}
+
+void mixer_apply(const mixer_t *m, const uint16_t *in, uint16_t *out) {
+    int32_t x[NUM_CHANNELS];
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        x[i] = (int32_t)in[i] - ADC_CENTER_VALUE;
+    }
+
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        // |coef| <= 1.25 * 2^15 and |x| <= 2^11, so NUM_CHANNELS terms fit in int32
+        int32_t acc = m->offset[o];
+        for (uint16_t t = m->term_start[o]; t < m->term_start[o + 1]; t++) {
+            acc += m->terms[t].coef * x[m->terms[t].in];
+        }
+        int32_t v = (acc >= 0) ? (acc + Q15_ONE / 2) >> 15 : -((-acc + Q15_ONE / 2) >> 15);
+        v += ADC_CENTER_VALUE;
+        if (v < 0) v = 0;
+        if (v > ADC_MAX_VALUE) v = ADC_MAX_VALUE;
+        out[o] = (uint16_t)v;
+    }
+}
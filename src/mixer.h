@@ -0,0 +1,53 @@
+// Receiver channel mixer: weighted N x N matrix with offsets, compiled to Q15 terms
+// Runs between packet decode and servo output. Saturation at 125% weights on
+// all 16 channels is covered on the host by test/test_mixer.
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "device_settings.h"
+
+#ifndef ADC_MAX_VALUE
+#define ADC_MAX_VALUE 4095
+#endif
+#ifndef ADC_CENTER_VALUE
+#define ADC_CENTER_VALUE 2048
+#endif
+
+#define MIX_WEIGHT_MAX 125      // Weights and offsets are percent, -125..125
+
+typedef enum {
+    MIX_PRESET_IDENTITY = 0,    // Output N = input N
+    MIX_PRESET_CUSTOM = 1,      // Use mix_weight / mix_offset from settings
+    MIX_PRESET_TANK = 2,        // CH1 = thr + steer, CH2 = thr - steer (inputs CH1 thr, CH2 steer)
+    MIX_PRESET_ELEVON = 3,      // CH1 = 50% pitch + 50% roll, CH2 = 50% pitch - 50% roll (CH1 pitch, CH2 roll)
+    MIX_PRESET_VTAIL = 4,       // CH1 = 50% elev + 50% rud, CH2 = 50% elev - 50% rud (CH1 elev, CH2 rudder)
+    MIX_PRESET_COUNT
+} mix_preset_t;
+
+typedef struct {
+    uint8_t in;                 // Input channel index
+    int32_t coef;               // Q15 weight (32768 = 100%)
+} mixer_term_t;
+
+// Compiled mixer: only non-zero terms are kept, so per-frame cost is bounded by
+// the number of active mixes (at most NUM_CHANNELS * NUM_CHANNELS)
+typedef struct {
+    int32_t offset[NUM_CHANNELS];               // Q15 offset in signed counts
+    uint16_t term_start[NUM_CHANNELS + 1];      // terms[term_start[o] .. term_start[o+1]) feed output o
+    mixer_term_t terms[NUM_CHANNELS * NUM_CHANNELS];
+} mixer_t;
+
+// Fill weights/offsets (percent) for a preset; CUSTOM copies them from settings
+void mixer_build_matrix(const device_settings_t *settings,
+                        int8_t weight[NUM_CHANNELS][NUM_CHANNELS], int8_t offset[NUM_CHANNELS]);
+
+// Compile the active matrix from settings into Q15 terms
+void mixer_compile(mixer_t *m, const device_settings_t *settings);
+
+// Mix one frame. in/out are packet units (0..ADC_MAX_VALUE, center ADC_CENTER_VALUE).
+// Each output saturates independently at the ends of the range.
+void mixer_apply(const mixer_t *m, const uint16_t *in, uint16_t *out);
+
+#endif // MIXER_H
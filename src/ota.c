@@ -0,0 +1,203 @@
+// Firmware update implementation
+#include "ota.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_app_desc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/md.h"
+#include <string.h>
+
+static const char *TAG = "ota";
+
+static const esp_partition_t *update_partition = NULL;
+static esp_ota_handle_t update_handle = 0;
+static mbedtls_sha256_context sha_ctx;
+static mbedtls_md_context_t hmac_ctx;
+static int64_t start_us = 0;
+static int64_t flash_us = 0;
+static uint32_t written = 0;
+
+// Rollback check for a pending image: radio time without a link so far
+static bool pending_verify = false;
+static int64_t verify_deadline_us = 0;
+
+void ota_init(void) {
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (running != NULL && esp_ota_get_state_partition(running, &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        pending_verify = true;
+        verify_deadline_us = esp_timer_get_time() + (int64_t)OTA_VERIFY_TIMEOUT_MS * 1000;
+        ESP_LOGW(TAG, "New image on %s, kept once the control link is up (rolled back after %d s without)",
+                 running->label, OTA_VERIFY_TIMEOUT_MS / 1000);
+    }
+    ESP_LOGI(TAG, "Running %s from %s", esp_app_get_description()->version,
+             running ? running->label : "?");
+}
+
+esp_err_t ota_begin(size_t image_len, const uint8_t *key) {
+    if (update_partition != NULL) {
+        return ESP_ERR_INVALID_STATE;       // Another upload is in progress
+    }
+    uint8_t any = 0;
+    for (int i = 0; i < OTA_KEY_LEN; i++) {
+        any |= key[i];
+    }
+    if (!any) {
+        ESP_LOGE(TAG, "No link key provisioned, updates over Wi-Fi are disabled");
+        return ESP_ERR_NOT_ALLOWED;
+    }
+    const esp_partition_t *part = esp_ota_get_next_update_partition(NULL);
+    if (part == NULL) {
+        ESP_LOGE(TAG, "No OTA slot (partition table without ota_0/ota_1)");
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (image_len == 0 || image_len > part->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    mbedtls_md_init(&hmac_ctx);
+    if (mbedtls_md_setup(&hmac_ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1) != 0 ||
+        mbedtls_md_hmac_starts(&hmac_ctx, key, OTA_KEY_LEN) != 0) {
+        mbedtls_md_free(&hmac_ctx);
+        return ESP_ERR_NO_MEM;
+    }
+    // Sequential writes erase sector by sector as the data arrives, instead
+    // of erasing the whole slot up front while the client waits
+    esp_err_t err = esp_ota_begin(part, OTA_WITH_SEQUENTIAL_WRITES, &update_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
+        mbedtls_md_free(&hmac_ctx);
+        return err;
+    }
+    mbedtls_sha256_init(&sha_ctx);
+    mbedtls_sha256_starts(&sha_ctx, 0);
+    update_partition = part;
+    written = 0;
+    flash_us = 0;
+    start_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "Writing %u bytes to %s", (unsigned)image_len, part->label);
+    return ESP_OK;
+}
+
+esp_err_t ota_write(const void *data, size_t len) {
+    if (update_partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    mbedtls_sha256_update(&sha_ctx, data, len);
+    mbedtls_md_hmac_update(&hmac_ctx, data, len);
+    int64_t t = esp_timer_get_time();
+    esp_err_t err = esp_ota_write(update_handle, data, len);
+    flash_us += esp_timer_get_time() - t;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Write at %lu failed: %s", written, esp_err_to_name(err));
+        return err;
+    }
+    written += len;
+    return ESP_OK;
+}
+
+void ota_abort(void) {
+    if (update_partition != NULL) {
+        esp_ota_abort(update_handle);
+        mbedtls_sha256_free(&sha_ctx);
+        mbedtls_md_free(&hmac_ctx);
+        update_partition = NULL;
+        ESP_LOGW(TAG, "Update aborted after %lu bytes", written);
+    }
+}
+
+esp_err_t ota_finish(const uint8_t *expected_sha256, const uint8_t *expected_hmac, ota_stats_t *stats) {
+    if (update_partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint8_t sha[OTA_SHA256_LEN];
+    mbedtls_sha256_finish(&sha_ctx, sha);
+    if (expected_sha256 != NULL && memcmp(sha, expected_sha256, OTA_SHA256_LEN) != 0) {
+        ESP_LOGE(TAG, "SHA-256 of the upload does not match");
+        ota_abort();
+        return ESP_ERR_INVALID_CRC;
+    }
+    // Signature before esp_ota_end(): an unsigned image never becomes bootable
+    uint8_t mac[OTA_HMAC_LEN];
+    uint8_t diff = 0;
+    mbedtls_md_hmac_finish(&hmac_ctx, mac);
+    for (int i = 0; i < OTA_HMAC_LEN; i++) {
+        diff |= mac[i] ^ expected_hmac[i];
+    }
+    if (diff != 0) {
+        ESP_LOGE(TAG, "Image not signed with the link key");
+        ota_abort();
+        return ESP_ERR_NOT_ALLOWED;
+    }
+    mbedtls_sha256_free(&sha_ctx);
+    mbedtls_md_free(&hmac_ctx);
+
+    // Checks the image header, chip, segments and the image's own SHA-256
+    esp_err_t err = esp_ota_end(update_handle);
+    if (err == ESP_OK) {
+        err = esp_ota_set_boot_partition(update_partition);
+    }
+    const esp_partition_t *part = update_partition;
+    update_partition = NULL;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Image rejected: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    stats->bytes = written;
+    stats->elapsed_ms = elapsed_ms;
+    stats->flash_ms = (uint32_t)(flash_us / 1000);
+    stats->kb_per_s = elapsed_ms ? written / elapsed_ms : 0;
+    ESP_LOGI(TAG, "%lu bytes in %lu ms (%lu kB/s, %lu ms in flash writes), boot partition now %s",
+             stats->bytes, stats->elapsed_ms, stats->kb_per_s, stats->flash_ms, part->label);
+    return ESP_OK;
+}
+
+static void restart_cb(void *arg) {
+    esp_restart();
+}
+
+void ota_schedule_restart(void) {
+    esp_timer_create_args_t args = {
+        .callback = restart_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "ota_restart",
+    };
+    esp_timer_handle_t timer;
+    if (esp_timer_create(&args, &timer) != ESP_OK ||
+        esp_timer_start_once(timer, OTA_RESTART_DELAY_MS * 1000ULL) != ESP_OK) {
+        esp_restart();
+    }
+}
+
+void ota_poll(bool radio_running, bool link_up) {
+    if (!pending_verify) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    if (link_up) {
+        if (esp_ota_mark_app_valid_cancel_rollback() == ESP_OK) {
+            pending_verify = false;
+            ESP_LOGI(TAG, "Control link up, new image kept");
+        }
+    } else if (!radio_running) {
+        // Webserver or bind mode: no link possible, the window starts over with the role
+        verify_deadline_us = now + (int64_t)OTA_VERIFY_TIMEOUT_MS * 1000;
+    } else if (now >= verify_deadline_us) {
+        ESP_LOGE(TAG, "No control link within %d s, rolling back", OTA_VERIFY_TIMEOUT_MS / 1000);
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+}
+
+void ota_get_info(ota_info_t *info) {
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    strncpy(info->version, esp_app_get_description()->version, sizeof(info->version) - 1);
+    info->version[sizeof(info->version) - 1] = '\0';
+    strncpy(info->partition, running ? running->label : "", sizeof(info->partition) - 1);
+    info->partition[sizeof(info->partition) - 1] = '\0';
+    info->pending_verify = pending_verify;
+}
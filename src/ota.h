@@ -0,0 +1,70 @@
+// Firmware update over the config access point
+// POST /api/ota streams the uploaded image into the inactive OTA slot in
+// OTA_CHUNK_LEN pieces, so the image is never held in RAM. The image is checked
+// (ESP-IDF image validation, plus the SHA-256 of the upload when the client
+// sends one) before it becomes the boot partition.
+// Only images signed with the link key are accepted: the client sends an
+// HMAC-SHA256 of the image keyed with it, so reaching the access point is not
+// enough to install firmware.
+//
+// A freshly updated image boots in pending-verify state (bootloader rollback).
+// It is kept once it has brought up a control link, and rolled back if it
+// resets first or runs the radio role for OTA_VERIFY_TIMEOUT_MS without a link.
+#ifndef OTA_H
+#define OTA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#define OTA_CHUNK_LEN 4096              // Receive buffer; one flash sector per write
+#define OTA_SHA256_LEN 32
+#define OTA_HMAC_LEN 32                 // HMAC-SHA256 of the image
+#define OTA_KEY_LEN 16                  // The link key (link_auth.h) signs images
+#define OTA_VERIFY_TIMEOUT_MS 60000     // Radio time a new image gets to bring up the link
+#define OTA_RESTART_DELAY_MS 1000       // Lets the HTTP response go out before the restart
+
+typedef struct {
+    uint32_t bytes;                 // Image size written
+    uint32_t elapsed_ms;            // ota_begin() to ota_finish()
+    uint32_t flash_ms;              // Time spent in flash writes
+    uint32_t kb_per_s;              // Upload throughput (bytes per ms)
+} ota_stats_t;
+
+typedef struct {
+    char version[32];               // App version of the running image
+    char partition[17];             // Running partition label
+    bool pending_verify;            // Running a new image that has not been kept yet
+} ota_info_t;
+
+// At boot: log the running image and arm the rollback check for a new one
+void ota_init(void);
+
+// Start writing an image of image_len bytes into the inactive slot; key
+// (OTA_KEY_LEN bytes) is the key the image must be signed with
+esp_err_t ota_begin(size_t image_len, const uint8_t *key);
+
+// Append the next piece of the image
+esp_err_t ota_write(const void *data, size_t len);
+
+// Validate the image and make it the boot partition. expected_sha256 (may be
+// NULL) is compared with the SHA-256 of the uploaded bytes. expected_hmac must
+// match the HMAC of the upload, otherwise ESP_ERR_NOT_ALLOWED and the slot is
+// never made bootable.
+esp_err_t ota_finish(const uint8_t *expected_sha256, const uint8_t *expected_hmac, ota_stats_t *stats);
+
+// Drop a partial upload; the running image stays the boot partition
+void ota_abort(void);
+
+// Restart into the new image after OTA_RESTART_DELAY_MS
+void ota_schedule_restart(void);
+
+// Control task: keep a pending image once the link is up (the receiver answered
+// a sender, see sender_link_verified()), roll it back when the radio role ran
+// for OTA_VERIFY_TIMEOUT_MS without one
+void ota_poll(bool radio_running, bool link_up);
+
+void ota_get_info(ota_info_t *info);
+
+#endif // OTA_H
@@ -0,0 +1,115 @@
+// Receiver output stage implementation
+#include "output_stage.h"
+#include <string.h>
+
+void output_stage_configure(output_stage_cfg_t *cfg, const device_settings_t *settings) {
+    uint16_t rate = settings->output_rate_hz;
+    if (rate < OUTPUT_RATE_MIN_HZ) rate = OUTPUT_RATE_MIN_HZ;
+    if (rate > OUTPUT_RATE_MAX_HZ) rate = OUTPUT_RATE_MAX_HZ;
+    cfg->rate_hz = rate;
+    cfg->extrapolate = settings->output_extrapolate;
+
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        // Slew is µs per second; convert to Q8 µs per tick (at least 1/256 µs)
+        uint32_t slew = settings->ch_slew[i];
+        if (slew == 0) {
+            cfg->slew_q8[i] = 0;
+        } else {
+            uint32_t q8 = (slew << 8) / rate;
+            cfg->slew_q8[i] = q8 ? q8 : 1;
+        }
+        uint16_t lo = settings->servo_min[i];
+        uint16_t hi = settings->servo_max[i];
+        if (lo > hi) {
+            uint16_t t = lo;
+            lo = hi;
+            hi = t;
+        }
+        cfg->limit_min[i] = lo;
+        cfg->limit_max[i] = hi;
+    }
+}
+
+void output_stage_reset(output_stage_t *os) {
+    memset(os->from_q8, 0, sizeof(os->from_q8));
+    memset(os->to_q8, 0, sizeof(os->to_q8));
+    memset(os->out_q8, 0, sizeof(os->out_q8));
+    os->seg_start_us = 0;
+    os->interval_us = OUTPUT_FRAME_US_DEFAULT;
+    os->frames = 0;
+}
+
+// Interpolated (or extrapolated) setpoint for one channel, before slew limiting.
+// The segment from -> to spans one frame interval starting at the frame's arrival.
+static int32_t setpoint_q8(const output_stage_t *os, int ch, uint32_t elapsed) {
+    int32_t from = os->from_q8[ch];
+    int32_t to = os->to_q8[ch];
+    uint32_t iv = os->interval_us;
+
+    if (elapsed >= iv) {
+        if (!os->cfg.extrapolate || os->frames < 2) {
+            return to;
+        }
+        // Next frame is late: keep the slope for at most one more interval, then hold
+        if (elapsed > 2 * iv) elapsed = 2 * iv;
+    }
+    int32_t v = from + (int32_t)(((int64_t)(to - from) * elapsed) / iv);
+
+    int32_t lo = (int32_t)os->cfg.limit_min[ch] << 8;
+    int32_t hi = (int32_t)os->cfg.limit_max[ch] << 8;
+    if (v < lo) v = lo;
+    if (v > hi) v = hi;
+    return v;
+}
+
+void output_stage_push_frame(output_stage_t *os, const uint16_t *target_us, uint32_t now_us, uint32_t interval_us) {
+    if (os->frames == 0) {
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            int32_t t = (int32_t)target_us[i] << 8;
+            os->from_q8[i] = t;
+            os->to_q8[i] = t;
+            os->out_q8[i] = t;
+        }
+    } else {
+        uint32_t dt = now_us - os->seg_start_us;
+        // New segment starts where the previous one currently is (no jump)
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            os->from_q8[i] = setpoint_q8(os, i, dt);
+            os->to_q8[i] = (int32_t)target_us[i] << 8;
+        }
+        // Track the frame interval; gaps (lost frames, link loss) are bounded
+        if (dt < OUTPUT_FRAME_US_MIN) dt = OUTPUT_FRAME_US_MIN;
+        if (dt > OUTPUT_FRAME_US_MAX) dt = OUTPUT_FRAME_US_MAX;
+        os->interval_us = (os->interval_us * 3 + dt) / 4;
+    }
+    // An announced interval applies to this segment at once, so a rate change
+    // is followed without the smoothing lag
+    if (interval_us > 0) {
+        if (interval_us < OUTPUT_FRAME_US_MIN) interval_us = OUTPUT_FRAME_US_MIN;
+        if (interval_us > OUTPUT_FRAME_US_MAX) interval_us = OUTPUT_FRAME_US_MAX;
+        os->interval_us = interval_us;
+    }
+    os->seg_start_us = now_us;
+    os->frames++;
+}
+
+bool output_stage_tick(output_stage_t *os, uint32_t now_us, uint16_t *out_us) {
+    if (os->frames == 0) {
+        return false;
+    }
+    uint32_t elapsed = now_us - os->seg_start_us;
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        int32_t sp = setpoint_q8(os, i, elapsed);
+        uint32_t slew = os->cfg.slew_q8[i];
+        if (slew) {
+            int32_t delta = sp - os->out_q8[i];
+            if (delta > (int32_t)slew) delta = (int32_t)slew;
+            if (delta < -(int32_t)slew) delta = -(int32_t)slew;
+            os->out_q8[i] += delta;
+        } else {
+            os->out_q8[i] = sp;
+        }
+        out_us[i] = (uint16_t)((os->out_q8[i] + 128) >> 8);
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+// Receiver output stage: fixed-rate upsampling of received frames
+// Interpolates between frames (one frame interval of smoothing), optionally
+// extrapolates across a single lost frame, and applies per-channel slew limits.
+// The frame interval is the one the sender announced (frame_rate.h) or, for
+// frames without one, measured from arrival times.
+// Time is passed in by the caller (microseconds); test/test_output_stage drives
+// it on the host with synthetic frame arrival times.
+#ifndef OUTPUT_STAGE_H
+#define OUTPUT_STAGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "device_settings.h"
+
+#define OUTPUT_RATE_MIN_HZ 50
+#define OUTPUT_RATE_MAX_HZ 500
+#define OUTPUT_FRAME_US_DEFAULT 20000   // Assumed frame interval until measured (50 Hz)
+#define OUTPUT_FRAME_US_MIN 2000        // Bounds for the measured frame interval
+#define OUTPUT_FRAME_US_MAX 100000
+
+typedef struct {
+    uint16_t rate_hz;                       // Output update rate
+    bool extrapolate;                       // Continue the last slope across one lost frame
+    uint32_t slew_q8[NUM_CHANNELS];         // Max change per tick (µs, Q8), 0 = unlimited
+    uint16_t limit_min[NUM_CHANNELS];       // Output clamp (µs)
+    uint16_t limit_max[NUM_CHANNELS];
+} output_stage_cfg_t;
+
+typedef struct {
+    output_stage_cfg_t cfg;
+    int32_t from_q8[NUM_CHANNELS];          // Segment start (µs, Q8)
+    int32_t to_q8[NUM_CHANNELS];            // Segment end = latest received frame
+    int32_t out_q8[NUM_CHANNELS];           // Current output after slew limiting
+    uint32_t seg_start_us;                  // Arrival time of the latest frame
+    uint32_t interval_us;                   // Announced or smoothed frame interval
+    uint32_t frames;                        // Frames received since reset
+} output_stage_t;
+
+// Build the stage configuration from settings (rate, extrapolation, slew, servo limits)
+void output_stage_configure(output_stage_cfg_t *cfg, const device_settings_t *settings);
+
+// Clear history; the next frame is output without interpolation
+void output_stage_reset(output_stage_t *os);
+
+// A new frame of servo targets (µs) arrived at now_us. interval_us: time until
+// the next frame as announced by the sender, 0 = not announced (measured)
+void output_stage_push_frame(output_stage_t *os, const uint16_t *target_us, uint32_t now_us, uint32_t interval_us);
+
+// Advance one output tick at now_us; writes servo positions (µs).
+// Returns false if no frame has been received yet.
+bool output_stage_tick(output_stage_t *os, uint32_t now_us, uint16_t *out_us);
+
+#endif // OUTPUT_STAGE_H
@@ -0,0 +1,266 @@
+// Runtime performance counters implementation
+#include "perf.h"
+#include "task_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static perf_hist_t hist[PERF_POINT_COUNT];
+static portMUX_TYPE hist_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Run-time counters at the previous report, for per-interval CPU shares
+static struct {
+    TaskHandle_t handle;
+    uint32_t runtime;
+} prev_tasks[PERF_MAX_TASKS];
+static int prev_count = 0;
+static uint32_t prev_total = 0;
+static uint32_t prev_report_us = 0;
+static SemaphoreHandle_t report_mutex = NULL;
+
+static const char *point_names[PERF_POINT_COUNT] = {
+    [PERF_SENDER_FRAME] = "sender_frame",
+    [PERF_RX_OUTPUT]    = "rx_output",
+    [PERF_RX_CALLBACK]  = "rx_callback",
+    [PERF_LINK_SEAL]    = "link_seal",
+    [PERF_LINK_OPEN]    = "link_open",
+    [PERF_RX_LATENCY]   = "rx_latency",
+    [PERF_TX_LATENCY]   = "tx_latency",
+};
+
+// Load generator (perf load): busy share of every LOAD_PERIOD_MS
+#define LOAD_PERIOD_MS 10
+#define LOAD_MAX_PERCENT 90         // Leaves the idle task its watchdog feed
+static TaskHandle_t load_task_handle = NULL;
+static volatile uint32_t load_busy_us = 0;
+
+static void record(perf_point_t point, uint32_t cycles) {
+    int bucket = 0;
+    if (cycles >= (1UL << PERF_HIST_SHIFT)) {
+        bucket = 32 - __builtin_clz(cycles) - PERF_HIST_SHIFT;
+        if (bucket >= PERF_HIST_BUCKETS) {
+            bucket = PERF_HIST_BUCKETS - 1;
+        }
+    }
+
+    portENTER_CRITICAL(&hist_lock);
+    perf_hist_t *h = &hist[point];
+    if (h->count == 0 || cycles < h->min_cycles) {
+        h->min_cycles = cycles;
+    }
+    if (cycles > h->max_cycles) {
+        h->max_cycles = cycles;
+    }
+    h->count++;
+    h->sum_cycles += cycles;
+    h->buckets[bucket]++;
+    portEXIT_CRITICAL(&hist_lock);
+}
+
+void perf_end(perf_point_t point, uint32_t start) {
+    record(point, esp_cpu_get_cycle_count() - start);
+}
+
+void perf_record_us(perf_point_t point, uint32_t us) {
+    record(point, us * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+}
+
+void perf_reset_histograms(void) {
+    portENTER_CRITICAL(&hist_lock);
+    memset(hist, 0, sizeof(hist));
+    portEXIT_CRITICAL(&hist_lock);
+}
+
+esp_err_t perf_collect(perf_snapshot_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->heap_free = esp_get_free_heap_size();
+    out->heap_min_free = esp_get_minimum_free_heap_size();
+    out->heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    out->cpu_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+
+    portENTER_CRITICAL(&hist_lock);
+    memcpy(out->hist, hist, sizeof(hist));
+    portEXIT_CRITICAL(&hist_lock);
+
+    // A few spare entries in case tasks are created between the two calls
+    UBaseType_t n = uxTaskGetNumberOfTasks() + 2;
+    TaskStatus_t *status = malloc(n * sizeof(TaskStatus_t));
+    if (status == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (report_mutex != NULL) {
+        xSemaphoreTake(report_mutex, portMAX_DELAY);
+    }
+    uint32_t total = 0;
+    n = uxTaskGetSystemState(status, n, &total);
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    // The total counts time per core; tasks on all cores share it
+    uint64_t total_delta = (uint64_t)(total - prev_total) * portNUM_PROCESSORS;
+    out->interval_ms = (now_us - prev_report_us) / 1000;
+
+    int count = 0;
+    for (UBaseType_t i = 0; i < n && count < PERF_MAX_TASKS; i++) {
+        uint32_t delta = status[i].ulRunTimeCounter;
+        for (int j = 0; j < prev_count; j++) {
+            if (prev_tasks[j].handle == status[i].xHandle) {
+                delta -= prev_tasks[j].runtime;
+                break;
+            }
+        }
+        perf_task_t *t = &out->tasks[count++];
+        strncpy(t->name, status[i].pcTaskName, sizeof(t->name) - 1);
+        t->priority = (uint8_t)status[i].uxCurrentPriority;
+        t->cpu_permille = total_delta ? (uint16_t)((uint64_t)delta * 1000 / total_delta) : 0;
+        t->stack_free = status[i].usStackHighWaterMark;  // StackType_t is a byte on ESP-IDF
+    }
+    out->num_tasks = (uint8_t)count;
+
+    prev_count = 0;
+    for (UBaseType_t i = 0; i < n && prev_count < PERF_MAX_TASKS; i++) {
+        prev_tasks[prev_count].handle = status[i].xHandle;
+        prev_tasks[prev_count].runtime = status[i].ulRunTimeCounter;
+        prev_count++;
+    }
+    prev_total = total;
+    prev_report_us = now_us;
+    if (report_mutex != NULL) {
+        xSemaphoreGive(report_mutex);
+    }
+
+    free(status);
+    return ESP_OK;
+}
+
+int perf_format_json(const perf_snapshot_t *snap, char *buf, size_t size) {
+    int len = snprintf(buf, size,
+                       "{\"interval_ms\":%lu,\"cpu_mhz\":%u,"
+                       "\"heap\":{\"free\":%lu,\"min_free\":%lu,\"largest_block\":%lu},\"tasks\":[",
+                       snap->interval_ms, snap->cpu_mhz,
+                       snap->heap_free, snap->heap_min_free, snap->heap_largest);
+    for (int i = 0; i < snap->num_tasks && len < (int)size; i++) {
+        const perf_task_t *t = &snap->tasks[i];
+        len += snprintf(buf + len, size - len,
+                        "%s{\"name\":\"%s\",\"prio\":%u,\"cpu_permille\":%u,\"stack_free\":%lu}",
+                        i ? "," : "", t->name, t->priority, t->cpu_permille, t->stack_free);
+    }
+    if (len < (int)size) {
+        len += snprintf(buf + len, size - len, "],\"hist\":{");
+    }
+    for (int p = 0; p < PERF_POINT_COUNT && len < (int)size; p++) {
+        const perf_hist_t *h = &snap->hist[p];
+        uint32_t avg = h->count ? (uint32_t)(h->sum_cycles / h->count) : 0;
+        len += snprintf(buf + len, size - len,
+                        "%s\"%s\":{\"count\":%lu,\"min_cyc\":%lu,\"avg_cyc\":%lu,\"max_cyc\":%lu,\"buckets\":[",
+                        p ? "," : "", point_names[p], h->count, h->min_cycles, avg, h->max_cycles);
+        for (int b = 0; b < PERF_HIST_BUCKETS && len < (int)size; b++) {
+            len += snprintf(buf + len, size - len, "%s%lu", b ? "," : "", h->buckets[b]);
+        }
+        if (len < (int)size) {
+            len += snprintf(buf + len, size - len, "]}");
+        }
+    }
+    if (len < (int)size) {
+        len += snprintf(buf + len, size - len, "}}");
+    }
+    return len < (int)size ? len : (int)size - 1;
+}
+
+static void print_report(const perf_snapshot_t *snap) {
+    printf("Heap: free %lu, min free %lu, largest block %lu\n",
+           snap->heap_free, snap->heap_min_free, snap->heap_largest);
+    printf("Tasks (CPU over the last %lu ms):\n", snap->interval_ms);
+    printf("  %-16s %4s %6s %10s\n", "name", "prio", "cpu%", "stack_free");
+    for (int i = 0; i < snap->num_tasks; i++) {
+        const perf_task_t *t = &snap->tasks[i];
+        printf("  %-16s %4u %3u.%u %10lu\n", t->name, t->priority,
+               t->cpu_permille / 10, t->cpu_permille % 10, t->stack_free);
+    }
+    printf("Timing (us at %u MHz):\n", snap->cpu_mhz);
+    for (int p = 0; p < PERF_POINT_COUNT; p++) {
+        const perf_hist_t *h = &snap->hist[p];
+        if (h->count == 0) {
+            printf("  %-13s no samples\n", point_names[p]);
+            continue;
+        }
+        uint32_t avg = (uint32_t)(h->sum_cycles / h->count);
+        printf("  %-13s n=%lu min=%lu avg=%lu max=%lu\n", point_names[p], h->count,
+               h->min_cycles / snap->cpu_mhz, avg / snap->cpu_mhz, h->max_cycles / snap->cpu_mhz);
+        for (int b = 0; b < PERF_HIST_BUCKETS; b++) {
+            if (h->buckets[b] == 0) {
+                continue;
+            }
+            uint32_t lo = b ? (1UL << (b + PERF_HIST_SHIFT - 1)) : 0;
+            printf("    >= %6lu us: %lu\n", lo / snap->cpu_mhz, h->buckets[b]);
+        }
+    }
+}
+
+// Parks between runs instead of exiting, so a new load never races a task on its way out
+static void load_task(void *arg) {
+    TickType_t period = pdMS_TO_TICKS(LOAD_PERIOD_MS) ? pdMS_TO_TICKS(LOAD_PERIOD_MS) : 1;
+    TickType_t wake = xTaskGetTickCount();
+    while (1) {
+        uint32_t busy_us = load_busy_us;
+        if (busy_us == 0) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            wake = xTaskGetTickCount();
+            continue;
+        }
+        int64_t until = esp_timer_get_time() + busy_us;
+        while (esp_timer_get_time() < until) {
+        }
+        xTaskDelayUntil(&wake, period);
+    }
+}
+
+static int load_cmd(int percent) {
+    if (percent < 0 || percent > LOAD_MAX_PERCENT) {
+        printf("load: 0..%d %%\n", LOAD_MAX_PERCENT);
+        return 1;
+    }
+    load_busy_us = (uint32_t)percent * LOAD_PERIOD_MS * 10;
+    if (load_task_handle != NULL) {
+        xTaskNotifyGive(load_task_handle);
+    } else if (percent > 0 &&
+               xTaskCreatePinnedToCore(load_task, "load", TASK_STACK_LOAD, NULL, TASK_PRIO_LOAD,
+                                       &load_task_handle, TASK_CORE_UI) != pdPASS) {
+        load_busy_us = 0;
+        printf("Out of memory\n");
+        return 1;
+    }
+    printf("Load %d %% at priority %d\n", percent, TASK_PRIO_LOAD);
+    return 0;
+}
+
+int perf_console_cmd(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        perf_reset_histograms();
+        printf("Timing histograms cleared\n");
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "load") == 0) {
+        return load_cmd(argc > 2 ? atoi(argv[2]) : 0);
+    }
+    perf_snapshot_t *snap = malloc(sizeof(perf_snapshot_t));
+    if (snap == NULL || perf_collect(snap) != ESP_OK) {
+        free(snap);
+        printf("Out of memory\n");
+        return 1;
+    }
+    print_report(snap);
+    free(snap);
+    return 0;
+}
+
+esp_err_t perf_init(void) {
+    report_mutex = xSemaphoreCreateMutex();
+    return report_mutex ? ESP_OK : ESP_ERR_NO_MEM;
+}
@@ -0,0 +1,84 @@
+// Runtime performance counters
+// Per-task CPU share and stack high-water marks (FreeRTOS run-time stats),
+// heap figures and cycle-count histograms for the hot paths. Reported by
+// GET /api/perf and by the "perf" serial console command (see console.h).
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_cpu.h"
+
+typedef enum {
+    PERF_SENDER_FRAME = 0,      // Sender: sample/capture, conditioning and esp_now_send()
+    PERF_RX_OUTPUT,             // Receiver: mix and servo/serial output update
+    PERF_RX_CALLBACK,           // Receiver: ESP-NOW receive callback (Wi-Fi task)
+    PERF_LINK_SEAL,             // Sender: frame counter and authentication tag (link_auth.h)
+    PERF_LINK_OPEN,             // Receiver: tag and replay check, inside rx_callback
+    PERF_RX_LATENCY,            // Receiver: frame arrival (rx_callback) to servo output update
+    PERF_TX_LATENCY,            // Sender: esp_now_send() to send callback (tx_pipeline.h)
+    PERF_POINT_COUNT
+} perf_point_t;
+
+// Log2 buckets: [0] < 256 cycles, [i] = 2^(i+7) .. 2^(i+8)-1, last bucket open-ended
+#define PERF_HIST_BUCKETS 16
+#define PERF_HIST_SHIFT 8
+#define PERF_MAX_TASKS 24
+#define PERF_TASK_NAME_LEN 16
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t sum_cycles;
+    uint32_t buckets[PERF_HIST_BUCKETS];
+} perf_hist_t;
+
+typedef struct {
+    char name[PERF_TASK_NAME_LEN];
+    uint8_t priority;
+    uint16_t cpu_permille;      // Share of run time since the previous report
+    uint32_t stack_free;        // Stack high-water mark: bytes never used
+} perf_task_t;
+
+typedef struct {
+    uint8_t num_tasks;
+    perf_task_t tasks[PERF_MAX_TASKS];
+    uint32_t interval_ms;       // Time covered by cpu_permille
+    uint32_t heap_free;
+    uint32_t heap_min_free;     // Minimum ever free heap since boot
+    uint32_t heap_largest;      // Largest free 8-bit capable block
+    uint16_t cpu_mhz;           // Clock the timed paths run at (they hold a power lock)
+    perf_hist_t hist[PERF_POINT_COUNT];
+} perf_snapshot_t;
+
+// Create the report lock
+esp_err_t perf_init(void);
+
+// Time a section: start = perf_begin(); ... perf_end(point, start);
+// Safe from tasks and Wi-Fi/esp_timer callbacks.
+static inline uint32_t perf_begin(void) {
+    return esp_cpu_get_cycle_count();
+}
+void perf_end(perf_point_t point, uint32_t start);
+// Record a duration measured with esp_timer (spans tasks or cores, where cycle
+// counts do not compare); stored as cycles at the nominal CPU clock
+void perf_record_us(perf_point_t point, uint32_t us);
+
+void perf_reset_histograms(void);
+
+// Fill a snapshot (allocates a temporary task list; call from a task)
+esp_err_t perf_collect(perf_snapshot_t *out);
+
+// Format a snapshot as JSON. Returns the length written (truncated at size - 1).
+int perf_format_json(const perf_snapshot_t *snap, char *buf, size_t size);
+
+// Serial console command: "perf" prints a report, "perf reset" clears the histograms,
+// "perf load <percent>" busies a task at the httpd priority (task_config.h) for
+// that share of every 10 ms. The webserver never runs alongside the radio role,
+// so this is how rx_latency is measured under request-handling load.
+int perf_console_cmd(int argc, char **argv);
+
+#endif // PERF_H
@@ -0,0 +1,216 @@
+// Power management implementation
+#include "power.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_pm.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "power";
+
+#define XTAL_FREQ_MHZ 40
+#define DFS_MIN_FREQ_MHZ 80         // Lowest PLL-derived frequency; APB stays at 80 MHz
+
+static power_stats_t stats = {
+    .mode = POWER_MODE_PERFORMANCE,
+    .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+    .min_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+};
+
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t pm_locks[POWER_LOCK_COUNT];
+static bool pm_locks_created = false;
+#endif
+
+// Active-time accounting over the frame-path locks (not POWER_LOCK_WEBSERVER)
+static portMUX_TYPE account_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t lock_count[POWER_LOCK_COUNT];
+static uint32_t active_holders = 0;
+static uint32_t active_since_us = 0;
+static uint32_t active_accum_us = 0;    // Since the last frame mark
+static uint32_t last_frame_us = 0;
+static uint32_t window_active_us = 0;
+static uint32_t window_interval_us = 0;
+static uint32_t window_frames = 0;
+
+#if CONFIG_PM_ENABLE
+static esp_err_t create_locks(void) {
+    static const struct {
+        esp_pm_lock_type_t type;
+        const char *name;
+    } defs[POWER_LOCK_COUNT] = {
+        [POWER_LOCK_ADC]       = {ESP_PM_CPU_FREQ_MAX, "adc"},
+        [POWER_LOCK_TX]        = {ESP_PM_CPU_FREQ_MAX, "tx"},
+        [POWER_LOCK_OUTPUT]    = {ESP_PM_CPU_FREQ_MAX, "output"},
+        [POWER_LOCK_WEBSERVER] = {ESP_PM_NO_LIGHT_SLEEP, "webserver"},
+    };
+    for (int i = 0; i < POWER_LOCK_COUNT; i++) {
+        esp_err_t err = esp_pm_lock_create(defs[i].type, 0, defs[i].name, &pm_locks[i]);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    pm_locks_created = true;
+    return ESP_OK;
+}
+#endif
+
+esp_err_t power_configure(power_mode_t mode, uint32_t latency_budget_us, bool is_sender) {
+    if (mode >= POWER_MODE_COUNT) {
+        mode = POWER_MODE_PERFORMANCE;
+    }
+    uint16_t max_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    uint16_t min_mhz = max_mhz;
+    bool light_sleep = false;
+
+    if (mode == POWER_MODE_LIGHT_SLEEP && !is_sender) {
+        ESP_LOGW(TAG, "Light sleep would stop the receiver radio; using DFS only");
+        mode = POWER_MODE_DFS;
+    }
+    if (mode != POWER_MODE_PERFORMANCE) {
+        min_mhz = (latency_budget_us >= POWER_XTAL_WAKE_US) ? XTAL_FREQ_MHZ : DFS_MIN_FREQ_MHZ;
+        // Servo PWM timers are clocked from APB, which follows the CPU below 80 MHz
+        if (!is_sender) {
+            min_mhz = DFS_MIN_FREQ_MHZ;
+        }
+    }
+    if (mode == POWER_MODE_LIGHT_SLEEP) {
+        if (latency_budget_us >= POWER_LIGHT_SLEEP_WAKE_US) {
+            light_sleep = true;
+        } else {
+            ESP_LOGW(TAG, "Latency budget %lu us is below the light sleep wake-up cost (%d us); using DFS only",
+                     latency_budget_us, POWER_LIGHT_SLEEP_WAKE_US);
+            mode = POWER_MODE_DFS;
+        }
+    }
+
+#if CONFIG_PM_ENABLE
+    if (!pm_locks_created) {
+        esp_err_t err = create_locks();
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create PM locks: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+    esp_pm_config_t cfg = {
+        .max_freq_mhz = max_mhz,
+        .min_freq_mhz = min_mhz,
+        .light_sleep_enable = light_sleep,
+    };
+    esp_err_t err = esp_pm_configure(&cfg);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_pm_configure failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    // The Wi-Fi driver blocks light sleep unless modem sleep is enabled
+    if (light_sleep) {
+        esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+    }
+#else
+    if (mode != POWER_MODE_PERFORMANCE) {
+        ESP_LOGW(TAG, "CONFIG_PM_ENABLE is off; running at fixed frequency");
+        mode = POWER_MODE_PERFORMANCE;
+        min_mhz = max_mhz;
+        light_sleep = false;
+    }
+#endif
+
+    portENTER_CRITICAL(&account_lock);
+    stats.mode = (uint8_t)mode;
+    stats.max_freq_mhz = max_mhz;
+    stats.min_freq_mhz = min_mhz;
+    stats.light_sleep = light_sleep;
+    stats.frames = 0;
+    stats.active_us = 0;
+    stats.idle_us = 0;
+    stats.active_permille = 0;
+    active_accum_us = 0;
+    window_active_us = 0;
+    window_interval_us = 0;
+    window_frames = 0;
+    last_frame_us = 0;
+    portEXIT_CRITICAL(&account_lock);
+
+    ESP_LOGI(TAG, "Power mode %d: %u-%u MHz, light sleep %s, budget %lu us",
+             mode, min_mhz, max_mhz, light_sleep ? "on" : "off", latency_budget_us);
+    return ESP_OK;
+}
+
+void power_lock_acquire(power_lock_t lock) {
+#if CONFIG_PM_ENABLE
+    if (pm_locks_created) {
+        esp_pm_lock_acquire(pm_locks[lock]);
+    }
+#endif
+    if (lock == POWER_LOCK_WEBSERVER) {
+        return;
+    }
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL(&account_lock);
+    lock_count[lock]++;
+    if (active_holders++ == 0) {
+        active_since_us = now;
+    }
+    portEXIT_CRITICAL(&account_lock);
+}
+
+void power_lock_release(power_lock_t lock) {
+    if (lock != POWER_LOCK_WEBSERVER) {
+        uint32_t now = (uint32_t)esp_timer_get_time();
+        portENTER_CRITICAL(&account_lock);
+        if (lock_count[lock] == 0) {
+            portEXIT_CRITICAL(&account_lock);
+            return;     // Unbalanced release (e.g. send callback after a restart)
+        }
+        lock_count[lock]--;
+        if (--active_holders == 0) {
+            active_accum_us += now - active_since_us;
+        }
+        portEXIT_CRITICAL(&account_lock);
+    }
+#if CONFIG_PM_ENABLE
+    if (pm_locks_created) {
+        esp_pm_lock_release(pm_locks[lock]);
+    }
+#endif
+}
+
+void power_frame_done(void) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL(&account_lock);
+    uint32_t active = active_accum_us;
+    if (active_holders > 0) {
+        // Still active (e.g. TX in flight): count up to now, continue from here
+        active += now - active_since_us;
+        active_since_us = now;
+    }
+    active_accum_us = 0;
+
+    if (last_frame_us != 0) {
+        window_active_us += active;
+        window_interval_us += now - last_frame_us;
+        if (++window_frames == POWER_STATS_WINDOW) {
+            uint32_t avg_active = window_active_us / POWER_STATS_WINDOW;
+            uint32_t avg_interval = window_interval_us / POWER_STATS_WINDOW;
+            if (avg_active > avg_interval) {
+                avg_active = avg_interval;
+            }
+            stats.active_us = avg_active;
+            stats.idle_us = avg_interval - avg_active;
+            stats.active_permille = avg_interval ? (uint16_t)((uint64_t)avg_active * 1000 / avg_interval) : 0;
+            window_active_us = 0;
+            window_interval_us = 0;
+            window_frames = 0;
+        }
+    }
+    last_frame_us = now;
+    stats.frames++;
+    portEXIT_CRITICAL(&account_lock);
+}
+
+void power_get_stats(power_stats_t *out) {
+    portENTER_CRITICAL(&account_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&account_lock);
+}
@@ -0,0 +1,62 @@
+// Power management (esp_pm dynamic frequency scaling and automatic light sleep)
+// The CPU runs at full speed only while a power lock is held: around ADC
+// sampling and transmit on the sender, around frame processing and output
+// updates on the receiver. Between frames it drops to the minimum frequency
+// and, if allowed, into light sleep via tickless idle. The time locks are
+// held per frame is accounted so the savings can be read from /api/status.
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef enum {
+    POWER_MODE_PERFORMANCE = 0, // Fixed maximum CPU frequency (no esp_pm)
+    POWER_MODE_DFS = 1,         // Dynamic frequency scaling, radio always on
+    POWER_MODE_LIGHT_SLEEP = 2, // DFS plus automatic light sleep between frames (sender only)
+    POWER_MODE_COUNT
+} power_mode_t;
+
+typedef enum {
+    POWER_LOCK_ADC = 0,         // Sender: ADC sampling and frame build
+    POWER_LOCK_TX,              // Sender: from esp_now_send() until the send callback
+    POWER_LOCK_OUTPUT,          // Receiver: frame decode and servo/light/serial output
+    POWER_LOCK_WEBSERVER,       // Config mode: SoftAP and HTTP must stay responsive
+    POWER_LOCK_COUNT
+} power_lock_t;
+
+// Wake-up cost assumed when applying the latency budget
+#define POWER_LIGHT_SLEEP_WAKE_US 1000  // Light sleep exit (flash/CPU power-up, PLL lock)
+#define POWER_XTAL_WAKE_US 250          // Running ISRs and lock acquisition at XTAL clock
+#define POWER_BUDGET_DEFAULT_US 2000
+#define POWER_STATS_WINDOW 64           // Frames per active/idle statistics window
+
+typedef struct {
+    uint8_t mode;               // power_mode_t in effect
+    uint16_t max_freq_mhz;
+    uint16_t min_freq_mhz;
+    bool light_sleep;           // Light sleep actually enabled
+    uint32_t frames;            // Frames counted since power_configure()
+    uint32_t active_us;         // Average lock-held time per frame over the last window
+    uint32_t idle_us;           // Average remaining time per frame
+    uint16_t active_permille;   // active / frame interval
+} power_stats_t;
+
+// Apply the power mode. latency_budget_us is the extra delay the role can
+// tolerate when woken from idle; it decides the minimum CPU frequency and
+// whether light sleep is allowed. is_sender enables light sleep at all
+// (the receiver must keep its radio listening).
+esp_err_t power_configure(power_mode_t mode, uint32_t latency_budget_us, bool is_sender);
+
+// Hold the CPU at maximum frequency (and out of light sleep) while held.
+// Safe from tasks and Wi-Fi callbacks; not from ISRs.
+void power_lock_acquire(power_lock_t lock);
+void power_lock_release(power_lock_t lock);
+
+// Mark the end of one frame (after transmit / after applying outputs)
+void power_frame_done(void);
+
+void power_get_stats(power_stats_t *out);
+
+#endif // POWER_H
@@ -0,0 +1,310 @@
+// Model profiles implementation
+#include "profiles.h"
+#include "settings.h"
+#include "board.h"
+#include "bind.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "profiles";
+
+#define PROFILE_VERSION 1
+#define NVS_ACTIVE "model_act"
+
+// Stored form; a blob of another size or version is ignored (slot left empty)
+typedef struct {
+    uint8_t version;
+    model_profile_t p;
+} profile_blob_t;
+
+typedef enum {
+    PREPARED_NONE = 0,
+    PREPARED_SENDER,
+    PREPARED_RECEIVER,
+} prepared_role_t;
+
+static model_profile_t profiles[PROFILE_COUNT];
+static bool valid[PROFILE_COUNT];
+static int active = 0;
+static device_settings_t *working = NULL;
+static prepared_role_t prepared = PREPARED_NONE;
+static SemaphoreHandle_t lock = NULL;
+static device_settings_t scratch;   // Compile input, guarded by lock
+
+static void blob_key(int slot, char *key, size_t len) {
+    snprintf(key, len, "model%d", slot);
+}
+
+static void profile_capture(model_profile_t *p, const device_settings_t *s) {
+    memcpy(p->peer_mac, s->peer_mac, PEER_MAC_LEN);
+    p->peer_bound = s->peer_bound;
+    p->peer_num_channels = s->peer_num_channels;
+    p->peer_caps = s->peer_caps;
+    memcpy(p->ch_deadband, s->ch_deadband, sizeof(p->ch_deadband));
+    memcpy(p->ch_trim, s->ch_trim, sizeof(p->ch_trim));
+    memcpy(p->ch_filter, s->ch_filter, sizeof(p->ch_filter));
+    memcpy(p->ch_filter_strength, s->ch_filter_strength, sizeof(p->ch_filter_strength));
+    memcpy(p->ch_reverse, s->ch_reverse, sizeof(p->ch_reverse));
+    memcpy(p->servo_min, s->servo_min, sizeof(p->servo_min));
+    memcpy(p->servo_center, s->servo_center, sizeof(p->servo_center));
+    memcpy(p->servo_max, s->servo_max, sizeof(p->servo_max));
+    memcpy(p->expo, s->expo, sizeof(p->expo));
+    memcpy(p->ch_slew, s->ch_slew, sizeof(p->ch_slew));
+    p->mix_preset = s->mix_preset;
+    memcpy(p->mix_weight, s->mix_weight, sizeof(p->mix_weight));
+    memcpy(p->mix_offset, s->mix_offset, sizeof(p->mix_offset));
+}
+
+static void profile_apply(const model_profile_t *p, device_settings_t *s) {
+    memcpy(s->peer_mac, p->peer_mac, PEER_MAC_LEN);
+    s->peer_bound = p->peer_bound;
+    s->peer_num_channels = p->peer_num_channels;
+    s->peer_caps = p->peer_caps;
+    memcpy(s->ch_deadband, p->ch_deadband, sizeof(s->ch_deadband));
+    memcpy(s->ch_trim, p->ch_trim, sizeof(s->ch_trim));
+    memcpy(s->ch_filter, p->ch_filter, sizeof(s->ch_filter));
+    memcpy(s->ch_filter_strength, p->ch_filter_strength, sizeof(s->ch_filter_strength));
+    memcpy(s->ch_reverse, p->ch_reverse, sizeof(s->ch_reverse));
+    memcpy(s->servo_min, p->servo_min, sizeof(s->servo_min));
+    memcpy(s->servo_center, p->servo_center, sizeof(s->servo_center));
+    memcpy(s->servo_max, p->servo_max, sizeof(s->servo_max));
+    memcpy(s->expo, p->expo, sizeof(s->expo));
+    memcpy(s->ch_slew, p->ch_slew, sizeof(s->ch_slew));
+    s->mix_preset = p->mix_preset;
+    memcpy(s->mix_weight, p->mix_weight, sizeof(s->mix_weight));
+    memcpy(s->mix_offset, p->mix_offset, sizeof(s->mix_offset));
+}
+
+static esp_err_t profile_save(int slot) {
+    profile_blob_t blob = {.version = PROFILE_VERSION, .p = profiles[slot]};
+    char key[16];
+    blob_key(slot, key, sizeof(key));
+    return settings_save_blob(key, &blob, sizeof(blob));
+}
+
+// Compile slot for the running role: working copy with the profile applied
+static void compile_slot(int slot) {
+    if (prepared == PREPARED_NONE) {
+        return;
+    }
+    scratch = *working;
+    profile_apply(&profiles[slot], &scratch);
+#if RC_ROLE_SENDER
+    if (prepared == PREPARED_SENDER) {
+        sender_prepare_profile(slot, &scratch);
+    }
+#endif
+#if RC_ROLE_RECEIVER
+    if (prepared == PREPARED_RECEIVER) {
+        receiver_prepare_profile(slot, &scratch);
+    }
+#endif
+}
+
+void profiles_init(device_settings_t *settings) {
+    lock = xSemaphoreCreateMutex();
+    configASSERT(lock);
+    working = settings;
+
+    int count = 0;
+    for (int i = 0; i < PROFILE_COUNT; i++) {
+        profile_blob_t blob;
+        char key[16];
+        blob_key(i, key, sizeof(key));
+        valid[i] = settings_load_blob(key, &blob, sizeof(blob)) == ESP_OK && blob.version == PROFILE_VERSION;
+        if (valid[i]) {
+            profiles[i] = blob.p;
+            profiles[i].name[PROFILE_NAME_LEN - 1] = '\0';
+            count++;
+        }
+    }
+
+    if (count == 0) {
+        // First start with profiles: the existing configuration becomes model 1
+        memset(&profiles[0], 0, sizeof(profiles[0]));
+        snprintf(profiles[0].name, PROFILE_NAME_LEN, "Model 1");
+        profile_capture(&profiles[0], settings);
+        valid[0] = true;
+        count = 1;
+        if (profile_save(0) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to save profile 0");
+        }
+        settings_save_counter(NVS_ACTIVE, 0);
+    }
+
+    active = (int)settings_load_counter(NVS_ACTIVE);
+    if (active >= PROFILE_COUNT || !valid[active]) {
+        for (active = 0; !valid[active]; active++) {
+        }
+    }
+    profile_apply(&profiles[active], settings);
+    ESP_LOGI(TAG, "%d profile(s), active %d '%s'", count, active, profiles[active].name);
+}
+
+int profiles_active(void) {
+    return active;
+}
+
+bool profiles_valid(int slot) {
+    return slot >= 0 && slot < PROFILE_COUNT && valid[slot];
+}
+
+const char *profiles_name(int slot) {
+    return profiles_valid(slot) ? profiles[slot].name : "";
+}
+
+esp_err_t profiles_store(int slot, const char *name) {
+    if (slot < 0 || slot >= PROFILE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    model_profile_t *p = &profiles[slot];
+    if (!valid[slot]) {
+        memset(p, 0, sizeof(*p));
+        snprintf(p->name, PROFILE_NAME_LEN, "Model %d", slot + 1);
+    }
+    if (name != NULL && name[0] != '\0') {
+        snprintf(p->name, PROFILE_NAME_LEN, "%s", name);
+        // Names go into JSON and console tables unescaped
+        for (char *c = p->name; *c; c++) {
+            if (*c < ' ' || *c == '"' || *c == '\\') {
+                *c = '_';
+            }
+        }
+    }
+    profile_capture(p, working);
+    esp_err_t err = profile_save(slot);
+    if (err == ESP_OK) {
+        valid[slot] = true;
+        compile_slot(slot);
+    }
+    xSemaphoreGive(lock);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save profile %d: %s", slot, esp_err_to_name(err));
+    }
+    return err;
+}
+
+void profiles_store_active(void) {
+    profiles_store(active, NULL);
+}
+
+esp_err_t profiles_delete(int slot) {
+    if (!profiles_valid(slot)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (slot == active) {
+        return ESP_ERR_INVALID_STATE;   // Switch away first
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    char key[16];
+    blob_key(slot, key, sizeof(key));
+    esp_err_t err = settings_erase_key(key);
+    if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+        valid[slot] = false;
+        err = ESP_OK;
+    }
+    xSemaphoreGive(lock);
+    return err;
+}
+
+void profiles_prepare(bool is_sender) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    prepared = is_sender ? PREPARED_SENDER : PREPARED_RECEIVER;
+    for (int i = 0; i < PROFILE_COUNT; i++) {
+        if (valid[i]) {
+            compile_slot(i);
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+esp_err_t profiles_switch(int slot) {
+    if (!profiles_valid(slot)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (bind_get_state() == BIND_ACTIVE) {
+        return ESP_ERR_INVALID_STATE;   // Bind mode owns the ESP-NOW peers
+    }
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(lock, portMAX_DELAY);
+    const model_profile_t *p = &profiles[slot];
+    esp_err_t err = ESP_OK;
+    // The radio side first: a peer that cannot be registered leaves the old profile active
+#if RC_ROLE_SENDER
+    if (prepared == PREPARED_SENDER) {
+        err = sender_select_profile(slot, p->peer_mac);
+    }
+#endif
+#if RC_ROLE_RECEIVER
+    if (prepared == PREPARED_RECEIVER) {
+        err = receiver_select_profile(slot, p->peer_mac, p->peer_bound);
+    }
+#endif
+    if (err != ESP_OK) {
+        xSemaphoreGive(lock);
+        ESP_LOGE(TAG, "Profile %d not switched: %s", slot, esp_err_to_name(err));
+        return err;
+    }
+    active = slot;
+    profile_apply(&profiles[slot], working);
+    xSemaphoreGive(lock);
+    int64_t switched = esp_timer_get_time();
+
+    // The working copy in NVS is left alone: profiles_init() reapplies the
+    // active profile over it on the next start
+    settings_save_counter(NVS_ACTIVE, (uint32_t)slot);
+    ESP_LOGI(TAG, "Profile %d '%s' active (peer " MACSTR "), switched in %lld us", slot, p->name,
+             MAC2STR(p->peer_mac), (long long)(switched - start));
+    return ESP_OK;
+}
+
+esp_err_t profiles_switch_next(void) {
+    for (int i = 1; i <= PROFILE_COUNT; i++) {
+        int slot = (active + i) % PROFILE_COUNT;
+        if (valid[slot]) {
+            return slot == active ? ESP_OK : profiles_switch(slot);
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static void print_profiles(void) {
+    for (int i = 0; i < PROFILE_COUNT; i++) {
+        if (!valid[i]) {
+            continue;
+        }
+        printf("%c %d  %-16s " MACSTR "%s\n", i == active ? '*' : ' ', i, profiles[i].name,
+               MAC2STR(profiles[i].peer_mac), profiles[i].peer_bound ? " (bound)" : "");
+    }
+}
+
+int profiles_console_cmd(int argc, char **argv) {
+    if (argc < 2) {
+        print_profiles();
+        return 0;
+    }
+    esp_err_t err;
+    if (strcmp(argv[1], "save") == 0 && argc >= 3) {
+        err = profiles_store(atoi(argv[2]), argc >= 4 ? argv[3] : NULL);
+    } else if (strcmp(argv[1], "delete") == 0 && argc >= 3) {
+        err = profiles_delete(atoi(argv[2]));
+    } else if (argv[1][0] >= '0' && argv[1][0] <= '9') {
+        err = profiles_switch(atoi(argv[1]));
+    } else {
+        printf("usage: profile [<n> | save <n> [name] | delete <n>]\n");
+        return 1;
+    }
+    if (err != ESP_OK) {
+        printf("profile: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+    print_profiles();
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Model profiles
+// One transmitter, several vehicles: each profile holds the per-model part of
+// device_settings_t (peer, input conditioning, servo endpoints, expo and slew,
+// mixer) and is stored as one NVS blob. Hardware setup (PWM frame rates, output
+// rate, serial protocol, link security) stays device-wide. device_settings_t stays
+// the working copy of the active profile. At role start every profile is
+// compiled into the runtime form the frame path uses (sender: input pipeline
+// configuration, receiver: rx_config_t snapshot), so a switch only publishes
+// a precompiled configuration and re-targets the ESP-NOW peer.
+#ifndef PROFILES_H
+#define PROFILES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "common.h"
+
+#define PROFILE_COUNT 8
+#define PROFILE_NAME_LEN 16
+
+typedef struct {
+    char name[PROFILE_NAME_LEN];
+    uint8_t peer_mac[PEER_MAC_LEN];
+    bool peer_bound;
+    uint8_t peer_num_channels;
+    uint16_t peer_caps;
+    uint16_t ch_deadband[NUM_CHANNELS];
+    int16_t ch_trim[NUM_CHANNELS];
+    uint8_t ch_filter[NUM_CHANNELS];
+    uint8_t ch_filter_strength[NUM_CHANNELS];
+    bool ch_reverse[NUM_CHANNELS];
+    uint16_t servo_min[NUM_CHANNELS];
+    uint16_t servo_center[NUM_CHANNELS];
+    uint16_t servo_max[NUM_CHANNELS];
+    float expo[NUM_CHANNELS];
+    uint16_t ch_slew[NUM_CHANNELS];
+    uint8_t mix_preset;
+    int8_t mix_weight[NUM_CHANNELS][NUM_CHANNELS];
+    int8_t mix_offset[NUM_CHANNELS];
+} model_profile_t;
+
+// Load all profiles; settings is the working copy (kept by the caller for the
+// lifetime of the program). A device without profiles gets "Model 1" from its
+// current settings.
+void profiles_init(device_settings_t *settings);
+
+int profiles_active(void);
+bool profiles_valid(int slot);
+const char *profiles_name(int slot);
+
+// Save the working copy into slot (creating it) under name (NULL keeps the old name)
+esp_err_t profiles_store(int slot, const char *name);
+// Save the working copy into the active profile (after a settings change)
+void profiles_store_active(void);
+esp_err_t profiles_delete(int slot);
+
+// Compile every profile for the role about to start (call before sender/receiver start)
+void profiles_prepare(bool is_sender);
+
+// Make slot active: the working copy is replaced, the running role switches to
+// the precompiled configuration and peer immediately, and the choice is saved.
+// Safe from any task.
+esp_err_t profiles_switch(int slot);
+// Next valid profile after the active one (wraps)
+esp_err_t profiles_switch_next(void);
+
+// Serial console command: "profile" lists, "profile <n>" switches
+int profiles_console_cmd(int argc, char **argv);
+
+#endif // PROFILES_H
@@ -0,0 +1,189 @@
+// RC serial protocol encoders implementation
+#include "rc_protocol.h"
+#include <string.h>
+
+uint16_t rc_us_to_ticks(uint16_t us) {
+    int32_t t = (((int32_t)us - 880) * 8 + 2) / 5;
+    if (t < 0) t = 0;
+    if (t > 2047) t = 2047;
+    return (uint16_t)t;
+}
+
+uint16_t rc_ticks_to_us(uint16_t ticks) {
+    return (uint16_t)(((uint32_t)ticks * 5 + 4) / 8 + 880);
+}
+
+void rc_pack_11bit(const uint16_t *ticks, uint8_t *out) {
+    uint32_t bits = 0;
+    int nbits = 0;
+    int o = 0;
+    memset(out, 0, 22);
+    for (int i = 0; i < RC_PROTO_CHANNELS; i++) {
+        bits |= (uint32_t)(ticks[i] & 0x07FF) << nbits;
+        nbits += 11;
+        while (nbits >= 8) {
+            out[o++] = (uint8_t)(bits & 0xFF);
+            bits >>= 8;
+            nbits -= 8;
+        }
+    }
+}
+
+void rc_pack_12bit(const uint16_t *values, int n, uint8_t *out) {
+    int i = 0;
+    for (; i + 1 < n; i += 2) {
+        uint16_t a = values[i] & 0x0FFF;
+        uint16_t b = values[i + 1] & 0x0FFF;
+        *out++ = (uint8_t)a;
+        *out++ = (uint8_t)((a >> 8) | (b << 4));
+        *out++ = (uint8_t)(b >> 4);
+    }
+    if (i < n) {
+        uint16_t a = values[i] & 0x0FFF;
+        *out++ = (uint8_t)a;
+        *out = (uint8_t)(a >> 8);
+    }
+}
+
+void rc_unpack_12bit(const uint8_t *in, int n, uint16_t *values) {
+    int i = 0;
+    for (; i + 1 < n; i += 2) {
+        values[i] = (uint16_t)(in[0] | ((in[1] & 0x0F) << 8));
+        values[i + 1] = (uint16_t)((in[1] >> 4) | (in[2] << 4));
+        in += 3;
+    }
+    if (i < n) {
+        values[i] = (uint16_t)(in[0] | ((in[1] & 0x0F) << 8));
+    }
+}
+
+void rc_unpack_11bit(const uint8_t *in, uint16_t *ticks) {
+    uint32_t bits = 0;
+    int nbits = 0;
+    int o = 0;
+    for (int i = 0; i < 22; i++) {
+        bits |= (uint32_t)in[i] << nbits;
+        nbits += 8;
+        if (nbits >= 11) {
+            ticks[o++] = (uint16_t)(bits & 0x07FF);
+            bits >>= 11;
+            nbits -= 11;
+        }
+    }
+}
+
+uint8_t crsf_crc8(const uint8_t *data, int len) {
+    uint8_t crc = 0;
+    for (int i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0xD5) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void fill_ticks(const uint16_t *us, int num_ch, uint16_t *ticks) {
+    for (int i = 0; i < RC_PROTO_CHANNELS; i++) {
+        ticks[i] = (i < num_ch) ? rc_us_to_ticks(us[i]) : RC_TICKS_CENTER;
+    }
+}
+
+void sbus_encode(const uint16_t *us, int num_ch, uint8_t flags, uint8_t out[SBUS_FRAME_LEN]) {
+    uint16_t ticks[RC_PROTO_CHANNELS];
+    fill_ticks(us, num_ch, ticks);
+    out[0] = SBUS_HEADER;
+    rc_pack_11bit(ticks, &out[1]);
+    out[23] = flags;
+    out[24] = SBUS_FOOTER;
+}
+
+void crsf_encode_rc(const uint16_t *us, int num_ch, uint8_t out[CRSF_RC_FRAME_LEN]) {
+    uint16_t ticks[RC_PROTO_CHANNELS];
+    fill_ticks(us, num_ch, ticks);
+    out[0] = CRSF_ADDR_FLIGHT_CONTROLLER;
+    out[1] = CRSF_RC_PAYLOAD_LEN + 2;     // type + payload + crc
+    out[2] = CRSF_FRAMETYPE_RC_CHANNELS;
+    rc_pack_11bit(ticks, &out[3]);
+    out[CRSF_RC_FRAME_LEN - 1] = crsf_crc8(&out[2], CRSF_RC_PAYLOAD_LEN + 1);
+}
+
+int ppm_encode(const uint16_t *us, int num_ch, uint32_t frame_us, uint16_t *durations) {
+    uint32_t used = 0;
+    int n = 0;
+    for (int i = 0; i < num_ch; i++) {
+        uint16_t w = us[i];
+        if (w < PPM_PULSE_US * 2) w = PPM_PULSE_US * 2;
+        durations[n++] = PPM_PULSE_US;
+        durations[n++] = (uint16_t)(w - PPM_PULSE_US);
+        used += w;
+    }
+    // Sync: pulse, then a gap padding the frame (never shorter than PPM_SYNC_MIN_US)
+    uint32_t gap = (frame_us > used + PPM_SYNC_MIN_US) ? frame_us - used : PPM_SYNC_MIN_US;
+    durations[n++] = PPM_PULSE_US;
+    durations[n++] = (uint16_t)(gap - PPM_PULSE_US);
+    return n;
+}
+
+void sbus_parser_reset(sbus_parser_t *p) {
+    p->pos = 0;
+}
+
+static bool sbus_footer_valid(uint8_t footer) {
+    return footer == SBUS_FOOTER || (footer & 0x0F) == 0x04;
+}
+
+bool sbus_parser_feed(sbus_parser_t *p, uint8_t byte) {
+    if (p->pos == 0 && byte != SBUS_HEADER) {
+        return false;
+    }
+    p->buf[p->pos++] = byte;
+    if (p->pos < SBUS_FRAME_LEN) {
+        return false;
+    }
+    if (sbus_footer_valid(p->buf[SBUS_FRAME_LEN - 1])) {
+        p->pos = 0;
+        return true;
+    }
+    // Misaligned: restart from the next header candidate inside the buffer
+    int start = 1;
+    while (start < SBUS_FRAME_LEN && p->buf[start] != SBUS_HEADER) {
+        start++;
+    }
+    p->pos = (uint8_t)(SBUS_FRAME_LEN - start);
+    memmove(p->buf, &p->buf[start], p->pos);
+    return false;
+}
+
+bool sbus_decode(const uint8_t frame[SBUS_FRAME_LEN], uint16_t *us, int num_ch, uint8_t *flags) {
+    if (frame[0] != SBUS_HEADER || !sbus_footer_valid(frame[SBUS_FRAME_LEN - 1])) {
+        return false;
+    }
+    uint16_t ticks[RC_PROTO_CHANNELS];
+    rc_unpack_11bit(&frame[1], ticks);
+    if (num_ch > RC_PROTO_CHANNELS) {
+        num_ch = RC_PROTO_CHANNELS;
+    }
+    for (int i = 0; i < num_ch; i++) {
+        us[i] = rc_ticks_to_us(ticks[i]);
+    }
+    if (flags) {
+        *flags = frame[23];
+    }
+    return true;
+}
+
+int ppm_decode(const uint16_t *widths, int n, uint16_t *us, int max_ch) {
+    if (n < PPM_MIN_CHANNELS || n > PPM_MAX_CHANNELS) {
+        return 0;
+    }
+    for (int i = 0; i < n; i++) {
+        if (widths[i] < PPM_CH_US_MIN || widths[i] > PPM_CH_US_MAX) {
+            return 0;
+        }
+    }
+    for (int i = 0; i < n && i < max_ch; i++) {
+        us[i] = widths[i];
+    }
+    return n;
+}
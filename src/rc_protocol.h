@@ -0,0 +1,95 @@
+// RC serial protocol encoders and decoders (SBUS, CRSF, PPM)
+// Pure frame builders/parsers with no ESP-IDF dependencies; the transports live in
+// serial_output.c (receiver outputs) and input_source.c (sender trainer input).
+// Tested on the host in test/test_rc_protocol.
+#ifndef RC_PROTOCOL_H
+#define RC_PROTOCOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RC_PROTO_CHANNELS 16            // Channels carried by SBUS and CRSF frames
+
+// Channel value scale shared by SBUS and CRSF: ticks = (us - 880) * 8 / 5
+// 172 = 987.5 µs, 992 = 1500 µs, 1811 = 2011.9 µs
+#define RC_TICKS_MIN 172
+#define RC_TICKS_CENTER 992
+#define RC_TICKS_MAX 1811
+
+// SBUS: 100000 baud, 8E2, inverted; header, 22 bytes of 11-bit channels, flags, footer
+#define SBUS_FRAME_LEN 25
+#define SBUS_HEADER 0x0F
+#define SBUS_FOOTER 0x00
+#define SBUS_FLAG_CH17 0x01
+#define SBUS_FLAG_CH18 0x02
+#define SBUS_FLAG_FRAME_LOST 0x04
+#define SBUS_FLAG_FAILSAFE 0x08
+
+// CRSF: 420000 baud 8N1; [addr][len][type][payload][crc8 DVB-S2 over type+payload]
+#define CRSF_ADDR_FLIGHT_CONTROLLER 0xC8
+#define CRSF_FRAMETYPE_RC_CHANNELS 0x16
+#define CRSF_RC_PAYLOAD_LEN 22
+#define CRSF_RC_FRAME_LEN (CRSF_RC_PAYLOAD_LEN + 4)
+
+// PPM: one separator pulse per channel, then a sync gap padding the frame
+#define PPM_FRAME_US_DEFAULT 22500
+#define PPM_PULSE_US 300
+#define PPM_SYNC_MIN_US 3000
+#define PPM_CH_US_MIN 700               // Decoder: accepted channel width range
+#define PPM_CH_US_MAX 2300
+#define PPM_MIN_CHANNELS 4              // Decoder: shorter trains are treated as noise
+#define PPM_MAX_CHANNELS 16
+
+// Microseconds to SBUS/CRSF ticks (clamped to 0..2047)
+uint16_t rc_us_to_ticks(uint16_t us);
+// SBUS/CRSF ticks to microseconds
+uint16_t rc_ticks_to_us(uint16_t ticks);
+
+// Pack 16 x 11-bit values little-endian into 22 bytes
+void rc_pack_11bit(const uint16_t *ticks, uint8_t *out);
+// Unpack 22 bytes into 16 x 11-bit values
+void rc_unpack_11bit(const uint8_t *in, uint16_t *ticks);
+
+// Pack n 12-bit values little-endian, two values per three bytes; an odd last
+// value takes two bytes. Writes (n * 12 + 7) / 8 bytes.
+void rc_pack_12bit(const uint16_t *values, int n, uint8_t *out);
+// Inverse of rc_pack_12bit()
+void rc_unpack_12bit(const uint8_t *in, int n, uint16_t *values);
+
+// CRC8 with polynomial 0xD5 (DVB-S2), as used by CRSF
+uint8_t crsf_crc8(const uint8_t *data, int len);
+
+// Build an SBUS frame from num_ch servo positions (µs); missing channels are centered
+void sbus_encode(const uint16_t *us, int num_ch, uint8_t flags, uint8_t out[SBUS_FRAME_LEN]);
+
+// Build a CRSF RC_CHANNELS_PACKED frame; missing channels are centered
+void crsf_encode_rc(const uint16_t *us, int num_ch, uint8_t out[CRSF_RC_FRAME_LEN]);
+
+// Build PPM timing: for each channel a PPM_PULSE_US pulse followed by the
+// remainder of its width, then a sync pulse and gap filling frame_us.
+// durations[] receives alternating pulse/space lengths in µs (2 * (num_ch + 1) entries).
+// Returns the number of entries written.
+int ppm_encode(const uint16_t *us, int num_ch, uint32_t frame_us, uint16_t *durations);
+
+// SBUS byte-stream parser: resynchronizes on the header and accepts the SBUS
+// (0x00) and SBUS2 (0x?4) footers
+typedef struct {
+    uint8_t buf[SBUS_FRAME_LEN];
+    uint8_t pos;
+} sbus_parser_t;
+
+void sbus_parser_reset(sbus_parser_t *p);
+
+// Feed one byte; returns true when p->buf holds a complete frame
+bool sbus_parser_feed(sbus_parser_t *p, uint8_t byte);
+
+// Decode a complete SBUS frame into num_ch servo positions (µs) and the flags byte.
+// Returns false if the header or footer is invalid.
+bool sbus_decode(const uint8_t frame[SBUS_FRAME_LEN], uint16_t *us, int num_ch, uint8_t *flags);
+
+// Decode one PPM frame given the channel widths (pulse + space, µs) measured
+// between sync gaps. Copies up to max_ch channels into us[].
+// Returns the number of channels in the frame, or 0 if it is not a valid frame.
+int ppm_decode(const uint16_t *widths, int n, uint16_t *us, int max_ch);
+
+#endif // RC_PROTOCOL_H
@@ -1,20 +1,58 @@
 // Receiver implementation for ESP-NOW radio control
 #include "common.h"
 #include "settings.h"
+#include "mixer.h"
+#include "output_stage.h"
+#include "rx_config.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_now.h"
 #include "driver/gpio.h"
-#include "driver/ledc.h"
+#include "servo_pwm.h"
+#include "serial_output.h"
+#include "power.h"
+#include "perf.h"
+#include "trace.h"
+#include "link_auth.h"
+#include "profiles.h"
+#include "blackbox.h"
+#include "task_config.h"
+#include "esp_timer.h"
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "receiver";
 static volatile control_packet_t last_pkt = {0};
 static volatile uint8_t have_pkt = 0;
+static volatile uint32_t pkt_seq = 0;       // Incremented per received frame
+static volatile uint32_t pkt_time_us = 0;   // Arrival time of the latest frame
 static TaskHandle_t receiver_task_handle = NULL;
-static device_settings_t *g_settings = NULL;
+
+// Settings reach the frame path only as published rx_config_t snapshots (see
+// rx_config.h): each frame uses one complete configuration, old or new
+static uint16_t mixed_ch[NUM_CHANNELS];  // Last mixer output (packet units)
+
+// Output stage: when output_rate_hz > 0, servos are driven from a periodic
+// esp_timer that interpolates between frames instead of from receiver_task()
+static output_stage_t output_stage;
+static uint32_t output_generation = 0;  // Snapshot generation output_stage.cfg was taken from
+static esp_timer_handle_t output_timer = NULL;
+static uint32_t output_seq = 0;
+
+// Packet arrival to light GPIO update, for light changes
+static uint32_t light_lat_last_us = 0;
+static uint32_t light_lat_max_us = 0;
+
+// Event frames (event_frame.h): the receive callback patches their lights into
+// last_pkt in arrival order and leaves the ack to receiver_task(), which sends
+// it once the lights are written
+static portMUX_TYPE event_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint8_t have_event = 0;
+static link_event_frame_t event_frame;      // Newest event frame, answered by the ack
+static uint8_t event_mac[PEER_MAC_LEN];
+static uint32_t event_time_us = 0;          // Arrival time of event_frame
 
 static void light_outputs_init(void) {
     gpio_config_t io = {
@@ -29,96 +67,296 @@ static void light_outputs_init(void) {
     ESP_LOGI(TAG, "Light outputs initialized");
 }
 
-static void ledc_servo_init(void) {
-    ledc_timer_config_t timer = {
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = LEDC_TIMER_14_BIT,
-        .timer_num = LEDC_TIMER_0,
-        .freq_hz = SERVO_FREQ_HZ,
-        .clk_cfg = LEDC_AUTO_CLK,
-    };
-    ESP_ERROR_CHECK(ledc_timer_config(&timer));
+static void servo_outputs_init(const rx_config_t *cfg) {
+    const int gpio_pins[SERVO_PIN_MAP_LEN] = SERVO_PIN_MAP;
+    ESP_ERROR_CHECK(servo_pwm_init(gpio_pins, cfg->pwm_hz, NUM_SERVO_OUTPUTS));
+    ESP_LOGI(TAG, "Servo outputs initialized (%d of %d channels on PWM)", NUM_SERVO_OUTPUTS, NUM_CHANNELS);
+}
 
-    // Configure 6 PWM channels on LEDC timer 0
-    int gpio_pins[6] = {PIN_SERVO_CH1, PIN_SERVO_CH2, PIN_SERVO_CH3, 
-                        PIN_SERVO_CH4, PIN_SERVO_CH5, PIN_SERVO_CH6};
-    
-    for (int i = 0; i < 6; i++) {
-        ledc_channel_config_t ch = {
-            .gpio_num = gpio_pins[i],
-            .speed_mode = LEDC_LOW_SPEED_MODE,
-            .channel = (ledc_channel_t)i,
-            .intr_type = LEDC_INTR_DISABLE,
-            .timer_sel = LEDC_TIMER_0,
-            .duty = 0,
-            .hpoint = 0,
-        };
-        ESP_ERROR_CHECK(ledc_channel_config(&ch));
+static void recv_event(const uint8_t *src_mac, const uint8_t *data, int len) {
+    link_event_frame_t frame;
+    if (src_mac == NULL || !link_auth_open_event(src_mac, data, len, &frame)) {
+        return;
+    }
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    last_pkt.lights = frame.msg.lights;
+    portENTER_CRITICAL(&event_lock);
+    event_frame = frame;
+    memcpy(event_mac, src_mac, PEER_MAC_LEN);
+    event_time_us = now;
+    have_event = 1;
+    portEXIT_CRITICAL(&event_lock);
+    TRACE(TRACE_EV_EVENT_RX, 0, frame.msg.seq);
+    if (receiver_task_handle != NULL) {
+        xTaskNotifyGive(receiver_task_handle);
     }
-    ESP_LOGI(TAG, "LEDC servos initialized (6 channels on GPIO4,5,12,13,14,11)");
 }
 
 static void recv_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
-    if (len == sizeof(control_packet_t)) {
-        memcpy((void *)&last_pkt, data, sizeof(last_pkt));
+    uint32_t start = perf_begin();
+    control_packet_t pkt;
+    if (len == (int)link_auth_frame_len(sizeof(event_msg_t))) {
+        // Event frames bypass the frame path: no servo update, no link status change
+        recv_event(info ? info->src_addr : NULL, data, len);
+    } else if (link_auth_open(info ? info->src_addr : NULL, data, len, &pkt)) {
+        last_pkt = pkt;
+        pkt_time_us = (uint32_t)esp_timer_get_time();
+        pkt_seq++;
         have_pkt = 1;
+        TRACE(TRACE_EV_RX, (info && info->rx_ctrl) ? info->rx_ctrl->rssi : -120, pkt_seq);
+        if (receiver_task_handle != NULL) {
+            xTaskNotifyGive(receiver_task_handle);
+        }
         // Update connection status with RSSI from the received packet
         if (info && info->rx_ctrl) {
             update_connection_status(true, info->rx_ctrl->rssi);
         } else {
             update_connection_status(true, -120);
         }
+    } else if (link_auth_resync_pending() && receiver_task_handle != NULL) {
+        // Refused as a session from before a restart: the task asks for a new one
+        xTaskNotifyGive(receiver_task_handle);
+    }
+    perf_end(PERF_RX_CALLBACK, start);
+}
+
+// Send an ack or resync request to the sender, registering it as a peer if needed
+static void send_to_sender(const uint8_t *mac, const link_event_frame_t *frame, size_t len) {
+    if (!esp_now_is_peer_exist(mac)) {
+        esp_now_peer_info_t peer;
+        link_auth_peer_init(&peer, mac);
+        if (esp_now_add_peer(&peer) != ESP_OK) {
+            return;
+        }
+    }
+    esp_now_send(mac, (const uint8_t *)frame, len);
+}
+
+// Answer an event frame once its lights are written, so the sender stops repeating it
+static void send_event_ack(link_event_frame_t *frame, const uint8_t *mac, uint8_t lights, uint32_t arrival_us) {
+    uint32_t apply_us = (uint32_t)esp_timer_get_time() - arrival_us;
+    event_msg_init(&frame->msg, EVENT_MSG_ACK, frame->msg.seq, lights);
+    frame->msg.apply_us = apply_us > UINT16_MAX ? UINT16_MAX : (uint16_t)apply_us;
+    size_t len = link_auth_seal_ack(frame);     // Epoch and counter stay those of the event frame
+    if (len > 0) {
+        send_to_sender(mac, frame, len);
+    }
+}
+
+static void write_servo_outputs(const uint16_t *us) {
+    for (int i = 0; i < NUM_SERVO_OUTPUTS; i++) {
+        servo_pwm_write_us(i, us[i]);
+    }
+}
+
+// Decode, mix and map the latest packet to servo positions (µs)
+static void compute_servo_targets(const rx_config_t *cfg, uint16_t *us) {
+    uint16_t in_ch[NUM_CHANNELS];
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        in_ch[i] = last_pkt.ch[i];
+    }
+    mixer_apply(&cfg->mixer, in_ch, mixed_ch);
+
+    // Expo and endpoints are precomputed per channel in the snapshot's curve table
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        us[i] = rx_config_map(cfg, i, mixed_ch[i]);
+    }
+    // Serial output sends the raw targets at its own rate (the FC does its own smoothing)
+    serial_output_update(us, NUM_CHANNELS);
+}
+
+static void output_timer_cb(void *arg) {
+    power_lock_acquire(POWER_LOCK_OUTPUT);
+    uint32_t start = perf_begin();
+    const rx_config_t *cfg = rx_config_acquire(RX_CONFIG_READER_TIMER);
+    if (cfg->generation != output_generation) {
+        output_stage.cfg = cfg->output;
+        output_generation = cfg->generation;
+    }
+
+    uint32_t seq = pkt_seq;
+    uint32_t arrival_us = pkt_time_us;
+    bool new_frame = (seq != output_seq);
+    if (new_frame) {
+        output_seq = seq;
+        uint16_t target[NUM_CHANNELS];
+        compute_servo_targets(cfg, target);
+        output_stage_push_frame(&output_stage, target, arrival_us, frame_rate_interval_us(last_pkt.rate));
+    }
+
+    uint16_t us[NUM_CHANNELS];
+    if (output_stage_tick(&output_stage, (uint32_t)esp_timer_get_time(), us)) {
+        write_servo_outputs(us);
+        if (new_frame) {
+            // Traced once per frame, not per tick, to keep the ring history long
+            TRACE(TRACE_EV_OUTPUT_APPLIED, TRACE_OUTPUT_TIMER, seq);
+            perf_record_us(PERF_RX_LATENCY, (uint32_t)esp_timer_get_time() - arrival_us);
+        }
+    }
+    rx_config_release(RX_CONFIG_READER_TIMER);
+    perf_end(PERF_RX_OUTPUT, start);
+    power_lock_release(POWER_LOCK_OUTPUT);
+}
+
+static void output_timer_start(uint16_t rate_hz) {
+    output_stage_reset(&output_stage);
+    output_generation = 0;      // Take the configuration from the current snapshot
+    output_seq = pkt_seq;
+
+    esp_timer_create_args_t args = {
+        .callback = output_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "servo_out",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &output_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(output_timer, 1000000ULL / rate_hz));
+    ESP_LOGI(TAG, "Output stage running at %u Hz", rate_hz);
+}
+
+static void output_timer_stop(void) {
+    if (output_timer != NULL) {
+        esp_timer_stop(output_timer);
+        esp_timer_delete(output_timer);
+        output_timer = NULL;
+        rx_config_release(RX_CONFIG_READER_TIMER);
     }
 }
 
 static void receiver_task(void *arg) {
+    link_auth_add_sender_peer();
     ESP_ERROR_CHECK(esp_now_register_recv_cb(recv_cb));
-    ledc_servo_init();
+
+    if (rx_config_acquire(RX_CONFIG_READER_TASK) == NULL) {
+        // No settings supplied yet: default endpoints, identity mixer
+        device_settings_t defaults;
+        settings_get_defaults(&defaults);
+        ESP_ERROR_CHECK(rx_config_publish(&defaults));
+    }
+    // Output setup (PWM rates, output stage, serial protocol) is fixed for this run
+    const rx_config_t *cfg = rx_config_acquire(RX_CONFIG_READER_TASK);
+    servo_outputs_init(cfg);
     light_outputs_init();
     ESP_LOGI(TAG, "Receiver task started");
 
     const uint8_t light_pins[NUM_LIGHTS] = {PIN_LIGHT_OUT1, PIN_LIGHT_OUT2, PIN_LIGHT_OUT3, PIN_LIGHT_OUT4};
+    uint8_t applied_lights = 0;
+    uint8_t logged_rate = 0;
+    bool link_lost = false;
+
+    // Timer-driven output stage if configured, otherwise servos follow frames directly
+    if (cfg->output.rate_hz > 0) {
+        output_timer_start(cfg->output.rate_hz);
+    }
+    if (cfg->serial_proto != SERIAL_PROTO_NONE) {
+        serial_output_start((serial_proto_t)cfg->serial_proto, cfg->serial_rate_hz, PIN_SERIAL_OUT);
+    }
+    rx_config_release(RX_CONFIG_READER_TASK);
     
     while (1) {
-        // Check for connection timeout
+        // Woken by recv_cb for every frame; while connected the timeout bounds
+        // how late a link loss is noticed, otherwise sleep until the next frame.
+        // The timeout follows the frame rate the sender announced (frame_rate.h).
+        TickType_t wait = portMAX_DELAY;
+        TickType_t limit = pdMS_TO_TICKS(frame_rate_timeout_ms(last_pkt.rate, CONNECTION_TIMEOUT_MS));
+        connection_status_t conn = get_connection_status();
+        if (conn.connected) {
+            TickType_t age = xTaskGetTickCount() - conn.last_packet;
+            wait = (age < limit) ? limit - age + 1 : 0;
+        }
+        if (!have_pkt && !have_event) {
+            ulTaskNotifyTake(pdTRUE, wait);
+        }
+
+        // Frames of the session from before a restart are refused: ask for a new one
+        link_event_frame_t resync;
+        uint8_t resync_mac[PEER_MAC_LEN];
+        size_t resync_len = link_auth_seal_resync(&resync, resync_mac);
+        if (resync_len > 0) {
+            send_to_sender(resync_mac, &resync, resync_len);
+        }
+
+        // Check for connection timeout (a frame that arrived meanwhile may have raised the limit)
         TickType_t now = xTaskGetTickCount();
-        if (get_connection_status().connected && (now - get_connection_status().last_packet > pdMS_TO_TICKS(CONNECTION_TIMEOUT_MS))) {
+        limit = pdMS_TO_TICKS(frame_rate_timeout_ms(last_pkt.rate, CONNECTION_TIMEOUT_MS));
+        if (get_connection_status().connected && (now - get_connection_status().last_packet > limit)) {
             update_connection_status(false, -120);
+            serial_output_set_failsafe(true);
+            TRACE(TRACE_EV_FAILSAFE, 1, 0);
+            blackbox_record_event(BB_EV_FAILSAFE, 1);
+            link_lost = true;
         }
         
-        if (have_pkt) {
-            // Set PWM duty for all proportional channels using per-channel settings
-            for (int i = 0; i < NUM_CHANNELS; i++) {
-                // Use channel's expo (S-curve input sensitivity)
-                float expo;
-                if (g_settings) {
-                    expo = g_settings->expo[i];
-                } else {
-                    expo = 0.0f;
+        bool frame = have_pkt;
+        if (frame || have_event) {
+            power_lock_acquire(POWER_LOCK_OUTPUT);
+            uint32_t arrival_us = pkt_time_us;
+            if (frame) {
+                uint32_t seq = pkt_seq;
+                TRACE(TRACE_EV_DECODE, 0, seq);
+                if (link_lost) {
+                    TRACE(TRACE_EV_FAILSAFE, 0, 0);
+                    blackbox_record_event(BB_EV_FAILSAFE, 0);
+                    link_lost = false;
                 }
-                
-                uint32_t us;
-                if (g_settings) {
-                    us = map_adc_to_us_custom(last_pkt.ch[i], expo,
-                                             g_settings->servo_min[i],
-                                             g_settings->servo_center[i],
-                                             g_settings->servo_max[i]);
-                } else {
-                    us = map_adc_to_us(last_pkt.ch[i], 0.0f);
+                if (output_timer == NULL) {
+                    // Set PWM duty for all proportional channels
+                    uint32_t start = perf_begin();
+                    uint16_t us[NUM_CHANNELS];
+                    compute_servo_targets(rx_config_acquire(RX_CONFIG_READER_TASK), us);
+                    rx_config_release(RX_CONFIG_READER_TASK);
+                    write_servo_outputs(us);
+                    perf_end(PERF_RX_OUTPUT, start);
+                    perf_record_us(PERF_RX_LATENCY, (uint32_t)esp_timer_get_time() - arrival_us);
+                    TRACE(TRACE_EV_OUTPUT_APPLIED, TRACE_OUTPUT_DIRECT, seq);
                 }
-                uint32_t duty = servo_us_to_duty(us);
-                ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)i, duty);
-                ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)i);
             }
 
-            // Set light outputs based on packet bits 0-3
+            // Taken before the lights are read, so the ack never reports an older state
+            bool event = false;
+            link_event_frame_t ack;
+            uint8_t ack_mac[PEER_MAC_LEN];
+            portENTER_CRITICAL(&event_lock);
+            if (have_event) {
+                event = true;
+                ack = event_frame;
+                memcpy(ack_mac, event_mac, PEER_MAC_LEN);
+                arrival_us = event_time_us;
+                have_event = 0;
+            }
+            portEXIT_CRITICAL(&event_lock);
+
+            // Set light outputs based on bits 0-3 of the newest frame, control or event
+            uint8_t lights = last_pkt.lights;
             for (int i = 0; i < NUM_LIGHTS; i++) {
-                gpio_set_level(light_pins[i], (last_pkt.lights & (1 << i)) ? 1 : 0);
+                gpio_set_level(light_pins[i], (lights & (1 << i)) ? 1 : 0);
             }
+            if (lights != applied_lights) {
+                light_lat_last_us = (uint32_t)esp_timer_get_time() - arrival_us;
+                if (light_lat_last_us > light_lat_max_us) {
+                    light_lat_max_us = light_lat_last_us;
+                }
+                applied_lights = lights;
+            }
+            if (event) {
+                send_event_ack(&ack, ack_mac, lights, arrival_us);
+            }
+            // Queued for the flight recorder after the outputs, never waits on flash
+            control_packet_t rec = get_last_control_packet();
+            if (frame && rec.rate != logged_rate) {
+                blackbox_record_event(BB_EV_RATE, frame_rate_hz(rec.rate));
+                logged_rate = rec.rate;
+            }
+            blackbox_record_frame(rec.ch, lights, get_connection_status().rssi, frame_rate_interval_us(rec.rate));
 
-            have_pkt = 0;
+            if (frame) {
+                have_pkt = 0;
+            }
+            power_lock_release(POWER_LOCK_OUTPUT);
+            power_frame_done();
+            // Outside the frame: writes NVS once per new sender session
+            link_auth_persist();
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
 
@@ -128,42 +366,90 @@ void receiver_start(void) {
         return;
     }
     
-    xTaskCreate(receiver_task, "receiver", 4096, NULL, 5, &receiver_task_handle);
+    blackbox_start();
+    xTaskCreatePinnedToCore(receiver_task, "receiver", TASK_STACK_RECEIVER, NULL, TASK_PRIO_RADIO,
+                            &receiver_task_handle, TASK_CORE_RADIO);
 }
 
 void receiver_set_settings(device_settings_t *settings) {
-    g_settings = settings;
+    // Compiled into a new snapshot; frames in flight finish with the previous one
+    if (rx_config_publish(settings) != ESP_OK) {
+        ESP_LOGE(TAG, "Out of memory, receiver settings not applied");
+        return;
+    }
     ESP_LOGI(TAG, "Receiver settings updated: per-channel servo and expo configuration");
 }
 
+// Model profiles: one prebuilt snapshot per valid slot, published by copy on a switch
+static rx_config_t *profile_cfg[PROFILE_COUNT];
+
+void receiver_prepare_profile(int slot, const device_settings_t *settings) {
+    if (profile_cfg[slot] == NULL) {
+        profile_cfg[slot] = malloc(sizeof(rx_config_t));
+        if (profile_cfg[slot] == NULL) {
+            ESP_LOGE(TAG, "Out of memory, profile %d not prepared", slot);
+            return;
+        }
+    }
+    rx_config_build(profile_cfg[slot], settings);
+}
+
+esp_err_t receiver_select_profile(int slot, const uint8_t *peer_mac, bool peer_bound) {
+    if (profile_cfg[slot] == NULL) {
+        ESP_LOGE(TAG, "Profile %d not available", slot);
+        return ESP_ERR_INVALID_STATE;
+    }
+    // The peer first: in encrypted mode frames from the new sender need its entry
+    link_auth_set_peer(peer_mac, peer_bound);
+    esp_err_t err = link_auth_add_sender_peer();
+    if (err != ESP_OK) {
+        return err;
+    }
+    // PWM rates and the serial protocol are device-wide: the running outputs stay as they are
+    err = rx_config_publish_copy(profile_cfg[slot]);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Profile %d not available", slot);
+    }
+    return err;
+}
+
 void receiver_stop(void) {
     if (receiver_task_handle != NULL) {
+        output_timer_stop();
+        serial_output_stop();
         vTaskDelete(receiver_task_handle);
         receiver_task_handle = NULL;
+        // In case the task was deleted mid-frame
+        power_lock_release(POWER_LOCK_OUTPUT);
+        rx_config_release(RX_CONFIG_READER_TASK);
+        blackbox_stop();    // Flight recorder on flash before the webserver may read it
         ESP_LOGI(TAG, "Receiver stopped");
     }
 }
 
+void receiver_get_light_latency(uint32_t *last_us, uint32_t *max_us) {
+    *last_us = light_lat_last_us;
+    *max_us = light_lat_max_us;
+}
+
 control_packet_t get_last_control_packet(void) {
     return (control_packet_t)last_pkt;
 }
 
 // Get servo positions in microseconds for all channels
-// Returns array of 6 uint16_t values using per-channel min/center/max settings
+// Returns NUM_CHANNELS uint16_t values (after mixing) using per-channel min/center/max settings
 void get_servo_positions(uint16_t *positions) {
-    if (!g_settings) {
+    const rx_config_t *cfg = rx_config_acquire(RX_CONFIG_READER_API);
+    if (!cfg) {
     // Fallback to default if settings not set
         for (int i = 0; i < NUM_CHANNELS; i++) {
-            positions[i] = (uint16_t)map_adc_to_us(last_pkt.ch[i], 0.0f);
+            positions[i] = (uint16_t)map_adc_to_us(mixed_ch[i], 0.0f);
+        }
+    } else {
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            positions[i] = rx_config_map(cfg, i, mixed_ch[i]);
         }
-        return;
-    }
-    
-    for (int i = 0; i < NUM_CHANNELS; i++) {
-        positions[i] = (uint16_t)map_adc_to_us_custom(last_pkt.ch[i], g_settings->expo[i],
-                                                       g_settings->servo_min[i],
-                                                       g_settings->servo_center[i],
-                                                       g_settings->servo_max[i]);
     }
+    rx_config_release(RX_CONFIG_READER_API);
 }
 
@@ -0,0 +1,108 @@
+// Receiver runtime configuration snapshots implementation
+#include "rx_config.h"
+#include "common.h"
+#include "serial_output.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "rx_config";
+
+static rx_config_t *active = NULL;
+static rx_config_t *hazard[RX_CONFIG_READER_COUNT];
+static uint32_t generation = 0;
+
+void rx_config_build(rx_config_t *cfg, const device_settings_t *settings) {
+    mixer_compile(&cfg->mixer, settings);
+    output_stage_configure(&cfg->output, settings);
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        uint16_t lo = settings->servo_min[ch];
+        uint16_t mid = settings->servo_center[ch];
+        uint16_t hi = settings->servo_max[ch];
+        if (lo > hi) {
+            uint16_t t = lo;
+            lo = hi;
+            hi = t;
+        }
+        if (mid < lo || mid > hi) {
+            mid = (uint16_t)((lo + hi) / 2);
+        }
+        if (lo != settings->servo_min[ch] || mid != settings->servo_center[ch] || hi != settings->servo_max[ch]) {
+            ESP_LOGW(TAG, "CH%d endpoints corrected to %u/%u/%u", ch + 1, lo, mid, hi);
+        }
+        float expo = settings->expo[ch];
+        if (!(expo >= 0.0f)) {      // Also catches NaN from a corrupt NVS entry
+            expo = 0.0f;
+        } else if (expo > 1.0f) {
+            expo = 1.0f;
+        }
+
+        for (int i = 0; i < RX_CURVE_POINTS - 1; i++) {
+            cfg->curve[ch][i] = (uint16_t)map_adc_to_us_custom((uint16_t)(i << RX_CURVE_SHIFT), expo, lo, mid, hi);
+        }
+        cfg->curve[ch][RX_CURVE_POINTS - 1] = (uint16_t)map_adc_to_us_custom(ADC_MAX_VALUE, expo, lo, mid, hi);
+        cfg->pwm_hz[ch] = settings->ch_pwm_hz[ch] ? settings->ch_pwm_hz[ch] : SERVO_FREQ_HZ;
+    }
+
+    cfg->serial_proto = settings->serial_proto < SERIAL_PROTO_COUNT ? settings->serial_proto : SERIAL_PROTO_NONE;
+    cfg->serial_rate_hz = settings->serial_rate_hz;
+}
+
+static bool in_use(const rx_config_t *cfg) {
+    for (int r = 0; r < RX_CONFIG_READER_COUNT; r++) {
+        if (__atomic_load_n(&hazard[r], __ATOMIC_SEQ_CST) == cfg) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void swap_in(rx_config_t *cfg) {
+    cfg->generation = __atomic_add_fetch(&generation, 1, __ATOMIC_RELAXED);
+
+    rx_config_t *old = __atomic_exchange_n(&active, cfg, __ATOMIC_SEQ_CST);
+    if (old != NULL) {
+        // Grace period: readers hold a snapshot for one frame at most
+        while (in_use(old)) {
+            vTaskDelay(1);
+        }
+        free(old);
+    }
+}
+
+esp_err_t rx_config_publish(const device_settings_t *settings) {
+    rx_config_t *cfg = malloc(sizeof(rx_config_t));
+    if (cfg == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    rx_config_build(cfg, settings);
+    swap_in(cfg);
+    return ESP_OK;
+}
+
+esp_err_t rx_config_publish_copy(const rx_config_t *src) {
+    rx_config_t *cfg = malloc(sizeof(rx_config_t));
+    if (cfg == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(cfg, src, sizeof(*cfg));
+    swap_in(cfg);
+    return ESP_OK;
+}
+
+const rx_config_t *rx_config_acquire(rx_config_reader_t reader) {
+    rx_config_t *cfg;
+    do {
+        cfg = __atomic_load_n(&active, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&hazard[reader], cfg, __ATOMIC_SEQ_CST);
+        // Re-check: the publisher may have swapped and scanned before the slot was set
+    } while (cfg != __atomic_load_n(&active, __ATOMIC_SEQ_CST));
+    return cfg;
+}
+
+void rx_config_release(rx_config_reader_t reader) {
+    __atomic_store_n(&hazard[reader], NULL, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,65 @@
+// Receiver runtime configuration snapshots
+// Settings are compiled off the hot path into an immutable rx_config_t
+// (validated endpoints, compiled mixer, output stage limits, per-channel
+// servo curve tables) and published with one atomic pointer exchange.
+// Readers never lock: they announce the snapshot they use in a per-reader
+// hazard slot, and a replaced snapshot is freed only once no slot holds it.
+#ifndef RX_CONFIG_H
+#define RX_CONFIG_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "settings.h"
+#include "mixer.h"
+#include "output_stage.h"
+
+#define RX_CURVE_SHIFT 4                                    // Table step: 16 packet units
+#define RX_CURVE_POINTS ((ADC_MAX_VALUE >> RX_CURVE_SHIFT) + 2)
+
+typedef struct {
+    uint32_t generation;                                // Increments per publish
+    mixer_t mixer;
+    output_stage_cfg_t output;
+    // Mixed channel value (packet units) -> servo µs, expo and endpoints applied
+    uint16_t curve[NUM_CHANNELS][RX_CURVE_POINTS];
+    uint16_t pwm_hz[NUM_CHANNELS];
+    uint8_t serial_proto;
+    uint16_t serial_rate_hz;
+} rx_config_t;
+
+// One hazard slot per reader context; a context must not nest acquires
+typedef enum {
+    RX_CONFIG_READER_TASK = 0,      // receiver_task()
+    RX_CONFIG_READER_TIMER,         // Output stage esp_timer callback
+    RX_CONFIG_READER_API,           // Webserver status handler
+    RX_CONFIG_READER_COUNT
+} rx_config_reader_t;
+
+// Compile settings into cfg. Out-of-range values are corrected, not rejected.
+void rx_config_build(rx_config_t *cfg, const device_settings_t *settings);
+
+// Build a new snapshot, make it current and free the one it replaces after
+// all readers have moved on (may sleep; call from a task, never the hot path)
+esp_err_t rx_config_publish(const device_settings_t *settings);
+// Same for a snapshot built ahead with rx_config_build() (model profiles): a
+// copy is published, src stays owned by the caller
+esp_err_t rx_config_publish_copy(const rx_config_t *src);
+
+// Pin the current snapshot for reader until rx_config_release(). Lock-free;
+// returns NULL if nothing has been published yet.
+const rx_config_t *rx_config_acquire(rx_config_reader_t reader);
+void rx_config_release(rx_config_reader_t reader);
+
+// Servo position (µs) for a mixed channel value, by table interpolation
+static inline uint16_t rx_config_map(const rx_config_t *cfg, int ch, uint16_t value) {
+    const uint16_t *c = cfg->curve[ch];
+    if (value >= ADC_MAX_VALUE) {
+        return c[RX_CURVE_POINTS - 1];      // Exact full-scale endpoint
+    }
+    uint32_t i = value >> RX_CURVE_SHIFT;
+    uint32_t frac = value & ((1 << RX_CURVE_SHIFT) - 1);
+    int32_t delta = (int32_t)c[i + 1] - (int32_t)c[i];
+    return (uint16_t)(c[i] + ((delta * (int32_t)frac) >> RX_CURVE_SHIFT));
+}
+
+#endif // RX_CONFIG_H
@@ -0,0 +1,143 @@
+// Live channel scope ring implementation
+#include "scope.h"
+#include "common.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "scope";
+
+#define SCOPE_MASK (SCOPE_RING_LEN - 1)
+
+_Static_assert(sizeof(scope_batch_header_t) == 8, "scope header layout");
+_Static_assert(SCOPE_BATCH_MAX <= UINT8_MAX, "batch count is one byte");
+_Static_assert(sizeof(scope_sample_t) <= UINT8_MAX, "sample size is one byte");
+_Static_assert((SCOPE_RING_LEN & SCOPE_MASK) == 0, "SCOPE_RING_LEN must be a power of two");
+
+// Output mapping, as the receiver builds its curve tables (rx_config.c)
+typedef struct {
+    float expo[NUM_CHANNELS];
+    uint16_t lo[NUM_CHANNELS];
+    uint16_t mid[NUM_CHANNELS];
+    uint16_t hi[NUM_CHANNELS];
+} scope_map_t;
+
+static scope_sample_t *ring = NULL;
+static uint32_t head = 0;           // Samples written (producer)
+static uint32_t tail = 0;           // Samples sent (consumer)
+static uint32_t dropped = 0;
+static uint16_t rate = 0;
+static scope_map_t map;
+static portMUX_TYPE map_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void scope_configure(const device_settings_t *settings) {
+    scope_map_t m;
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        uint16_t lo = settings->servo_min[ch];
+        uint16_t mid = settings->servo_center[ch];
+        uint16_t hi = settings->servo_max[ch];
+        if (lo > hi) {
+            uint16_t t = lo;
+            lo = hi;
+            hi = t;
+        }
+        if (mid < lo || mid > hi) {
+            mid = (uint16_t)((lo + hi) / 2);
+        }
+        float expo = settings->expo[ch];
+        if (!(expo >= 0.0f)) {
+            expo = 0.0f;
+        } else if (expo > 1.0f) {
+            expo = 1.0f;
+        }
+        m.expo[ch] = expo;
+        m.lo[ch] = lo;
+        m.mid[ch] = mid;
+        m.hi[ch] = hi;
+    }
+    portENTER_CRITICAL(&map_lock);
+    map = m;
+    portEXIT_CRITICAL(&map_lock);
+}
+
+uint16_t scope_open(uint16_t rate_hz, const device_settings_t *settings) {
+    if (ring == NULL) {
+        ring = malloc(SCOPE_RING_LEN * sizeof(scope_sample_t));
+        if (ring == NULL) {
+            ESP_LOGE(TAG, "No memory for %d samples", SCOPE_RING_LEN);
+            return 0;
+        }
+    }
+    if (rate_hz < SCOPE_RATE_MIN_HZ) {
+        rate_hz = SCOPE_RATE_MIN_HZ;
+    } else if (rate_hz > SCOPE_RATE_MAX_HZ) {
+        rate_hz = SCOPE_RATE_MAX_HZ;
+    }
+    scope_configure(settings);
+    head = 0;
+    tail = 0;
+    dropped = 0;
+    rate = rate_hz;
+    return rate_hz;
+}
+
+void scope_close(void) {
+    free(ring);
+    ring = NULL;
+}
+
+bool scope_is_open(void) {
+    return ring != NULL;
+}
+
+bool scope_record(uint32_t t_us, const uint16_t *raw, const uint16_t *cond) {
+    uint32_t h = head;
+    if (h - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) >= SCOPE_RING_LEN) {
+        __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    scope_map_t m;
+    portENTER_CRITICAL(&map_lock);
+    m = map;
+    portEXIT_CRITICAL(&map_lock);
+
+    scope_sample_t *s = &ring[h & SCOPE_MASK];
+    s->t_us = t_us;
+    memcpy(s->raw, raw, sizeof(s->raw));
+    memcpy(s->cond, cond, sizeof(s->cond));
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        s->out_us[ch] = (uint16_t)map_adc_to_us_custom(cond[ch], m.expo[ch], m.lo[ch], m.mid[ch], m.hi[ch]);
+    }
+    __atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+size_t scope_drain(uint8_t *out) {
+    uint32_t t = tail;
+    uint32_t n = __atomic_load_n(&head, __ATOMIC_ACQUIRE) - t;
+    if (n == 0) {
+        return 0;
+    }
+    if (n > SCOPE_BATCH_MAX) {
+        n = SCOPE_BATCH_MAX;
+    }
+    uint32_t lost = __atomic_exchange_n(&dropped, 0, __ATOMIC_RELAXED);
+
+    scope_batch_header_t header = {
+        .version = SCOPE_VERSION,
+        .num_ch = NUM_CHANNELS,
+        .sample_size = sizeof(scope_sample_t),
+        .count = (uint8_t)n,
+        .rate_hz = rate,
+        .dropped = lost > UINT16_MAX ? UINT16_MAX : (uint16_t)lost,
+    };
+    memcpy(out, &header, sizeof(header));
+    scope_sample_t *samples = (scope_sample_t *)(out + sizeof(header));
+    for (uint32_t i = 0; i < n; i++) {
+        samples[i] = ring[(t + i) & SCOPE_MASK];
+    }
+    // The slots are free for the producer only after the copy
+    __atomic_store_n(&tail, t + n, __ATOMIC_RELEASE);
+    return sizeof(header) + n * sizeof(scope_sample_t);
+}
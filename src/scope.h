@@ -0,0 +1,64 @@
+// Live channel scope
+// Per-frame samples (raw input, conditioned input, output µs) collected in a
+// ring and streamed to the web page in binary batches over a WebSocket
+// (GET /api/scope). One producer (the sampler) and one consumer (the httpd
+// task): the producer never waits, a sample that finds the ring full is
+// dropped and counted in the next batch header.
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "channel_config.h"
+#include "settings.h"
+
+#define SCOPE_VERSION 1
+#define SCOPE_RING_LEN 256          // Power of two; 0.5 s at the maximum rate
+#define SCOPE_BATCH_MAX 64          // Samples per WebSocket message
+#define SCOPE_RATE_MIN_HZ 50
+#define SCOPE_RATE_MAX_HZ 500
+#define SCOPE_RATE_DEFAULT_HZ 100
+
+// One frame as sent (little-endian, as in memory)
+typedef struct {
+    uint32_t t_us;                  // esp_timer time of the capture
+    uint16_t raw[NUM_CHANNELS];     // Input before conditioning (linearized ADC counts)
+    uint16_t cond[NUM_CHANNELS];    // Conditioned value sent on air (0..4095)
+    uint16_t out_us[NUM_CHANNELS];  // Servo position from expo and endpoints (µs)
+} scope_sample_t;
+
+// Batch header, followed by count samples of sample_size bytes, oldest first
+typedef struct {
+    uint8_t version;                // SCOPE_VERSION
+    uint8_t num_ch;                 // NUM_CHANNELS
+    uint8_t sample_size;            // sizeof(scope_sample_t), padding included
+    uint8_t count;
+    uint16_t rate_hz;               // Sample rate
+    uint16_t dropped;               // Samples lost to a full ring since the last batch (saturating)
+} scope_batch_header_t;
+
+#define SCOPE_BATCH_SIZE (sizeof(scope_batch_header_t) + SCOPE_BATCH_MAX * sizeof(scope_sample_t))
+
+// Allocate the ring for a capture at rate_hz (clamped to the supported range)
+// and take the output mapping from settings. Returns the rate used, 0 if out
+// of memory.
+uint16_t scope_open(uint16_t rate_hz, const device_settings_t *settings);
+
+// Free the ring; the producer must have stopped
+void scope_close(void);
+
+bool scope_is_open(void);
+
+// New expo / servo endpoints for the output column (settings saved while open)
+void scope_configure(const device_settings_t *settings);
+
+// Producer: map cond to servo µs and queue the frame. Returns false if dropped.
+bool scope_record(uint32_t t_us, const uint16_t *raw, const uint16_t *cond);
+
+// Consumer: move up to SCOPE_BATCH_MAX queued samples into out (SCOPE_BATCH_SIZE
+// bytes). Returns the batch length in bytes, 0 if nothing is queued.
+size_t scope_drain(uint8_t *out);
+
+#endif // SCOPE_H
@@ -1,34 +1,362 @@
 // Sender implementation for ESP-NOW radio control
 #include "common.h"
+#include "input_pipeline.h"
+#include "calibration.h"
+#include "input_source.h"
+#include "power.h"
+#include "perf.h"
+#include "trace.h"
+#include "link_auth.h"
+#include "profiles.h"
+#include "scope.h"
+#include "adc_lut.h"
+#include "event_frame.h"
+#include "frame_rate.h"
+#include "tx_pipeline.h"
+#include "task_config.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_now.h"
+#include "esp_timer.h"
+#include "esp_random.h"
 #include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "soc/soc_caps.h"
 #include "driver/gpio.h"
+#include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "sender";
 static adc_oneshot_unit_handle_t adc_unit = NULL;
 static TaskHandle_t sender_task_handle = NULL;
 static uint8_t shared_light_states = 0; // Will be updated by main task
+static uint32_t light_lat_last_us = 0;
+static uint32_t light_lat_max_us = 0;
+static portMUX_TYPE light_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Event frames (event_frame.h): posted by the control task, sent by sender_task()
+// between periodic frames, acked in the receive callback; all under light_lock.
+// The retry timer wakes sender_task() when an unacked frame is due again.
+static event_tx_t event_tx;
+static esp_timer_handle_t event_timer = NULL;
+// Set by recv_cb() on a resync request from a restarted receiver; sender_task()
+// opens the new session (an NVS write) before its next frame
+static volatile bool resync_requested = false;
+// Set once the receiver answered this run: a MAC ack to the unicast peer in
+// send_cb() or an authenticated ack/resync from it in recv_cb(). A broadcast
+// always reports success, so an unbound sender probes with its light state
+// every LINK_PROBE_US until one of its event frames is acked. ota_poll() keeps
+// a new image on this, not on the LED connection flag.
+#define LINK_PROBE_US 1000000
+static volatile bool link_verified = false;
+
+// Adaptive frame rate (frame_rate.h), owned by sender_task(). send_cb() only
+// counts results, the task feeds them in before each sample. The frame timer
+// wakes the task for the next sample (the tick is too coarse above 50 Hz).
+// New bounds are published under cfg_lock like the input conditioning.
+static frame_rate_t frame_rate;
+static esp_timer_handle_t frame_timer = NULL;
+static volatile uint32_t tx_results = 0;
+static volatile uint32_t tx_failures = 0;
+static uint16_t pending_rate_min = FRAME_RATE_DEFAULT_MIN_HZ;
+static uint16_t pending_rate_max = FRAME_RATE_DEFAULT_MAX_HZ;
+static volatile bool rate_pending = true;
+
+// Transmit pipeline (tx_pipeline.h): sender_task() records each esp_now_send(),
+// send_cb() completes it from the Wi-Fi task. A control frame held back while
+// the previous one is in flight stays in sender_task()'s packet and is
+// overwritten by the next sample; send_cb() wakes the task once it may go.
+static tx_pipeline_t tx_pipe;
+static portMUX_TYPE tx_lock = portMUX_INITIALIZER_UNLOCKED;
 static bool adc_initialized = false;
+static const adc_channel_t adc_inputs[ADC_INPUT_MAP_LEN] = ADC_INPUT_MAP;
+static adc_lut_t adc_lut;                // Raw code -> linearized, shared by all sticks
+
+// Input conditioning: the pipeline is owned by sender_task(); new settings are
+// compiled into pending_cfg and picked up at the start of the next frame.
+static input_pipeline_t input_pipeline;
+static input_channel_cfg_t pending_cfg[NUM_CHANNELS];
+static volatile bool cfg_pending = false;
+static bool cfg_valid = false;
+static portMUX_TYPE cfg_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Channel source selected in settings; sender_task() switches when it changes
+static volatile uint8_t requested_source = INPUT_SOURCE_ADC;
+
+// Model profiles: compiled ahead so a switch is a copy into pending_cfg. The
+// peer frames go to is read per frame under light_lock.
+static input_channel_cfg_t profile_cfg[PROFILE_COUNT][NUM_CHANNELS];
+static uint8_t target_mac[PEER_MAC_LEN];
 
-void sender_set_light_states(uint8_t states) {
+void sender_set_light_states(uint8_t states, uint32_t event_us) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL(&light_lock);
     shared_light_states = states;
+    event_tx_post(&event_tx, states, event_us, now);
+    portEXIT_CRITICAL(&light_lock);
+    // Wake the sender so the event frame goes out now; the periodic frames keep their timing
+    if (sender_task_handle != NULL) {
+        xTaskNotifyGive(sender_task_handle);
+    }
+}
+
+bool sender_link_verified(void) {
+    return link_verified;
+}
+
+void sender_get_light_latency(uint32_t *last_us, uint32_t *max_us) {
+    *last_us = light_lat_last_us;
+    *max_us = light_lat_max_us;
+}
+
+void sender_get_event_stats(event_stats_t *out) {
+    portENTER_CRITICAL(&light_lock);
+    *out = event_tx.stats;
+    portEXIT_CRITICAL(&light_lock);
+}
+
+void sender_set_settings(const device_settings_t *settings) {
+    // Compile outside the critical section, publish with a short copy
+    static input_pipeline_t compiled;
+    input_pipeline_configure(&compiled, settings);
+
+    portENTER_CRITICAL(&cfg_lock);
+    memcpy(pending_cfg, compiled.cfg, sizeof(pending_cfg));
+    cfg_pending = true;
+    pending_rate_min = settings->rate_min_hz;
+    pending_rate_max = settings->rate_max_hz;
+    rate_pending = true;
+    portEXIT_CRITICAL(&cfg_lock);
+    cfg_valid = true;
+    requested_source = settings->input_source < INPUT_SOURCE_COUNT ? settings->input_source : INPUT_SOURCE_ADC;
+    ESP_LOGI(TAG, "Sender settings updated: per-channel input conditioning");
+}
+
+void sender_prepare_profile(int slot, const device_settings_t *settings) {
+    static input_pipeline_t compiled;
+    input_pipeline_configure(&compiled, settings);
+    memcpy(profile_cfg[slot], compiled.cfg, sizeof(profile_cfg[slot]));
+}
+
+static esp_err_t register_peer(const uint8_t *mac) {
+    esp_now_peer_info_t peer;
+    link_auth_peer_init(&peer, mac);
+    esp_err_t ret = esp_now_add_peer(&peer);
+    if (ret == ESP_ERR_ESPNOW_EXIST) {
+        ret = esp_now_mod_peer(&peer);
+    }
+    return ret;
+}
+
+esp_err_t sender_select_profile(int slot, const uint8_t *peer_mac) {
+    uint8_t old_mac[PEER_MAC_LEN];
+    portENTER_CRITICAL(&light_lock);
+    memcpy(old_mac, target_mac, PEER_MAC_LEN);
+    portEXIT_CRITICAL(&light_lock);
+    // The old entry goes once frames no longer use it: the peer list is short,
+    // encrypted peers especially (CONFIG_ESP_WIFI_ESPNOW_MAX_ENCRYPT_NUM)
+    bool drop_old = memcmp(old_mac, peer_mac, PEER_MAC_LEN) != 0 &&
+                    memcmp(old_mac, "\xff\xff\xff\xff\xff\xff", PEER_MAC_LEN) != 0;
+
+    // Register the new peer before frames go to it
+    esp_err_t ret = register_peer(peer_mac);
+    if (ret == ESP_ERR_ESPNOW_FULL && drop_old) {
+        // No room next to the old peer: a frame or two to it fails during the switch
+        esp_now_del_peer(old_mac);
+        drop_old = false;
+        ret = register_peer(peer_mac);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add/modify peer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    portENTER_CRITICAL(&cfg_lock);
+    memcpy(pending_cfg, profile_cfg[slot], sizeof(pending_cfg));
+    cfg_pending = true;
+    portEXIT_CRITICAL(&cfg_lock);
+    cfg_valid = true;
+    portENTER_CRITICAL(&light_lock);
+    if (memcmp(target_mac, peer_mac, PEER_MAC_LEN) != 0) {
+        link_verified = false;      // An answer from the old peer says nothing about the new one
+    }
+    memcpy(target_mac, peer_mac, PEER_MAC_LEN);
+    portEXIT_CRITICAL(&light_lock);
+    if (drop_old) {
+        esp_now_del_peer(old_mac);
+    }
+    // The next frame goes out with the new configuration and peer
+    if (sender_task_handle != NULL) {
+        xTaskNotifyGive(sender_task_handle);
+    }
+    return ESP_OK;
+}
+
+static void apply_pending_cfg(void) {
+    if (!cfg_pending) {
+        return;
+    }
+    portENTER_CRITICAL(&cfg_lock);
+    memcpy(input_pipeline.cfg, pending_cfg, sizeof(input_pipeline.cfg));
+    cfg_pending = false;
+    portEXIT_CRITICAL(&cfg_lock);
+    input_pipeline_reset(&input_pipeline);
+}
+
+static void apply_pending_rate(void) {
+    if (!rate_pending) {
+        return;
+    }
+    portENTER_CRITICAL(&cfg_lock);
+    uint16_t lo = pending_rate_min;
+    uint16_t hi = pending_rate_max;
+    rate_pending = false;
+    portEXIT_CRITICAL(&cfg_lock);
+    frame_rate_configure(&frame_rate, lo, hi);
+    ESP_LOGI(TAG, "Frame rate %u-%u Hz", frame_rate.stats.min_hz, frame_rate.stats.max_hz);
+}
+
+void sender_get_rate_stats(frame_rate_stats_t *out) {
+    // Copied without a lock: the counters may be one sample apart
+    *out = frame_rate.stats;
+}
+
+int sender_rate_console_cmd(int argc, char **argv) {
+    frame_rate_stats_t st;
+    sender_get_rate_stats(&st);
+    printf("Frame rate %u Hz (bounds %u-%u Hz, congestion ceiling %u Hz)\n",
+           st.hz, st.min_hz, st.max_hz, st.ceiling_hz);
+    printf("  input velocity %lu units/s, %lu of %lu samples sent, %lu rate changes\n",
+           st.velocity, st.frames, st.samples, st.changes);
+    printf("  sends %lu, failed %lu (%lu%%), %lu backoffs\n",
+           st.sent, st.failed, st.sent ? st.failed * 100 / st.sent : 0, st.backoffs);
+    return 0;
+}
+
+void sender_get_tx_stats(tx_pipeline_stats_t *out) {
+    portENTER_CRITICAL(&tx_lock);
+    *out = tx_pipe.stats;
+    portEXIT_CRITICAL(&tx_lock);
+}
+
+int sender_tx_console_cmd(int argc, char **argv) {
+    tx_pipeline_stats_t st;
+    sender_get_tx_stats(&st);
+    printf("Sent %lu frames, %lu completed, %lu lost without a callback\n",
+           st.sent, st.completed, st.lost);
+    printf("  control frames %lu: %lu held for a completion, %lu replaced while held\n",
+           st.offered, st.deferred, st.superseded);
+    printf("  send errors: %lu no memory, %lu other\n", st.no_mem, st.errors);
+    printf("  latency send->callback: last %lu us, avg %lu us, max %lu us\n",
+           st.lat_last_us, st.lat_avg_us, st.lat_max_us);
+    printf("  frames in flight at send (max %u):", st.depth_max);
+    for (int i = 0; i < TX_PIPELINE_DEPTH_BUCKETS; i++) {
+        printf(" %s%d:%lu", i == TX_PIPELINE_DEPTH_BUCKETS - 1 ? ">=" : "", i, st.depth[i]);
+    }
+    printf("\n");
+    return 0;
+}
+
+// One POWER_LOCK_TX is held per frame record in the transmit pipeline
+static void release_tx_locks(uint32_t records) {
+    for (; records > 0; records--) {
+        power_lock_release(POWER_LOCK_TX);
+    }
 }
 
 static void send_cb(const wifi_tx_info_t *info, esp_now_send_status_t status) {
+    TRACE(TRACE_EV_TX_DONE, status, 0);
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    uint32_t latency_us = 0;
+    portENTER_CRITICAL(&tx_lock);
+    bool matched = tx_pipeline_done(&tx_pipe, now, &latency_us);
+    bool ready = tx_pipeline_ready(&tx_pipe, now);
+    uint32_t released = (matched ? 1 : 0) + tx_pipeline_take_dropped(&tx_pipe);
+    portEXIT_CRITICAL(&tx_lock);
+    // Nothing for a callback whose record was already written off
+    release_tx_locks(released);
+    if (matched) {
+        perf_record_us(PERF_TX_LATENCY, latency_us);
+    }
+    // A control frame held back for this one can go now
+    TaskHandle_t task = sender_task_handle;
+    if (ready && task != NULL) {
+        xTaskNotifyGive(task);
+    }
+    // Congestion input for frame_rate, collected by sender_task()
+    tx_results++;
+    if (status != ESP_NOW_SEND_SUCCESS) {
+        tx_failures++;
+    }
     // Update connection status based on send success
     // RSSI is not available for sender, use a placeholder value
     if (status == ESP_NOW_SEND_SUCCESS) {
+        // Only a unicast frame to the peer is acked at the MAC layer
+        if (!link_verified && info != NULL &&
+            memcmp(info->des_addr, "\xff\xff\xff\xff\xff\xff", PEER_MAC_LEN) != 0) {
+            portENTER_CRITICAL(&light_lock);
+            bool to_peer = memcmp(target_mac, info->des_addr, PEER_MAC_LEN) == 0;
+            portEXIT_CRITICAL(&light_lock);
+            link_verified = to_peer;
+        }
         update_connection_status(true, -50);  // Placeholder RSSI for successful send
     } else {
         update_connection_status(false, -120);
     }
 }
 
+static bool cali_raw_to_mv(void *ctx, int raw, int *mv) {
+    return adc_cali_raw_to_voltage((adc_cali_handle_t)ctx, raw, mv) == ESP_OK;
+}
+
+// Bake the factory calibration of ADC1 at the stick attenuation into adc_lut.
+// The eFuse curve depends on unit and attenuation only, so one table serves
+// every stick.
+static void adc_lut_init(void) {
+    adc_cali_handle_t cali = NULL;
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t cali_cfg = {
+        .unit_id = ADC_UNIT_1,
+        .chan = adc_inputs[0],
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    err = adc_cali_create_scheme_curve_fitting(&cali_cfg, &cali);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cali_cfg = {
+        .unit_id = ADC_UNIT_1,
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    err = adc_cali_create_scheme_line_fitting(&cali_cfg, &cali);
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No ADC calibration (%s), sticks read uncorrected", esp_err_to_name(err));
+    }
+
+    int64_t start = esp_timer_get_time();
+    if (!adc_lut_build(&adc_lut, SOC_ADC_RTC_MAX_BITWIDTH, err == ESP_OK ? cali_raw_to_mv : NULL, cali)) {
+        // The sticks still work, only without the linearization
+        ESP_LOGW(TAG, "No memory for the ADC table, sticks read uncorrected");
+    }
+    uint32_t build_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+
+    if (err == ESP_OK) {
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_curve_fitting(cali);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_line_fitting(cali);
+#endif
+    }
+    if (adc_lut.calibrated) {
+        ESP_LOGI(TAG, "ADC linearization: %u codes over %u..%u mV, built in %lu ms",
+                 adc_lut.size, adc_lut.mv_lo, adc_lut.mv_hi, build_ms);
+    }
+}
+
 static void adc_init(void) {
     if (adc_initialized) {
         ESP_LOGI(TAG, "ADC already initialized");
@@ -44,34 +372,357 @@ static void adc_init(void) {
         .bitwidth = ADC_BITWIDTH_DEFAULT,
         .atten = ADC_ATTEN_DB_12,
     };
-    // Configure all 6 ADC channels
-    for (int i = 0; i < 6; i++) {
-        ESP_ERROR_CHECK(adc_oneshot_config_channel(adc_unit, (adc_channel_t)i, &chan_cfg));
+    for (int i = 0; i < NUM_ADC_INPUTS; i++) {
+        ESP_ERROR_CHECK(adc_oneshot_config_channel(adc_unit, adc_inputs[i], &chan_cfg));
     }
+    adc_lut_init();
     adc_initialized = true;
-    ESP_LOGI(TAG, "ADC initialized for 6 channels");
+    ESP_LOGI(TAG, "ADC initialized for %d of %d channels", NUM_ADC_INPUTS, NUM_CHANNELS);
+}
+
+// Calibration capture: dedicated sampler task reading the ADC at full rate
+#define CALIB_BURST_SAMPLES 32      // Frames sampled back-to-back before yielding a tick
+
+static calib_tracker_t calib_tracker;
+static TaskHandle_t calib_task_handle = NULL;
+static volatile bool calib_stop_requested = false;
+
+static void calib_task(void *arg) {
+    adc_init();
+    while (!calib_stop_requested) {
+        for (int n = 0; n < CALIB_BURST_SAMPLES; n++) {
+            uint16_t raw[NUM_CHANNELS];
+            for (int i = 0; i < NUM_CHANNELS; i++) {
+                int v = 0;
+                if (i >= NUM_ADC_INPUTS) {
+                    raw[i] = ADC_CENTER_VALUE;      // No stick: never moves, so never applied
+                } else if (adc_oneshot_read(adc_unit, adc_inputs[i], &v) == ESP_OK) {
+                    raw[i] = adc_lut_apply(&adc_lut, v);
+                } else {
+                    raw[i] = calib_tracker.last[i];
+                }
+            }
+            calib_tracker_feed(&calib_tracker, raw);
+        }
+        vTaskDelay(1);
+    }
+    calib_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+bool sender_calibration_start(void) {
+    if (sender_task_handle != NULL) {
+        ESP_LOGW(TAG, "Calibration not available while sender is running");
+        return false;
+    }
+    if (sender_scope_active()) {
+        ESP_LOGW(TAG, "Calibration not available while the scope is running");
+        return false;
+    }
+    if (calib_task_handle != NULL) {
+        // Restart: the tracker is sampler-owned, so stop the sampler before resetting it
+        sender_calibration_stop();
+    }
+    calib_tracker_start(&calib_tracker);
+    calib_stop_requested = false;
+    if (xTaskCreatePinnedToCore(calib_task, "calib", TASK_STACK_CALIB, NULL, TASK_PRIO_CALIB,
+                                &calib_task_handle, TASK_CORE_UI) != pdPASS) {
+        calib_task_handle = NULL;
+        return false;
+    }
+    ESP_LOGI(TAG, "Calibration capture started");
+    return true;
+}
+
+void sender_calibration_set_phase(calib_phase_t phase) {
+    calib_tracker_set_phase(&calib_tracker, phase);
+}
+
+void sender_calibration_stop(void) {
+    calib_tracker_set_phase(&calib_tracker, CALIB_IDLE);
+    calib_stop_requested = true;
+    // Let the sampler finish its burst and exit on its own (never kill it mid-read)
+    for (int i = 0; i < 10 && calib_task_handle != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    ESP_LOGI(TAG, "Calibration capture stopped");
+}
+
+bool sender_calibration_active(void) {
+    return calib_task_handle != NULL;
+}
+
+void sender_calibration_get(calib_snapshot_t *out) {
+    calib_tracker_read(&calib_tracker, out);
+}
+
+// Scope capture: sticks and input conditioning at the scope rate, paced by an
+// esp_timer (the tick is too coarse for 500 Hz). Owns input_pipeline while it
+// runs, so settings saved in the web page show up in the next sample.
+static TaskHandle_t scope_task_handle = NULL;
+static esp_timer_handle_t scope_timer = NULL;
+static volatile bool scope_stop_requested = false;
+
+static void scope_timer_cb(void *arg) {
+    xTaskNotifyGive((TaskHandle_t)arg);
+}
+
+static void scope_task(void *arg) {
+    adc_init();
+    if (!cfg_valid) {
+        device_settings_t defaults;
+        settings_get_defaults(&defaults);
+        sender_set_settings(&defaults);
+    }
+    input_pipeline_reset(&input_pipeline);
+    uint16_t raw[NUM_CHANNELS];
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        raw[i] = ADC_CENTER_VALUE;
+    }
+    while (!scope_stop_requested) {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)) == 0) {
+            continue;
+        }
+        apply_pending_cfg();
+        uint32_t t_us = (uint32_t)esp_timer_get_time();
+        for (int i = 0; i < NUM_ADC_INPUTS; i++) {
+            int v = 0;
+            if (adc_oneshot_read(adc_unit, adc_inputs[i], &v) == ESP_OK) {
+                raw[i] = adc_lut_apply(&adc_lut, v);    // A failed read repeats the last sample
+            }
+        }
+        uint16_t cond[NUM_CHANNELS];
+        input_pipeline_process(&input_pipeline, raw, cond);
+        scope_record(t_us, raw, cond);
+    }
+    scope_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+bool sender_scope_start(uint16_t rate_hz) {
+    if (sender_task_handle != NULL || calib_task_handle != NULL) {
+        ESP_LOGW(TAG, "Scope not available while the sender or calibration is running");
+        return false;
+    }
+    if (scope_task_handle != NULL) {
+        sender_scope_stop();
+    }
+    scope_stop_requested = false;
+    if (xTaskCreatePinnedToCore(scope_task, "scope", TASK_STACK_SCOPE, NULL, TASK_PRIO_SCOPE,
+                                &scope_task_handle, TASK_CORE_UI) != pdPASS) {
+        scope_task_handle = NULL;
+        return false;
+    }
+    esp_timer_create_args_t args = {
+        .callback = scope_timer_cb,
+        .arg = scope_task_handle,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "scope",
+    };
+    if (esp_timer_create(&args, &scope_timer) != ESP_OK ||
+        esp_timer_start_periodic(scope_timer, 1000000ULL / rate_hz) != ESP_OK) {
+        sender_scope_stop();
+        return false;
+    }
+    ESP_LOGI(TAG, "Scope capture at %u Hz", rate_hz);
+    return true;
+}
+
+void sender_scope_stop(void) {
+    if (scope_timer != NULL) {
+        esp_timer_stop(scope_timer);
+        esp_timer_delete(scope_timer);
+        scope_timer = NULL;
+    }
+    scope_stop_requested = true;
+    // The task exits within one notification timeout
+    for (int i = 0; i < 20 && scope_task_handle != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+bool sender_scope_active(void) {
+    return scope_task_handle != NULL;
+}
+
+// Hand a frame to esp_now_send(), recorded in the transmit pipeline first since
+// send_cb() can run before the call returns. Returns the esp_now_send() result.
+static esp_err_t pipeline_send(tx_frame_kind_t kind, const uint8_t *peer_mac, const uint8_t *data, size_t len) {
+    // Held until the record leaves the pipeline so the radio hand-off runs at
+    // full clock; taken before recording, as any callback may release it
+    power_lock_acquire(POWER_LOCK_TX);
+    portENTER_CRITICAL(&tx_lock);
+    tx_pipeline_send(&tx_pipe, kind, (uint32_t)esp_timer_get_time());
+    uint32_t released = tx_pipeline_take_dropped(&tx_pipe);
+    portEXIT_CRITICAL(&tx_lock);
+    release_tx_locks(released);
+    esp_err_t err = esp_now_send(peer_mac, data, len);
+    if (err != ESP_OK) {
+        portENTER_CRITICAL(&tx_lock);
+        bool removed = tx_pipeline_failed(&tx_pipe, kind, err == ESP_ERR_ESPNOW_NO_MEM);
+        portEXIT_CRITICAL(&tx_lock);
+        release_tx_locks(removed ? 1 : 0);
+    }
+    return err;
+}
+
+// Fill in the light bits, pack, seal and send
+static void transmit(control_packet_t *pkt) {
+    uint8_t peer_mac[PEER_MAC_LEN];
+    portENTER_CRITICAL(&light_lock);
+    pkt->lights = shared_light_states;
+    memcpy(peer_mac, target_mac, PEER_MAC_LEN);
+    portEXIT_CRITICAL(&light_lock);
+
+    // Counter and tag are added last so every retransmission gets a fresh counter
+    link_frame_t frame;
+    control_packet_pack(pkt, frame.payload);
+    size_t len = link_auth_seal(&frame);
+    if (len == 0) {
+        // Link security enabled without a usable key: never send unauthenticated
+        portENTER_CRITICAL(&tx_lock);
+        tx_pipeline_drop(&tx_pipe);
+        portEXIT_CRITICAL(&tx_lock);
+        return;
+    }
+    esp_err_t err = pipeline_send(TX_FRAME_CONTROL, peer_mac, (uint8_t *)&frame, len);
+    // Traced rather than logged: a log line per failed frame would change the timing
+    TRACE(TRACE_EV_TX, err != ESP_OK, pkt->lights);
+    if (err == ESP_ERR_ESPNOW_NO_MEM) {
+        // Wi-Fi TX queue full: the frame stays pending, and counts as congestion for frame_rate
+        tx_results++;
+        tx_failures++;
+    }
+}
+
+// Offer a new control frame (already in *pkt) to the transmit pipeline and
+// send it if no control frame is in flight. Otherwise it waits in *pkt, where
+// the next sample replaces it, until service_tx() finds the pipeline free.
+static void send_control(control_packet_t *pkt, uint32_t capture_us) {
+    portENTER_CRITICAL(&tx_lock);
+    bool go = tx_pipeline_offer(&tx_pipe, (uint32_t)esp_timer_get_time());
+    uint32_t released = tx_pipeline_take_dropped(&tx_pipe);
+    portEXIT_CRITICAL(&tx_lock);
+    release_tx_locks(released);
+    if (go) {
+        input_source_record_latency((uint32_t)esp_timer_get_time() - capture_us);
+        transmit(pkt);
+    }
+}
+
+// Send the held-back control frame once the one ahead of it has completed
+static void service_tx(control_packet_t *pkt, uint32_t capture_us) {
+    portENTER_CRITICAL(&tx_lock);
+    bool go = tx_pipeline_ready(&tx_pipe, (uint32_t)esp_timer_get_time());
+    uint32_t released = tx_pipeline_take_dropped(&tx_pipe);
+    portEXIT_CRITICAL(&tx_lock);
+    release_tx_locks(released);
+    if (go) {
+        input_source_record_latency((uint32_t)esp_timer_get_time() - capture_us);
+        transmit(pkt);
+    }
+}
+
+// Retry and frame timers: both only wake sender_task()
+static void wake_timer_cb(void *arg) {
+    TaskHandle_t task = sender_task_handle;
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+// Acks for event frames and resync requests; control frames never come back to the sender
+static void recv_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
+    event_msg_t ack;
+    if (!info || !link_auth_open_ack(info->src_addr, data, len, &ack)) {
+        return;
+    }
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL(&light_lock);
+    // With a broadcast target any receiver may answer, otherwise only the peer
+    bool from_peer = memcmp(target_mac, info->src_addr, PEER_MAC_LEN) == 0 ||
+                     memcmp(target_mac, "\xff\xff\xff\xff\xff\xff", PEER_MAC_LEN) == 0;
+    bool matched = from_peer && ack.type == EVENT_MSG_ACK && event_tx_ack(&event_tx, &ack, now);
+    portEXIT_CRITICAL(&light_lock);
+    if (matched) {
+        TRACE(TRACE_EV_EVENT_ACK, 0, ack.seq);
+    }
+    if (from_peer) {
+        link_verified = true;       // Sealed with the link key: the receiver is there
+    }
+    if (from_peer && ack.type == EVENT_MSG_RESYNC) {
+        resync_requested = true;
+        TaskHandle_t task = sender_task_handle;
+        if (task != NULL) {
+            xTaskNotifyGive(task);
+        }
+    }
+}
+
+// Send the event frame if one is due and arm the retry timer. Runs in
+// sender_task() only, so event and periodic frames go out in the order built.
+// Records button-to-transmit latency on an event's first frame.
+static void service_events(void) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    link_event_frame_t frame;
+    uint8_t peer_mac[PEER_MAC_LEN];
+    uint32_t event_us;
+    uint32_t wait_us = 0;
+    portENTER_CRITICAL(&light_lock);
+    bool due = event_tx_next(&event_tx, now, &frame.msg);
+    bool waiting = event_tx_wait_us(&event_tx, now, &wait_us);
+    uint8_t sends = event_tx.sends;
+    event_us = event_tx.event_us;
+    memcpy(peer_mac, target_mac, PEER_MAC_LEN);
+    portEXIT_CRITICAL(&light_lock);
+
+    if (due) {
+        if (sends == 1) {
+            light_lat_last_us = now - event_us;
+            if (light_lat_last_us > light_lat_max_us) {
+                light_lat_max_us = light_lat_last_us;
+            }
+        }
+        size_t len = link_auth_seal_event(&frame);
+        if (len > 0) {
+            // Never held back for control frames; a refused frame is retried on the event timer
+            pipeline_send(TX_FRAME_EVENT, peer_mac, (uint8_t *)&frame, len);
+            TRACE(TRACE_EV_EVENT_TX, sends, frame.msg.seq);
+        }
+    }
+    if (waiting) {
+        esp_timer_stop(event_timer);
+        esp_timer_start_once(event_timer, wait_us > 0 ? wait_us : 1);
+    }
+}
+
+// Repost the current light state while no answer arrived and no event is in
+// flight, so an unbound sender gets an ack to verify the link with
+static void probe_link(uint32_t *probe_us) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    if (now - *probe_us < LINK_PROBE_US) {
+        return;
+    }
+    uint32_t wait_us;
+    portENTER_CRITICAL(&light_lock);
+    bool probe = memcmp(target_mac, "\xff\xff\xff\xff\xff\xff", PEER_MAC_LEN) == 0 &&
+                 !event_tx_wait_us(&event_tx, now, &wait_us);
+    if (probe) {
+        event_tx_post(&event_tx, shared_light_states, now, now);
+    }
+    portEXIT_CRITICAL(&light_lock);
+    if (probe) {
+        *probe_us = now;
+    }
 }
 
 static void sender_task(void *arg) {
-    const uint8_t *peer_mac = (const uint8_t *)arg;
-    
     // Register send callback to track connection status
     ESP_ERROR_CHECK(esp_now_register_send_cb(send_cb));
+    ESP_ERROR_CHECK(esp_now_register_recv_cb(recv_cb));
     
-    // Add peer (or update if it already exists)
-    esp_now_peer_info_t peer = {0};
-    memcpy(peer.peer_addr, peer_mac, 6);
-    peer.channel = ESP_NOW_CHANNEL;
-    peer.ifidx = ESP_IF_WIFI_STA;
-    peer.encrypt = false;
-    
-    // Try to add peer, if it already exists, modify it instead
-    esp_err_t ret = esp_now_add_peer(&peer);
-    if (ret == ESP_ERR_ESPNOW_EXIST) {
-        // Peer already exists, update it
-        ret = esp_now_mod_peer(&peer);
-    }
-    
+    // Add peer (or update if it already exists); encrypted when link security asks for it
+    esp_err_t ret = register_peer(target_mac);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Failed to add/modify peer: %s", esp_err_to_name(ret));
         return;
@@ -80,23 +731,135 @@ static void sender_task(void *arg) {
 
     adc_init();
 
+    if (!cfg_valid) {
+        // No settings supplied yet: full-range calibration, no conditioning
+        device_settings_t defaults;
+        settings_get_defaults(&defaults);
+        sender_set_settings(&defaults);
+    }
+
+    input_source_t source = INPUT_SOURCE_COUNT;
+    uint32_t last_seq = 0;
+    bool stale_logged = false;
+    control_packet_t tx_pkt = {0};     // Newest control frame, also the held-back one
+    uint32_t tx_capture_us = 0;
+    uint32_t results_seen = 0;
+    uint32_t failures_seen = 0;
+    uint32_t probe_us = (uint32_t)esp_timer_get_time() - LINK_PROBE_US;
+
     while (1) {
-        int ch_raw[6] = {0};
-        for (int i = 0; i < 6; i++) {
-            ESP_ERROR_CHECK(adc_oneshot_read(adc_unit, (adc_channel_t)i, &ch_raw[i]));
+        if (resync_requested) {
+            resync_requested = false;
+            link_auth_new_session();
+        }
+        if (!link_verified) {
+            probe_link(&probe_us);
+        }
+        apply_pending_rate();
+        if (cfg_pending) {
+            frame_rate_force(&frame_rate);      // New profile or peer: send the next sample
+        }
+        apply_pending_cfg();
+
+        if (source != requested_source) {
+            source = (input_source_t)requested_source;
+            if (input_source_start(source, PIN_TRAINER_IN, xTaskGetCurrentTaskHandle()) != ESP_OK) {
+                source = INPUT_SOURCE_ADC;
+                input_source_start(source, PIN_TRAINER_IN, NULL);
+            }
+            input_pipeline_reset(&input_pipeline);
         }
 
-        control_packet_t pkt = {0};
-        for (int i = 0; i < 6; i++) {
-            pkt.ch[i] = (uint16_t)ch_raw[i];
+        uint16_t ch_raw[NUM_CHANNELS] = {0};
+        uint32_t capture_us;
+        uint32_t frame_start = 0;
+        if (source == INPUT_SOURCE_ADC) {
+            power_lock_acquire(POWER_LOCK_ADC);
+            frame_start = perf_begin();
+            capture_us = (uint32_t)esp_timer_get_time();
+            for (int i = 0; i < NUM_ADC_INPUTS; i++) {
+                int raw = 0;
+                ESP_ERROR_CHECK(adc_oneshot_read(adc_unit, adc_inputs[i], &raw));
+                ch_raw[i] = adc_lut_apply(&adc_lut, raw);
+            }
+            for (int i = NUM_ADC_INPUTS; i < NUM_CHANNELS; i++) {
+                ch_raw[i] = ADC_CENTER_VALUE;
+            }
+        } else {
+            // Transmit as soon as a trainer frame completes; the timeout only
+            // bounds how long a lost trainer signal goes unnoticed
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+            service_events();
+            service_tx(&tx_pkt, tx_capture_us);
+            input_frame_t frame;
+            bool have_frame = input_source_read(&frame);
+            uint32_t now = (uint32_t)esp_timer_get_time();
+            if (!have_frame || now - frame.capture_us > INPUT_SOURCE_STALE_US) {
+                // No trainer signal: stop transmitting so the receiver fails safe
+                if (have_frame && !stale_logged) {
+                    ESP_LOGW(TAG, "Trainer input lost");
+                    stale_logged = true;
+                }
+                continue;
+            }
+            if (frame.seq == last_seq) {
+                continue;           // Woken for an event frame between trainer frames
+            }
+            power_lock_acquire(POWER_LOCK_ADC);
+            frame_start = perf_begin();
+            stale_logged = false;
+            last_seq = frame.seq;
+            capture_us = frame.capture_us;
+            for (int i = 0; i < NUM_CHANNELS; i++) {
+                ch_raw[i] = (i < frame.num_ch) ? input_source_us_to_adc(frame.ch[i]) : ADC_CENTER_VALUE;
+            }
         }
-        pkt.lights = shared_light_states;
 
-        esp_err_t err = esp_now_send(peer_mac, (uint8_t *)&pkt, sizeof(pkt));
-        if (err != ESP_OK) {
-            ESP_LOGW(TAG, "ESP-NOW send failed: %s", esp_err_to_name(err));
+        uint16_t ch_out[NUM_CHANNELS];
+        input_pipeline_process(&input_pipeline, ch_raw, ch_out);
+
+        // Sticks are sampled at the upper rate bound and frame_rate picks the
+        // samples that go out. Trainer frames go out as they arrive, unsignalled.
+        bool send = true;
+        uint8_t rate = 0;
+        if (source == INPUT_SOURCE_ADC) {
+            uint32_t results = tx_results;
+            uint32_t failures = tx_failures;
+            frame_rate_tx_done(&frame_rate, results - results_seen, failures - failures_seen, capture_us);
+            results_seen = results;
+            failures_seen = failures;
+            send = frame_rate_sample(&frame_rate, ch_out, capture_us, &rate);
+        }
+        if (send) {
+            for (int i = 0; i < NUM_CHANNELS; i++) {
+                tx_pkt.ch[i] = ch_out[i];
+            }
+            if (rate != tx_pkt.rate) {
+                TRACE(TRACE_EV_RATE, rate, frame_rate_hz(rate));
+            }
+            tx_pkt.rate = rate;
+            tx_capture_us = capture_us;
+            send_control(&tx_pkt, capture_us);
+        }
+        perf_end(PERF_SENDER_FRAME, frame_start);
+        power_lock_release(POWER_LOCK_ADC);
+        power_frame_done();
+        if (source == INPUT_SOURCE_ADC) {
+            // Sleep until the next sample on the frame timer. Event frames go out
+            // while waiting without moving it; a profile switch samples at once.
+            uint32_t now_us = (uint32_t)esp_timer_get_time();
+            uint32_t wait_us = frame_rate_wait_us(&frame_rate, now_us);
+            uint32_t wake_us = now_us + wait_us;
+            if (wait_us > 0) {
+                esp_timer_stop(frame_timer);
+                esp_timer_start_once(frame_timer, wait_us);
+            }
+            while (!cfg_pending && !rate_pending && (int32_t)(wake_us - (uint32_t)esp_timer_get_time()) > 0) {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000 / FRAME_RATE_MIN_HZ));
+                service_events();
+                service_tx(&tx_pkt, tx_capture_us);
+            }
         }
-        vTaskDelay(pdMS_TO_TICKS(20)); // ~50 Hz
     }
 }
 
@@ -105,14 +868,58 @@ void sender_start(const uint8_t *peer_mac) {
         ESP_LOGW(TAG, "Sender already running");
         return;
     }
+    if (calib_task_handle != NULL) {
+        sender_calibration_stop();
+    }
+    if (scope_task_handle != NULL) {
+        sender_scope_stop();
+    }
     
-    xTaskCreate(sender_task, "sender", 4096, (void *)peer_mac, 5, &sender_task_handle);
+    memcpy(target_mac, peer_mac, PEER_MAC_LEN);
+    link_verified = false;
+    if (event_timer == NULL) {
+        esp_timer_create_args_t args = {
+            .callback = wake_timer_cb,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "event_retry",
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&args, &event_timer));
+    }
+    if (frame_timer == NULL) {
+        esp_timer_create_args_t args = {
+            .callback = wake_timer_cb,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "frame",
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&args, &frame_timer));
+    }
+    rate_pending = true;        // Fresh rate state and statistics for this run
+    // Frames still in flight from the last run hold their locks. A late
+    // callback for one finds no record (or completes a newer one), so each
+    // lock is still released once.
+    portENTER_CRITICAL(&tx_lock);
+    uint32_t released = tx_pipe.count + tx_pipeline_take_dropped(&tx_pipe);
+    tx_pipeline_init(&tx_pipe);
+    portEXIT_CRITICAL(&tx_lock);
+    release_tx_locks(released);
+    portENTER_CRITICAL(&light_lock);
+    event_tx_init(&event_tx, (uint16_t)esp_random());
+    portEXIT_CRITICAL(&light_lock);
+    xTaskCreatePinnedToCore(sender_task, "sender", TASK_STACK_SENDER, NULL, TASK_PRIO_RADIO,
+                            &sender_task_handle, TASK_CORE_RADIO);
 }
 
 void sender_stop(void) {
     if (sender_task_handle != NULL) {
         vTaskDelete(sender_task_handle);
         sender_task_handle = NULL;
+        esp_timer_stop(event_timer);
+        esp_timer_stop(frame_timer);
+        esp_now_unregister_recv_cb();
+        power_lock_release(POWER_LOCK_ADC);     // In case the task was deleted mid-frame
+        input_source_stop();
         ESP_LOGI(TAG, "Sender stopped");
     }
 }
@@ -0,0 +1,303 @@
+// Receiver serial outputs implementation
+#include "serial_output.h"
+#include "rc_protocol.h"
+#include "common.h"
+#include "power.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "driver/uart.h"
+#include "driver/rmt_tx.h"
+#include <string.h>
+
+static const char *TAG = "serial_out";
+
+#define SERIAL_UART_PORT UART_NUM_1
+#define SERIAL_UART_RX_BUF 256              // Driver requires an RX buffer larger than the FIFO
+#define SBUS_PERIOD_US 14000
+#define CRSF_PERIOD_US 4000
+#define PPM_PERIOD_MAX_US 32000             // RMT durations are 15-bit at 1 MHz
+#define PPM_CHANNELS (NUM_CHANNELS < 8 ? NUM_CHANNELS : 8)    // 8 x 2500 µs still fits the 15-bit limit
+#define PPM_PERIOD_MIN_US (PPM_CHANNELS * 2500 + 5000)      // Room for the channels plus the sync gap
+#define PPM_SYMBOLS (PPM_CHANNELS + 1)
+#define PPM_BUFFERS 3                       // One transmitting, one queued, one being filled
+
+static serial_proto_t active_proto = SERIAL_PROTO_NONE;
+static esp_timer_handle_t frame_timer = NULL;
+static uint32_t period_us = 0;
+
+// Latest channel frame, written by the receiver and read by the frame timer
+static portMUX_TYPE frame_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint16_t latest_us[NUM_CHANNELS];
+static bool have_frame = false;
+static bool failsafe = false;
+
+static uint32_t frames_sent = 0;
+static uint32_t frames_skipped = 0;
+
+// PPM via RMT
+static rmt_channel_handle_t ppm_chan = NULL;
+static rmt_encoder_handle_t ppm_encoder = NULL;
+static rmt_symbol_word_t ppm_symbols[PPM_BUFFERS][PPM_SYMBOLS];
+static int ppm_next_buf = 0;
+static uint32_t ppm_queued = 0;            // Written by the frame timer only
+static volatile uint32_t ppm_done = 0;     // Written by the RMT done ISR only
+
+static uint32_t default_period_us(serial_proto_t proto) {
+    switch (proto) {
+        case SERIAL_PROTO_SBUS: return SBUS_PERIOD_US;
+        case SERIAL_PROTO_CRSF: return CRSF_PERIOD_US;
+        case SERIAL_PROTO_PPM:  return PPM_FRAME_US_DEFAULT;
+        default:                return 0;
+    }
+}
+
+static esp_err_t uart_output_init(serial_proto_t proto, int gpio) {
+    uart_config_t cfg = {
+        .baud_rate = (proto == SERIAL_PROTO_SBUS) ? 100000 : 420000,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = (proto == SERIAL_PROTO_SBUS) ? UART_PARITY_EVEN : UART_PARITY_DISABLE,
+        .stop_bits = (proto == SERIAL_PROTO_SBUS) ? UART_STOP_BITS_2 : UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    // No TX ring buffer: a frame (25/26 bytes) fits in the hardware FIFO
+    esp_err_t err = uart_driver_install(SERIAL_UART_PORT, SERIAL_UART_RX_BUF, 0, 0, NULL, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = uart_param_config(SERIAL_UART_PORT, &cfg);
+    if (err == ESP_OK) {
+        err = uart_set_pin(SERIAL_UART_PORT, gpio, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    }
+    if (err == ESP_OK && proto == SERIAL_PROTO_SBUS) {
+        err = uart_set_line_inverse(SERIAL_UART_PORT, UART_SIGNAL_TXD_INV);
+    }
+    if (err != ESP_OK) {
+        uart_driver_delete(SERIAL_UART_PORT);
+    }
+    return err;
+}
+
+static bool IRAM_ATTR ppm_done_cb(rmt_channel_handle_t chan, const rmt_tx_done_event_data_t *edata, void *ctx) {
+    ppm_done++;
+    return false;
+}
+
+static esp_err_t ppm_output_init(int gpio) {
+    rmt_tx_channel_config_t cfg = {
+        .gpio_num = gpio,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = 1000000,           // 1 µs per tick
+        .mem_block_symbols = 48,
+        .trans_queue_depth = PPM_BUFFERS - 1,
+    };
+    esp_err_t err = rmt_new_tx_channel(&cfg, &ppm_chan);
+    if (err != ESP_OK) {
+        return err;
+    }
+    rmt_copy_encoder_config_t enc_cfg = {};
+    err = rmt_new_copy_encoder(&enc_cfg, &ppm_encoder);
+    if (err == ESP_OK) {
+        rmt_tx_event_callbacks_t cbs = {
+            .on_trans_done = ppm_done_cb,
+        };
+        err = rmt_tx_register_event_callbacks(ppm_chan, &cbs, NULL);
+    }
+    if (err == ESP_OK) {
+        err = rmt_enable(ppm_chan);
+    }
+    if (err != ESP_OK) {
+        if (ppm_encoder) {
+            rmt_del_encoder(ppm_encoder);
+            ppm_encoder = NULL;
+        }
+        rmt_del_channel(ppm_chan);
+        ppm_chan = NULL;
+    }
+    ppm_queued = 0;
+    ppm_done = 0;
+    ppm_next_buf = 0;
+    return err;
+}
+
+static bool uart_send(const uint8_t *frame, int len) {
+    // Previous frame still shifting out: drop this one rather than queue behind it
+    if (uart_wait_tx_done(SERIAL_UART_PORT, 0) != ESP_OK) {
+        return false;
+    }
+    return uart_tx_chars(SERIAL_UART_PORT, (const char *)frame, len) == len;
+}
+
+static bool ppm_send(const uint16_t *us) {
+    if (ppm_queued - ppm_done >= PPM_BUFFERS - 1) {
+        return false;
+    }
+    uint16_t durations[PPM_SYMBOLS * 2];
+    int n = ppm_encode(us, PPM_CHANNELS, period_us, durations);
+
+    rmt_symbol_word_t *sym = ppm_symbols[ppm_next_buf];
+    for (int i = 0; i < n / 2; i++) {
+        uint16_t space = durations[2 * i + 1];
+        if (space > 0x7FFF) space = 0x7FFF;
+        sym[i].level0 = 1;
+        sym[i].duration0 = durations[2 * i];
+        sym[i].level1 = 0;
+        sym[i].duration1 = space;
+    }
+    rmt_transmit_config_t tx = {
+        .loop_count = 0,
+    };
+    if (rmt_transmit(ppm_chan, ppm_encoder, sym, (n / 2) * sizeof(rmt_symbol_word_t), &tx) != ESP_OK) {
+        return false;
+    }
+    ppm_queued++;
+    ppm_next_buf = (ppm_next_buf + 1) % PPM_BUFFERS;
+    return true;
+}
+
+static void send_frame(void) {
+    uint16_t us[NUM_CHANNELS];
+    bool valid;
+    bool lost;
+    portENTER_CRITICAL(&frame_lock);
+    memcpy(us, latest_us, sizeof(us));
+    valid = have_frame;
+    lost = failsafe;
+    portEXIT_CRITICAL(&frame_lock);
+
+    if (!valid) {
+        return;
+    }
+
+    bool sent = false;
+    switch (active_proto) {
+        case SERIAL_PROTO_SBUS: {
+            uint8_t frame[SBUS_FRAME_LEN];
+            sbus_encode(us, NUM_CHANNELS, lost ? (SBUS_FLAG_FAILSAFE | SBUS_FLAG_FRAME_LOST) : 0, frame);
+            sent = uart_send(frame, sizeof(frame));
+            break;
+        }
+        case SERIAL_PROTO_CRSF: {
+            if (lost) {
+                return;
+            }
+            uint8_t frame[CRSF_RC_FRAME_LEN];
+            crsf_encode_rc(us, NUM_CHANNELS, frame);
+            sent = uart_send(frame, sizeof(frame));
+            break;
+        }
+        case SERIAL_PROTO_PPM:
+            if (lost) {
+                return;
+            }
+            sent = ppm_send(us);
+            break;
+        default:
+            return;
+    }
+    if (sent) {
+        frames_sent++;
+    } else {
+        frames_skipped++;
+    }
+}
+
+static void frame_timer_cb(void *arg) {
+    power_lock_acquire(POWER_LOCK_OUTPUT);
+    send_frame();
+    power_lock_release(POWER_LOCK_OUTPUT);
+}
+
+esp_err_t serial_output_start(serial_proto_t proto, uint16_t rate_hz, int gpio) {
+    if (active_proto != SERIAL_PROTO_NONE) {
+        serial_output_stop();
+    }
+    if (proto == SERIAL_PROTO_NONE || proto >= SERIAL_PROTO_COUNT) {
+        return ESP_OK;
+    }
+
+    period_us = default_period_us(proto);
+    if (rate_hz > 0) {
+        if (rate_hz < SERIAL_OUTPUT_RATE_MIN_HZ) rate_hz = SERIAL_OUTPUT_RATE_MIN_HZ;
+        if (rate_hz > SERIAL_OUTPUT_RATE_MAX_HZ) rate_hz = SERIAL_OUTPUT_RATE_MAX_HZ;
+        period_us = 1000000UL / rate_hz;
+    }
+    if (proto == SERIAL_PROTO_PPM) {
+        // 50 Hz at up to 6 channels, 40 Hz at 8: the 22.5 ms default does not fit 8 channels
+        uint32_t asked_us = period_us;
+        if (period_us < PPM_PERIOD_MIN_US) period_us = PPM_PERIOD_MIN_US;
+        if (period_us > PPM_PERIOD_MAX_US) period_us = PPM_PERIOD_MAX_US;
+        if (period_us != asked_us) {
+            ESP_LOGW(TAG, "PPM frame of %lu us does not fit %d channels, using %lu us",
+                     asked_us, PPM_CHANNELS, period_us);
+        }
+    }
+
+    esp_err_t err = (proto == SERIAL_PROTO_PPM) ? ppm_output_init(gpio) : uart_output_init(proto, gpio);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize output: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    portENTER_CRITICAL(&frame_lock);
+    have_frame = false;
+    failsafe = false;
+    portEXIT_CRITICAL(&frame_lock);
+    frames_sent = 0;
+    frames_skipped = 0;
+    active_proto = proto;
+
+    esp_timer_create_args_t args = {
+        .callback = frame_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "serial_out",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &frame_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(frame_timer, period_us));
+
+    static const char *names[SERIAL_PROTO_COUNT] = {"none", "SBUS", "CRSF", "PPM"};
+    ESP_LOGI(TAG, "%s output on GPIO%d, frame every %lu us", names[proto], gpio, period_us);
+    return ESP_OK;
+}
+
+void serial_output_stop(void) {
+    if (frame_timer != NULL) {
+        esp_timer_stop(frame_timer);
+        esp_timer_delete(frame_timer);
+        frame_timer = NULL;
+    }
+    if (active_proto == SERIAL_PROTO_PPM) {
+        rmt_tx_wait_all_done(ppm_chan, 100);
+        rmt_disable(ppm_chan);
+        rmt_del_encoder(ppm_encoder);
+        rmt_del_channel(ppm_chan);
+        ppm_encoder = NULL;
+        ppm_chan = NULL;
+    } else if (active_proto != SERIAL_PROTO_NONE) {
+        uart_driver_delete(SERIAL_UART_PORT);
+    }
+    if (active_proto != SERIAL_PROTO_NONE) {
+        ESP_LOGI(TAG, "Output stopped (%lu frames sent, %lu skipped)", frames_sent, frames_skipped);
+    }
+    active_proto = SERIAL_PROTO_NONE;
+}
+
+void serial_output_update(const uint16_t *us, int num_ch) {
+    if (num_ch > NUM_CHANNELS) {
+        num_ch = NUM_CHANNELS;
+    }
+    portENTER_CRITICAL(&frame_lock);
+    memcpy(latest_us, us, num_ch * sizeof(uint16_t));
+    have_frame = true;
+    failsafe = false;
+    portEXIT_CRITICAL(&frame_lock);
+}
+
+void serial_output_set_failsafe(bool lost) {
+    portENTER_CRITICAL(&frame_lock);
+    failsafe = lost;
+    portEXIT_CRITICAL(&frame_lock);
+}
@@ -0,0 +1,38 @@
+// Receiver serial outputs (SBUS / CRSF / PPM)
+// Drives a flight controller over one wire from the decoded channel frame.
+// Frames are emitted from a periodic esp_timer at the protocol's own rate,
+// independent of the radio frame rate. SBUS and CRSF frames fit in the UART
+// hardware FIFO and are shifted out without further CPU involvement; PPM is
+// generated by the RMT peripheral.
+#ifndef SERIAL_OUTPUT_H
+#define SERIAL_OUTPUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef enum {
+    SERIAL_PROTO_NONE = 0,
+    SERIAL_PROTO_SBUS = 1,      // 100000 baud 8E2 inverted, default 14 ms frame
+    SERIAL_PROTO_CRSF = 2,      // 420000 baud 8N1, default 250 Hz
+    SERIAL_PROTO_PPM = 3,       // RMT pulse train, default 22.5 ms frame
+    SERIAL_PROTO_COUNT
+} serial_proto_t;
+
+#define SERIAL_OUTPUT_RATE_MIN_HZ 20
+#define SERIAL_OUTPUT_RATE_MAX_HZ 500
+
+// Start the selected protocol on gpio at rate_hz (0 = protocol default)
+esp_err_t serial_output_start(serial_proto_t proto, uint16_t rate_hz, int gpio);
+
+// Stop the output and release the UART/RMT channel
+void serial_output_stop(void);
+
+// Publish the latest channel positions (µs); also clears failsafe
+void serial_output_update(const uint16_t *us, int num_ch);
+
+// Signal link loss. SBUS keeps sending with the failsafe flags set;
+// CRSF and PPM stop sending so the flight controller detects the loss.
+void serial_output_set_failsafe(bool failsafe);
+
+#endif // SERIAL_OUTPUT_H
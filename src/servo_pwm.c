@@ -0,0 +1,128 @@
+// Servo PWM output driver implementation
+#include "servo_pwm.h"
+#include "common.h"
+#include "esp_log.h"
+#include "driver/ledc.h"
+#include "soc/soc_caps.h"
+
+static const char *TAG = "servo_pwm";
+
+#define SERVO_PWM_CLK_HZ 80000000UL     // APB clock (LEDC_USE_APB_CLK)
+
+#ifndef SOC_LEDC_TIMER_BIT_WIDTH
+#define SOC_LEDC_TIMER_BIT_WIDTH SOC_LEDC_TIMER_BIT_WIDE_NUM
+#endif
+
+typedef struct {
+    uint16_t freq_hz;
+    uint8_t resolution;
+} pwm_group_t;
+
+static pwm_group_t groups[SERVO_PWM_MAX_TIMERS];
+static int num_groups = 0;
+
+static uint8_t ch_group[NUM_CHANNELS];
+static uint32_t ch_duty_max[NUM_CHANNELS];
+static uint32_t last_duty[NUM_CHANNELS];
+static int num_outputs = 0;
+
+// Highest resolution so that freq * 2^bits <= clock, capped by the hardware
+static uint8_t best_resolution(uint32_t freq_hz) {
+    uint8_t bits = 1;
+    while (bits < SOC_LEDC_TIMER_BIT_WIDTH &&
+           ((uint64_t)freq_hz << (bits + 1)) <= SERVO_PWM_CLK_HZ) {
+        bits++;
+    }
+    return bits;
+}
+
+static int find_or_add_group(uint16_t freq_hz) {
+    for (int g = 0; g < num_groups; g++) {
+        if (groups[g].freq_hz == freq_hz) {
+            return g;
+        }
+    }
+    if (num_groups == SERVO_PWM_MAX_TIMERS) {
+        return -1;
+    }
+    groups[num_groups].freq_hz = freq_hz;
+    groups[num_groups].resolution = best_resolution(freq_hz);
+    return num_groups++;
+}
+
+esp_err_t servo_pwm_init(const int *pins, const uint16_t *freq_hz, int num_channels) {
+    if (num_channels > NUM_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    num_groups = 0;
+    num_outputs = num_channels;
+
+    for (int i = 0; i < num_channels; i++) {
+        uint16_t f = freq_hz[i];
+        if (f < SERVO_PWM_HZ_MIN) f = SERVO_PWM_HZ_MIN;
+        if (f > SERVO_PWM_HZ_MAX) f = SERVO_PWM_HZ_MAX;
+        int g = find_or_add_group(f);
+        if (g < 0) {
+            ESP_LOGW(TAG, "CH%d: no LEDC timer left for %u Hz, using %u Hz", i + 1, f, groups[0].freq_hz);
+            g = 0;
+        }
+        ch_group[i] = (uint8_t)g;
+    }
+
+    for (int g = 0; g < num_groups; g++) {
+        ledc_timer_config_t timer = {
+            .speed_mode = LEDC_LOW_SPEED_MODE,
+            .duty_resolution = (ledc_timer_bit_t)groups[g].resolution,
+            .timer_num = (ledc_timer_t)g,
+            .freq_hz = groups[g].freq_hz,
+            .clk_cfg = LEDC_USE_APB_CLK,
+        };
+        esp_err_t err = ledc_timer_config(&timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+        ESP_LOGI(TAG, "LEDC timer %d: %u Hz, %u-bit", g, groups[g].freq_hz, groups[g].resolution);
+    }
+
+    for (int i = 0; i < num_channels; i++) {
+        ledc_channel_config_t ch = {
+            .gpio_num = pins[i],
+            .speed_mode = LEDC_LOW_SPEED_MODE,
+            .channel = (ledc_channel_t)i,
+            .intr_type = LEDC_INTR_DISABLE,
+            .timer_sel = (ledc_timer_t)ch_group[i],
+            .duty = 0,
+            .hpoint = 0,
+        };
+        esp_err_t err = ledc_channel_config(&ch);
+        if (err != ESP_OK) {
+            return err;
+        }
+        ch_duty_max[i] = (1UL << groups[ch_group[i]].resolution) - 1;
+        last_duty[i] = 0;
+    }
+    return ESP_OK;
+}
+
+void servo_pwm_write_us(int ch, uint32_t us) {
+    if (ch < 0 || ch >= num_outputs) {
+        return;
+    }
+    const pwm_group_t *g = &groups[ch_group[ch]];
+    uint32_t duty = servo_us_to_duty(us, g->freq_hz, g->resolution);
+    if (duty > ch_duty_max[ch]) duty = ch_duty_max[ch];
+    if (duty == last_duty[ch]) {
+        return;
+    }
+    last_duty[ch] = duty;
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)ch, duty);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)ch);
+}
+
+uint32_t servo_pwm_get_freq(int ch) {
+    return (ch >= 0 && ch < num_outputs) ? groups[ch_group[ch]].freq_hz : 0;
+}
+
+uint8_t servo_pwm_get_resolution(int ch) {
+    return (ch >= 0 && ch < num_outputs) ? groups[ch_group[ch]].resolution : 0;
+}
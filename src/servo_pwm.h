@@ -0,0 +1,29 @@
+// Servo PWM output driver (LEDC)
+// Channels are grouped by frame rate onto separate LEDC timers, each running at
+// the highest duty resolution its clock allows. Duty is computed from the
+// timer's actual resolution and only written when it changes.
+#ifndef SERVO_PWM_H
+#define SERVO_PWM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define SERVO_PWM_MAX_TIMERS 4          // LEDC timers available for frame-rate groups
+#define SERVO_PWM_HZ_MIN 50
+#define SERVO_PWM_HZ_MAX 560
+
+// Configure LEDC for num_channels outputs. pins[i] is the GPIO and freq_hz[i]
+// the frame rate of channel i. Channels sharing a frame rate share a timer;
+// if more than SERVO_PWM_MAX_TIMERS distinct rates are requested, the extra
+// channels fall back to the first group.
+esp_err_t servo_pwm_init(const int *pins, const uint16_t *freq_hz, int num_channels);
+
+// Set pulse width in microseconds; skips the LEDC update if the duty is unchanged
+void servo_pwm_write_us(int ch, uint32_t us);
+
+// Frame rate and duty resolution actually used by a channel
+uint32_t servo_pwm_get_freq(int ch);
+uint8_t servo_pwm_get_resolution(int ch);
+
+#endif // SERVO_PWM_H
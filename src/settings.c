@@ -1,6 +1,7 @@
 // NVS-based settings implementation
 #include "settings.h"
 #include "common.h"
+#include "power.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "nvs.h"
@@ -10,6 +11,27 @@
 static const char *TAG = "settings";
 static const char *NVS_NAMESPACE = "radio";
 
+// Stick calibration is stored as a single blob so a capture is committed atomically
+// (NVS replaces a blob entry in one step; power loss leaves either the old or the new set).
+typedef struct {
+    uint16_t min[NUM_CHANNELS];
+    uint16_t center[NUM_CHANNELS];
+    uint16_t max[NUM_CHANNELS];
+} calib_blob_t;
+
+// Mixer configuration is stored as one blob as well (preset + custom matrix)
+typedef struct {
+    uint8_t preset;
+    int8_t weight[NUM_CHANNELS][NUM_CHANNELS];
+    int8_t offset[NUM_CHANNELS];
+} mixer_blob_t;
+
+static void calib_to_blob(const device_settings_t *settings, calib_blob_t *blob) {
+    memcpy(blob->min, settings->ch_min, sizeof(blob->min));
+    memcpy(blob->center, settings->ch_center, sizeof(blob->center));
+    memcpy(blob->max, settings->ch_max, sizeof(blob->max));
+}
+
 void settings_init(void) {
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -24,19 +46,62 @@ void settings_init(void) {
 void settings_get_defaults(device_settings_t *settings) {
     // Default broadcast MAC (all FF for broadcast)
     memset(settings->peer_mac, PEER_MAC_BROADCAST, PEER_MAC_LEN);
+    settings->peer_bound = false;
+    settings->peer_num_channels = 0;
+    settings->peer_caps = 0;
     settings->channel = 1;
     // Default calibration: full ADC range for all channels
     for (int i = 0; i < NUM_CHANNELS; i++) {
         settings->ch_min[i] = 0;
         settings->ch_max[i] = ADC_MAX_VALUE;
+        settings->ch_center[i] = ADC_CENTER_VALUE;
+        // Default input conditioning: no deadband, trim or filtering
+        settings->ch_deadband[i] = 0;
+        settings->ch_trim[i] = 0;
+        settings->ch_filter[i] = 0;
+        settings->ch_filter_strength[i] = 2;
+        settings->ch_reverse[i] = false;
         // Default servo positions for each channel (standard RC servo range)
         settings->servo_min[i] = SERVO_US_MIN;     // Full left/backward
         settings->servo_center[i] = SERVO_US_CENTER;  // Neutral
         settings->servo_max[i] = SERVO_US_MAX;     // Full right/forward
+        settings->ch_pwm_hz[i] = SERVO_FREQ_HZ;    // Analog servo frame rate
         // Default expo for each channel (0.0 = linear, 1.0 = strong S-curve)
         settings->expo[i] = 0.0f;
     }
+    // Default channel source: local sticks
+    settings->input_source = 0;
+    // Default frame rate: 10 Hz keepalive, up to 100 Hz while the sticks move
+    settings->rate_min_hz = FRAME_RATE_DEFAULT_MIN_HZ;
+    settings->rate_max_hz = FRAME_RATE_DEFAULT_MAX_HZ;
+    // Default output stage: off (servos follow frames directly), no slew limit
+    settings->output_rate_hz = 0;
+    settings->output_extrapolate = false;
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        settings->ch_slew[i] = 0;
+    }
+    // Default serial output: off
+    settings->serial_proto = 0;
+    settings->serial_rate_hz = 0;
+    // Default power mode: fixed full CPU frequency
+    settings->power_mode = POWER_MODE_PERFORMANCE;
+    settings->power_budget_us = POWER_BUDGET_DEFAULT_US;
+    // Default link security: off, no key
+    settings->link_security = 0;
+    memset(settings->link_key, 0, sizeof(settings->link_key));
+    strcpy(settings->ap_password, AP_PASSWORD_DEFAULT);
+    // Default mixer: identity (output N follows input N)
+    settings->mix_preset = 0;
+    memset(settings->mix_weight, 0, sizeof(settings->mix_weight));
+    memset(settings->mix_offset, 0, sizeof(settings->mix_offset));
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        settings->mix_weight[i][i] = 100;
+    }
+#ifdef ROLE_FIXED
+    settings->device_role = ROLE_FIXED;
+#else
     settings->device_role = ROLE_RECEIVER;      // receiver by default
+#endif
     settings->is_configured = false;
 }
 
@@ -61,6 +126,16 @@ void settings_load(device_settings_t *settings) {
     if (err != ESP_OK) {
         memset(settings->peer_mac, 0xFF, 6);
     }
+    // Bind result (see bind.h)
+    uint8_t bound = 0;
+    nvs_get_u8(handle, "peer_bound", &bound);
+    settings->peer_bound = (bound != 0);
+    if (nvs_get_u8(handle, "peer_nch", &settings->peer_num_channels) != ESP_OK) {
+        settings->peer_num_channels = 0;
+    }
+    if (nvs_get_u16(handle, "peer_caps", &settings->peer_caps) != ESP_OK) {
+        settings->peer_caps = 0;
+    }
 
     // Load other settings
     nvs_get_u8(handle, "channel", &settings->channel);
@@ -79,6 +154,54 @@ void settings_load(device_settings_t *settings) {
             settings->ch_max[i] = ADC_MAX_VALUE;
         }
     }
+
+    // Load per-channel input conditioning
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        char key_ctr[16], key_dbnd[16], key_trim[16], key_filt[16], key_fstr[16], key_rev[16];
+        snprintf(key_ctr, sizeof(key_ctr), "ch%d_ctr", i + 1);
+        snprintf(key_dbnd, sizeof(key_dbnd), "ch%d_dbnd", i + 1);
+        snprintf(key_trim, sizeof(key_trim), "ch%d_trim", i + 1);
+        snprintf(key_filt, sizeof(key_filt), "ch%d_filt", i + 1);
+        snprintf(key_fstr, sizeof(key_fstr), "ch%d_fstr", i + 1);
+        snprintf(key_rev, sizeof(key_rev), "ch%d_rev", i + 1);
+
+        if (nvs_get_u16(handle, key_ctr, &settings->ch_center[i]) != ESP_OK) {
+            settings->ch_center[i] = ADC_CENTER_VALUE;
+        }
+        if (nvs_get_u16(handle, key_dbnd, &settings->ch_deadband[i]) != ESP_OK) {
+            settings->ch_deadband[i] = 0;
+        }
+        if (nvs_get_i16(handle, key_trim, &settings->ch_trim[i]) != ESP_OK) {
+            settings->ch_trim[i] = 0;
+        }
+        if (nvs_get_u8(handle, key_filt, &settings->ch_filter[i]) != ESP_OK) {
+            settings->ch_filter[i] = 0;
+        }
+        if (nvs_get_u8(handle, key_fstr, &settings->ch_filter_strength[i]) != ESP_OK) {
+            settings->ch_filter_strength[i] = 2;
+        }
+        uint8_t rev = 0;
+        nvs_get_u8(handle, key_rev, &rev);
+        settings->ch_reverse[i] = (rev != 0);
+    }
+    if (nvs_get_u8(handle, "in_src", &settings->input_source) != ESP_OK) {
+        settings->input_source = 0;
+    }
+    if (nvs_get_u16(handle, "rate_min", &settings->rate_min_hz) != ESP_OK) {
+        settings->rate_min_hz = FRAME_RATE_DEFAULT_MIN_HZ;
+    }
+    if (nvs_get_u16(handle, "rate_max", &settings->rate_max_hz) != ESP_OK) {
+        settings->rate_max_hz = FRAME_RATE_DEFAULT_MAX_HZ;
+    }
+
+    // Calibration blob supersedes the legacy per-channel min/max/center keys
+    calib_blob_t blob;
+    size_t blob_len = sizeof(blob);
+    if (nvs_get_blob(handle, "calib", &blob, &blob_len) == ESP_OK && blob_len == sizeof(blob)) {
+        memcpy(settings->ch_min, blob.min, sizeof(blob.min));
+        memcpy(settings->ch_center, blob.center, sizeof(blob.center));
+        memcpy(settings->ch_max, blob.max, sizeof(blob.max));
+    }
     
     // Load per-channel servo positions and expo
     for (int i = 0; i < NUM_CHANNELS; i++) {
@@ -101,9 +224,78 @@ void settings_load(device_settings_t *settings) {
         if (nvs_get_u32(handle, key_expo, (uint32_t*)&settings->expo[i]) != ESP_OK) {
             settings->expo[i] = 0.0f;
         }
+        char key_pwm[16];
+        snprintf(key_pwm, sizeof(key_pwm), "ch%d_pwmhz", i + 1);
+        if (nvs_get_u16(handle, key_pwm, &settings->ch_pwm_hz[i]) != ESP_OK) {
+            settings->ch_pwm_hz[i] = SERVO_FREQ_HZ;
+        }
     }
     
+    // Load output stage configuration
+    if (nvs_get_u16(handle, "out_rate", &settings->output_rate_hz) != ESP_OK) {
+        settings->output_rate_hz = 0;
+    }
+    uint8_t extrap = 0;
+    nvs_get_u8(handle, "out_extrap", &extrap);
+    settings->output_extrapolate = (extrap != 0);
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        char key_slew[16];
+        snprintf(key_slew, sizeof(key_slew), "ch%d_slew", i + 1);
+        if (nvs_get_u16(handle, key_slew, &settings->ch_slew[i]) != ESP_OK) {
+            settings->ch_slew[i] = 0;
+        }
+    }
+
+    // Load serial output configuration
+    if (nvs_get_u8(handle, "ser_proto", &settings->serial_proto) != ESP_OK) {
+        settings->serial_proto = 0;
+    }
+    if (nvs_get_u16(handle, "ser_rate", &settings->serial_rate_hz) != ESP_OK) {
+        settings->serial_rate_hz = 0;
+    }
+
+    // Load power management configuration
+    if (nvs_get_u8(handle, "pwr_mode", &settings->power_mode) != ESP_OK) {
+        settings->power_mode = POWER_MODE_PERFORMANCE;
+    }
+    if (nvs_get_u16(handle, "pwr_budget", &settings->power_budget_us) != ESP_OK) {
+        settings->power_budget_us = POWER_BUDGET_DEFAULT_US;
+    }
+
+    // Load link security configuration
+    if (nvs_get_u8(handle, "link_sec", &settings->link_security) != ESP_OK) {
+        settings->link_security = 0;
+    }
+    size_t key_len = sizeof(settings->link_key);
+    if (nvs_get_blob(handle, "link_key", settings->link_key, &key_len) != ESP_OK ||
+        key_len != sizeof(settings->link_key)) {
+        memset(settings->link_key, 0, sizeof(settings->link_key));
+    }
+    size_t pass_len = sizeof(settings->ap_password);
+    if (nvs_get_str(handle, "ap_pass", settings->ap_password, &pass_len) != ESP_OK ||
+        strlen(settings->ap_password) < AP_PASSWORD_MIN) {
+        strcpy(settings->ap_password, AP_PASSWORD_DEFAULT);
+    }
+
+    mixer_blob_t mix;
+    size_t mix_len = sizeof(mix);
+    if (nvs_get_blob(handle, "mixer", &mix, &mix_len) == ESP_OK && mix_len == sizeof(mix)) {
+        settings->mix_preset = mix.preset;
+        memcpy(settings->mix_weight, mix.weight, sizeof(mix.weight));
+        memcpy(settings->mix_offset, mix.offset, sizeof(mix.offset));
+    } else {
+        settings->mix_preset = 0;
+        memset(settings->mix_weight, 0, sizeof(settings->mix_weight));
+        memset(settings->mix_offset, 0, sizeof(settings->mix_offset));
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            settings->mix_weight[i][i] = 100;
+        }
+    }
+
     nvs_get_u8(handle, "dev_role", &settings->device_role);
+#ifdef ROLE_FIXED
+    settings->device_role = ROLE_FIXED;         // Single-role image
+#endif
     
     uint8_t configured = 0;
     nvs_get_u8(handle, "configured", &configured);
@@ -113,21 +305,52 @@ void settings_load(device_settings_t *settings) {
     ESP_LOGI(TAG, "Settings loaded from NVS");
 }
 
+void settings_save_calibration(const device_settings_t *settings) {
+    nvs_handle_t handle;
+    ESP_ERROR_CHECK(nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle));
+
+    calib_blob_t blob;
+    calib_to_blob(settings, &blob);
+    ESP_ERROR_CHECK(nvs_set_blob(handle, "calib", &blob, sizeof(blob)));
+    ESP_ERROR_CHECK(nvs_set_u8(handle, "configured", 1));
+
+    ESP_ERROR_CHECK(nvs_commit(handle));
+    nvs_close(handle);
+    ESP_LOGI(TAG, "Calibration saved to NVS");
+}
+
 void settings_save(const device_settings_t *settings) {
     nvs_handle_t handle;
     ESP_ERROR_CHECK(nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle));
 
     ESP_ERROR_CHECK(nvs_set_blob(handle, "peer_mac", settings->peer_mac, PEER_MAC_LEN));
+    ESP_ERROR_CHECK(nvs_set_u8(handle, "peer_bound", settings->peer_bound ? 1 : 0));
+    ESP_ERROR_CHECK(nvs_set_u8(handle, "peer_nch", settings->peer_num_channels));
+    ESP_ERROR_CHECK(nvs_set_u16(handle, "peer_caps", settings->peer_caps));
     ESP_ERROR_CHECK(nvs_set_u8(handle, "channel", settings->channel));
     
     // Save calibration for all channels
+    calib_blob_t blob;
+    calib_to_blob(settings, &blob);
+    ESP_ERROR_CHECK(nvs_set_blob(handle, "calib", &blob, sizeof(blob)));
+
+    // Save per-channel input conditioning
     for (int i = 0; i < NUM_CHANNELS; i++) {
-        char key_min[16], key_max[16];
-        snprintf(key_min, sizeof(key_min), "ch%d_min", i + 1);
-        snprintf(key_max, sizeof(key_max), "ch%d_max", i + 1);
-        ESP_ERROR_CHECK(nvs_set_u16(handle, key_min, settings->ch_min[i]));
-        ESP_ERROR_CHECK(nvs_set_u16(handle, key_max, settings->ch_max[i]));
+        char key_dbnd[16], key_trim[16], key_filt[16], key_fstr[16], key_rev[16];
+        snprintf(key_dbnd, sizeof(key_dbnd), "ch%d_dbnd", i + 1);
+        snprintf(key_trim, sizeof(key_trim), "ch%d_trim", i + 1);
+        snprintf(key_filt, sizeof(key_filt), "ch%d_filt", i + 1);
+        snprintf(key_fstr, sizeof(key_fstr), "ch%d_fstr", i + 1);
+        snprintf(key_rev, sizeof(key_rev), "ch%d_rev", i + 1);
+        ESP_ERROR_CHECK(nvs_set_u16(handle, key_dbnd, settings->ch_deadband[i]));
+        ESP_ERROR_CHECK(nvs_set_i16(handle, key_trim, settings->ch_trim[i]));
+        ESP_ERROR_CHECK(nvs_set_u8(handle, key_filt, settings->ch_filter[i]));
+        ESP_ERROR_CHECK(nvs_set_u8(handle, key_fstr, settings->ch_filter_strength[i]));
+        ESP_ERROR_CHECK(nvs_set_u8(handle, key_rev, settings->ch_reverse[i] ? 1 : 0));
     }
+    ESP_ERROR_CHECK(nvs_set_u8(handle, "in_src", settings->input_source));
+    ESP_ERROR_CHECK(nvs_set_u16(handle, "rate_min", settings->rate_min_hz));
+    ESP_ERROR_CHECK(nvs_set_u16(handle, "rate_max", settings->rate_max_hz));
     
     // Save per-channel servo positions and expo
     for (int i = 0; i < NUM_CHANNELS; i++) {
@@ -142,7 +365,38 @@ void settings_save(const device_settings_t *settings) {
         ESP_ERROR_CHECK(nvs_set_u16(handle, key_scenter, settings->servo_center[i]));
         ESP_ERROR_CHECK(nvs_set_u16(handle, key_smax, settings->servo_max[i]));
         ESP_ERROR_CHECK(nvs_set_u32(handle, key_expo, *(uint32_t*)&settings->expo[i]));
+        char key_pwm[16];
+        snprintf(key_pwm, sizeof(key_pwm), "ch%d_pwmhz", i + 1);
+        ESP_ERROR_CHECK(nvs_set_u16(handle, key_pwm, settings->ch_pwm_hz[i]));
+    }
+    
+    // Save output stage configuration
+    ESP_ERROR_CHECK(nvs_set_u16(handle, "out_rate", settings->output_rate_hz));
+    ESP_ERROR_CHECK(nvs_set_u8(handle, "out_extrap", settings->output_extrapolate ? 1 : 0));
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        char key_slew[16];
+        snprintf(key_slew, sizeof(key_slew), "ch%d_slew", i + 1);
+        ESP_ERROR_CHECK(nvs_set_u16(handle, key_slew, settings->ch_slew[i]));
     }
+
+    // Save serial output configuration
+    ESP_ERROR_CHECK(nvs_set_u8(handle, "ser_proto", settings->serial_proto));
+    ESP_ERROR_CHECK(nvs_set_u16(handle, "ser_rate", settings->serial_rate_hz));
+
+    // Save power management configuration
+    ESP_ERROR_CHECK(nvs_set_u8(handle, "pwr_mode", settings->power_mode));
+    ESP_ERROR_CHECK(nvs_set_u16(handle, "pwr_budget", settings->power_budget_us));
+
+    // Save link security configuration
+    ESP_ERROR_CHECK(nvs_set_u8(handle, "link_sec", settings->link_security));
+    ESP_ERROR_CHECK(nvs_set_blob(handle, "link_key", settings->link_key, sizeof(settings->link_key)));
+    ESP_ERROR_CHECK(nvs_set_str(handle, "ap_pass", settings->ap_password));
+
+    mixer_blob_t mix;
+    mix.preset = settings->mix_preset;
+    memcpy(mix.weight, settings->mix_weight, sizeof(mix.weight));
+    memcpy(mix.offset, settings->mix_offset, sizeof(mix.offset));
+    ESP_ERROR_CHECK(nvs_set_blob(handle, "mixer", &mix, sizeof(mix)));
     
     ESP_ERROR_CHECK(nvs_set_u8(handle, "dev_role", settings->device_role));
     ESP_ERROR_CHECK(nvs_set_u8(handle, "configured", settings->is_configured ? 1 : 0));
@@ -151,3 +405,64 @@ void settings_save(const device_settings_t *settings) {
     nvs_close(handle);
     ESP_LOGI(TAG, "Settings saved to NVS");
 }
+
+uint32_t settings_load_counter(const char *key) {
+    nvs_handle_t handle;
+    uint32_t value = 0;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        nvs_get_u32(handle, key, &value);
+        nvs_close(handle);
+    }
+    return value;
+}
+
+void settings_save_counter(const char *key, uint32_t value) {
+    nvs_handle_t handle;
+    ESP_ERROR_CHECK(nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle));
+    ESP_ERROR_CHECK(nvs_set_u32(handle, key, value));
+    ESP_ERROR_CHECK(nvs_commit(handle));
+    nvs_close(handle);
+}
+
+esp_err_t settings_load_blob(const char *key, void *buf, size_t len) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    size_t stored = len;
+    err = nvs_get_blob(handle, key, buf, &stored);
+    nvs_close(handle);
+    if (err == ESP_OK && stored != len) {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    return err;
+}
+
+esp_err_t settings_save_blob(const char *key, const void *buf, size_t len) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_set_blob(handle, key, buf, len);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t settings_erase_key(const char *key) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_erase_key(handle, key);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err;
+}
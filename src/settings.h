@@ -4,29 +4,10 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
 
-// Forward declarations (defined in common.h)
-#ifndef NUM_CHANNELS
-#define NUM_CHANNELS 6
-#endif
-#ifndef PEER_MAC_LEN
-#define PEER_MAC_LEN 6
-#endif
-
-typedef struct {
-    uint8_t peer_mac[PEER_MAC_LEN];          // Target peer MAC address
-    uint8_t channel;              // ESP-NOW channel (1-13)
-    uint16_t ch_min[NUM_CHANNELS];           // Min ADC value for each proportional channel
-    uint16_t ch_max[NUM_CHANNELS];           // Max ADC value for each proportional channel
-    // Per-channel servo configuration
-    uint16_t servo_min[NUM_CHANNELS];        // Minimum servo position (µs) for each channel
-    uint16_t servo_center[NUM_CHANNELS];     // Center servo position (µs) for each channel
-    uint16_t servo_max[NUM_CHANNELS];        // Maximum servo position (µs) for each channel
-    // Per-channel expo (input-side S-curve, like Betaflight)
-    float expo[NUM_CHANNELS];                // Expo value (0.0-1.0) for each channel, 0=linear, 1=strong S-curve
-    uint8_t device_role;          // 0=receiver, 1=sender
-    bool is_configured;           // Has been configured at least once
-} device_settings_t;
+#include "device_settings.h"
 
 // Initialize NVS and load settings
 void settings_init(void);
@@ -37,10 +18,24 @@ void settings_load(device_settings_t *settings);
 // Save settings to NVS
 void settings_save(const device_settings_t *settings);
 
+// Save only the stick calibration (min/center/max) as one atomic NVS write
+void settings_save_calibration(const device_settings_t *settings);
+
 // Reset settings to defaults
 void settings_reset_defaults(device_settings_t *settings);
 
 // Get default settings
 void settings_get_defaults(device_settings_t *settings);
 
+// Small persistent counters kept apart from device_settings_t (link security
+// session epochs, see link_auth.h). A missing key reads as 0.
+uint32_t settings_load_counter(const char *key);
+void settings_save_counter(const char *key, uint32_t value);
+
+// Fixed-size blobs kept apart from device_settings_t (model profiles, see profiles.h).
+// Load fails unless the stored size equals len.
+esp_err_t settings_load_blob(const char *key, void *buf, size_t len);
+esp_err_t settings_save_blob(const char *key, const void *buf, size_t len);
+esp_err_t settings_erase_key(const char *key);
+
 #endif // SETTINGS_H
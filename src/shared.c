@@ -64,12 +64,13 @@ static float apply_expo(float normalized, float expo) {
     return normalized + (cubic - normalized) * expo;
 }
 
-uint32_t servo_us_to_duty(uint32_t us) {
-    // 16-bit duty over 20ms period; duty = (us / period_us) * 2^16
-    const uint32_t period_us = 1000000UL / SERVO_FREQ_HZ; // 20000 us
-    uint32_t duty = (us * (1UL << 16)) / period_us;
-    if (duty > ((1UL << 16) - 1)) duty = (1UL << 16) - 1;
-    return duty;
+// Pulse width to LEDC duty for a timer running at freq_hz with resolution_bits
+// duty = us * freq_hz * 2^bits / 1e6, rounded, capped at full scale
+uint32_t servo_us_to_duty(uint32_t us, uint32_t freq_hz, uint8_t resolution_bits) {
+    uint64_t full = 1ULL << resolution_bits;
+    uint64_t duty = ((uint64_t)us * freq_hz * full + 500000ULL) / 1000000ULL;
+    if (duty > full - 1) duty = full - 1;
+    return (uint32_t)duty;
 }
 
 uint32_t map_adc_to_us(uint16_t adc_raw, float scale) {
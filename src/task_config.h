@@ -0,0 +1,58 @@
+// Task layout
+// Priority, stack size and core of every task the firmware creates. System
+// tasks for reference: Wi-Fi 23, esp_timer 22 (the receiver output stage and
+// serial frame timers run there), lwIP 18, idle 0.
+//
+// Tiers, highest first: radio/output path, control (LED, button events, role
+// changes), UI (httpd, console), housekeeping. On dual-core chips (ESP32,
+// ESP32-S3) the radio path is pinned to the APP core and the UI to the PRO
+// core, which also runs Wi-Fi and lwIP. Single-core chips (S2, C3) rely on the
+// priorities alone.
+#ifndef TASK_CONFIG_H
+#define TASK_CONFIG_H
+
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+#if CONFIG_FREERTOS_UNICORE
+#define TASK_CORE_RADIO tskNO_AFFINITY
+#define TASK_CORE_UI tskNO_AFFINITY
+#else
+#define TASK_CORE_RADIO 1
+#define TASK_CORE_UI 0
+#endif
+#define TASK_CORE_CONTROL tskNO_AFFINITY
+
+// Radio/output path
+#define TASK_PRIO_BUTTONS 14        // Above the role tasks: a press is classified before the next frame
+#define TASK_PRIO_TRAINER_IN 14     // SBUS trainer decode, ahead of the sender frame that uses it
+#define TASK_PRIO_RADIO 13          // sender, receiver
+
+// Control
+#define TASK_PRIO_CONTROL 8         // Forwards light button presses to the sender
+#define TASK_PRIO_BIND 8            // Only runs while the role is stopped
+
+// UI
+#define TASK_PRIO_SCOPE 6           // Scope sampler, ahead of httpd sending its batches
+#define TASK_PRIO_HTTPD 5
+#define TASK_PRIO_CONSOLE 3
+
+// Housekeeping
+#define TASK_PRIO_CALIB 4           // Stick sampling during calibration (webserver running)
+#define TASK_PRIO_LOAD TASK_PRIO_HTTPD  // perf load generator, stands in for request handling
+#define TASK_PRIO_BLACKBOX 2        // Flash log writer; the receiver only queues samples for it
+
+#define TASK_STACK_SENDER 4096
+#define TASK_STACK_RECEIVER 4096
+#define TASK_STACK_BUTTONS 2560
+#define TASK_STACK_TRAINER_IN 2560
+#define TASK_STACK_CONTROL 4096
+#define TASK_STACK_BIND 3072
+#define TASK_STACK_HTTPD 4096
+#define TASK_STACK_CONSOLE 4096
+#define TASK_STACK_CALIB 3072
+#define TASK_STACK_SCOPE 3072
+#define TASK_STACK_LOAD 2048
+#define TASK_STACK_BLACKBOX 3072
+
+#endif // TASK_CONFIG_H
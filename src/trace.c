@@ -0,0 +1,95 @@
+// Binary event trace ring implementation
+#include "trace.h"
+#include "console.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_MASK (TRACE_RING_LEN - 1)
+
+// The dump format is the in-memory layout: no padding allowed
+_Static_assert(sizeof(trace_record_t) == 8, "trace record layout");
+_Static_assert(sizeof(trace_header_t) == 16, "trace header layout");
+
+static trace_record_t ring[TRACE_RING_LEN];
+static uint32_t head = 0;           // Records ever claimed; slot = index & TRACE_MASK
+static uint32_t base = 0;           // head at the last trace_clear()
+
+#if TRACE_ENABLE
+void trace_record(trace_event_t type, uint8_t arg8, uint16_t arg16) {
+    uint32_t idx = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED);
+    trace_record_t *r = &ring[idx & TRACE_MASK];
+    // Type 0 marks the slot as being written; the real type is stored last
+    __atomic_store_n(&r->type, 0, __ATOMIC_RELAXED);
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    r->ts_us = (uint32_t)esp_timer_get_time();
+    r->arg8 = arg8;
+    r->arg16 = arg16;
+    __atomic_store_n(&r->type, (uint8_t)type, __ATOMIC_RELEASE);
+}
+#endif
+
+size_t trace_snapshot(trace_header_t *header, trace_record_t *out) {
+    uint32_t end = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    uint32_t first = __atomic_load_n(&base, __ATOMIC_RELAXED);
+    uint32_t dropped = 0;
+    if (end - first > TRACE_RING_LEN) {
+        dropped = end - first - TRACE_RING_LEN;
+        first = end - TRACE_RING_LEN;
+    }
+
+    size_t count = 0;
+    for (uint32_t i = first; i != end; i++) {
+        trace_record_t r = ring[i & TRACE_MASK];
+        if (r.type != 0) {          // Skip a record still being written
+            out[count++] = r;
+        }
+    }
+
+    // Records claimed while copying reused the oldest slots: drop that many from the front
+    uint32_t after = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    if (after - first > TRACE_RING_LEN) {
+        size_t lost = after - first - TRACE_RING_LEN;
+        if (lost > count) {
+            lost = count;
+        }
+        memmove(out, out + lost, (count - lost) * sizeof(*out));
+        count -= lost;
+        dropped += lost;
+    }
+
+    memcpy(header->magic, TRACE_MAGIC, sizeof(header->magic));
+    header->version = TRACE_VERSION;
+    header->record_size = sizeof(trace_record_t);
+    header->count = (uint16_t)count;
+    header->dropped = dropped;
+    header->now_us = (uint32_t)esp_timer_get_time();
+    return count;
+}
+
+void trace_clear(void) {
+    __atomic_store_n(&base, __atomic_load_n(&head, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+}
+
+int trace_console_cmd(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+        trace_clear();
+        printf("Trace cleared\n");
+        return 0;
+    }
+    trace_record_t *records = malloc(TRACE_RING_LEN * sizeof(trace_record_t));
+    if (records == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    trace_header_t header;
+    size_t count = trace_snapshot(&header, records);
+    // Same bytes as GET /api/trace, hex encoded between markers for tools/trace2perfetto.py
+    printf("TRACE BEGIN\n");
+    console_print_hex(NULL, &header, sizeof(header));
+    console_print_hex(NULL, records, count * sizeof(trace_record_t));
+    printf("TRACE END\n");
+    free(records);
+    return 0;
+}
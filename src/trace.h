@@ -0,0 +1,76 @@
+// Binary event trace ring
+// Fixed-size ring of 8-byte records timestamped in µs. Recording claims a slot
+// with one atomic increment and fills it in place: no lock, no formatting, safe
+// from tasks, callbacks and ISRs. The newest TRACE_RING_LEN records can be dumped
+// over HTTP (GET /api/trace, binary) or the serial console ("trace", hex lines)
+// and converted to Chrome/Perfetto JSON with tools/trace2perfetto.py.
+// Build with -D TRACE_ENABLE=0 to compile the hooks out.
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 1
+#endif
+
+#define TRACE_RING_LEN 1024         // Power of two
+#define TRACE_MAGIC "RCTR"
+#define TRACE_VERSION 1
+
+typedef enum {
+    TRACE_EV_TX = 1,                // Sender: esp_now_send() called. arg8: 0 = queued, 1 = failed; arg16: lights
+    TRACE_EV_TX_DONE,               // Sender: send callback. arg8: esp_now_send_status_t
+    TRACE_EV_RX,                    // Receiver: frame received. arg8: RSSI (int8); arg16: frame sequence
+    TRACE_EV_DECODE,                // Receiver: task picked up the frame. arg16: frame sequence
+    TRACE_EV_OUTPUT_APPLIED,        // Receiver: outputs written. arg8: trace_output_t; arg16: frame sequence
+    TRACE_EV_FAILSAFE,              // Receiver: arg8: 1 = link lost, 0 = link restored
+    TRACE_EV_BUTTON,                // arg8: button_id_t; arg16: button_event_type_t
+    TRACE_EV_EVENT_TX,              // Sender: event frame sent. arg8: send number (1 = first); arg16: event seq
+    TRACE_EV_EVENT_ACK,             // Sender: ack matched. arg16: event seq
+    TRACE_EV_EVENT_RX,              // Receiver: event frame accepted. arg16: event seq
+    TRACE_EV_RATE,                  // Sender: frame rate changed. arg8: rate code; arg16: Hz
+} trace_event_t;
+
+typedef enum {
+    TRACE_OUTPUT_DIRECT = 0,        // Servos written on frame arrival
+    TRACE_OUTPUT_TIMER,             // Output stage timer tick
+} trace_output_t;
+
+typedef struct {
+    uint32_t ts_us;                 // esp_timer time (wraps after ~71 minutes)
+    uint8_t type;                   // trace_event_t
+    uint8_t arg8;
+    uint16_t arg16;
+} trace_record_t;
+
+// Dump header, followed by count records (little-endian, as in memory)
+typedef struct {
+    char magic[4];                  // TRACE_MAGIC
+    uint8_t version;                // TRACE_VERSION
+    uint8_t record_size;            // sizeof(trace_record_t)
+    uint16_t count;                 // Records that follow, oldest first
+    uint32_t dropped;               // Records overwritten before this dump since the last clear
+    uint32_t now_us;                // esp_timer time of the dump
+} trace_header_t;
+
+#if TRACE_ENABLE
+void trace_record(trace_event_t type, uint8_t arg8, uint16_t arg16);
+#define TRACE(type, arg8, arg16) trace_record((type), (uint8_t)(arg8), (uint16_t)(arg16))
+#else
+#define TRACE(type, arg8, arg16) do { } while (0)
+#endif
+
+// Copy the newest records (oldest first) into out, which holds TRACE_RING_LEN
+// records, and fill in the header. Writers keep running; records overwritten
+// during the copy are left out. Returns the record count.
+size_t trace_snapshot(trace_header_t *header, trace_record_t *out);
+
+// Forget everything recorded so far
+void trace_clear(void);
+
+// Serial console command: "trace" dumps hex lines, "trace clear" empties the ring
+int trace_console_cmd(int argc, char **argv);
+
+#endif // TRACE_H
@@ -0,0 +1,113 @@
+// Sender transmit pipeline implementation
+#include "tx_pipeline.h"
+#include <string.h>
+
+void tx_pipeline_init(tx_pipeline_t *tx) {
+    memset(tx, 0, sizeof(*tx));
+}
+
+static void pop(tx_pipeline_t *tx) {
+    if (tx->kind[tx->head] == TX_FRAME_CONTROL) {
+        tx->control--;
+    }
+    tx->head = (uint8_t)((tx->head + 1) % TX_PIPELINE_SLOTS);
+    tx->count--;
+}
+
+// Write off frames whose callback never came (send callback unregistered or
+// lost), so a missing completion cannot stall the control frames for good
+static void expire(tx_pipeline_t *tx, uint32_t now_us) {
+    while (tx->count > 0 && now_us - tx->send_us[tx->head] > TX_PIPELINE_STALE_US) {
+        pop(tx);
+        tx->stats.lost++;
+        tx->dropped++;
+    }
+}
+
+bool tx_pipeline_offer(tx_pipeline_t *tx, uint32_t now_us) {
+    tx->stats.offered++;
+    if (tx->pending) {
+        tx->stats.superseded++;
+    }
+    tx->pending = true;
+    if (tx_pipeline_ready(tx, now_us)) {
+        return true;
+    }
+    tx->stats.deferred++;
+    return false;
+}
+
+bool tx_pipeline_ready(tx_pipeline_t *tx, uint32_t now_us) {
+    expire(tx, now_us);
+    return tx->pending && tx->control < TX_PIPELINE_MAX_CONTROL && tx->count < TX_PIPELINE_SLOTS;
+}
+
+void tx_pipeline_send(tx_pipeline_t *tx, tx_frame_kind_t kind, uint32_t now_us) {
+    expire(tx, now_us);
+    uint8_t depth = tx->count;
+    tx->stats.depth[depth < TX_PIPELINE_DEPTH_BUCKETS ? depth : TX_PIPELINE_DEPTH_BUCKETS - 1]++;
+    if (depth > tx->stats.depth_max) {
+        tx->stats.depth_max = depth;
+    }
+    if (tx->count == TX_PIPELINE_SLOTS) {
+        pop(tx);                            // Event frames past the slots: forget the oldest
+        tx->stats.lost++;
+        tx->dropped++;
+    }
+    uint8_t slot = (uint8_t)((tx->head + tx->count) % TX_PIPELINE_SLOTS);
+    tx->send_us[slot] = now_us;
+    tx->kind[slot] = (uint8_t)kind;
+    tx->count++;
+    if (kind == TX_FRAME_CONTROL) {
+        tx->control++;
+        tx->pending = false;
+    }
+    tx->stats.sent++;
+}
+
+bool tx_pipeline_failed(tx_pipeline_t *tx, tx_frame_kind_t kind, bool no_mem) {
+    // Callbacks only take frames off the head, so the newest record is still this frame
+    bool removed = tx->count > 0;
+    if (removed) {
+        tx->count--;
+        if (kind == TX_FRAME_CONTROL) {
+            tx->control--;
+        }
+    }
+    if (no_mem) {
+        tx->stats.no_mem++;
+        if (kind == TX_FRAME_CONTROL) {
+            tx->pending = true;             // Retried on the next completion or sample
+        }
+    } else {
+        tx->stats.errors++;
+    }
+    return removed;
+}
+
+void tx_pipeline_drop(tx_pipeline_t *tx) {
+    tx->pending = false;
+    tx->stats.errors++;
+}
+
+bool tx_pipeline_done(tx_pipeline_t *tx, uint32_t now_us, uint32_t *latency_us) {
+    if (tx->count == 0) {
+        return false;
+    }
+    uint32_t lat = now_us - tx->send_us[tx->head];
+    *latency_us = lat;
+    pop(tx);
+    tx->stats.completed++;
+    tx->stats.lat_last_us = lat;
+    tx->stats.lat_avg_us = tx->stats.completed == 1 ? lat : (tx->stats.lat_avg_us * 7 + lat) / 8;
+    if (lat > tx->stats.lat_max_us) {
+        tx->stats.lat_max_us = lat;
+    }
+    return true;
+}
+
+uint8_t tx_pipeline_take_dropped(tx_pipeline_t *tx) {
+    uint8_t n = tx->dropped;
+    tx->dropped = 0;
+    return n;
+}
@@ -0,0 +1,89 @@
+// Sender transmit pipeline: completion-paced control frames
+// esp_now_send() only queues a frame for the Wi-Fi task; the send callback
+// reports when it has left (acked or out of retries). The pipeline keeps a
+// FIFO of the frames handed over and lets at most TX_PIPELINE_MAX_CONTROL
+// control frames be in flight. A control frame built while that many are
+// still queued waits as the pending frame, and a newer one replaces it, so
+// stick data never queues up behind older stick data in the Wi-Fi TX queue.
+// Event frames (event_frame.h) are never held back, only counted.
+// A frame refused with ESP_ERR_ESPNOW_NO_MEM stays pending for the next try.
+// Whatever the caller holds per frame in flight (a power lock) is released
+// once per record: on its callback, on a refusal, or when the record is
+// written off (tx_pipeline_take_dropped()). A callback arriving after its
+// record was written off matches no record, or a newer one in its place, so
+// nothing is released twice.
+// Records send-to-callback latency and the queue depth seen by every send.
+// Time is passed in by the caller; has no ESP-IDF dependencies (test/test_tx_pipeline).
+#ifndef TX_PIPELINE_H
+#define TX_PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TX_PIPELINE_SLOTS 8             // In-flight records (control and event frames)
+#define TX_PIPELINE_MAX_CONTROL 1       // Control frames in flight before the next one waits
+#define TX_PIPELINE_STALE_US 100000     // A frame without a callback after this long is written off
+#define TX_PIPELINE_DEPTH_BUCKETS 8     // Depth histogram: 0..6 frames ahead, last bucket 7 or more
+
+typedef enum {
+    TX_FRAME_CONTROL = 0,
+    TX_FRAME_EVENT,
+} tx_frame_kind_t;
+
+typedef struct {
+    uint32_t offered;                   // Control frames built
+    uint32_t sent;                      // Frames handed to esp_now_send(), both kinds
+    uint32_t completed;                 // Send callbacks matched to a frame
+    uint32_t superseded;                // Pending control frames replaced by a newer one
+    uint32_t deferred;                  // Control frames that had to wait for a completion
+    uint32_t no_mem;                    // ESP_ERR_ESPNOW_NO_MEM refusals
+    uint32_t errors;                    // Other send errors
+    uint32_t lost;                      // Frames written off without a callback
+    uint32_t lat_last_us;               // esp_now_send() to send callback
+    uint32_t lat_avg_us;                // Moving average over about 8 frames
+    uint32_t lat_max_us;
+    uint8_t depth_max;                  // Most frames seen in flight by a send
+    uint32_t depth[TX_PIPELINE_DEPTH_BUCKETS]; // Frames already in flight at each send attempt
+} tx_pipeline_stats_t;
+
+typedef struct {
+    uint8_t head;                       // Oldest in-flight record
+    uint8_t count;                      // Frames in flight
+    uint8_t control;                    // Control frames in flight
+    bool pending;                       // A control frame waits to be sent
+    uint8_t dropped;                    // Records written off since tx_pipeline_take_dropped()
+    uint32_t send_us[TX_PIPELINE_SLOTS];
+    uint8_t kind[TX_PIPELINE_SLOTS];    // tx_frame_kind_t
+    tx_pipeline_stats_t stats;
+} tx_pipeline_t;
+
+void tx_pipeline_init(tx_pipeline_t *tx);
+
+// A new control frame was built at now_us. Returns true if it can be sent
+// now; otherwise it is the pending frame (replacing an older pending one).
+bool tx_pipeline_offer(tx_pipeline_t *tx, uint32_t now_us);
+
+// True if the pending control frame can be sent now
+bool tx_pipeline_ready(tx_pipeline_t *tx, uint32_t now_us);
+
+// A frame is about to be handed to esp_now_send() at now_us. Recorded before
+// the call, since the send callback can run before esp_now_send() returns.
+void tx_pipeline_send(tx_pipeline_t *tx, tx_frame_kind_t kind, uint32_t now_us);
+
+// esp_now_send() refused the frame just recorded. A control frame refused for
+// lack of memory (ESP_ERR_ESPNOW_NO_MEM) stays pending; other errors drop it.
+// Returns false if its record was already gone.
+bool tx_pipeline_failed(tx_pipeline_t *tx, tx_frame_kind_t kind, bool no_mem);
+
+// The pending control frame cannot be sent at all (never handed over): drop it
+void tx_pipeline_drop(tx_pipeline_t *tx);
+
+// Send callback at now_us: completes the oldest frame in flight. Returns false
+// if none was recorded, otherwise true with its send-to-callback latency.
+bool tx_pipeline_done(tx_pipeline_t *tx, uint32_t now_us, uint32_t *latency_us);
+
+// Records written off without a callback (stale, or pushed out by a send)
+// since the last call
+uint8_t tx_pipeline_take_dropped(tx_pipeline_t *tx);
+
+#endif // TX_PIPELINE_H
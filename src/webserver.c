@@ -1,6 +1,18 @@
 // Webserver implementation for ESP-NOW radio control configuration
 #include "webserver.h"
 #include "webserver_page.h"
+#include "calibration.h"
+#include "mixer.h"
+#include "input_source.h"
+#include "power.h"
+#include "perf.h"
+#include "trace.h"
+#include "link_auth.h"
+#include "profiles.h"
+#include "scope.h"
+#include "ota.h"
+#include "blackbox.h"
+#include "task_config.h"
 #include "esp_log.h"
 #include "esp_http_server.h"
 #include "esp_wifi.h"
@@ -8,6 +20,7 @@
 #include "esp_system.h"
 #include "esp_mac.h"
 #include "esp_chip_info.h"
+#include "esp_timer.h"
 #include "lwip/inet.h"
 #include <stdio.h>
 #include <string.h>
@@ -51,8 +64,10 @@ static esp_err_t handler_index(httpd_req_t *req) {
     return httpd_resp_send(req, html_page, strlen(html_page));
 }
 
+#define SETTINGS_JSON_SIZE (1024 + NUM_CHANNELS * 256)
+
 static esp_err_t handler_get_settings(httpd_req_t *req) {
-    char *response = malloc(2048);
+    char *response = malloc(SETTINGS_JSON_SIZE);
     if (!response) {
         return httpd_resp_send_500(req);
     }
@@ -62,43 +77,51 @@ static esp_err_t handler_get_settings(httpd_req_t *req) {
              g_settings->peer_mac[0], g_settings->peer_mac[1], g_settings->peer_mac[2],
              g_settings->peer_mac[3], g_settings->peer_mac[4], g_settings->peer_mac[5]);
 
-    snprintf(response, 2048,
-             "{"
-             "\"device_role\":%d,"
-             "\"peer_mac\":\"%s\","
-             "\"channel\":%d,"
-             "\"ch1_min\":%d,\"ch1_max\":%d,"
-             "\"ch2_min\":%d,\"ch2_max\":%d,"
-             "\"ch3_min\":%d,\"ch3_max\":%d,"
-             "\"ch4_min\":%d,\"ch4_max\":%d,"
-             "\"ch5_min\":%d,\"ch5_max\":%d,"
-             "\"ch6_min\":%d,\"ch6_max\":%d,"
-             "\"ch1_smin\":%u,\"ch1_sctr\":%u,\"ch1_smax\":%u,\"ch1_expo\":%.1f,"
-             "\"ch2_smin\":%u,\"ch2_sctr\":%u,\"ch2_smax\":%u,\"ch2_expo\":%.1f,"
-             "\"ch3_smin\":%u,\"ch3_sctr\":%u,\"ch3_smax\":%u,\"ch3_expo\":%.1f,"
-             "\"ch4_smin\":%u,\"ch4_sctr\":%u,\"ch4_smax\":%u,\"ch4_expo\":%.1f,"
-             "\"ch5_smin\":%u,\"ch5_sctr\":%u,\"ch5_smax\":%u,\"ch5_expo\":%.1f,"
-             "\"ch6_smin\":%u,\"ch6_sctr\":%u,\"ch6_smax\":%u,\"ch6_expo\":%.1f"
-             "}",
-             g_settings->device_role, mac_str, g_settings->channel,
-             g_settings->ch_min[0], g_settings->ch_max[0],
-             g_settings->ch_min[1], g_settings->ch_max[1],
-             g_settings->ch_min[2], g_settings->ch_max[2],
-             g_settings->ch_min[3], g_settings->ch_max[3],
-             g_settings->ch_min[4], g_settings->ch_max[4],
-             g_settings->ch_min[5], g_settings->ch_max[5],
-             g_settings->servo_min[0], g_settings->servo_center[0], g_settings->servo_max[0], 
-             g_settings->expo[0],
-             g_settings->servo_min[1], g_settings->servo_center[1], g_settings->servo_max[1], 
-             g_settings->expo[1],
-             g_settings->servo_min[2], g_settings->servo_center[2], g_settings->servo_max[2], 
-             g_settings->expo[2],
-             g_settings->servo_min[3], g_settings->servo_center[3], g_settings->servo_max[3], 
-             g_settings->expo[3],
-             g_settings->servo_min[4], g_settings->servo_center[4], g_settings->servo_max[4], 
-             g_settings->expo[4],
-             g_settings->servo_min[5], g_settings->servo_center[5], g_settings->servo_max[5], 
-             g_settings->expo[5]);
+    int len = snprintf(response, SETTINGS_JSON_SIZE,
+             "{\"device_role\":%d,\"peer_mac\":\"%s\",\"peer_bound\":%d,\"channel\":%d,"
+             "\"num_channels\":%d,\"adc_inputs\":%d,\"servo_outputs\":%d",
+             g_settings->device_role, mac_str, g_settings->peer_bound ? 1 : 0, g_settings->channel,
+             NUM_CHANNELS, NUM_ADC_INPUTS, NUM_SERVO_OUTPUTS);
+
+    // Per-channel calibration, servo endpoints and expo
+    for (int i = 0; i < NUM_CHANNELS && len < SETTINGS_JSON_SIZE; i++) {
+        len += snprintf(response + len, SETTINGS_JSON_SIZE - len,
+                        ",\"ch%d_min\":%u,\"ch%d_max\":%u,"
+                        "\"ch%d_smin\":%u,\"ch%d_sctr\":%u,\"ch%d_smax\":%u,\"ch%d_expo\":%.1f",
+                        i + 1, g_settings->ch_min[i], i + 1, g_settings->ch_max[i],
+                        i + 1, g_settings->servo_min[i], i + 1, g_settings->servo_center[i],
+                        i + 1, g_settings->servo_max[i], i + 1, g_settings->expo[i]);
+    }
+
+    // Per-channel sender input conditioning
+    for (int i = 0; i < NUM_CHANNELS && len < SETTINGS_JSON_SIZE; i++) {
+        len += snprintf(response + len, SETTINGS_JSON_SIZE - len,
+                        ",\"ch%d_ctr\":%u,\"ch%d_dbnd\":%u,\"ch%d_trim\":%d,"
+                        "\"ch%d_filt\":%u,\"ch%d_fstr\":%u,\"ch%d_rev\":%d",
+                        i + 1, g_settings->ch_center[i], i + 1, g_settings->ch_deadband[i],
+                        i + 1, g_settings->ch_trim[i], i + 1, g_settings->ch_filter[i],
+                        i + 1, g_settings->ch_filter_strength[i], i + 1, g_settings->ch_reverse[i] ? 1 : 0);
+    }
+    // Receiver output stage
+    if (len < SETTINGS_JSON_SIZE) {
+        len += snprintf(response + len, SETTINGS_JSON_SIZE - len,
+                        ",\"in_src\":%u,\"rate_min\":%u,\"rate_max\":%u,\"out_rate\":%u,\"out_extrap\":%d,\"ser_proto\":%u,\"ser_rate\":%u"
+                        ",\"pwr_mode\":%u,\"pwr_budget\":%u,\"link_sec\":%u,\"link_key_id\":\"%08lx\"",
+                        g_settings->input_source, g_settings->rate_min_hz, g_settings->rate_max_hz,
+                        g_settings->output_rate_hz, g_settings->output_extrapolate ? 1 : 0,
+                        g_settings->serial_proto, g_settings->serial_rate_hz,
+                        g_settings->power_mode, g_settings->power_budget_us,
+                        g_settings->link_security, link_auth_key_id(g_settings->link_key));
+    }
+    for (int i = 0; i < NUM_CHANNELS && len < SETTINGS_JSON_SIZE; i++) {
+        len += snprintf(response + len, SETTINGS_JSON_SIZE - len,
+                        ",\"ch%d_slew\":%u,\"ch%d_pwmhz\":%u", i + 1, g_settings->ch_slew[i],
+                        i + 1, g_settings->ch_pwm_hz[i]);
+    }
+    if (len < SETTINGS_JSON_SIZE - 1) {
+        response[len++] = '}';
+        response[len] = '\0';
+    }
 
     httpd_resp_set_type(req, "application/json");
     esp_err_t ret = httpd_resp_send(req, response, strlen(response));
@@ -106,35 +129,102 @@ static esp_err_t handler_get_settings(httpd_req_t *req) {
     return ret;
 }
 
+// Fixed fields, then two values of up to 5 characters per channel
+#define STATUS_JSON_SIZE (2176 + NUM_CHANNELS * 12)
+
 static esp_err_t handler_get_status(httpd_req_t *req) {
-    char *response = malloc(512);
+    char *response = malloc(STATUS_JSON_SIZE);
     if (!response) {
         return httpd_resp_send_500(req);
     }
     
-    control_packet_t pkt = get_last_control_packet();
-    uint16_t servo_us[6];
+    control_packet_t pkt = {0};
+    uint16_t servo_us[NUM_CHANNELS] = {0};
+    input_source_stats_t input = {0};
+    uint32_t tx_lat = 0, tx_lat_max = 0, rx_lat = 0, rx_lat_max = 0;
+    event_stats_t events = {0};
+    frame_rate_stats_t rate = {0};
+    tx_pipeline_stats_t tx = {0};
+    blackbox_stats_t bb = {0};
+#if RC_ROLE_SENDER
+    input_source_get_stats(&input);
+    sender_get_light_latency(&tx_lat, &tx_lat_max);
+    sender_get_event_stats(&events);
+    sender_get_rate_stats(&rate);
+    sender_get_tx_stats(&tx);
+#endif
+#if RC_ROLE_RECEIVER
+    pkt = get_last_control_packet();
     get_servo_positions(servo_us);
+    receiver_get_light_latency(&rx_lat, &rx_lat_max);
+    blackbox_get_stats(&bb);
+#endif
+    char ch_list[NUM_CHANNELS * 6 + 1];
+    char us_list[NUM_CHANNELS * 6 + 1];
+    int ch_len = 0, us_len = 0;
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        ch_len += snprintf(ch_list + ch_len, sizeof(ch_list) - ch_len, "%s%u", i ? "," : "", pkt.ch[i]);
+        us_len += snprintf(us_list + us_len, sizeof(us_list) - us_len, "%s%u", i ? "," : "", servo_us[i]);
+    }
+    char depth_list[TX_PIPELINE_DEPTH_BUCKETS * 11 + 1];
+    int depth_len = 0;
+    for (int i = 0; i < TX_PIPELINE_DEPTH_BUCKETS; i++) {
+        depth_len += snprintf(depth_list + depth_len, sizeof(depth_list) - depth_len, "%s%lu",
+                              i ? "," : "", tx.depth[i]);
+    }
+    power_stats_t power;
+    power_get_stats(&power);
+    ota_info_t fw;
+    ota_get_info(&fw);
     
-    snprintf(response, 512,
+    snprintf(response, STATUS_JSON_SIZE,
              "{"
              "\"device_mac\":\"%s\","
              "\"chip_model\":\"%s\","
              "\"cores\":%lu,"
              "\"idf_version\":\"%s\","
              "\"free_heap\":%lu,"
-             "\"ch\":[%u,%u,%u,%u,%u,%u],"
-             "\"servo_us\":[%u,%u,%u,%u,%u,%u],"
-             "\"lights\":%u"
+             "\"ch\":[%s],"
+             "\"servo_us\":[%s],"
+             "\"lights\":%u,"
+             "\"input\":{\"src\":%u,\"frames\":%lu,\"errors\":%lu,\"lat_avg_us\":%lu,\"lat_max_us\":%lu},"
+             "\"light_lat\":{\"tx_us\":%lu,\"tx_max_us\":%lu,\"rx_us\":%lu,\"rx_max_us\":%lu},"
+             "\"events\":{\"events\":%lu,\"frames\":%lu,\"retries\":%lu,\"acked\":%lu,\"expired\":%lu,"
+             "\"superseded\":%lu,\"ack_us\":%lu,\"ack_max_us\":%lu,\"rx_apply_us\":%lu},"
+             "\"rate\":{\"hz\":%u,\"min_hz\":%u,\"max_hz\":%u,\"ceiling_hz\":%u,\"velocity\":%lu,\"samples\":%lu,"
+             "\"frames\":%lu,\"changes\":%lu,\"sent\":%lu,\"failed\":%lu,\"backoffs\":%lu,\"rx_hz\":%u},"
+             "\"tx\":{\"sent\":%lu,\"completed\":%lu,\"lost\":%lu,\"offered\":%lu,\"deferred\":%lu,"
+             "\"superseded\":%lu,\"no_mem\":%lu,\"errors\":%lu,\"lat_us\":%lu,\"lat_avg_us\":%lu,"
+             "\"lat_max_us\":%lu,\"depth_max\":%u,\"depth\":[%s]},"
+             "\"power\":{\"mode\":%u,\"min_mhz\":%u,\"max_mhz\":%u,\"sleep\":%d,\"frames\":%lu,"
+             "\"active_us\":%lu,\"idle_us\":%lu,\"active_permille\":%u},"
+             "\"blackbox\":{\"available\":%d,\"recording\":%d,\"used\":%lu,\"capacity\":%lu,\"rate_bps\":%lu,"
+             "\"minutes\":%lu,\"dropped\":%lu,\"write_max_us\":%lu,\"erase_max_us\":%lu,"
+             "\"ready\":%lu},"
+             "\"firmware\":{\"version\":\"%s\",\"partition\":\"%s\",\"pending_verify\":%d}"
              "}",
              g_device_mac,
              g_chip_model,
              g_cores,
              g_idf_version,
              esp_get_free_heap_size(),
-             pkt.ch[0], pkt.ch[1], pkt.ch[2], pkt.ch[3], pkt.ch[4], pkt.ch[5],
-             servo_us[0], servo_us[1], servo_us[2], servo_us[3], servo_us[4], servo_us[5],
-             pkt.lights);
+             ch_list,
+             us_list,
+             pkt.lights,
+             input.source, input.frames, input.errors, input.lat_avg_us, input.lat_max_us,
+             tx_lat, tx_lat_max, rx_lat, rx_lat_max,
+             events.events, events.frames, events.retries, events.acked, events.expired,
+             events.superseded, events.ack_last_us, events.ack_max_us, events.apply_last_us,
+             rate.hz, rate.min_hz, rate.max_hz, rate.ceiling_hz, rate.velocity, rate.samples,
+             rate.frames, rate.changes, rate.sent, rate.failed, rate.backoffs, frame_rate_hz(pkt.rate),
+             tx.sent, tx.completed, tx.lost, tx.offered, tx.deferred,
+             tx.superseded, tx.no_mem, tx.errors, tx.lat_last_us, tx.lat_avg_us,
+             tx.lat_max_us, tx.depth_max, depth_list,
+             power.mode, power.min_freq_mhz, power.max_freq_mhz, power.light_sleep ? 1 : 0, power.frames,
+             power.active_us, power.idle_us, power.active_permille,
+             bb.available ? 1 : 0, bb.recording ? 1 : 0, bb.used, bb.capacity, bb.rate_bps,
+             bb.minutes, bb.dropped, bb.write_max_us, bb.erase_max_us, bb.ready,
+             fw.version, fw.partition, fw.pending_verify ? 1 : 0);
 
     httpd_resp_set_type(req, "application/json");
     esp_err_t ret = httpd_resp_send(req, response, strlen(response));
@@ -142,72 +232,707 @@ static esp_err_t handler_get_status(httpd_req_t *req) {
     return ret;
 }
 
+#define PERF_JSON_SIZE 4608
+
+static esp_err_t handler_get_perf(httpd_req_t *req) {
+    perf_snapshot_t *snap = malloc(sizeof(perf_snapshot_t));
+    char *response = malloc(PERF_JSON_SIZE);
+    if (!snap || !response || perf_collect(snap) != ESP_OK) {
+        free(snap);
+        free(response);
+        return httpd_resp_send_500(req);
+    }
+    perf_format_json(snap, response, PERF_JSON_SIZE);
+    free(snap);
+
+    httpd_resp_set_type(req, "application/json");
+    esp_err_t ret = httpd_resp_send(req, response, strlen(response));
+    free(response);
+    return ret;
+}
+
+// Binary trace dump (trace_header_t + records), see tools/trace2perfetto.py
+static esp_err_t handler_get_trace(httpd_req_t *req) {
+    trace_record_t *records = malloc(TRACE_RING_LEN * sizeof(trace_record_t));
+    if (!records) {
+        return httpd_resp_send_500(req);
+    }
+    trace_header_t header;
+    size_t count = trace_snapshot(&header, records);
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"trace.bin\"");
+    esp_err_t ret = httpd_resp_send_chunk(req, (const char *)&header, sizeof(header));
+    if (ret == ESP_OK && count > 0) {
+        ret = httpd_resp_send_chunk(req, (const char *)records, count * sizeof(trace_record_t));
+    }
+    if (ret == ESP_OK) {
+        ret = httpd_resp_send_chunk(req, NULL, 0);
+    }
+    free(records);
+    return ret;
+}
+
+#if RC_ROLE_RECEIVER
+static bool send_chunk(void *ctx, const void *data, size_t len) {
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, (const char *)data, len) == ESP_OK;
+}
+
+// Flight recorder dump (blackbox_dump_header_t + sectors), see tools/blackbox_decode.py
+static esp_err_t handler_get_blackbox(httpd_req_t *req) {
+    blackbox_stats_t bb;
+    blackbox_get_stats(&bb);
+    if (!bb.available) {
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No blackbox partition");
+    }
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"blackbox.bin\"");
+    esp_err_t err = blackbox_dump(send_chunk, req);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+#endif
+
+// Locate the value for "key" in a flat JSON object. Values posted by the form
+// are strings, so an opening quote is skipped. Returns NULL if the key is absent.
+static const char *json_find_value(const char *json, const char *key) {
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char *p = strstr(json, pattern);
+    if (!p) {
+        return NULL;
+    }
+    p += strlen(pattern);
+    while (*p == ' ' || *p == ':') p++;
+    if (*p == '"') p++;
+    return p;
+}
+
+static bool json_get_long(const char *json, const char *key, long *out) {
+    const char *p = json_find_value(json, key);
+    if (!p) {
+        return false;
+    }
+    char *end;
+    long v = strtol(p, &end, 10);
+    if (end == p) {
+        return false;
+    }
+    *out = v;
+    return true;
+}
+
+static bool json_get_float(const char *json, const char *key, float *out) {
+    const char *p = json_find_value(json, key);
+    if (!p) {
+        return false;
+    }
+    char *end;
+    float v = strtof(p, &end);
+    if (end == p) {
+        return false;
+    }
+    *out = v;
+    return true;
+}
+
+static void json_get_u8(const char *json, const char *key, uint8_t *out) {
+    long v;
+    if (json_get_long(json, key, &v) && v >= 0 && v <= UINT8_MAX) *out = (uint8_t)v;
+}
+
+static void json_get_u16(const char *json, const char *key, uint16_t *out) {
+    long v;
+    if (json_get_long(json, key, &v) && v >= 0 && v <= UINT16_MAX) *out = (uint16_t)v;
+}
+
+static void json_get_i16(const char *json, const char *key, int16_t *out) {
+    long v;
+    if (json_get_long(json, key, &v) && v >= INT16_MIN && v <= INT16_MAX) *out = (int16_t)v;
+}
+
+// Parse up to max integers following "key" (nested arrays are flattened).
+// Returns the number of values read.
+static int json_get_int_array(const char *json, const char *key, long *out, int max) {
+    const char *p = json_find_value(json, key);
+    if (!p || *p != '[') {
+        return 0;
+    }
+    int depth = 0;
+    int n = 0;
+    while (*p && n < max) {
+        if (*p == '[') {
+            depth++;
+            p++;
+        } else if (*p == ']') {
+            if (--depth == 0) break;
+            p++;
+        } else if (*p == '-' || (*p >= '0' && *p <= '9')) {
+            char *end;
+            out[n++] = strtol(p, &end, 10);
+            p = end;
+        } else {
+            p++;
+        }
+    }
+    return n;
+}
+
+#define SETTINGS_POST_MAX (1024 + NUM_CHANNELS * 384)
+
 static esp_err_t handler_post_settings(httpd_req_t *req) {
-    char buffer[1024] = {0};
-    int ret = httpd_req_recv(req, buffer, sizeof(buffer) - 1);
-    if (ret <= 0) {
+    if (req->content_len >= SETTINGS_POST_MAX) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Body too large");
+    }
+    char *buffer = calloc(1, SETTINGS_POST_MAX);
+    if (!buffer) {
         return httpd_resp_send_500(req);
     }
+    size_t received = 0;
+    while (received < req->content_len) {
+        int ret = httpd_req_recv(req, buffer + received, req->content_len - received);
+        if (ret <= 0) {
+            free(buffer);
+            return httpd_resp_send_500(req);
+        }
+        received += ret;
+    }
+
+    // Parse JSON (flat object, keys looked up individually)
+    json_get_u8(buffer, "device_role", &g_settings->device_role);
+#ifdef ROLE_FIXED
+    g_settings->device_role = ROLE_FIXED;
+#endif
+
+    const char *mac_str = json_find_value(buffer, "peer_mac");
+    uint8_t mac[6];
+    if (mac_str && sscanf(mac_str, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+                          &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) == 6 &&
+        memcmp(g_settings->peer_mac, mac, 6) != 0) {
+        // A typed-in MAC pins the peer like a bind does; broadcast unpins it
+        memcpy(g_settings->peer_mac, mac, 6);
+        static const uint8_t broadcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+        g_settings->peer_bound = memcmp(mac, broadcast, 6) != 0;
+        g_settings->peer_num_channels = 0;
+        g_settings->peer_caps = 0;
+    }
+
+    json_get_u8(buffer, "channel", &g_settings->channel);
 
-    // Parse JSON (simple parsing for now)
-    char mac_str[18] = {0};
-    if (sscanf(buffer, "{\"device_role\":%hhu,\"peer_mac\":\"%17[^\"]\"", 
-               &g_settings->device_role, mac_str) > 0) {
-        // Parse MAC address from string format
-        uint8_t mac[6];
-        if (sscanf(mac_str, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
-                   &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) == 6) {
-            memcpy(g_settings->peer_mac, mac, 6);
+    json_get_u16(buffer, "out_rate", &g_settings->output_rate_hz);
+    long extrap;
+    if (json_get_long(buffer, "out_extrap", &extrap)) {
+        g_settings->output_extrapolate = (extrap != 0);
+    }
+    json_get_u8(buffer, "in_src", &g_settings->input_source);
+    json_get_u16(buffer, "rate_min", &g_settings->rate_min_hz);
+    json_get_u16(buffer, "rate_max", &g_settings->rate_max_hz);
+    json_get_u8(buffer, "ser_proto", &g_settings->serial_proto);
+    json_get_u16(buffer, "ser_rate", &g_settings->serial_rate_hz);
+    json_get_u8(buffer, "pwr_mode", &g_settings->power_mode);
+    json_get_u16(buffer, "pwr_budget", &g_settings->power_budget_us);
+    json_get_u8(buffer, "link_sec", &g_settings->link_security);
+    // Link key: write-only, 32 hex digits; an empty field keeps the current key
+    const char *key_str = json_find_value(buffer, "link_key");
+    uint8_t key[LINK_KEY_LEN];
+    int key_pos = 0;
+    if (key_str) {
+        while (key_pos < LINK_KEY_LEN && sscanf(key_str + 2 * key_pos, "%2hhx", &key[key_pos]) == 1) {
+            key_pos++;
+        }
+        if (key_pos == LINK_KEY_LEN) {
+            memcpy(g_settings->link_key, key, LINK_KEY_LEN);
         }
     }
-    
-    sscanf(buffer, "\"channel\":%hhu", &g_settings->channel);
-    
-    // Parse calibration for all channels
-    for (int i = 0; i < NUM_CHANNELS; i++) {
-        char key_min[16], key_max[16];
-        snprintf(key_min, sizeof(key_min), "\"ch%d_min\"", i + 1);
-        snprintf(key_max, sizeof(key_max), "\"ch%d_max\"", i + 1);
-        
-        char pattern_min[32], pattern_max[32];
-        snprintf(pattern_min, sizeof(pattern_min), "%s:%%hu", key_min);
-        snprintf(pattern_max, sizeof(pattern_max), "%s:%%hu", key_max);
-        
-        sscanf(buffer, pattern_min, &g_settings->ch_min[i]);
-        sscanf(buffer, pattern_max, &g_settings->ch_max[i]);
+    // Access point passphrase: write-only, 8-63 printable characters without
+    // quotes or backslashes (no JSON escapes); an empty field keeps the current one
+    const char *pass_str = json_find_value(buffer, "ap_pass");
+    if (pass_str) {
+        int len = 0;
+        while (len <= AP_PASSWORD_MAX && pass_str[len] >= ' ' && pass_str[len] < 0x7F &&
+               pass_str[len] != '"' && pass_str[len] != '\\') {
+            len++;
+        }
+        if (pass_str[len] == '"' && len >= AP_PASSWORD_MIN && len <= AP_PASSWORD_MAX) {
+            memcpy(g_settings->ap_password, pass_str, len);
+            g_settings->ap_password[len] = '\0';
+        }
     }
-    
-    // Parse per-channel servo positions and expo
+
     for (int i = 0; i < NUM_CHANNELS; i++) {
-        char key_smin[16], key_sctr[16], key_smax[16];
-        char key_expo[16];
-        snprintf(key_smin, sizeof(key_smin), "\"ch%d_smin\"", i + 1);
-        snprintf(key_sctr, sizeof(key_sctr), "\"ch%d_sctr\"", i + 1);
-        snprintf(key_smax, sizeof(key_smax), "\"ch%d_smax\"", i + 1);
-        snprintf(key_expo, sizeof(key_expo), "\"ch%d_expo\"", i + 1);
-        
-        char pattern_smin[32], pattern_sctr[32], pattern_smax[32];
-        char pattern_expo[32];
-        snprintf(pattern_smin, sizeof(pattern_smin), "%s:%%hu", key_smin);
-        snprintf(pattern_sctr, sizeof(pattern_sctr), "%s:%%hu", key_sctr);
-        snprintf(pattern_smax, sizeof(pattern_smax), "%s:%%hu", key_smax);
-        snprintf(pattern_expo, sizeof(pattern_expo), "%s:%%f", key_expo);
-        
-        sscanf(buffer, pattern_smin, &g_settings->servo_min[i]);
-        sscanf(buffer, pattern_sctr, &g_settings->servo_center[i]);
-        sscanf(buffer, pattern_smax, &g_settings->servo_max[i]);
-        sscanf(buffer, pattern_expo, &g_settings->expo[i]);
+        char key[16];
+        // Calibration
+        snprintf(key, sizeof(key), "ch%d_min", i + 1);
+        json_get_u16(buffer, key, &g_settings->ch_min[i]);
+        snprintf(key, sizeof(key), "ch%d_max", i + 1);
+        json_get_u16(buffer, key, &g_settings->ch_max[i]);
+        snprintf(key, sizeof(key), "ch%d_ctr", i + 1);
+        json_get_u16(buffer, key, &g_settings->ch_center[i]);
+
+        // Input conditioning
+        snprintf(key, sizeof(key), "ch%d_dbnd", i + 1);
+        json_get_u16(buffer, key, &g_settings->ch_deadband[i]);
+        snprintf(key, sizeof(key), "ch%d_trim", i + 1);
+        json_get_i16(buffer, key, &g_settings->ch_trim[i]);
+        snprintf(key, sizeof(key), "ch%d_filt", i + 1);
+        json_get_u8(buffer, key, &g_settings->ch_filter[i]);
+        snprintf(key, sizeof(key), "ch%d_fstr", i + 1);
+        json_get_u8(buffer, key, &g_settings->ch_filter_strength[i]);
+        long rev;
+        snprintf(key, sizeof(key), "ch%d_rev", i + 1);
+        if (json_get_long(buffer, key, &rev)) {
+            g_settings->ch_reverse[i] = (rev != 0);
+        }
+
+        // Servo positions and expo
+        snprintf(key, sizeof(key), "ch%d_smin", i + 1);
+        json_get_u16(buffer, key, &g_settings->servo_min[i]);
+        snprintf(key, sizeof(key), "ch%d_sctr", i + 1);
+        json_get_u16(buffer, key, &g_settings->servo_center[i]);
+        snprintf(key, sizeof(key), "ch%d_smax", i + 1);
+        json_get_u16(buffer, key, &g_settings->servo_max[i]);
+        snprintf(key, sizeof(key), "ch%d_expo", i + 1);
+        json_get_float(buffer, key, &g_settings->expo[i]);
+        snprintf(key, sizeof(key), "ch%d_slew", i + 1);
+        json_get_u16(buffer, key, &g_settings->ch_slew[i]);
+        snprintf(key, sizeof(key), "ch%d_pwmhz", i + 1);
+        json_get_u16(buffer, key, &g_settings->ch_pwm_hz[i]);
     }
-    
-    
-    // Update receiver with new settings
+    free(buffer);
+
+    g_settings->is_configured = true;
+    settings_save(g_settings);
+    profiles_store_active();
+
+    // Update receiver and sender with new settings
+#if RC_ROLE_RECEIVER
     receiver_set_settings(g_settings);
+#endif
+#if RC_ROLE_SENDER
+    sender_set_settings(g_settings);
+#endif
+    scope_configure(g_settings);
 
     const char *response = "{\"message\":\"Settings saved\"}";
     httpd_resp_set_type(req, "application/json");
     return httpd_resp_send(req, response, strlen(response));
 }
 
+#if RC_ROLE_SENDER
+static esp_err_t handler_get_calibration(httpd_req_t *req) {
+    char *response = malloc(1024);
+    if (!response) {
+        return httpd_resp_send_500(req);
+    }
+
+    calib_snapshot_t snap;
+    sender_calibration_get(&snap);
+    bool active = sender_calibration_active();
+
+    int len = snprintf(response, 1024, "{\"active\":%d,\"phase\":%u,\"samples\":%lu,\"ch\":[",
+                       active ? 1 : 0, active ? snap.phase : CALIB_IDLE, snap.samples);
+    for (int i = 0; i < NUM_CHANNELS && len < 1024; i++) {
+        bool sampled = snap.samples > 0;
+        len += snprintf(response + len, 1024 - len,
+                        "%s{\"min\":%u,\"ctr\":%u,\"max\":%u,\"raw\":%u}",
+                        i ? "," : "",
+                        sampled ? snap.min[i] : 0, snap.center[i],
+                        sampled ? snap.max[i] : 0, snap.last[i]);
+    }
+    if (len < 1024 - 2) {
+        strcpy(response + len, "]}");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    esp_err_t ret = httpd_resp_send(req, response, strlen(response));
+    free(response);
+    return ret;
+}
+
+static esp_err_t handler_post_calibration(httpd_req_t *req) {
+    char buffer[128] = {0};
+    int ret = httpd_req_recv(req, buffer, sizeof(buffer) - 1);
+    if (ret <= 0) {
+        return httpd_resp_send_500(req);
+    }
+
+    char action[16] = {0};
+    const char *p = json_find_value(buffer, "action");
+    if (p) {
+        sscanf(p, "%15[a-z]", action);
+    }
+
+    char response[96];
+    if (strcmp(action, "start") == 0) {
+        if (!sender_calibration_start()) {
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Calibration unavailable");
+        }
+        snprintf(response, sizeof(response), "{\"message\":\"Leave sticks centered\"}");
+    } else if (strcmp(action, "range") == 0) {
+        sender_calibration_set_phase(CALIB_RANGE);
+        snprintf(response, sizeof(response), "{\"message\":\"Move all sticks to their limits\"}");
+    } else if (strcmp(action, "save") == 0) {
+        if (!sender_calibration_active()) {
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Calibration not running");
+        }
+        calib_snapshot_t snap;
+        sender_calibration_stop();
+        sender_calibration_get(&snap);
+        uint32_t applied = calib_apply(&snap, g_settings);
+        if (applied) {
+            settings_save_calibration(g_settings);
+            sender_set_settings(g_settings);
+        }
+        snprintf(response, sizeof(response),
+                 "{\"message\":\"Calibration saved\",\"applied\":%lu}", applied);
+    } else if (strcmp(action, "cancel") == 0) {
+        sender_calibration_stop();
+        snprintf(response, sizeof(response), "{\"message\":\"Calibration cancelled\"}");
+    } else {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown action");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, response, strlen(response));
+}
+#endif
+
+#if RC_ROLE_SENDER
+// Live scope: one WebSocket client at a time. The sampler fills the scope ring
+// (sender.c); a flush timer queues httpd work that sends what has accumulated,
+// so sockets are only touched from the httpd task.
+#define SCOPE_FLUSH_MS 50
+
+static int scope_fd = -1;
+static uint8_t *scope_batch = NULL;
+static esp_timer_handle_t scope_flush_timer = NULL;
+static volatile bool scope_flush_queued = false;
+
+static void scope_stream_stop(void) {
+    if (scope_flush_timer != NULL) {
+        esp_timer_stop(scope_flush_timer);
+        esp_timer_delete(scope_flush_timer);
+        scope_flush_timer = NULL;
+    }
+    sender_scope_stop();
+    scope_close();
+    free(scope_batch);
+    scope_batch = NULL;
+    if (scope_fd >= 0) {
+        ESP_LOGI(TAG, "Scope stream closed");
+    }
+    scope_fd = -1;
+}
+
+// httpd task
+static void scope_flush(void *arg) {
+    scope_flush_queued = false;
+    if (scope_fd < 0) {
+        return;
+    }
+    if (httpd_ws_get_fd_info(http_server, scope_fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+        scope_stream_stop();        // Client went away
+        return;
+    }
+    size_t len;
+    while ((len = scope_drain(scope_batch)) > 0) {
+        httpd_ws_frame_t frame = {
+            .final = true,
+            .type = HTTPD_WS_TYPE_BINARY,
+            .payload = scope_batch,
+            .len = len,
+        };
+        if (httpd_ws_send_frame_async(http_server, scope_fd, &frame) != ESP_OK) {
+            scope_stream_stop();
+            return;
+        }
+    }
+}
+
+// esp_timer task: hand the send to httpd, at most one flush pending
+static void scope_flush_timer_cb(void *arg) {
+    if (!scope_flush_queued && http_server != NULL) {
+        scope_flush_queued = true;
+        if (httpd_queue_work(http_server, scope_flush, NULL) != ESP_OK) {
+            scope_flush_queued = false;
+        }
+    }
+}
+
+// GET /api/scope?rate=<hz> upgrades to a WebSocket; a new client replaces the old one
+static esp_err_t handler_scope(httpd_req_t *req) {
+    if (req->method != HTTP_GET) {
+        // Nothing is expected from the client: read and discard its frames
+        uint8_t buf[32];
+        httpd_ws_frame_t frame = {.payload = buf};
+        esp_err_t ret = httpd_ws_recv_frame(req, &frame, 0);
+        if (ret == ESP_OK && frame.len > 0 && frame.len <= sizeof(buf)) {
+            ret = httpd_ws_recv_frame(req, &frame, frame.len);
+        }
+        return ret;
+    }
+
+    scope_stream_stop();
+    uint16_t rate_hz = SCOPE_RATE_DEFAULT_HZ;
+    char query[32];
+    char value[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "rate", value, sizeof(value)) == ESP_OK) {
+        rate_hz = (uint16_t)atoi(value);
+    }
+    scope_batch = malloc(SCOPE_BATCH_SIZE);
+    rate_hz = scope_batch ? scope_open(rate_hz, g_settings) : 0;
+    if (rate_hz == 0 || !sender_scope_start(rate_hz)) {
+        scope_stream_stop();
+        return ESP_FAIL;            // Closes the socket; the page shows the scope as unavailable
+    }
+    esp_timer_create_args_t args = {
+        .callback = scope_flush_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "scope_flush",
+    };
+    if (esp_timer_create(&args, &scope_flush_timer) != ESP_OK ||
+        esp_timer_start_periodic(scope_flush_timer, SCOPE_FLUSH_MS * 1000ULL) != ESP_OK) {
+        scope_stream_stop();
+        return ESP_FAIL;
+    }
+    scope_fd = httpd_req_to_sockfd(req);
+    ESP_LOGI(TAG, "Scope stream at %u Hz", rate_hz);
+    return ESP_OK;
+}
+#endif
+
+#if RC_ROLE_RECEIVER
+// Weight matrix and offsets, up to 5 characters per value
+#define MIXER_JSON_SIZE (1024 + NUM_CHANNELS * NUM_CHANNELS * 6)
+
+static esp_err_t handler_get_mixer(httpd_req_t *req) {
+    char *response = malloc(MIXER_JSON_SIZE);
+    if (!response) {
+        return httpd_resp_send_500(req);
+    }
+
+    int len = snprintf(response, MIXER_JSON_SIZE, "{\"preset\":%u,\"weight\":[", g_settings->mix_preset);
+    for (int o = 0; o < NUM_CHANNELS && len < MIXER_JSON_SIZE; o++) {
+        len += snprintf(response + len, MIXER_JSON_SIZE - len, "%s[", o ? "," : "");
+        for (int i = 0; i < NUM_CHANNELS && len < MIXER_JSON_SIZE; i++) {
+            len += snprintf(response + len, MIXER_JSON_SIZE - len, "%s%d", i ? "," : "", g_settings->mix_weight[o][i]);
+        }
+        if (len < MIXER_JSON_SIZE) len += snprintf(response + len, MIXER_JSON_SIZE - len, "]");
+    }
+    if (len < MIXER_JSON_SIZE) len += snprintf(response + len, MIXER_JSON_SIZE - len, "],\"offset\":[");
+    for (int o = 0; o < NUM_CHANNELS && len < MIXER_JSON_SIZE; o++) {
+        len += snprintf(response + len, MIXER_JSON_SIZE - len, "%s%d", o ? "," : "", g_settings->mix_offset[o]);
+    }
+    if (len < MIXER_JSON_SIZE) snprintf(response + len, MIXER_JSON_SIZE - len, "]}");
+
+    httpd_resp_set_type(req, "application/json");
+    esp_err_t ret = httpd_resp_send(req, response, strlen(response));
+    free(response);
+    return ret;
+}
+
+static esp_err_t handler_post_mixer(httpd_req_t *req) {
+    if (req->content_len >= MIXER_JSON_SIZE) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Body too large");
+    }
+    char *buffer = calloc(1, MIXER_JSON_SIZE);
+    if (!buffer) {
+        return httpd_resp_send_500(req);
+    }
+    size_t received = 0;
+    while (received < req->content_len) {
+        int ret = httpd_req_recv(req, buffer + received, req->content_len - received);
+        if (ret <= 0) {
+            free(buffer);
+            return httpd_resp_send_500(req);
+        }
+        received += ret;
+    }
+
+    long preset;
+    if (json_get_long(buffer, "preset", &preset)) {
+        if (preset < 0 || preset >= MIX_PRESET_COUNT) {
+            free(buffer);
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown preset");
+        }
+        g_settings->mix_preset = (uint8_t)preset;
+    }
+
+    long values[NUM_CHANNELS * NUM_CHANNELS];
+    if (json_get_int_array(buffer, "weight", values, NUM_CHANNELS * NUM_CHANNELS) == NUM_CHANNELS * NUM_CHANNELS) {
+        for (int o = 0; o < NUM_CHANNELS; o++) {
+            for (int i = 0; i < NUM_CHANNELS; i++) {
+                long w = values[o * NUM_CHANNELS + i];
+                if (w > MIX_WEIGHT_MAX) w = MIX_WEIGHT_MAX;
+                if (w < -MIX_WEIGHT_MAX) w = -MIX_WEIGHT_MAX;
+                g_settings->mix_weight[o][i] = (int8_t)w;
+            }
+        }
+    }
+    if (json_get_int_array(buffer, "offset", values, NUM_CHANNELS) == NUM_CHANNELS) {
+        for (int o = 0; o < NUM_CHANNELS; o++) {
+            long w = values[o];
+            if (w > MIX_WEIGHT_MAX) w = MIX_WEIGHT_MAX;
+            if (w < -MIX_WEIGHT_MAX) w = -MIX_WEIGHT_MAX;
+            g_settings->mix_offset[o] = (int8_t)w;
+        }
+    }
+    free(buffer);
+
+    settings_save(g_settings);
+    profiles_store_active();
+    receiver_set_settings(g_settings);
+
+    const char *response = "{\"message\":\"Mixer saved\"}";
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, response, strlen(response));
+}
+#endif
+
+static esp_err_t handler_get_profiles(httpd_req_t *req) {
+    char response[PROFILE_COUNT * 80 + 32];
+    int len = snprintf(response, sizeof(response), "{\"active\":%d,\"profiles\":[", profiles_active());
+    bool first = true;
+    for (int i = 0; i < PROFILE_COUNT; i++) {
+        if (!profiles_valid(i)) {
+            continue;
+        }
+        // The active profile is the working copy; others only need their name here
+        len += snprintf(response + len, sizeof(response) - len, "%s{\"slot\":%d,\"name\":\"%s\"}",
+                        first ? "" : ",", i, profiles_name(i));
+        first = false;
+    }
+    snprintf(response + len, sizeof(response) - len, "]}");
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, response, strlen(response));
+}
+
+static esp_err_t handler_post_profiles(httpd_req_t *req) {
+    char buffer[128] = {0};
+    int ret = httpd_req_recv(req, buffer, sizeof(buffer) - 1);
+    if (ret <= 0) {
+        return httpd_resp_send_500(req);
+    }
+
+    char action[16] = {0};
+    const char *p = json_find_value(buffer, "action");
+    if (p) {
+        sscanf(p, "%15[a-z]", action);
+    }
+    long slot = -1;
+    json_get_long(buffer, "slot", &slot);
+    char name[PROFILE_NAME_LEN] = {0};
+    p = json_find_value(buffer, "name");
+    if (p) {
+        sscanf(p, "%15[^\"]", name);
+    }
+
+    esp_err_t err;
+    if (strcmp(action, "select") == 0) {
+        // The working copy now holds the selected model; the page reloads its settings
+        err = profiles_switch((int)slot);
+    } else if (strcmp(action, "save") == 0) {
+        err = profiles_store((int)slot, name);
+    } else if (strcmp(action, "delete") == 0) {
+        err = profiles_delete((int)slot);
+    } else {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown action");
+    }
+    if (err != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, esp_err_to_name(err));
+    }
+
+    char response[64];
+    snprintf(response, sizeof(response), "{\"message\":\"Profile %ld %s\"}", slot,
+             strcmp(action, "select") == 0 ? "selected" : strcmp(action, "save") == 0 ? "saved" : "deleted");
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, response, strlen(response));
+}
+
+// Read a 32-byte value sent as 64 hex digits in header name. Returns false if
+// the header is absent or malformed.
+static bool get_hex_header(httpd_req_t *req, const char *name, uint8_t *out) {
+    char hex[2 * OTA_SHA256_LEN + 1];
+    if (httpd_req_get_hdr_value_str(req, name, hex, sizeof(hex)) != ESP_OK) {
+        return false;
+    }
+    int n = 0;
+    while (n < OTA_SHA256_LEN && sscanf(hex + 2 * n, "%2hhx", &out[n]) == 1) {
+        n++;
+    }
+    return n == OTA_SHA256_LEN;
+}
+
+// Firmware upload: the raw image is the request body (application/octet-stream).
+// X-OTA-HMAC (64 hex digits, HMAC-SHA256 of the image keyed with the link key)
+// is required; an optional X-OTA-SHA256 header is checked against the upload.
+static esp_err_t handler_post_ota(httpd_req_t *req) {
+    uint8_t expected[OTA_SHA256_LEN];
+    uint8_t signature[OTA_HMAC_LEN];
+    bool have_hash = httpd_req_get_hdr_value_len(req, "X-OTA-SHA256") > 0;
+    if (have_hash && !get_hex_header(req, "X-OTA-SHA256", expected)) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "X-OTA-SHA256 must be 64 hex digits");
+    }
+    // Checked before anything is written to flash
+    if (!get_hex_header(req, "X-OTA-HMAC", signature)) {
+        return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED,
+                                   "X-OTA-HMAC (HMAC-SHA256 of the image with the link key) required");
+    }
+
+    esp_err_t err = ota_begin(req->content_len, g_settings->link_key);
+    if (err == ESP_ERR_NOT_ALLOWED) {
+        return httpd_resp_send_err(req, HTTPD_403_FORBIDDEN, "No link key provisioned, OTA disabled");
+    }
+    if (err != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, esp_err_to_name(err));
+    }
+    char *buffer = malloc(OTA_CHUNK_LEN);
+    if (!buffer) {
+        ota_abort();
+        return httpd_resp_send_500(req);
+    }
+    size_t remaining = req->content_len;
+    int timeouts = 0;
+    while (remaining > 0) {
+        int ret = httpd_req_recv(req, buffer, remaining < OTA_CHUNK_LEN ? remaining : OTA_CHUNK_LEN);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < 3) {
+            continue;       // Slow client: wait for the next segment
+        }
+        if (ret <= 0 || ota_write(buffer, ret) != ESP_OK) {
+            free(buffer);
+            ota_abort();
+            return httpd_resp_send_500(req);
+        }
+        timeouts = 0;
+        remaining -= ret;
+    }
+    free(buffer);
+
+    ota_stats_t stats;
+    err = ota_finish(have_hash ? expected : NULL, signature, &stats);
+    if (err == ESP_ERR_NOT_ALLOWED) {
+        return httpd_resp_send_err(req, HTTPD_403_FORBIDDEN, "Image not signed with the link key");
+    }
+    if (err != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                   err == ESP_ERR_INVALID_CRC ? "SHA-256 mismatch" : esp_err_to_name(err));
+    }
+
+    char response[160];
+    snprintf(response, sizeof(response),
+             "{\"message\":\"Update written, restarting\",\"bytes\":%lu,\"ms\":%lu,\"flash_ms\":%lu,\"kb_per_s\":%lu}",
+             stats.bytes, stats.elapsed_ms, stats.flash_ms, stats.kb_per_s);
+    httpd_resp_set_type(req, "application/json");
+    esp_err_t ret = httpd_resp_send(req, response, strlen(response));
+    ota_schedule_restart();
+    return ret;
+}
+
 void webserver_start(device_settings_t *settings) {
     if (http_server != NULL) {
         ESP_LOGW(TAG, "Webserver already running");
@@ -215,21 +940,27 @@ void webserver_start(device_settings_t *settings) {
     }
 
     g_settings = settings;
+    // No light sleep while the access point and HTTP server are up
+    power_lock_acquire(POWER_LOCK_WEBSERVER);
 
     // Switch WiFi to AP mode for configuration
     ESP_LOGI(TAG, "Switching WiFi to AP mode...");
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_AP));
     
+    // WPA2: an open AP would hand the settings (and the OTA endpoint) to anyone in range
     wifi_config_t ap_config = {
         .ap = {
             .ssid = "esp-radio-control",
-            .password = "",
             .ssid_len = strlen("esp-radio-control"),
             .channel = 1,
-            .authmode = WIFI_AUTH_OPEN,
+            .authmode = WIFI_AUTH_WPA2_PSK,
             .max_connection = 4,
         }
     };
+    strncpy((char *)ap_config.ap.password, settings->ap_password, sizeof(ap_config.ap.password) - 1);
+    if (strcmp(settings->ap_password, AP_PASSWORD_DEFAULT) == 0) {
+        ESP_LOGW(TAG, "Access point uses the default password, set your own under Link Security");
+    }
     
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &ap_config));
     ESP_ERROR_CHECK(esp_wifi_start());
@@ -259,7 +990,10 @@ void webserver_start(device_settings_t *settings) {
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.max_open_sockets = 4;
-    config.max_uri_handlers = 7;
+    config.max_uri_handlers = 15;
+    config.task_priority = TASK_PRIO_HTTPD;
+    config.stack_size = TASK_STACK_HTTPD;
+    config.core_id = TASK_CORE_UI;
 
     if (httpd_start(&http_server, &config) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start webserver");
@@ -298,6 +1032,100 @@ void webserver_start(device_settings_t *settings) {
     };
     httpd_register_uri_handler(http_server, &uri_status);
 
+    httpd_uri_t uri_perf = {
+        .uri = "/api/perf",
+        .method = HTTP_GET,
+        .handler = handler_get_perf,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(http_server, &uri_perf);
+
+    httpd_uri_t uri_trace = {
+        .uri = "/api/trace",
+        .method = HTTP_GET,
+        .handler = handler_get_trace,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(http_server, &uri_trace);
+
+#if RC_ROLE_SENDER
+    httpd_uri_t uri_calib_get = {
+        .uri = "/api/calibration",
+        .method = HTTP_GET,
+        .handler = handler_get_calibration,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(http_server, &uri_calib_get);
+
+    httpd_uri_t uri_calib_post = {
+        .uri = "/api/calibration",
+        .method = HTTP_POST,
+        .handler = handler_post_calibration,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(http_server, &uri_calib_post);
+
+    httpd_uri_t uri_scope = {
+        .uri = "/api/scope",
+        .method = HTTP_GET,
+        .handler = handler_scope,
+        .user_ctx = NULL,
+        .is_websocket = true
+    };
+    httpd_register_uri_handler(http_server, &uri_scope);
+#endif
+
+#if RC_ROLE_RECEIVER
+
+    httpd_uri_t uri_mixer_get = {
+        .uri = "/api/mixer",
+        .method = HTTP_GET,
+        .handler = handler_get_mixer,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(http_server, &uri_mixer_get);
+
+    httpd_uri_t uri_mixer_post = {
+        .uri = "/api/mixer",
+        .method = HTTP_POST,
+        .handler = handler_post_mixer,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(http_server, &uri_mixer_post);
+
+    httpd_uri_t uri_blackbox = {
+        .uri = "/api/blackbox",
+        .method = HTTP_GET,
+        .handler = handler_get_blackbox,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(http_server, &uri_blackbox);
+#endif
+
+    httpd_uri_t uri_profiles_get = {
+        .uri = "/api/profiles",
+        .method = HTTP_GET,
+        .handler = handler_get_profiles,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(http_server, &uri_profiles_get);
+
+    httpd_uri_t uri_profiles_post = {
+        .uri = "/api/profiles",
+        .method = HTTP_POST,
+        .handler = handler_post_profiles,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(http_server, &uri_profiles_post);
+
+    httpd_uri_t uri_ota = {
+        .uri = "/api/ota",
+        .method = HTTP_POST,
+        .handler = handler_post_ota,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(http_server, &uri_ota);
+
     ESP_LOGI(TAG, "Webserver started on http://192.168.4.1");
     
     // Initialize static device info (MAC, chip model, cores, IDF version)
@@ -308,15 +1136,27 @@ void webserver_start(device_settings_t *settings) {
 }
 
 void webserver_stop(void) {
+#if RC_ROLE_SENDER
+    if (sender_calibration_active()) {
+        sender_calibration_stop();
+    }
+    if (scope_flush_timer != NULL) {
+        esp_timer_stop(scope_flush_timer);  // No new flush work once httpd is stopping
+    }
+#endif
     if (http_server != NULL) {
         httpd_stop(http_server);
         http_server = NULL;
+#if RC_ROLE_SENDER
+        scope_stream_stop();
+#endif
         ESP_LOGI(TAG, "Webserver stopped");
         
         // Switch WiFi back to STA mode for ESP-NOW
         ESP_LOGI(TAG, "Switching WiFi back to STA mode...");
         ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
         ESP_LOGI(TAG, "WiFi switched to STA mode for ESP-NOW");
+        power_lock_release(POWER_LOCK_WEBSERVER);
     }
 }
 
@@ -2,6 +2,12 @@
 #ifndef WEBSERVER_PAGE_H
 #define WEBSERVER_PAGE_H
 
+#include "board.h"
+
+// Compile-time values spliced into the page script
+#define PAGE_STR2(x) #x
+#define PAGE_STR(x) PAGE_STR2(x)
+
 static const char *html_page = 
     "<!DOCTYPE html>\n"
     "<html>\n"
@@ -84,62 +90,7 @@ static const char *html_page =
     "  <div class='status-section'>\n"
     "    <h2>Channel & Light Feedback</h2>\n"
     "    <p style='color: #666; font-size: 0.9em;'>Live input values from sender device:</p>\n"
-    "    <div id='channelFeedback'>\n"
-    "      <div style='margin: 12px 0;'>\n"
-    "        <div style='display: flex; justify-content: space-between; margin-bottom: 4px;'>\n"
-    "          <span style='font-weight: bold; color: #555;'>Channel 1:</span>\n"
-    "          <span id='ch1_val' style='font-family: monospace; color: #2196F3;'>0/4095</span>\n"
-    "        </div>\n"
-    "        <div style='background: #e0e0e0; height: 20px; border-radius: 3px; overflow: hidden;'>\n"
-    "          <div id='ch1_bar' style='background: #2196F3; height: 100%; width: 0%; transition: width 0.1s;'></div>\n"
-    "        </div>\n"
-    "      </div>\n"
-    "      <div style='margin: 12px 0;'>\n"
-    "        <div style='display: flex; justify-content: space-between; margin-bottom: 4px;'>\n"
-    "          <span style='font-weight: bold; color: #555;'>Channel 2:</span>\n"
-    "          <span id='ch2_val' style='font-family: monospace; color: #2196F3;'>0/4095</span>\n"
-    "        </div>\n"
-    "        <div style='background: #e0e0e0; height: 20px; border-radius: 3px; overflow: hidden;'>\n"
-    "          <div id='ch2_bar' style='background: #2196F3; height: 100%; width: 0%; transition: width 0.1s;'></div>\n"
-    "        </div>\n"
-    "      </div>\n"
-    "      <div style='margin: 12px 0;'>\n"
-    "        <div style='display: flex; justify-content: space-between; margin-bottom: 4px;'>\n"
-    "          <span style='font-weight: bold; color: #555;'>Channel 3:</span>\n"
-    "          <span id='ch3_val' style='font-family: monospace; color: #2196F3;'>0/4095</span>\n"
-    "        </div>\n"
-    "        <div style='background: #e0e0e0; height: 20px; border-radius: 3px; overflow: hidden;'>\n"
-    "          <div id='ch3_bar' style='background: #2196F3; height: 100%; width: 0%; transition: width 0.1s;'></div>\n"
-    "        </div>\n"
-    "      </div>\n"
-    "      <div style='margin: 12px 0;'>\n"
-    "        <div style='display: flex; justify-content: space-between; margin-bottom: 4px;'>\n"
-    "          <span style='font-weight: bold; color: #555;'>Channel 4:</span>\n"
-    "          <span id='ch4_val' style='font-family: monospace; color: #2196F3;'>0/4095</span>\n"
-    "        </div>\n"
-    "        <div style='background: #e0e0e0; height: 20px; border-radius: 3px; overflow: hidden;'>\n"
-    "          <div id='ch4_bar' style='background: #2196F3; height: 100%; width: 0%; transition: width 0.1s;'></div>\n"
-    "        </div>\n"
-    "      </div>\n"
-    "      <div style='margin: 12px 0;'>\n"
-    "        <div style='display: flex; justify-content: space-between; margin-bottom: 4px;'>\n"
-    "          <span style='font-weight: bold; color: #555;'>Channel 5:</span>\n"
-    "          <span id='ch5_val' style='font-family: monospace; color: #2196F3;'>0/4095</span>\n"
-    "        </div>\n"
-    "        <div style='background: #e0e0e0; height: 20px; border-radius: 3px; overflow: hidden;'>\n"
-    "          <div id='ch5_bar' style='background: #2196F3; height: 100%; width: 0%; transition: width 0.1s;'></div>\n"
-    "        </div>\n"
-    "      </div>\n"
-    "      <div style='margin: 12px 0;'>\n"
-    "        <div style='display: flex; justify-content: space-between; margin-bottom: 4px;'>\n"
-    "          <span style='font-weight: bold; color: #555;'>Channel 6:</span>\n"
-    "          <span id='ch6_val' style='font-family: monospace; color: #2196F3;'>0/4095</span>\n"
-    "        </div>\n"
-    "        <div style='background: #e0e0e0; height: 20px; border-radius: 3px; overflow: hidden;'>\n"
-    "          <div id='ch6_bar' style='background: #2196F3; height: 100%; width: 0%; transition: width 0.1s;'></div>\n"
-    "        </div>\n"
-    "      </div>\n"
-    "    </div>\n"
+    "    <div id='channelFeedback'></div>\n"
     "    <h3 style='margin-top: 20px; margin-bottom: 10px;'>Lights</h3>\n"
     "    <div style='display: grid; grid-template-columns: repeat(4, 1fr); gap: 10px;'>\n"
     "      <div style='text-align: center;'>\n"
@@ -162,6 +113,63 @@ static const char *html_page =
     "  </div>\n"
     "\n"
     "  <div class='status-section'>\n"
+    "    <h2>Stick Calibration (Sender)</h2>\n"
+    "    <p style='color: #666; font-size: 0.9em;'>1. Start with sticks centered. 2. Capture range and move every stick to its limits. 3. Save.</p>\n"
+    "    <div style='display: grid; grid-template-columns: repeat(4, 1fr); gap: 10px;'>\n"
+    "      <button type='button' onclick=\"calib('start')\">Start</button>\n"
+    "      <button type='button' onclick=\"calib('range')\">Capture Range</button>\n"
+    "      <button type='button' onclick=\"calib('save')\">Save</button>\n"
+    "      <button type='button' class='reset' style='margin-top: 10px;' onclick=\"calib('cancel')\">Cancel</button>\n"
+    "    </div>\n"
+    "    <div id='calibState' class='status-value' style='margin: 10px 0;'>Idle</div>\n"
+    "    <table id='calibTable' style='width: 100%; font-family: monospace; text-align: right;'></table>\n"
+    "  </div>\n"
+    "\n"
+    "  <div class='status-section'>\n"
+    "    <h2>Live Scope (Sender)</h2>\n"
+    "    <p style='color: #666; font-size: 0.9em;'>Sticks sampled at the selected rate: raw ADC (grey), after input conditioning (blue), servo output 1000-2000 µs after expo and endpoints (orange). Last 2 s.</p>\n"
+    "    <div style='display: grid; grid-template-columns: repeat(4, 1fr); gap: 10px; align-items: end;'>\n"
+    "      <div><label>Channel:</label><select id='scopeCh' onchange='scopeBuf.length = 0'></select></div>\n"
+    "      <div><label>Rate:</label><select id='scopeRate'><option value='50'>50 Hz</option><option value='100' selected>100 Hz</option><option value='200'>200 Hz</option><option value='500'>500 Hz</option></select></div>\n"
+    "      <button type='button' onclick='scopeStart()'>Start</button>\n"
+    "      <button type='button' class='reset' style='margin-top: 10px;' onclick='scopeStop()'>Stop</button>\n"
+    "    </div>\n"
+    "    <canvas id='scopeCanvas' width='560' height='200' style='width: 100%; margin-top: 10px; background: #111; border-radius: 3px;'></canvas>\n"
+    "    <div id='scopeState' class='status-value' style='margin: 10px 0;'>Stopped</div>\n"
+    "  </div>\n"
+    "\n"
+    "  <div class='status-section'>\n"
+    "    <h2>Model Profiles</h2>\n"
+    "    <p style='color: #666; font-size: 0.9em;'>Peer, servo, expo, input conditioning and mixer per model. Short-press BOOT to switch to the next model.</p>\n"
+    "    <div class='form-group'>\n"
+    "      <label>Profile:</label>\n"
+    "      <select id='profSlot'></select>\n"
+    "      <label style='margin-top: 10px;'>Name:</label>\n"
+    "      <input type='text' id='profName' maxlength='15'>\n"
+    "    </div>\n"
+    "    <button type='button' onclick=\"profile('select')\">Switch To</button>\n"
+    "    <button type='button' onclick=\"profile('save')\">Save Current Model Here</button>\n"
+    "    <button type='button' class='reset' style='margin-top: 10px;' onclick=\"profile('delete')\">Delete</button>\n"
+    "  </div>\n"
+    "\n"
+    "  <div class='status-section'>\n"
+    "    <h2>Channel Mixer (Receiver)</h2>\n"
+    "    <div class='form-group'>\n"
+    "      <label>Preset:</label>\n"
+    "      <select id='mixPreset'>\n"
+    "        <option value='0'>None (CHn = input n)</option>\n"
+    "        <option value='1'>Custom matrix</option>\n"
+    "        <option value='2'>Tank / differential (CH1 thr, CH2 steer)</option>\n"
+    "        <option value='3'>Elevon (CH1 pitch, CH2 roll)</option>\n"
+    "        <option value='4'>V-tail (CH1 elevator, CH2 rudder)</option>\n"
+    "      </select>\n"
+    "    </div>\n"
+    "    <p style='color: #666; font-size: 0.9em;'>Custom matrix: rows are outputs, columns are inputs, weights and offsets in % (-125..125).</p>\n"
+    "    <table id='mixTable' style='width: 100%;'></table>\n"
+    "    <button type='button' onclick='saveMixer()'>Save Mixer</button>\n"
+    "  </div>\n"
+    "\n"
+    "  <div class='status-section'>\n"
     "    <form id='settingsForm'>\n"
     "      <div class='form-group'>\n"
     "        <label>Device Role:</label>\n"
@@ -171,7 +179,7 @@ static const char *html_page =
     "        </select>\n"
     "      </div>\n"
     "      <div class='form-group'>\n"
-    "        <label>Peer MAC Address (XX:XX:XX:XX:XX:XX):</label>\n"
+    "        <label>Peer MAC Address (XX:XX:XX:XX:XX:XX, <span id='peer_bound'></span>):</label>\n"
     "        <input type='text' name='peer_mac' placeholder='FF:FF:FF:FF:FF:FF'>\n"
     "      </div>\n"
     "      <div class='form-group'>\n"
@@ -179,107 +187,342 @@ static const char *html_page =
     "        <input type='number' name='channel' min='1' max='13' value='1'>\n"
     "      </div>\n"
     "      <h3>Proportional Channel Calibration</h3>\n"
+    "      <div id='calibFields'></div>\n"
+    "      <h3>Sender Channel Source</h3>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 1 Min:</label>\n"
-    "        <input type='number' name='ch1_min' min='0' max='4095'>\n"
+    "        <label>Source (trainer input on GPIO17):</label>\n"
+    "        <select name='in_src'>\n"
+    "          <option value='0'>Local sticks (ADC)</option>\n"
+    "          <option value='1'>Trainer PPM</option>\n"
+    "          <option value='2'>Trainer SBUS</option>\n"
+    "        </select>\n"
     "      </div>\n"
+    "      <h3>Sender Frame Rate</h3>\n"
+    "      <p style='color: #666; font-size: 0.9em;'>Local sticks are sampled at the maximum rate; frames go out faster the faster they move, down to the keepalive rate when still, and slower when sends fail. Equal values give a fixed rate.</p>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 1 Max:</label>\n"
-    "        <input type='number' name='ch1_max' min='0' max='4095'>\n"
+    "        <label>Keepalive Rate (Hz, 10-300):</label>\n"
+    "        <input type='number' name='rate_min' min='10' max='300'>\n"
     "      </div>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 2 Min:</label>\n"
-    "        <input type='number' name='ch2_min' min='0' max='4095'>\n"
+    "        <label>Maximum Rate (Hz, 10-300):</label>\n"
+    "        <input type='number' name='rate_max' min='10' max='300'>\n"
     "      </div>\n"
+    "      <h3>Sender Input Conditioning</h3>\n"
+    "      <p style='color: #666; font-size: 0.9em;'>Applied on the sender before transmit: filter, calibration (min/center/max), center deadband, reverse, trim.</p>\n"
+    "      <div id='inputCond' style='display: grid; grid-template-columns: repeat(3, 1fr); gap: 15px;'></div>\n"
+    "      <h3>Receiver Output Stage</h3>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 2 Max:</label>\n"
-    "        <input type='number' name='ch2_max' min='0' max='4095'>\n"
+    "        <label>Output Rate (Hz, 0 = update on each frame, 50-500):</label>\n"
+    "        <input type='number' name='out_rate' min='0' max='500'>\n"
     "      </div>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 3 Min:</label>\n"
-    "        <input type='number' name='ch3_min' min='0' max='4095'>\n"
+    "        <label>Lost Frame Handling:</label>\n"
+    "        <select name='out_extrap'>\n"
+    "          <option value='0'>Hold</option>\n"
+    "          <option value='1'>Extrapolate one frame</option>\n"
+    "        </select>\n"
     "      </div>\n"
+    "      <h3>Receiver Serial Output</h3>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 3 Max:</label>\n"
-    "        <input type='number' name='ch3_max' min='0' max='4095'>\n"
+    "        <label>Protocol (GPIO18):</label>\n"
+    "        <select name='ser_proto'>\n"
+    "          <option value='0'>Off</option>\n"
+    "          <option value='1'>SBUS (inverted, 100k 8E2)</option>\n"
+    "          <option value='2'>CRSF (420k)</option>\n"
+    "          <option value='3'>PPM</option>\n"
+    "        </select>\n"
     "      </div>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 4 Min:</label>\n"
-    "        <input type='number' name='ch4_min' min='0' max='4095'>\n"
+    "        <label>Frame Rate (Hz, 0 = protocol default):</label>\n"
+    "        <input type='number' name='ser_rate' min='0' max='500'>\n"
     "      </div>\n"
+    "      <h3>Power Management</h3>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 4 Max:</label>\n"
-    "        <input type='number' name='ch4_max' min='0' max='4095'>\n"
+    "        <label>Mode:</label>\n"
+    "        <select name='pwr_mode'>\n"
+    "          <option value='0'>Performance (fixed clock)</option>\n"
+    "          <option value='1'>Frequency scaling</option>\n"
+    "          <option value='2'>Frequency scaling + light sleep (sender)</option>\n"
+    "        </select>\n"
     "      </div>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 5 Min:</label>\n"
-    "        <input type='number' name='ch5_min' min='0' max='4095'>\n"
+    "        <label>Latency Budget (us):</label>\n"
+    "        <input type='number' name='pwr_budget' min='0' max='20000'>\n"
     "      </div>\n"
+    "      <h3>Link Security</h3>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 5 Max:</label>\n"
-    "        <input type='number' name='ch5_max' min='0' max='4095'>\n"
+    "        <label>Mode:</label>\n"
+    "        <select name='link_sec'>\n"
+    "          <option value='0'>Off</option>\n"
+    "          <option value='1'>HMAC tag + replay protection</option>\n"
+    "          <option value='2'>ESP-NOW encryption + replay protection (unicast MACs)</option>\n"
+    "        </select>\n"
     "      </div>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 6 Min:</label>\n"
-    "        <input type='number' name='ch6_min' min='0' max='4095'>\n"
+    "        <label>Key (32 hex digits, same on both devices; current id <span id='link_key_id'></span>):</label>\n"
+    "        <input type='password' name='link_key' maxlength='32' placeholder='unchanged' autocomplete='off'>\n"
     "      </div>\n"
     "      <div class='form-group'>\n"
-    "        <label>Channel 6 Max:</label>\n"
-    "        <input type='number' name='ch6_max' min='0' max='4095'>\n"
+    "        <label>Access point password (8-63 characters, applies when the webserver next starts):</label>\n"
+    "        <input type='password' name='ap_pass' minlength='8' maxlength='63' placeholder='unchanged' autocomplete='off'>\n"
     "      </div>\n"
     "      <h3>Per-Channel Servo & Rate Configuration</h3>\n"
     "      <div style='background: #f0f0f0; padding: 15px; border-radius: 5px;'>\n"
-    "        <div style='display: grid; grid-template-columns: repeat(3, 1fr); gap: 15px;'>\n"
-    "          <div>\n"
-    "            <strong>Channel 1</strong>\n"
-    "            <div><label>Min (µs):</label><input type='number' name='ch1_smin' min='500' max='2500'></div>\n"
-    "            <div><label>Center (µs):</label><input type='number' name='ch1_sctr' min='500' max='2500'></div>\n"
-    "            <div><label>Max (µs):</label><input type='number' name='ch1_smax' min='500' max='2500'></div>\n"
-    "            <div><label>Expo (0.0-1.0):</label><input type='number' name='ch1_expo' min='0' max='1' step='0.05'></div>\n"
-    "          </div>\n"
-    "          <div>\n"
-    "            <strong>Channel 2</strong>\n"
-    "            <div><label>Min (µs):</label><input type='number' name='ch2_smin' min='500' max='2500'></div>\n"
-    "            <div><label>Center (µs):</label><input type='number' name='ch2_sctr' min='500' max='2500'></div>\n"
-    "            <div><label>Max (µs):</label><input type='number' name='ch2_smax' min='500' max='2500'></div>\n"
-    "            <div><label>Expo (0.0-1.0):</label><input type='number' name='ch2_expo' min='0' max='1' step='0.05'></div>\n"
-    "          </div>\n"
-    "          <div>\n"
-    "            <strong>Channel 3</strong>\n"
-    "            <div><label>Min (µs):</label><input type='number' name='ch3_smin' min='500' max='2500'></div>\n"
-    "            <div><label>Center (µs):</label><input type='number' name='ch3_sctr' min='500' max='2500'></div>\n"
-    "            <div><label>Max (µs):</label><input type='number' name='ch3_smax' min='500' max='2500'></div>\n"
-    "            <div><label>Expo (0.0-1.0):</label><input type='number' name='ch3_expo' min='0' max='1' step='0.05'></div>\n"
-    "          </div>\n"
-    "          <div>\n"
-    "            <strong>Channel 4</strong>\n"
-    "            <div><label>Min (µs):</label><input type='number' name='ch4_smin' min='500' max='2500'></div>\n"
-    "            <div><label>Center (µs):</label><input type='number' name='ch4_sctr' min='500' max='2500'></div>\n"
-    "            <div><label>Max (µs):</label><input type='number' name='ch4_smax' min='500' max='2500'></div>\n"
-    "            <div><label>Expo (0.0-1.0):</label><input type='number' name='ch4_expo' min='0' max='1' step='0.05'></div>\n"
-    "          </div>\n"
-    "          <div>\n"
-    "            <strong>Channel 5</strong>\n"
-    "            <div><label>Min (µs):</label><input type='number' name='ch5_smin' min='500' max='2500'></div>\n"
-    "            <div><label>Center (µs):</label><input type='number' name='ch5_sctr' min='500' max='2500'></div>\n"
-    "            <div><label>Max (µs):</label><input type='number' name='ch5_smax' min='500' max='2500'></div>\n"
-    "            <div><label>Expo (0.0-1.0):</label><input type='number' name='ch5_expo' min='0' max='1' step='0.05'></div>\n"
-    "          </div>\n"
-    "          <div>\n"
-    "            <strong>Channel 6</strong>\n"
-    "            <div><label>Min (µs):</label><input type='number' name='ch6_smin' min='500' max='2500'></div>\n"
-    "            <div><label>Center (µs):</label><input type='number' name='ch6_sctr' min='500' max='2500'></div>\n"
-    "            <div><label>Max (µs):</label><input type='number' name='ch6_smax' min='500' max='2500'></div>\n"
-    "            <div><label>Expo (0.0-1.0):</label><input type='number' name='ch6_expo' min='0' max='1' step='0.05'></div>\n"
-    "          </div>\n"
-    "        </div>\n"
+    "        <div id='servoGrid' style='display: grid; grid-template-columns: repeat(3, 1fr); gap: 15px;'></div>\n"
     "      </div>\n"
     "      <button type='submit'>Save Settings</button>\n"
     "      <button type='reset' class='reset'>Reset to Defaults</button>\n"
     "    </form>\n"
     "  </div>\n"
     "\n"
+    "  <div class='status-section'>\n"
+    "    <h2>Flight Recorder (Receiver)</h2>\n"
+    "    <p style='color: #666; font-size: 0.9em;'>Received frames, RSSI and failsafe events, kept in flash as a circular log. Decode or replay the download with tools/blackbox_decode.py.</p>\n"
+    "    <div class='status-item'>\n"
+    "      <span class='status-label'>Log:</span>\n"
+    "      <span id='bbInfo' class='status-value'>Loading...</span>\n"
+    "    </div>\n"
+    "    <a href='/api/blackbox' download='blackbox.bin'><button type='button'>Download</button></a>\n"
+    "  </div>\n"
+    "\n"
+    "  <div class='status-section'>\n"
+    "    <h2>Firmware Update</h2>\n"
+    "    <p style='color: #666; font-size: 0.9em;'>Upload a firmware .bin built for this board. The device restarts into it and keeps it once the control link comes up; otherwise it returns to the current firmware.</p>\n"
+    "    <p style='color: #666; font-size: 0.9em;'>Images must be signed with the link key: <code>openssl dgst -sha256 -mac HMAC -macopt hexkey:&lt;link key&gt; firmware.bin</code></p>\n"
+    "    <div class='status-item'>\n"
+    "      <span class='status-label'>Running:</span>\n"
+    "      <span id='fwInfo' class='status-value'>Loading...</span>\n"
+    "    </div>\n"
+    "    <input type='file' id='otaFile' accept='.bin'>\n"
+    "    <input type='text' id='otaHmac' maxlength='64' placeholder='HMAC-SHA256 signature (64 hex digits)' autocomplete='off'>\n"
+    "    <button type='button' onclick='otaUpload()'>Upload</button>\n"
+    "    <div id='otaState' class='status-value' style='margin: 10px 0;'></div>\n"
+    "  </div>\n"
+    "\n"
     "  <script>\n"
+    "    // Channel count and PWM outputs of this build (channel_config.h, board.h)\n"
+    "    const NUM_CH = " PAGE_STR(NUM_CHANNELS) ";\n"
+    "    const NUM_PWM = " PAGE_STR(NUM_SERVO_OUTPUTS) ";\n"
+    "    const RATES = '<option value=\"50\">50 Hz (analog)</option><option value=\"200\">200 Hz</option><option value=\"333\">333 Hz</option><option value=\"560\">560 Hz</option>';\n"
+    "\n"
+    "    // Build per-channel feedback, calibration, input conditioning and servo fields\n"
+    "    (function() {\n"
+    "      const fb = document.getElementById('channelFeedback');\n"
+    "      const cal = document.getElementById('calibFields');\n"
+    "      const c = document.getElementById('inputCond');\n"
+    "      const srv = document.getElementById('servoGrid');\n"
+    "      for (let i = 1; i <= NUM_CH; i++) {\n"
+    "        fb.insertAdjacentHTML('beforeend',\n"
+    "          '<div style=\"margin: 12px 0;\"><div style=\"display: flex; justify-content: space-between; margin-bottom: 4px;\">' +\n"
+    "          '<span style=\"font-weight: bold; color: #555;\">Channel ' + i + ':</span>' +\n"
+    "          '<span id=\"ch' + i + '_val\" style=\"font-family: monospace; color: #2196F3;\">0/4095</span></div>' +\n"
+    "          '<div style=\"background: #e0e0e0; height: 20px; border-radius: 3px; overflow: hidden;\">' +\n"
+    "          '<div id=\"ch' + i + '_bar\" style=\"background: #2196F3; height: 100%; width: 0%; transition: width 0.1s;\"></div></div></div>');\n"
+    "        cal.insertAdjacentHTML('beforeend',\n"
+    "          '<div class=\"form-group\"><label>Channel ' + i + ' Min:</label><input type=\"number\" name=\"ch' + i + '_min\" min=\"0\" max=\"4095\"></div>' +\n"
+    "          '<div class=\"form-group\"><label>Channel ' + i + ' Max:</label><input type=\"number\" name=\"ch' + i + '_max\" min=\"0\" max=\"4095\"></div>');\n"
+    "        srv.insertAdjacentHTML('beforeend',\n"
+    "          '<div><strong>Channel ' + i + (i > NUM_PWM ? ' (serial only)' : '') + '</strong>' +\n"
+    "          '<div><label>Min (µs):</label><input type=\"number\" name=\"ch' + i + '_smin\" min=\"500\" max=\"2500\"></div>' +\n"
+    "          '<div><label>Center (µs):</label><input type=\"number\" name=\"ch' + i + '_sctr\" min=\"500\" max=\"2500\"></div>' +\n"
+    "          '<div><label>Max (µs):</label><input type=\"number\" name=\"ch' + i + '_smax\" min=\"500\" max=\"2500\"></div>' +\n"
+    "          '<div><label>Expo (0.0-1.0):</label><input type=\"number\" name=\"ch' + i + '_expo\" min=\"0\" max=\"1\" step=\"0.05\"></div>' +\n"
+    "          '<div><label>Slew (µs/s, 0 = off):</label><input type=\"number\" name=\"ch' + i + '_slew\" min=\"0\" max=\"65535\"></div>' +\n"
+    "          (i <= NUM_PWM ? '<div><label>Frame rate:</label><select name=\"ch' + i + '_pwmhz\">' + RATES + '</select></div>' : '') +\n"
+    "          '</div>');\n"
+    "        c.insertAdjacentHTML('beforeend',\n"
+    "          '<div><strong>Channel ' + i + '</strong>' +\n"
+    "          '<div><label>Center (ADC):</label><input type=\"number\" name=\"ch' + i + '_ctr\" min=\"0\" max=\"4095\"></div>' +\n"
+    "          '<div><label>Deadband:</label><input type=\"number\" name=\"ch' + i + '_dbnd\" min=\"0\" max=\"512\"></div>' +\n"
+    "          '<div><label>Trim:</label><input type=\"number\" name=\"ch' + i + '_trim\" min=\"-512\" max=\"512\"></div>' +\n"
+    "          '<div><label>Filter:</label><select name=\"ch' + i + '_filt\"><option value=\"0\">Off</option><option value=\"1\">Low-pass</option><option value=\"2\">Median 3</option><option value=\"3\">Median 5</option></select></div>' +\n"
+    "          '<div><label>Low-pass strength (1-6):</label><input type=\"number\" name=\"ch' + i + '_fstr\" min=\"1\" max=\"6\"></div>' +\n"
+    "          '<div><label>Direction:</label><select name=\"ch' + i + '_rev\"><option value=\"0\">Normal</option><option value=\"1\">Reversed</option></select></div>' +\n"
+    "          '</div>');\n"
+    "      }\n"
+    "    })();\n"
+    "\n"
+    "    // Calibration capture: poll progress while active\n"
+    "    let calibTimer = null;\n"
+    "    const calibPhases = ['Idle', 'Centering', 'Capturing range'];\n"
+    "    function calibPoll() {\n"
+    "      fetch('/api/calibration')\n"
+    "        .then(r => r.json())\n"
+    "        .then(d => {\n"
+    "          document.getElementById('calibState').textContent =\n"
+    "            (d.active ? calibPhases[d.phase] : 'Idle') + ' (' + d.samples + ' samples)';\n"
+    "          let rows = '<tr><th>Ch</th><th>Min</th><th>Center</th><th>Max</th><th>Raw</th></tr>';\n"
+    "          d.ch.forEach((c, i) => {\n"
+    "            rows += '<tr><td>' + (i + 1) + '</td><td>' + c.min + '</td><td>' + c.ctr + '</td><td>' + c.max + '</td><td>' + c.raw + '</td></tr>';\n"
+    "          });\n"
+    "          document.getElementById('calibTable').innerHTML = rows;\n"
+    "          if (!d.active && calibTimer) { clearInterval(calibTimer); calibTimer = null; }\n"
+    "        });\n"
+    "    }\n"
+    "    function calib(action) {\n"
+    "      fetch('/api/calibration', {\n"
+    "        method: 'POST',\n"
+    "        headers: { 'Content-Type': 'application/json' },\n"
+    "        body: JSON.stringify({ action: action })\n"
+    "      })\n"
+    "        .then(r => r.ok ? r.json() : r.text().then(t => ({ message: t })))\n"
+    "        .then(r => {\n"
+    "          document.getElementById('calibState').textContent = r.message;\n"
+    "          if (action === 'start' && !calibTimer) calibTimer = setInterval(calibPoll, 150);\n"
+    "          if (action === 'save') setTimeout(() => location.reload(), 500);\n"
+    "          calibPoll();\n"
+    "        });\n"
+    "    }\n"
+    "\n"
+    "    // Live scope: binary batches over a WebSocket (src/scope.h), newest 2 s plotted\n"
+    "    let scopeWs = null;\n"
+    "    const scopeBuf = [];\n"
+    "    let scopeDropped = 0;\n"
+    "    for (let i = 1; i <= NUM_CH; i++) document.getElementById('scopeCh').insertAdjacentHTML('beforeend', '<option value=\"' + (i - 1) + '\">' + i + '</option>');\n"
+    "    function scopeStop() {\n"
+    "      if (scopeWs) scopeWs.close();\n"
+    "    }\n"
+    "    function scopeStart() {\n"
+    "      scopeStop();\n"
+    "      scopeBuf.length = 0;\n"
+    "      scopeDropped = 0;\n"
+    "      const ws = new WebSocket('ws://' + location.host + '/api/scope?rate=' + document.getElementById('scopeRate').value);\n"
+    "      ws.binaryType = 'arraybuffer';\n"
+    "      ws.onmessage = e => {\n"
+    "        // Header: version, channels, sample size, count, rate (u16), dropped (u16)\n"
+    "        const v = new DataView(e.data);\n"
+    "        const n = v.getUint8(1), size = v.getUint8(2), count = v.getUint8(3), hz = v.getUint16(4, true);\n"
+    "        const ch = parseInt(document.getElementById('scopeCh').value);\n"
+    "        scopeDropped += v.getUint16(6, true);\n"
+    "        for (let i = 0; i < count; i++) {\n"
+    "          const o = 8 + i * size;\n"
+    "          scopeBuf.push([v.getUint32(o, true), v.getUint16(o + 4 + ch * 2, true),\n"
+    "                         v.getUint16(o + 4 + (n + ch) * 2, true), v.getUint16(o + 4 + (2 * n + ch) * 2, true)]);\n"
+    "        }\n"
+    "        if (scopeBuf.length > hz * 2) scopeBuf.splice(0, scopeBuf.length - hz * 2);\n"
+    "        document.getElementById('scopeState').textContent = hz + ' Hz, ' + scopeDropped + ' dropped';\n"
+    "      };\n"
+    "      ws.onclose = () => {\n"
+    "        if (scopeWs && scopeWs !== ws) return;   // Replaced by a newer stream\n"
+    "        scopeWs = null;\n"
+    "        document.getElementById('scopeState').textContent = 'Stopped' + (scopeBuf.length ? '' : ' (not available while calibrating or on a receiver)');\n"
+    "      };\n"
+    "      scopeWs = ws;\n"
+    "      requestAnimationFrame(scopeDraw);\n"
+    "    }\n"
+    "    function scopeDraw() {\n"
+    "      const c = document.getElementById('scopeCanvas');\n"
+    "      const g = c.getContext('2d');\n"
+    "      g.fillStyle = '#111';\n"
+    "      g.fillRect(0, 0, c.width, c.height);\n"
+    "      if (scopeBuf.length > 1) {\n"
+    "        const t0 = scopeBuf[scopeBuf.length - 1][0];\n"
+    "        const series = [[1, '#888', s => s / 4095], [2, '#2196F3', s => s / 4095], [3, '#FF9800', s => (s - 1000) / 1000]];\n"
+    "        series.forEach(([k, color, norm]) => {\n"
+    "          g.strokeStyle = color;\n"
+    "          g.beginPath();\n"
+    "          scopeBuf.forEach((s, i) => {\n"
+    "            const x = c.width * (1 - ((t0 - s[0]) >>> 0) / 2000000);   // µs timestamps wrap: unsigned difference\n"
+    "            const y = c.height * (1 - norm(s[k]));\n"
+    "            if (i) g.lineTo(x, y); else g.moveTo(x, y);\n"
+    "          });\n"
+    "          g.stroke();\n"
+    "        });\n"
+    "      }\n"
+    "      if (scopeWs) requestAnimationFrame(scopeDraw);\n"
+    "    }\n"
+    "\n"
+    "    // Firmware upload: the file is streamed as the request body, throughput shown while it runs\n"
+    "    function otaUpload() {\n"
+    "      const file = document.getElementById('otaFile').files[0];\n"
+    "      const st = document.getElementById('otaState');\n"
+    "      const hmac = document.getElementById('otaHmac').value.trim().split(' ').pop();\n"
+    "      if (!file) return;\n"
+    "      if (!/^[0-9a-fA-F]{64}$/.test(hmac)) { st.textContent = 'Enter the 64-digit HMAC signature'; return; }\n"
+    "      const xhr = new XMLHttpRequest();\n"
+    "      const t0 = performance.now();\n"
+    "      xhr.upload.onprogress = e => {\n"
+    "        st.textContent = 'Uploading ' + (e.loaded / 1024).toFixed(0) + ' / ' + (e.total / 1024).toFixed(0) + ' KB, ' +\n"
+    "          (e.loaded / (performance.now() - t0)).toFixed(1) + ' kB/s';\n"
+    "      };\n"
+    "      xhr.onload = () => {\n"
+    "        if (xhr.status !== 200) { st.textContent = 'Update failed: ' + xhr.responseText; return; }\n"
+    "        const r = JSON.parse(xhr.responseText);\n"
+    "        st.textContent = r.message + ': ' + (r.bytes / 1024).toFixed(0) + ' KB in ' + (r.ms / 1000).toFixed(1) + ' s (' +\n"
+    "          r.kb_per_s + ' kB/s, ' + r.flash_ms + ' ms writing flash)';\n"
+    "      };\n"
+    "      xhr.onerror = () => st.textContent = 'Upload failed';\n"
+    "      xhr.open('POST', '/api/ota');\n"
+    "      xhr.setRequestHeader('Content-Type', 'application/octet-stream');\n"
+    "      xhr.setRequestHeader('X-OTA-HMAC', hmac);\n"
+    "      xhr.send(file);\n"
+    "    }\n"
+    "\n"
+    "    // Model profiles: every slot is listed, empty ones can be saved into\n"
+    "    function loadProfiles() {\n"
+    "      fetch('/api/profiles').then(r => r.json()).then(d => {\n"
+    "        const names = {};\n"
+    "        d.profiles.forEach(p => names[p.slot] = p.name);\n"
+    "        let opts = '';\n"
+    "        for (let i = 0; i < 8; i++) {\n"
+    "          opts += '<option value=\"' + i + '\">' + i + ': ' + (names[i] !== undefined ? names[i] : '(empty)') + (i == d.active ? ' *' : '') + '</option>';\n"
+    "        }\n"
+    "        const sel = document.getElementById('profSlot');\n"
+    "        sel.innerHTML = opts;\n"
+    "        sel.value = d.active;\n"
+    "        document.getElementById('profName').value = names[d.active] || '';\n"
+    "      });\n"
+    "    }\n"
+    "    function profile(action) {\n"
+    "      const slot = parseInt(document.getElementById('profSlot').value);\n"
+    "      fetch('/api/profiles', {\n"
+    "        method: 'POST',\n"
+    "        headers: { 'Content-Type': 'application/json' },\n"
+    "        body: JSON.stringify({ action: action, slot: slot, name: document.getElementById('profName').value })\n"
+    "      })\n"
+    "        .then(r => r.ok ? r.json() : r.text().then(t => { throw t; }))\n"
+    "        .then(r => { alert(r.message); if (action === 'select') location.reload(); else loadProfiles(); })\n"
+    "        .catch(e => alert('Error: ' + e));\n"
+    "    }\n"
+    "    loadProfiles();\n"
+    "\n"
+    "    // Channel mixer matrix editor\n"
+    "    (function() {\n"
+    "      let rows = '<tr><th></th>';\n"
+    "      for (let i = 1; i <= NUM_CH; i++) rows += '<th>In ' + i + '</th>';\n"
+    "      rows += '<th>Offset</th></tr>';\n"
+    "      for (let o = 0; o < NUM_CH; o++) {\n"
+    "        rows += '<tr><th>Out ' + (o + 1) + '</th>';\n"
+    "        for (let i = 0; i < NUM_CH; i++) rows += '<td><input type=\"number\" id=\"mw' + o + '_' + i + '\" min=\"-125\" max=\"125\"></td>';\n"
+    "        rows += '<td><input type=\"number\" id=\"mo' + o + '\" min=\"-125\" max=\"125\"></td></tr>';\n"
+    "      }\n"
+    "      document.getElementById('mixTable').innerHTML = rows;\n"
+    "      fetch('/api/mixer').then(r => r.json()).then(d => {\n"
+    "        document.getElementById('mixPreset').value = d.preset;\n"
+    "        for (let o = 0; o < NUM_CH; o++) {\n"
+    "          for (let i = 0; i < NUM_CH; i++) document.getElementById('mw' + o + '_' + i).value = d.weight[o][i];\n"
+    "          document.getElementById('mo' + o).value = d.offset[o];\n"
+    "        }\n"
+    "      });\n"
+    "    })();\n"
+    "    function saveMixer() {\n"
+    "      const weight = [], offset = [];\n"
+    "      for (let o = 0; o < NUM_CH; o++) {\n"
+    "        const row = [];\n"
+    "        for (let i = 0; i < NUM_CH; i++) row.push(parseInt(document.getElementById('mw' + o + '_' + i).value) || 0);\n"
+    "        weight.push(row);\n"
+    "        offset.push(parseInt(document.getElementById('mo' + o).value) || 0);\n"
+    "      }\n"
+    "      fetch('/api/mixer', {\n"
+    "        method: 'POST',\n"
+    "        headers: { 'Content-Type': 'application/json' },\n"
+    "        body: JSON.stringify({ preset: parseInt(document.getElementById('mixPreset').value), weight: weight, offset: offset })\n"
+    "      })\n"
+    "        .then(r => r.json())\n"
+    "        .then(r => alert(r.message))\n"
+    "        .catch(e => alert('Error: ' + e));\n"
+    "    }\n"
+    "\n"
     "    // Update status display every 500ms\n"
     "    setInterval(function() {\n"
     "      fetch('/api/status')\n"
@@ -307,9 +550,20 @@ static const char *html_page =
     "          if (d.free_heap) {\n"
     "            freeHeap.textContent = (d.free_heap / 1024).toFixed(1) + ' KB';\n"
     "          }\n"
+    "          if (d.blackbox) {\n"
+    "            const b = d.blackbox;\n"
+    "            document.getElementById('bbInfo').textContent = !b.available ? 'Not available (sender, or partition table without a blackbox partition)' :\n"
+    "              (b.used / 1024).toFixed(0) + ' of ' + (b.capacity / 1024).toFixed(0) + ' KB' +\n"
+    "              (b.rate_bps ? ', ' + b.rate_bps + ' B/s, about ' + b.minutes + ' min of history' : '') +\n"
+    "              (b.dropped ? ', ' + b.dropped + ' samples dropped' : '');\n"
+    "          }\n"
+    "          if (d.firmware) {\n"
+    "            document.getElementById('fwInfo').textContent = d.firmware.version + ' (' + d.firmware.partition +\n"
+    "              (d.firmware.pending_verify ? ', not yet kept' : '') + ')';\n"
+    "          }\n"
     "          \n"
     "          // Update channel bars and values (servo microseconds 1000-2000us)\n"
-    "          for (let i = 0; i < 6; i++) {\n"
+    "          for (let i = 0; i < NUM_CH; i++) {\n"
     "            const chNum = i + 1;\n"
     "            const us = d.servo_us[i];\n"
     "            const pct = ((us - 1000) / 1000 * 100).toFixed(0);\n"
@@ -355,14 +609,24 @@ static const char *html_page =
     "      .then(d => {\n"
     "        document.querySelector('[name=device_role]').value = d.device_role;\n"
     "        document.querySelector('[name=peer_mac]').value = d.peer_mac;\n"
+    "        document.getElementById('peer_bound').textContent = d.peer_bound ? 'bound' : 'not bound, double-press BOOT to bind';\n"
     "        document.querySelector('[name=channel]').value = d.channel;\n"
-    "        for (let i = 1; i <= 6; i++) {\n"
-    "          document.querySelector('[name=ch' + i + '_min]').value = d['ch' + i + '_min'];\n"
-    "          document.querySelector('[name=ch' + i + '_max]').value = d['ch' + i + '_max'];\n"
-    "          document.querySelector('[name=ch' + i + '_smin]').value = d['ch' + i + '_smin'];\n"
-    "          document.querySelector('[name=ch' + i + '_sctr]').value = d['ch' + i + '_sctr'];\n"
-    "          document.querySelector('[name=ch' + i + '_smax]').value = d['ch' + i + '_smax'];\n"
-    "          document.querySelector('[name=ch' + i + '_expo]').value = d['ch' + i + '_expo'];\n"
+    "        document.querySelector('[name=out_rate]').value = d.out_rate;\n"
+    "        document.querySelector('[name=out_extrap]').value = d.out_extrap;\n"
+    "        document.querySelector('[name=ser_proto]').value = d.ser_proto;\n"
+    "        document.querySelector('[name=in_src]').value = d.in_src;\n"
+    "        document.querySelector('[name=rate_min]').value = d.rate_min;\n"
+    "        document.querySelector('[name=rate_max]').value = d.rate_max;\n"
+    "        document.querySelector('[name=ser_rate]').value = d.ser_rate;\n"
+    "        document.querySelector('[name=pwr_mode]').value = d.pwr_mode;\n"
+    "        document.querySelector('[name=pwr_budget]').value = d.pwr_budget;\n"
+    "        document.querySelector('[name=link_sec]').value = d.link_sec;\n"
+    "        document.getElementById('link_key_id').textContent = d.link_key_id === '00000000' ? 'none' : d.link_key_id;\n"
+    "        for (let i = 1; i <= NUM_CH; i++) {\n"
+    "          ['min', 'max', 'smin', 'sctr', 'smax', 'expo', 'ctr', 'dbnd', 'trim', 'filt', 'fstr', 'rev', 'slew', 'pwmhz'].forEach(k => {\n"
+    "            const el = document.querySelector('[name=ch' + i + '_' + k + ']');\n"
+    "            if (el) el.value = d['ch' + i + '_' + k];\n"
+    "          });\n"
     "        }\n"
     "      });\n"
     "  </script>\n"
@@ -0,0 +1,190 @@
+// Host tests for the ADC linearization table (src/adc_lut.c): pio test -e native
+// The calibration is modelled as a straight line plus a bend at each end of
+// the range, as seen at 12 dB attenuation, and reports whole millivolts like
+// the ESP-IDF calibration schemes.
+#include <unity.h>
+#include <stdlib.h>
+#include "adc_lut.h"
+
+typedef struct {
+    int bits;
+    float mv_lo;                        // Line at raw 0
+    float mv_span;                      // Line from raw 0 to full scale
+    float bend_lo;                      // Extra mV at raw 0, fading out within the first quarter
+    float bend_hi;                      // mV lost at full scale, fading in over the last quarter
+    int fail_at;                        // Raw code the calibration refuses (-1: none)
+} curve_t;
+
+static adc_lut_t lut;
+
+static float pow12(float x) {
+    float x2 = x * x;
+    float x4 = x2 * x2;
+    return x4 * x4 * x4;
+}
+
+static float curve_mv(const curve_t *c, int raw) {
+    float x = (float)raw / (float)((1 << c->bits) - 1);
+    return c->mv_lo + c->mv_span * x + c->bend_lo * pow12(1.0f - x) - c->bend_hi * pow12(x);
+}
+
+static bool curve_cali(void *ctx, int raw, int *mv) {
+    const curve_t *c = ctx;
+    if (raw == c->fail_at) {
+        return false;
+    }
+    *mv = (int)(curve_mv(c, raw) + 0.5f);
+    return true;
+}
+
+static bool flat_cali(void *ctx, int raw, int *mv) {
+    (void)ctx;
+    (void)raw;
+    *mv = 1500;
+    return true;
+}
+
+// Stick position proportional to the modelled voltage, 0..ADC_MAX_VALUE
+static float ideal(const curve_t *c, int raw) {
+    float lo = curve_mv(c, 0);
+    float hi = curve_mv(c, (1 << c->bits) - 1);
+    return (curve_mv(c, raw) - lo) / (hi - lo) * ADC_MAX_VALUE;
+}
+
+static float abs_f(float v) {
+    return v < 0.0f ? -v : v;
+}
+
+// Largest table error against the model, and against a table taken straight
+// from the whole-millivolt readings code by code
+static void errors(const curve_t *c, float *table_err, float *per_code_err) {
+    int size = 1 << c->bits;
+    int lo = (int)(curve_mv(c, 0) + 0.5f);
+    int hi = (int)(curve_mv(c, size - 1) + 0.5f);
+    *table_err = 0.0f;
+    *per_code_err = 0.0f;
+    for (int r = 0; r < size; r++) {
+        float want = ideal(c, r);
+        float e = abs_f(adc_lut_apply(&lut, r) - want);
+        if (e > *table_err) {
+            *table_err = e;
+        }
+        int mv = (int)(curve_mv(c, r) + 0.5f);
+        int step = (int)((float)(mv - lo) * ADC_MAX_VALUE / (hi - lo) + 0.5f);
+        e = abs_f(step - want);
+        if (e > *per_code_err) {
+            *per_code_err = e;
+        }
+    }
+}
+
+static void assert_non_decreasing(void) {
+    for (int r = 1; r < lut.size; r++) {
+        TEST_ASSERT_TRUE(lut.code[r] >= lut.code[r - 1]);
+    }
+}
+
+void setUp(void) {
+    lut = (adc_lut_t){0};
+}
+
+void tearDown(void) {
+    adc_lut_free(&lut);
+}
+
+static void test_bent_curve_is_linearized(void) {
+    // Bends of about 80 to 330 counts at the ends of the range
+    static const curve_t curves[] = {
+        {12, 140.0f, 2900.0f, 60.0f, 0.0f, -1},
+        {12, 140.0f, 2900.0f, 0.0f, 230.0f, -1},
+        {12, 100.0f, 2950.0f, 60.0f, 230.0f, -1},
+        {13, 100.0f, 2950.0f, 60.0f, 230.0f, -1},
+    };
+    for (int i = 0; i < (int)(sizeof(curves) / sizeof(curves[0])); i++) {
+        const curve_t *c = &curves[i];
+        TEST_ASSERT_TRUE(adc_lut_build(&lut, c->bits, curve_cali, (void *)c));
+        TEST_ASSERT_TRUE(lut.calibrated);
+        TEST_ASSERT_EQUAL_UINT16(1 << c->bits, lut.size);
+        TEST_ASSERT_EQUAL_UINT16(0, adc_lut_apply(&lut, 0));
+        TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, adc_lut_apply(&lut, lut.size - 1));
+        assert_non_decreasing();
+        float table_err, per_code_err;
+        errors(c, &table_err, &per_code_err);
+        TEST_ASSERT_TRUE(table_err <= 1.25f);  // About one count, the 12-bit output step
+        TEST_ASSERT_TRUE(table_err < per_code_err);
+        TEST_ASSERT_INT_WITHIN(1, (int)(curve_mv(c, 0) + 0.5f), lut.mv_lo);
+        TEST_ASSERT_INT_WITHIN(1, (int)(curve_mv(c, lut.size - 1) + 0.5f), lut.mv_hi);
+    }
+}
+
+static void test_no_calibration_rescales(void) {
+    TEST_ASSERT_TRUE(adc_lut_build(&lut, 13, NULL, NULL));
+    TEST_ASSERT_FALSE(lut.calibrated);
+    TEST_ASSERT_EQUAL_UINT16(0, adc_lut_apply(&lut, 0));
+    TEST_ASSERT_EQUAL_UINT16(2048, adc_lut_apply(&lut, 4096));
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, adc_lut_apply(&lut, 8191));
+    assert_non_decreasing();
+}
+
+static void test_failing_calibration_rescales(void) {
+    curve_t c = {12, 140.0f, 2900.0f, 60.0f, 230.0f, 3000};
+    TEST_ASSERT_TRUE(adc_lut_build(&lut, 12, curve_cali, &c));
+    TEST_ASSERT_FALSE(lut.calibrated);
+    TEST_ASSERT_EQUAL_UINT16(0, lut.mv_lo);
+    for (int r = 0; r < lut.size; r++) {
+        TEST_ASSERT_EQUAL_UINT16(r, adc_lut_apply(&lut, r));
+    }
+}
+
+static void test_flat_calibration_rescales(void) {
+    TEST_ASSERT_TRUE(adc_lut_build(&lut, 12, flat_cali, NULL));
+    TEST_ASSERT_FALSE(lut.calibrated);
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, adc_lut_apply(&lut, 4095));
+}
+
+static void test_rebuild_at_other_width(void) {
+    curve_t c = {12, 140.0f, 2900.0f, 60.0f, 230.0f, -1};
+    TEST_ASSERT_TRUE(adc_lut_build(&lut, 12, curve_cali, &c));
+    c.bits = 13;
+    TEST_ASSERT_TRUE(adc_lut_build(&lut, 13, curve_cali, &c));
+    TEST_ASSERT_EQUAL_UINT16(8192, lut.size);
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, adc_lut_apply(&lut, 8191));
+    assert_non_decreasing();
+}
+
+static void test_raw_out_of_range_is_clamped(void) {
+    TEST_ASSERT_TRUE(adc_lut_build(&lut, 12, NULL, NULL));
+    TEST_ASSERT_EQUAL_UINT16(0, adc_lut_apply(&lut, -5));
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, adc_lut_apply(&lut, 5000));
+}
+
+static void test_without_table_raw_is_shifted(void) {
+    // What adc_lut_build() leaves when the table cannot be allocated
+    TEST_ASSERT_TRUE(adc_lut_build(&lut, 13, NULL, NULL));
+    adc_lut_init_shift(&lut, 13);
+    TEST_ASSERT_NULL(lut.code);
+    TEST_ASSERT_FALSE(lut.calibrated);
+    TEST_ASSERT_EQUAL_UINT16(0, adc_lut_apply(&lut, 1));
+    TEST_ASSERT_EQUAL_UINT16(2048, adc_lut_apply(&lut, 4096));
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, adc_lut_apply(&lut, 8191));
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, adc_lut_apply(&lut, 9000));
+
+    adc_lut_init_shift(&lut, 12);
+    TEST_ASSERT_EQUAL_UINT16(1234, adc_lut_apply(&lut, 1234));
+
+    adc_lut_init_shift(&lut, 10);
+    TEST_ASSERT_EQUAL_UINT16(4092, adc_lut_apply(&lut, 1023));
+    TEST_ASSERT_EQUAL_UINT16(0, adc_lut_apply(&lut, -1));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bent_curve_is_linearized);
+    RUN_TEST(test_no_calibration_rescales);
+    RUN_TEST(test_failing_calibration_rescales);
+    RUN_TEST(test_flat_calibration_rescales);
+    RUN_TEST(test_rebuild_at_other_width);
+    RUN_TEST(test_raw_out_of_range_is_clamped);
+    RUN_TEST(test_without_table_raw_is_shifted);
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+// Host tests for the control frame packing (src/control_packet.h) and the
+// frame lengths documented in channel_config.h: pio test -e native
+// The control frame itself is checked at the build's channel count (16 in the
+// native env); every documented layout is checked through rc_pack_12bit(),
+// which control_packet_pack() uses.
+#include <unity.h>
+#include <string.h>
+#include "control_packet.h"
+
+#define GUARD 0xA5
+
+// Channel count -> control frame bytes on air (channel_config.h, README)
+static const struct {
+    int channels;
+    int wire_len;
+} LAYOUTS[] = {
+    {6, 10},
+    {8, 13},
+    {12, 19},
+    {16, 25},
+};
+#define NUM_LAYOUTS ((int)(sizeof(LAYOUTS) / sizeof(LAYOUTS[0])))
+
+static uint32_t rng = 41;
+
+static uint16_t next_value(void) {
+    rng = rng * 1103515245u + 12345u;
+    return (uint16_t)((rng >> 16) & 0x0FFF);
+}
+
+void setUp(void) {
+    rng = 41;
+}
+
+void tearDown(void) {
+}
+
+static void test_wire_len_of_this_build(void) {
+    // NUM_CHANNELS is a documented count, and the frame has its length
+    int l = 0;
+    while (l < NUM_LAYOUTS && LAYOUTS[l].channels != NUM_CHANNELS) {
+        l++;
+    }
+    TEST_ASSERT_TRUE(l < NUM_LAYOUTS);
+    TEST_ASSERT_EQUAL_INT(LAYOUTS[l].wire_len, CONTROL_WIRE_LEN);
+    TEST_ASSERT_EQUAL_INT(LAYOUTS[l].wire_len - 1, CONTROL_CH_BYTES);
+}
+
+static void test_documented_lengths_match_packer(void) {
+    // Bytes written by the packer plus the lights byte, for each documented count
+    for (int l = 0; l < NUM_LAYOUTS; l++) {
+        int n = LAYOUTS[l].channels;
+        uint16_t values[16];
+        uint8_t out[32];
+        for (int i = 0; i < n; i++) {
+            values[i] = 0x0FFF;
+        }
+        memset(out, GUARD, sizeof(out));
+        rc_pack_12bit(values, n, out);
+        int written = 0;
+        for (int i = 0; i < (int)sizeof(out); i++) {
+            if (out[i] != GUARD) {
+                written = i + 1;
+            }
+        }
+        TEST_ASSERT_EQUAL_INT(LAYOUTS[l].wire_len, written + 1);
+        TEST_ASSERT_EQUAL_INT(LAYOUTS[l].wire_len, (n * CONTROL_CH_BITS + 7) / 8 + 1);
+    }
+}
+
+static void test_random_frames_round_trip_at_each_count(void) {
+    for (int l = 0; l < NUM_LAYOUTS; l++) {
+        int n = LAYOUTS[l].channels;
+        for (int f = 0; f < 1000; f++) {
+            uint16_t values[16], back[16];
+            uint8_t out[32];
+            for (int i = 0; i < n; i++) {
+                values[i] = next_value();
+            }
+            memset(out, GUARD, sizeof(out));
+            rc_pack_12bit(values, n, out);
+            // Nothing written into the lights byte or past it
+            TEST_ASSERT_EQUAL_HEX8(GUARD, out[LAYOUTS[l].wire_len - 1]);
+            rc_unpack_12bit(out, n, back);
+            TEST_ASSERT_EQUAL_UINT16_ARRAY(values, back, n);
+        }
+    }
+}
+
+static void test_control_packet_round_trip(void) {
+    for (int f = 0; f < 1000; f++) {
+        control_packet_t pkt, back;
+        uint8_t out[CONTROL_WIRE_LEN + 1];
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            pkt.ch[i] = next_value();
+        }
+        pkt.lights = (uint8_t)(f & 0x0F);
+        pkt.rate = (uint8_t)((f >> 4) & 0x0F);
+        out[CONTROL_WIRE_LEN] = GUARD;
+        control_packet_pack(&pkt, out);
+        TEST_ASSERT_EQUAL_HEX8(GUARD, out[CONTROL_WIRE_LEN]);
+        control_packet_unpack(out, &back);
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(pkt.ch, back.ch, NUM_CHANNELS);
+        TEST_ASSERT_EQUAL_UINT8(pkt.lights, back.lights);
+        TEST_ASSERT_EQUAL_UINT8(pkt.rate, back.rate);
+    }
+}
+
+static void test_lights_and_rate_share_last_byte(void) {
+    control_packet_t pkt = {0};
+    uint8_t out[CONTROL_WIRE_LEN];
+    pkt.lights = 0xFA;                  // Only bits 0-3 are lights
+    pkt.rate = 0x09;
+    control_packet_pack(&pkt, out);
+    TEST_ASSERT_EQUAL_HEX8(0x9A, out[CONTROL_CH_BYTES]);
+    for (int i = 0; i < CONTROL_CH_BYTES; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0x00, out[i]);
+    }
+}
+
+static void test_channel_order_on_air(void) {
+    // CH1 takes the first byte and the low nibble of the second
+    control_packet_t pkt = {0};
+    uint8_t out[CONTROL_WIRE_LEN];
+    pkt.ch[0] = 0x0ABC;
+    pkt.ch[1] = 0x0123;
+    control_packet_pack(&pkt, out);
+    TEST_ASSERT_EQUAL_HEX8(0xBC, out[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x3A, out[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x12, out[2]);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_wire_len_of_this_build);
+    RUN_TEST(test_documented_lengths_match_packer);
+    RUN_TEST(test_random_frames_round_trip_at_each_count);
+    RUN_TEST(test_control_packet_round_trip);
+    RUN_TEST(test_lights_and_rate_share_last_byte);
+    RUN_TEST(test_channel_order_on_air);
+    return UNITY_END();
+}
@@ -0,0 +1,276 @@
+// Host tests for the event frame retry logic (src/event_frame.c) and a model
+// of button press to light output latency: pio test -e native
+// The model runs the real retry state against a link that loses each frame
+// (and each ack) with a fixed probability. Periodic control frames every
+// FRAME_US also carry the state. The "old" column is the scheme before event
+// frames: one extra control frame at the press, then the periodic frames.
+// The table it prints is the one quoted in the README (Event Frames).
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "event_frame.h"
+
+#define FRAME_US 20000                  // 50 Hz control frames
+#define AIR_US 600                      // esp_now_send() to the receiver task
+#define APPLY_US 200                    // Receiver task to light GPIO written
+#define PRESSES 20000
+
+static event_tx_t tx;
+static uint32_t rng;
+
+static uint32_t next_rand(void) {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+// True with probability loss_pct / 100
+static bool lost(int loss_pct) {
+    return (int)(next_rand() % 100) < loss_pct;
+}
+
+static event_msg_t ack_for(const event_msg_t *msg) {
+    event_msg_t ack;
+    event_msg_init(&ack, EVENT_MSG_ACK, msg->seq, msg->lights);
+    return ack;
+}
+
+void setUp(void) {
+    rng = 7;
+    event_tx_init(&tx, 100);
+}
+
+void tearDown(void) {
+}
+
+static void test_post_sends_at_once(void) {
+    event_msg_t msg;
+    uint32_t wait;
+    TEST_ASSERT_FALSE(event_tx_wait_us(&tx, 0, &wait));
+    event_tx_post(&tx, 0x05, 1000, 1000);
+    TEST_ASSERT_TRUE(event_tx_wait_us(&tx, 1000, &wait));
+    TEST_ASSERT_EQUAL_UINT32(0, wait);
+    TEST_ASSERT_TRUE(event_tx_next(&tx, 1000, &msg));
+    TEST_ASSERT_TRUE(event_msg_valid(&msg, EVENT_MSG_STATE));
+    TEST_ASSERT_EQUAL_UINT8(0x05, msg.lights);
+    TEST_ASSERT_EQUAL_UINT16(101, msg.seq);
+    TEST_ASSERT_FALSE(event_tx_next(&tx, 1000, &msg));
+    TEST_ASSERT_TRUE(event_tx_wait_us(&tx, 2000, &wait));
+    TEST_ASSERT_EQUAL_UINT32(EVENT_RETRY_US - 1000, wait);
+}
+
+static void test_retries_then_expires(void) {
+    event_msg_t msg;
+    uint32_t now = 0;
+    event_tx_post(&tx, 0x01, now, now);
+    for (int i = 0; i < EVENT_MAX_SENDS; i++) {
+        if (i > 0) {
+            TEST_ASSERT_FALSE(event_tx_next(&tx, now - 1, &msg));
+        }
+        TEST_ASSERT_TRUE(event_tx_next(&tx, now, &msg));
+        now += EVENT_RETRY_US;
+    }
+    TEST_ASSERT_FALSE(event_tx_next(&tx, now, &msg));
+    TEST_ASSERT_FALSE(tx.pending);
+    TEST_ASSERT_EQUAL_UINT32(EVENT_MAX_SENDS, tx.stats.frames);
+    TEST_ASSERT_EQUAL_UINT32(EVENT_MAX_SENDS - 1, tx.stats.retries);
+    TEST_ASSERT_EQUAL_UINT32(1, tx.stats.expired);
+    // All sends fit in one frame interval
+    TEST_ASSERT_TRUE((EVENT_MAX_SENDS - 1) * EVENT_RETRY_US < FRAME_US);
+}
+
+static void test_ack_stops_retries(void) {
+    event_msg_t msg;
+    event_tx_post(&tx, 0x03, 500, 1000);
+    TEST_ASSERT_TRUE(event_tx_next(&tx, 1000, &msg));
+    event_msg_t ack = ack_for(&msg);
+    ack.apply_us = 180;
+    TEST_ASSERT_TRUE(event_tx_ack(&tx, &ack, 2500));
+    TEST_ASSERT_FALSE(tx.pending);
+    TEST_ASSERT_EQUAL_UINT32(2000, tx.stats.ack_last_us);
+    TEST_ASSERT_EQUAL_UINT32(180, tx.stats.apply_last_us);
+    TEST_ASSERT_FALSE(event_tx_next(&tx, 1000 + EVENT_RETRY_US, &msg));
+    // A duplicate ack matches nothing
+    TEST_ASSERT_FALSE(event_tx_ack(&tx, &ack, 2600));
+    TEST_ASSERT_EQUAL_UINT32(1, tx.stats.acked);
+}
+
+static void test_stale_and_foreign_acks_ignored(void) {
+    event_msg_t first, second;
+    event_tx_post(&tx, 0x01, 0, 0);
+    TEST_ASSERT_TRUE(event_tx_next(&tx, 0, &first));
+    event_tx_post(&tx, 0x02, 1000, 1000);
+    TEST_ASSERT_EQUAL_UINT32(1, tx.stats.superseded);
+    TEST_ASSERT_TRUE(event_tx_next(&tx, 1000, &second));
+    event_msg_t ack = ack_for(&first);
+    TEST_ASSERT_FALSE(event_tx_ack(&tx, &ack, 1500));
+    ack = ack_for(&second);
+    ack.type = EVENT_MSG_RESYNC;
+    TEST_ASSERT_FALSE(event_tx_ack(&tx, &ack, 1500));
+    ack = ack_for(&second);
+    ack.magic[1] = 'X';
+    TEST_ASSERT_FALSE(event_tx_ack(&tx, &ack, 1500));
+    ack = ack_for(&second);
+    TEST_ASSERT_TRUE(event_tx_ack(&tx, &ack, 1500));
+}
+
+static void test_ack_before_first_send_ignored(void) {
+    // A change posted but not sent yet cannot be acked by the previous event's ack
+    event_msg_t msg;
+    event_tx_post(&tx, 0x01, 0, 0);
+    TEST_ASSERT_TRUE(event_tx_next(&tx, 0, &msg));
+    event_tx_post(&tx, 0x02, 100, 100);
+    TEST_ASSERT_EQUAL_UINT32(1, tx.stats.superseded);
+    msg.seq = tx.seq;
+    event_msg_t ack = ack_for(&msg);
+    TEST_ASSERT_FALSE(event_tx_ack(&tx, &ack, 200));
+    // A change replaced before its first frame is not counted as superseded
+    event_tx_post(&tx, 0x03, 300, 300);
+    TEST_ASSERT_EQUAL_UINT32(1, tx.stats.superseded);
+}
+
+static void test_wraps_around_timer(void) {
+    event_msg_t msg;
+    uint32_t now = UINT32_MAX - 1000;
+    event_tx_post(&tx, 0x01, now, now);
+    TEST_ASSERT_TRUE(event_tx_next(&tx, now, &msg));
+    TEST_ASSERT_FALSE(event_tx_next(&tx, now + EVENT_RETRY_US - 1, &msg));
+    TEST_ASSERT_TRUE(event_tx_next(&tx, now + EVENT_RETRY_US, &msg));
+}
+
+typedef struct {
+    uint32_t mean_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} latency_t;
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static latency_t summarize(uint32_t *lat, int n) {
+    uint64_t sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += lat[i];
+    }
+    qsort(lat, n, sizeof(lat[0]), cmp_u32);
+    return (latency_t){(uint32_t)(sum / n), lat[n * 99 / 100], lat[n - 1]};
+}
+
+// Before event frames: an extra control frame at the press, then the
+// periodic frames at FRAME_US, FRAME_US * 2, ...
+static uint32_t old_latency(uint32_t press_us, int loss_pct) {
+    uint32_t t = press_us;
+    uint32_t next = FRAME_US;
+    while (lost(loss_pct)) {
+        t = next;
+        next += FRAME_US;
+    }
+    return t - press_us + AIR_US + APPLY_US;
+}
+
+// Event frames: the press is posted, frames go out when event_tx_next() says
+// so, acks come back AIR_US after the lights are written. Runs until the
+// output changed and the event was acked or expired.
+static uint32_t event_latency(uint32_t press_us, int loss_pct) {
+    uint32_t now = press_us;
+    uint32_t periodic = FRAME_US;
+    uint32_t out = 0;
+    event_tx_post(&tx, (uint8_t)(tx.lights ^ 1), press_us, press_us);
+    for (;;) {
+        uint32_t wait;
+        bool pending = event_tx_wait_us(&tx, now, &wait);
+        if (!pending && out != 0) {
+            return out - press_us;
+        }
+        if (!pending || periodic <= now + wait) {
+            now = periodic;
+            periodic += FRAME_US;
+            if (!lost(loss_pct) && out == 0) {
+                out = now + AIR_US + APPLY_US;
+            }
+            continue;
+        }
+        now += wait;
+        event_msg_t msg;
+        if (!event_tx_next(&tx, now, &msg) || lost(loss_pct)) {
+            continue;                   // Expired, or the frame was lost
+        }
+        uint32_t applied = now + AIR_US + APPLY_US;
+        if (out == 0) {
+            out = applied;
+        }
+        if (!lost(loss_pct)) {
+            event_msg_t ack = ack_for(&msg);
+            ack.apply_us = APPLY_US;
+            TEST_ASSERT_TRUE(event_tx_ack(&tx, &ack, applied + AIR_US));
+        }
+    }
+}
+
+static void run_model(int loss_pct, latency_t *old, latency_t *ev, float *frames_per_event) {
+    static uint32_t old_lat[PRESSES];
+    static uint32_t ev_lat[PRESSES];
+    for (int i = 0; i < PRESSES; i++) {
+        uint32_t press = next_rand() % FRAME_US;
+        old_lat[i] = old_latency(press, loss_pct);
+        ev_lat[i] = event_latency(press, loss_pct);
+    }
+    TEST_ASSERT_EQUAL_UINT32(PRESSES, tx.stats.events);
+    TEST_ASSERT_EQUAL_UINT32(PRESSES, tx.stats.acked + tx.stats.expired);
+    *old = summarize(old_lat, PRESSES);
+    *ev = summarize(ev_lat, PRESSES);
+    *frames_per_event = (float)tx.stats.frames / PRESSES;
+    printf("loss %2d%%: old mean %4.1f p99 %4.1f ms | events mean %4.1f p99 %4.1f max %4.1f ms, "
+           "%.2f frames per event\n", loss_pct, old->mean_us / 1000.0, old->p99_us / 1000.0,
+           ev->mean_us / 1000.0, ev->p99_us / 1000.0, ev->max_us / 1000.0, *frames_per_event);
+}
+
+static void test_model_without_loss(void) {
+    latency_t old, ev;
+    float frames;
+    run_model(0, &old, &ev, &frames);
+    TEST_ASSERT_EQUAL_UINT32(AIR_US + APPLY_US, ev.max_us);
+    TEST_ASSERT_EQUAL_UINT32(AIR_US + APPLY_US, old.max_us);
+    TEST_ASSERT_EQUAL_UINT32(PRESSES, tx.stats.frames);
+    TEST_ASSERT_TRUE(frames == 1.0f);
+}
+
+static void test_model_with_loss(void) {
+    // Loss per frame, and upper bounds for the event frame column (README)
+    static const struct {
+        int loss_pct;
+        uint32_t mean_max_us;
+        uint32_t p99_max_us;
+        float frames_max;
+    } cases[] = {
+        {5, 1200, 6000, 1.20f},
+        {20, 2200, 11000, 1.60f},
+        {40, 4200, 25000, 2.40f},
+    };
+    for (int i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); i++) {
+        latency_t old, ev;
+        float frames;
+        event_tx_init(&tx, 100);
+        run_model(cases[i].loss_pct, &old, &ev, &frames);
+        TEST_ASSERT_TRUE(ev.mean_us <= cases[i].mean_max_us);
+        TEST_ASSERT_TRUE(ev.p99_us <= cases[i].p99_max_us);
+        TEST_ASSERT_TRUE(frames <= cases[i].frames_max);
+        TEST_ASSERT_TRUE(ev.mean_us < old.mean_us);
+        TEST_ASSERT_TRUE(ev.p99_us < old.p99_us);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_post_sends_at_once);
+    RUN_TEST(test_retries_then_expires);
+    RUN_TEST(test_ack_stops_retries);
+    RUN_TEST(test_stale_and_foreign_acks_ignored);
+    RUN_TEST(test_ack_before_first_send_ignored);
+    RUN_TEST(test_wraps_around_timer);
+    RUN_TEST(test_model_without_loss);
+    RUN_TEST(test_model_with_loss);
+    return UNITY_END();
+}
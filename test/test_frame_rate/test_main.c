@@ -0,0 +1,327 @@
+// Host tests for the sender frame rate controller (src/frame_rate.c) and a
+// simulation of it against a synthetic stick trace: pio test -e native
+// The trace holds still, flicks full travel, steers slowly, makes quick
+// corrections and holds still again, with +-2 units of ADC noise. Samples
+// are taken when frame_rate_wait_us() says, with up to 100 us of jitter.
+#include <unity.h>
+#include <string.h>
+#include "frame_rate.h"
+
+#define SAMPLE_US (1000000 / FRAME_RATE_DEFAULT_MAX_HZ)
+#define CENTER 2048
+
+static frame_rate_t fr;
+static uint16_t ch[NUM_CHANNELS];
+static uint32_t rng;
+
+static uint32_t next_rand(void) {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+// True with probability pct / 100
+static bool chance(int pct) {
+    return (int)(next_rand() % 100) < pct;
+}
+
+// Triangle wave between -amp and +amp
+static int triangle(uint32_t t_us, uint32_t period_us, int amp) {
+    uint32_t phase = t_us % period_us;
+    int64_t x = (int64_t)phase * 4 * amp / period_us;
+    if (x < amp) {
+        return (int)x;
+    }
+    if (x < 3 * amp) {
+        return (int)(2 * amp - x);
+    }
+    return (int)(x - 4 * amp);
+}
+
+static uint16_t stick(uint32_t t_us) {
+    if (t_us < 2000000) {
+        return CENTER;                              // Still
+    }
+    if (t_us < 2100000) {
+        return (uint16_t)(CENTER + (t_us - 2000000) * 2000 / 100000);   // Flick
+    }
+    if (t_us < 3000000) {
+        return CENTER + 2000;
+    }
+    if (t_us < 5000000) {
+        return (uint16_t)(CENTER + triangle(t_us - 3000000, 2000000, 600));  // Slow steering
+    }
+    if (t_us < 6000000) {
+        return (uint16_t)(CENTER + triangle(t_us - 5000000, 300000, 1500));  // Quick corrections
+    }
+    return CENTER;
+}
+
+static void set_sticks(uint16_t value) {
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        ch[i] = CENTER;
+    }
+    ch[0] = value;
+}
+
+typedef struct {
+    int loss_pct;                       // Frames lost on air, at random
+    int fail_pct;                       // Sends failing in [fail_from_us, fail_to_us)
+    uint32_t fail_from_us;
+    uint32_t fail_to_us;
+    uint32_t end_us;
+} sim_t;
+
+typedef struct {
+    int frames;
+    int frames_still;                   // In 0.5-2 s, after the start
+    int frames_still_end;               // In the last second
+    uint32_t flick_frame_us;            // First frame after the flick starts
+    uint8_t flick_code;
+    uint32_t max_late_us;               // Longest gap past the announced interval
+    int timeouts;                       // Receiver timeouts while frames still arrive
+    uint16_t ceiling_at_us[16];         // Ceiling at each half second
+} sim_result_t;
+
+static void simulate(const sim_t *sim, sim_result_t *res) {
+    memset(res, 0, sizeof(*res));
+    frame_rate_configure(&fr, FRAME_RATE_DEFAULT_MIN_HZ, FRAME_RATE_DEFAULT_MAX_HZ);
+    uint32_t now = 1000;
+    uint32_t prev_frame = 0;
+    uint8_t prev_code = 0;
+    uint32_t rx_last = 0;
+    uint8_t rx_code = 0;
+    uint32_t sent = 0, failed = 0;
+    while (now < sim->end_us) {
+        set_sticks((uint16_t)(stick(now) + next_rand() % 5 - 2));
+        frame_rate_tx_done(&fr, sent, failed, now);
+        sent = 0;
+        failed = 0;
+        uint8_t code;
+        if (frame_rate_sample(&fr, ch, now, &code)) {
+            res->frames++;
+            if (now >= 500000 && now < 2000000) {
+                res->frames_still++;
+            }
+            if (now >= sim->end_us - 1000000) {
+                res->frames_still_end++;
+            }
+            if (now >= 2000000 && res->flick_frame_us == 0) {
+                res->flick_frame_us = now;
+                res->flick_code = code;
+            }
+            if (prev_frame != 0) {
+                uint32_t gap = now - prev_frame;
+                uint32_t interval = frame_rate_interval_us(prev_code);
+                if (gap > interval && gap - interval > res->max_late_us) {
+                    res->max_late_us = gap - interval;
+                }
+            }
+            prev_frame = now;
+            prev_code = code;
+
+            bool fail = now >= sim->fail_from_us && now < sim->fail_to_us && chance(sim->fail_pct);
+            sent++;
+            failed += fail;
+            if (!fail && !chance(sim->loss_pct)) {
+                // Receiver: the link timeout follows the rate the last frame announced
+                if (rx_last != 0 && now - rx_last > frame_rate_timeout_ms(rx_code, 1000) * 1000) {
+                    res->timeouts++;
+                }
+                rx_last = now;
+                rx_code = code;
+            }
+        }
+        int slot = (int)(now / 500000);
+        if (slot < 16) {
+            res->ceiling_at_us[slot] = fr.stats.ceiling_hz;
+        }
+        now += frame_rate_wait_us(&fr, now) + next_rand() % 100;
+    }
+}
+
+void setUp(void) {
+    rng = 3;
+    set_sticks(CENTER);
+}
+
+void tearDown(void) {
+}
+
+static void test_code_table(void) {
+    TEST_ASSERT_EQUAL_UINT16(0, frame_rate_hz(0));
+    TEST_ASSERT_EQUAL_UINT32(0, frame_rate_interval_us(0));
+    TEST_ASSERT_EQUAL_UINT16(FRAME_RATE_MIN_HZ, frame_rate_hz(1));
+    TEST_ASSERT_EQUAL_UINT16(FRAME_RATE_MAX_HZ, frame_rate_hz(FRAME_RATE_CODES - 1));
+    TEST_ASSERT_EQUAL_UINT16(0, frame_rate_hz(FRAME_RATE_CODES));
+    TEST_ASSERT_EQUAL_UINT32(20000, frame_rate_interval_us(frame_rate_code(50)));
+    // Lowest code at or above, clamped to the table
+    TEST_ASSERT_EQUAL_UINT16(60, frame_rate_hz(frame_rate_code(51)));
+    TEST_ASSERT_EQUAL_UINT16(10, frame_rate_hz(frame_rate_code(0)));
+    TEST_ASSERT_EQUAL_UINT16(300, frame_rate_hz(frame_rate_code(1000)));
+    // Neighbours differ by at most 1.5x
+    for (uint8_t c = 2; c < FRAME_RATE_CODES; c++) {
+        TEST_ASSERT_TRUE(frame_rate_hz(c) * 2 <= frame_rate_hz(c - 1) * 3);
+        TEST_ASSERT_TRUE(frame_rate_hz(c) > frame_rate_hz(c - 1));
+    }
+}
+
+static void test_configure_rounds_and_swaps(void) {
+    frame_rate_configure(&fr, 12, 90);
+    TEST_ASSERT_EQUAL_UINT16(15, fr.stats.min_hz);
+    TEST_ASSERT_EQUAL_UINT16(75, fr.stats.max_hz);      // Upper bound rounds down
+    frame_rate_configure(&fr, 100, 20);
+    TEST_ASSERT_EQUAL_UINT16(20, fr.stats.min_hz);
+    TEST_ASSERT_EQUAL_UINT16(100, fr.stats.max_hz);
+    frame_rate_configure(&fr, 55, 55);                  // Fixed rate, not crossing
+    TEST_ASSERT_EQUAL_UINT16(60, fr.stats.min_hz);
+    TEST_ASSERT_EQUAL_UINT16(60, fr.stats.max_hz);
+    TEST_ASSERT_EQUAL_UINT16(60, fr.stats.ceiling_hz);
+}
+
+static void test_first_and_forced_samples_are_frames(void) {
+    uint8_t code;
+    frame_rate_configure(&fr, 10, 100);
+    TEST_ASSERT_EQUAL_UINT32(0, frame_rate_wait_us(&fr, 0));
+    TEST_ASSERT_TRUE(frame_rate_sample(&fr, ch, 0, &code));
+    TEST_ASSERT_EQUAL_UINT16(10, frame_rate_hz(code));          // Still sticks: keepalive
+    // Sampled at the upper bound, the next frame due an announced interval later
+    TEST_ASSERT_EQUAL_UINT32(SAMPLE_US, frame_rate_wait_us(&fr, 0));
+    TEST_ASSERT_FALSE(frame_rate_sample(&fr, ch, SAMPLE_US, &code));
+    frame_rate_force(&fr);
+    TEST_ASSERT_TRUE(frame_rate_sample(&fr, ch, 2 * SAMPLE_US, &code));
+    TEST_ASSERT_TRUE(frame_rate_sample(&fr, ch, 2 * SAMPLE_US + 100000 - FRAME_RATE_SLACK_US, &code));
+}
+
+static void test_still_sticks_step_down_to_keepalive(void) {
+    uint8_t code = 0;
+    uint8_t prev = 0;
+    frame_rate_configure(&fr, 10, 100);
+    for (uint32_t now = 0; now < 2000000; now += SAMPLE_US) {
+        if (frame_rate_sample(&fr, ch, now, &code)) {
+            // One table step per frame at most
+            TEST_ASSERT_TRUE(prev == 0 || code + 1 >= prev);
+            prev = code;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT16(10, frame_rate_hz(code));
+}
+
+static void test_movement_raises_rate_at_once(void) {
+    uint8_t code;
+    uint32_t now = 0;
+    frame_rate_configure(&fr, 10, 100);
+    for (; now < 1000000; now += SAMPLE_US) {
+        frame_rate_sample(&fr, ch, now, &code);
+    }
+    TEST_ASSERT_EQUAL_UINT16(10, fr.stats.hz);
+    // 200 units in one sample interval: far more than 16 units per frame at 100 Hz
+    set_sticks(CENTER + 200);
+    TEST_ASSERT_TRUE(frame_rate_sample(&fr, ch, now, &code));
+    TEST_ASSERT_EQUAL_UINT16(100, frame_rate_hz(code));
+}
+
+static void test_noise_is_ignored(void) {
+    uint8_t code;
+    frame_rate_configure(&fr, 10, 100);
+    for (uint32_t now = 0; now < 2000000; now += SAMPLE_US) {
+        set_sticks((uint16_t)(CENTER + (now / SAMPLE_US % 2) * FRAME_RATE_NOISE));
+        frame_rate_sample(&fr, ch, now, &code);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, fr.stats.velocity);
+    TEST_ASSERT_EQUAL_UINT16(10, fr.stats.hz);
+}
+
+static void test_congestion_halves_ceiling_and_clean_windows_restore(void) {
+    frame_rate_configure(&fr, 10, 100);
+    uint32_t now = 0;
+    frame_rate_tx_done(&fr, 10, 5, now);
+    now += FRAME_RATE_WINDOW_US;
+    frame_rate_tx_done(&fr, 0, 0, now);
+    TEST_ASSERT_EQUAL_UINT16(50, fr.stats.ceiling_hz);
+    TEST_ASSERT_EQUAL_UINT32(1, fr.stats.backoffs);
+    // Below FRAME_RATE_BACKOFF_PCT: no decision either way while anything failed
+    frame_rate_tx_done(&fr, 10, 2, now);
+    now += FRAME_RATE_WINDOW_US;
+    frame_rate_tx_done(&fr, 0, 0, now);
+    TEST_ASSERT_EQUAL_UINT16(50, fr.stats.ceiling_hz);
+    // Too few results for a decision
+    frame_rate_tx_done(&fr, FRAME_RATE_WINDOW_MIN - 1, FRAME_RATE_WINDOW_MIN - 1, now);
+    now += FRAME_RATE_WINDOW_US;
+    frame_rate_tx_done(&fr, 0, 0, now);
+    TEST_ASSERT_EQUAL_UINT16(50, fr.stats.ceiling_hz);
+    frame_rate_tx_done(&fr, 1, 1, now);
+    frame_rate_tx_done(&fr, 0, 0, now + FRAME_RATE_WINDOW_US);
+    TEST_ASSERT_EQUAL_UINT16(25, fr.stats.ceiling_hz);
+    now += FRAME_RATE_WINDOW_US;
+    // Clean windows: one step up each
+    frame_rate_tx_done(&fr, 10, 0, now);
+    now += FRAME_RATE_WINDOW_US;
+    frame_rate_tx_done(&fr, 0, 0, now);
+    TEST_ASSERT_EQUAL_UINT16(30, fr.stats.ceiling_hz);
+    // Never below the lower bound
+    for (int i = 0; i < 10; i++) {
+        frame_rate_tx_done(&fr, 10, 10, now);
+        now += FRAME_RATE_WINDOW_US;
+        frame_rate_tx_done(&fr, 0, 0, now);
+    }
+    TEST_ASSERT_EQUAL_UINT16(10, fr.stats.ceiling_hz);
+}
+
+static void test_receiver_timeout(void) {
+    TEST_ASSERT_EQUAL_UINT32(1000, frame_rate_timeout_ms(0, 1000));
+    TEST_ASSERT_EQUAL_UINT32(FRAME_RATE_TIMEOUT_MIN_MS, frame_rate_timeout_ms(frame_rate_code(300), 1000));
+    TEST_ASSERT_EQUAL_UINT32(200, frame_rate_timeout_ms(frame_rate_code(50), 1000));
+    TEST_ASSERT_EQUAL_UINT32(1000, frame_rate_timeout_ms(frame_rate_code(10), 1000));
+    TEST_ASSERT_EQUAL_UINT32(500, frame_rate_timeout_ms(frame_rate_code(10), 500));
+}
+
+static void test_trace_with_default_bounds(void) {
+    sim_t sim = {.end_us = 8000000};
+    sim_result_t res;
+    simulate(&sim, &res);
+    // Still sticks at the keepalive rate, the flick at the upper bound
+    TEST_ASSERT_INT_WITHIN(1, 15, res.frames_still);
+    TEST_ASSERT_INT_WITHIN(1, 10, res.frames_still_end);
+    TEST_ASSERT_TRUE(res.flick_frame_us - 2000000 <= SAMPLE_US + 100);
+    TEST_ASSERT_EQUAL_UINT16(100, frame_rate_hz(res.flick_code));
+    // Fewer frames than a fixed 50 Hz, and never later than a sample interval
+    TEST_ASSERT_TRUE(res.frames < 8 * 50);
+    TEST_ASSERT_TRUE(res.max_late_us <= SAMPLE_US + 100);
+    TEST_ASSERT_EQUAL_UINT32(0, fr.stats.backoffs);
+}
+
+static void test_trace_with_congestion(void) {
+    // Half the sends fail during the quick corrections (5-6 s)
+    sim_t sim = {.fail_pct = 50, .fail_from_us = 5000000, .fail_to_us = 6000000, .end_us = 8000000};
+    sim_result_t res;
+    simulate(&sim, &res);
+    TEST_ASSERT_EQUAL_UINT16(100, res.ceiling_at_us[9]);        // 4.5-5 s
+    TEST_ASSERT_TRUE(res.ceiling_at_us[11] <= 15);              // Down within 0.75 s (5.5-6 s)
+    TEST_ASSERT_TRUE(fr.stats.backoffs >= 3);
+    TEST_ASSERT_TRUE(res.ceiling_at_us[15] > res.ceiling_at_us[11]);   // Back up once clean
+}
+
+static void test_trace_with_frame_loss(void) {
+    // A fifth of the frames lost: the timeout announced by the last frame
+    // received never runs out while frames still arrive
+    sim_t sim = {.loss_pct = 20, .end_us = 8000000};
+    sim_result_t res;
+    simulate(&sim, &res);
+    TEST_ASSERT_EQUAL_INT(0, res.timeouts);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_code_table);
+    RUN_TEST(test_configure_rounds_and_swaps);
+    RUN_TEST(test_first_and_forced_samples_are_frames);
+    RUN_TEST(test_still_sticks_step_down_to_keepalive);
+    RUN_TEST(test_movement_raises_rate_at_once);
+    RUN_TEST(test_noise_is_ignored);
+    RUN_TEST(test_congestion_halves_ceiling_and_clean_windows_restore);
+    RUN_TEST(test_receiver_timeout);
+    RUN_TEST(test_trace_with_default_bounds);
+    RUN_TEST(test_trace_with_congestion);
+    RUN_TEST(test_trace_with_frame_loss);
+    return UNITY_END();
+}
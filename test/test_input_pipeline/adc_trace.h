@@ -0,0 +1,54 @@
+// Stick trace for test_input_pipeline: one channel at 50 Hz, 8 s
+// Modelled on the sender sticks: rest at raw 1890, full throw
+// to 3410 and back through 610, then rest again. ADC noise is +/-5 codes, and
+// every 37th sample carries a +/-260 code spike (Wi-Fi TX burst on the supply).
+// Synthetic (fixed seed), so the expected numbers in the tests stay exact.
+#ifndef ADC_TRACE_H
+#define ADC_TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_REST_RAW 1890
+#define TRACE_MIN_RAW 610
+#define TRACE_MAX_RAW 3410
+#define TRACE_LEN 400
+#define TRACE_SPIKE_FIRST 20
+#define TRACE_SPIKE_EVERY 37
+
+// Segments (sample index): rest, ramp up, hold max, ramp down, hold min, ramp to rest, rest
+#define TRACE_REST1_END 50
+#define TRACE_MAX_BEGIN 100
+#define TRACE_MAX_END 150
+#define TRACE_MIN_BEGIN 250
+#define TRACE_MIN_END 300
+#define TRACE_REST2_BEGIN 350
+
+static const uint16_t adc_trace[TRACE_LEN] = {
+    1888, 1895, 1888, 1891, 1894, 1893, 1885, 1887, 1892, 1885, 1895, 1894, 1893, 1887, 1895, 1891,
+    1888, 1891, 1888, 1885, 1635, 1887, 1887, 1888, 1894, 1892, 1891, 1890, 1888, 1894, 1885, 1885,
+    1889, 1893, 1893, 1886, 1893, 1885, 1895, 1885, 1892, 1894, 1895, 1893, 1890, 1890, 1895, 1891,
+    1891, 1888, 1885, 1919, 1949, 1985, 2013, 2043, 2076, 1846, 2128, 2160, 2190, 2221, 2258, 2288,
+    2311, 2341, 2377, 2405, 2437, 2472, 2494, 2531, 2559, 2585, 2621, 2645, 2681, 2713, 2745, 2768,
+    2797, 2832, 2859, 2898, 2922, 2950, 2981, 3020, 3044, 3076, 3110, 3141, 3168, 3197, 3491, 3262,
+    3289, 3314, 3344, 3377, 3414, 3405, 3413, 3406, 3414, 3412, 3405, 3414, 3407, 3414, 3405, 3405,
+    3411, 3405, 3409, 3411, 3407, 3406, 3409, 3407, 3406, 3406, 3414, 3405, 3405, 3415, 3411, 3413,
+    3405, 3409, 3412, 3670, 3405, 3406, 3406, 3408, 3412, 3408, 3409, 3408, 3407, 3414, 3413, 3411,
+    3411, 3414, 3410, 3406, 3413, 3415, 3406, 3379, 3349, 3321, 3295, 3271, 3240, 3214, 3182, 3156,
+    3129, 3102, 3075, 3048, 3016, 2995, 2964, 2932, 2641, 2874, 2845, 2820, 2792, 2762, 2735, 2713,
+    2679, 2649, 2630, 2603, 2573, 2539, 2511, 2489, 2453, 2425, 2403, 2376, 2349, 2314, 2291, 2260,
+    2234, 2203, 2176, 2145, 2125, 2089, 2065, 2037, 2011, 1980, 1959, 1929, 1900, 2134, 1842, 1813,
+    1785, 1763, 1729, 1706, 1676, 1641, 1617, 1591, 1557, 1529, 1510, 1477, 1447, 1426, 1393, 1364,
+    1336, 1314, 1281, 1257, 1227, 1202, 1165, 1146, 1114, 1084, 1060, 1029,  998,  969,  949,  914,
+     885,  857,  579,  803,  779,  755,  727,  690,  666,  634,  612,  611,  612,  615,  608,  611,
+     609,  614,  609,  606,  615,  612,  615,  606,  610,  612,  608,  609,  607,  606,  609,  613,
+     608,  615,  614,  610,  607,  612,  605,  874,  606,  612,  612,  609,  608,  612,  612,  612,
+     608,  607,  606,  609,  606,  614,  608,  614,  615,  608,  605,  606,  609,  641,  666,  685,
+     716,  740,  760,  786,  815,  844,  867,  894,  918,  946,  966,  993,  758, 1049, 1068, 1099,
+    1123, 1147, 1175, 1204, 1220, 1252, 1279, 1304, 1322, 1351, 1375, 1408, 1434, 1460, 1480, 1511,
+    1534, 1560, 1583, 1612, 1634, 1665, 1689, 1716, 1731, 1767, 1788, 1814, 1834, 1859, 1890, 1887,
+    1890, 1630, 1894, 1887, 1893, 1885, 1894, 1893, 1890, 1891, 1893, 1886, 1887, 1885, 1888, 1893,
+    1894, 1892, 1892, 1887, 1887, 1894, 1893, 1886, 1891, 1891, 1889, 1885, 1889, 1891, 1894, 1889,
+    1892, 1894, 1891, 1894, 1888, 1885, 2152, 1887, 1895, 1888, 1887, 1887, 1890, 1894, 1885, 1890,
+};
+
+#endif // ADC_TRACE_H
@@ -0,0 +1,179 @@
+// Host tests for the sender input pipeline (src/input_pipeline.c): pio test -e native
+#include <unity.h>
+#include <string.h>
+#include "input_pipeline.h"
+#include "adc_trace.h"
+
+static device_settings_t settings;
+static input_pipeline_t pipe;
+
+// Calibration matching adc_trace.h, everything else off
+static void trace_settings(void) {
+    memset(&settings, 0, sizeof(settings));
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        settings.ch_min[i] = TRACE_MIN_RAW + 5;
+        settings.ch_center[i] = TRACE_REST_RAW;
+        settings.ch_max[i] = TRACE_MAX_RAW - 5;
+        settings.ch_filter_strength[i] = 3;
+    }
+}
+
+static void replay(uint16_t *out) {
+    input_pipeline_configure(&pipe, &settings);
+    for (int i = 0; i < TRACE_LEN; i++) {
+        out[i] = input_pipeline_process_channel(&pipe, 0, adc_trace[i]);
+    }
+}
+
+static int max_deviation(const uint16_t *out, int from, int to, uint16_t center) {
+    int dev = 0;
+    for (int i = from; i < to; i++) {
+        int d = out[i] > center ? out[i] - center : center - out[i];
+        if (d > dev) dev = d;
+    }
+    return dev;
+}
+
+void setUp(void) {
+    trace_settings();
+}
+
+void tearDown(void) {
+}
+
+static void test_calibration_reaches_endpoints(void) {
+    input_pipeline_configure(&pipe, &settings);
+    TEST_ASSERT_EQUAL_UINT16(0, input_pipeline_process_channel(&pipe, 0, TRACE_MIN_RAW + 5));
+    TEST_ASSERT_EQUAL_UINT16(ADC_CENTER_VALUE, input_pipeline_process_channel(&pipe, 0, TRACE_REST_RAW));
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, input_pipeline_process_channel(&pipe, 0, TRACE_MAX_RAW - 5));
+    // Beyond the calibrated range clamps
+    TEST_ASSERT_EQUAL_UINT16(0, input_pipeline_process_channel(&pipe, 0, 0));
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, input_pipeline_process_channel(&pipe, 0, 4095));
+}
+
+static void test_unusable_calibration_falls_back_to_full_range(void) {
+    settings.ch_min[0] = 3000;
+    settings.ch_max[0] = 1000;      // Reversed
+    settings.ch_center[0] = 0;
+    input_pipeline_configure(&pipe, &settings);
+    TEST_ASSERT_EQUAL_UINT16(0, input_pipeline_process_channel(&pipe, 0, 0));
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, input_pipeline_process_channel(&pipe, 0, ADC_MAX_VALUE));
+    TEST_ASSERT_UINT_WITHIN(2, ADC_CENTER_VALUE, input_pipeline_process_channel(&pipe, 0, 2048));
+}
+
+static void test_deadband_holds_center_and_keeps_endpoints(void) {
+    settings.ch_deadband[0] = 16;
+    input_pipeline_configure(&pipe, &settings);
+    // +/-9 raw codes is about +/-14 output counts: inside the deadband
+    TEST_ASSERT_EQUAL_UINT16(ADC_CENTER_VALUE, input_pipeline_process_channel(&pipe, 0, TRACE_REST_RAW - 9));
+    TEST_ASSERT_EQUAL_UINT16(ADC_CENTER_VALUE, input_pipeline_process_channel(&pipe, 0, TRACE_REST_RAW + 9));
+    TEST_ASSERT_EQUAL_UINT16(0, input_pipeline_process_channel(&pipe, 0, TRACE_MIN_RAW + 5));
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, input_pipeline_process_channel(&pipe, 0, TRACE_MAX_RAW - 5));
+    // Just outside the deadband the output moves off center by a small step, not a jump
+    uint16_t out = input_pipeline_process_channel(&pipe, 0, TRACE_REST_RAW + 20);
+    TEST_ASSERT_GREATER_THAN(ADC_CENTER_VALUE, out);
+    TEST_ASSERT_LESS_OR_EQUAL(ADC_CENTER_VALUE + 16, out);
+}
+
+static void test_reverse_and_trim(void) {
+    settings.ch_reverse[0] = true;
+    settings.ch_trim[0] = 100;
+    settings.ch_trim[1] = 30000;    // Clamped to INPUT_TRIM_MAX
+    input_pipeline_configure(&pipe, &settings);
+    TEST_ASSERT_EQUAL_UINT16(ADC_CENTER_VALUE + 100, input_pipeline_process_channel(&pipe, 0, TRACE_REST_RAW));
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, input_pipeline_process_channel(&pipe, 0, TRACE_MIN_RAW + 5));
+    // The upper half is one count shorter (2047), so full throw mirrors to 1
+    TEST_ASSERT_EQUAL_UINT16(1 + 100, input_pipeline_process_channel(&pipe, 0, TRACE_MAX_RAW - 5));
+    TEST_ASSERT_EQUAL_UINT16(ADC_CENTER_VALUE + INPUT_TRIM_MAX,
+                             input_pipeline_process_channel(&pipe, 1, TRACE_REST_RAW));
+}
+
+static void test_lowpass_step_response(void) {
+    settings.ch_filter[0] = INPUT_FILTER_LOWPASS;
+    settings.ch_filter_strength[0] = 2;     // alpha 1/4
+    input_pipeline_configure(&pipe, &settings);
+    // The first sample primes the filter, no ramp from zero
+    TEST_ASSERT_EQUAL_UINT16(ADC_CENTER_VALUE, input_pipeline_process_channel(&pipe, 0, TRACE_REST_RAW));
+    uint16_t out = 0;
+    int n = 0;
+    while (out < ADC_MAX_VALUE - 8 && n < 100) {
+        out = input_pipeline_process_channel(&pipe, 0, TRACE_MAX_RAW - 5);
+        n++;
+    }
+    // (3/4)^n of the step left: within 8 counts of 2047 after 20 samples
+    TEST_ASSERT_INT_WITHIN(2, 20, n);
+}
+
+static void test_trace_unfiltered_passes_spikes(void) {
+    uint16_t out[TRACE_LEN];
+    replay(out);
+    // A 260-code spike at rest is about 400 output counts
+    TEST_ASSERT_GREATER_THAN(350, max_deviation(out, 0, TRACE_REST1_END, ADC_CENTER_VALUE));
+}
+
+static void test_trace_median3_with_deadband(void) {
+    settings.ch_filter[0] = INPUT_FILTER_MEDIAN3;
+    settings.ch_deadband[0] = 16;
+    uint16_t out[TRACE_LEN];
+    replay(out);
+    // Still sticks read exactly centered, spikes and noise included
+    TEST_ASSERT_EQUAL_INT(0, max_deviation(out, 1, TRACE_REST1_END, ADC_CENTER_VALUE));
+    TEST_ASSERT_EQUAL_INT(0, max_deviation(out, TRACE_REST2_BEGIN + 2, TRACE_LEN, ADC_CENTER_VALUE));
+    // Full throw reads as the endpoints
+    for (int i = TRACE_MAX_BEGIN + 2; i < TRACE_MAX_END; i++) {
+        TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, out[i]);
+    }
+    for (int i = TRACE_MIN_BEGIN + 2; i < TRACE_MIN_END; i++) {
+        TEST_ASSERT_EQUAL_UINT16(0, out[i]);
+    }
+    // Ramps stay monotonic: no spike survives the median
+    for (int i = TRACE_REST1_END + 1; i < TRACE_MAX_BEGIN; i++) {
+        TEST_ASSERT_GREATER_OR_EQUAL(out[i - 1], out[i]);
+    }
+    for (int i = TRACE_MAX_END + 1; i < TRACE_MIN_BEGIN; i++) {
+        TEST_ASSERT_LESS_OR_EQUAL(out[i - 1], out[i]);
+    }
+}
+
+static void test_trace_lowpass_attenuates_spikes(void) {
+    uint16_t raw_out[TRACE_LEN];
+    replay(raw_out);
+    settings.ch_filter[0] = INPUT_FILTER_LOWPASS;
+    uint16_t lp_out[TRACE_LEN];
+    replay(lp_out);
+    int raw_dev = max_deviation(raw_out, 0, TRACE_REST1_END, ADC_CENTER_VALUE);
+    int lp_dev = max_deviation(lp_out, 0, TRACE_REST1_END, ADC_CENTER_VALUE);
+    // Strength 3: a one-sample spike comes through at 1/8
+    TEST_ASSERT_LESS_OR_EQUAL(raw_dev / 6, lp_dev);
+}
+
+static void test_channels_are_independent(void) {
+    settings.ch_filter[1] = INPUT_FILTER_MEDIAN5;
+    input_pipeline_configure(&pipe, &settings);
+    uint16_t raw[NUM_CHANNELS];
+    uint16_t out[NUM_CHANNELS];
+    for (int n = 0; n < 5; n++) {
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            raw[i] = (i == 0) ? TRACE_MAX_RAW : TRACE_REST_RAW;
+        }
+        input_pipeline_process(&pipe, raw, out);
+    }
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, out[0]);
+    for (int i = 1; i < NUM_CHANNELS; i++) {
+        TEST_ASSERT_EQUAL_UINT16(ADC_CENTER_VALUE, out[i]);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_calibration_reaches_endpoints);
+    RUN_TEST(test_unusable_calibration_falls_back_to_full_range);
+    RUN_TEST(test_deadband_holds_center_and_keeps_endpoints);
+    RUN_TEST(test_reverse_and_trim);
+    RUN_TEST(test_lowpass_step_response);
+    RUN_TEST(test_trace_unfiltered_passes_spikes);
+    RUN_TEST(test_trace_median3_with_deadband);
+    RUN_TEST(test_trace_lowpass_attenuates_spikes);
+    RUN_TEST(test_channels_are_independent);
+    return UNITY_END();
+}
@@ -0,0 +1,230 @@
+// Host tests for the receiver mixer (src/mixer.c), saturation in particular:
+// pio test -e native (16 channels)
+#include <unity.h>
+#include <string.h>
+#include "mixer.h"
+
+static device_settings_t settings;
+static mixer_t mixer;
+
+// Same matrix in floating point: center + offset + sum(weight * input), clamped
+static uint16_t reference(const int8_t weight[NUM_CHANNELS][NUM_CHANNELS], const int8_t *offset,
+                          const uint16_t *in, int o) {
+    double acc = offset[o] * ADC_CENTER_VALUE / 100.0;
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        acc += weight[o][i] / 100.0 * ((int)in[i] - ADC_CENTER_VALUE);
+    }
+    double v = ADC_CENTER_VALUE + acc;
+    if (v < 0) return 0;
+    if (v > ADC_MAX_VALUE) return ADC_MAX_VALUE;
+    return (uint16_t)(v + 0.5);
+}
+
+static void set_all(uint16_t *in, uint16_t v) {
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        in[i] = v;
+    }
+}
+
+static void custom(int8_t w, int8_t off) {
+    settings.mix_preset = MIX_PRESET_CUSTOM;
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            settings.mix_weight[o][i] = w;
+        }
+        settings.mix_offset[o] = off;
+    }
+}
+
+void setUp(void) {
+    memset(&settings, 0, sizeof(settings));
+}
+
+void tearDown(void) {
+}
+
+static void test_identity_is_exact(void) {
+    mixer_compile(&mixer, &settings);
+    uint16_t in[NUM_CHANNELS], out[NUM_CHANNELS];
+    for (uint32_t v = 0; v <= ADC_MAX_VALUE; v += 13) {
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            in[i] = (uint16_t)((v + i * 257) % (ADC_MAX_VALUE + 1));
+        }
+        mixer_apply(&mixer, in, out);
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(in, out, NUM_CHANNELS);
+    }
+}
+
+static void test_full_deflection_125_all_channels_saturates(void) {
+    uint16_t in[NUM_CHANNELS], out[NUM_CHANNELS];
+    custom(MIX_WEIGHT_MAX, 0);
+    mixer_compile(&mixer, &settings);
+    set_all(in, ADC_MAX_VALUE);
+    mixer_apply(&mixer, in, out);
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, out[o]);
+    }
+    set_all(in, 0);
+    mixer_apply(&mixer, in, out);
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        TEST_ASSERT_EQUAL_UINT16(0, out[o]);
+    }
+}
+
+static void test_negative_125_inverts_and_saturates(void) {
+    uint16_t in[NUM_CHANNELS], out[NUM_CHANNELS];
+    custom(-MIX_WEIGHT_MAX, 0);
+    mixer_compile(&mixer, &settings);
+    set_all(in, 0);
+    mixer_apply(&mixer, in, out);
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, out[o]);
+    }
+    set_all(in, ADC_MAX_VALUE);
+    mixer_apply(&mixer, in, out);
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        TEST_ASSERT_EQUAL_UINT16(0, out[o]);
+    }
+}
+
+// Every term and the offset pull the same way: the largest accumulator the
+// matrix can produce must saturate, never wrap to the other end
+static void test_worst_case_accumulator_does_not_wrap(void) {
+    uint16_t in[NUM_CHANNELS], out[NUM_CHANNELS];
+    settings.mix_preset = MIX_PRESET_CUSTOM;
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            settings.mix_weight[o][i] = (i & 1) ? -MIX_WEIGHT_MAX : MIX_WEIGHT_MAX;
+        }
+        settings.mix_offset[o] = (o & 1) ? -MIX_WEIGHT_MAX : MIX_WEIGHT_MAX;
+    }
+    mixer_compile(&mixer, &settings);
+    // Even inputs full high, odd inputs full low: every term is positive
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        in[i] = (i & 1) ? 0 : ADC_MAX_VALUE;
+    }
+    mixer_apply(&mixer, in, out);
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, out[o]);
+    }
+    // Mirrored: every term negative
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        in[i] = (i & 1) ? ADC_MAX_VALUE : 0;
+    }
+    mixer_apply(&mixer, in, out);
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        TEST_ASSERT_EQUAL_UINT16(0, out[o]);
+    }
+}
+
+static void test_out_of_range_weights_clamp_to_125(void) {
+    uint16_t in[NUM_CHANNELS], out_clamped[NUM_CHANNELS], out_max[NUM_CHANNELS];
+    set_all(in, ADC_CENTER_VALUE);
+    in[0] = ADC_CENTER_VALUE + 1000;
+    custom(0, 0);
+    settings.mix_weight[0][0] = 127;
+    settings.mix_offset[1] = -127;
+    mixer_compile(&mixer, &settings);
+    mixer_apply(&mixer, in, out_clamped);
+    settings.mix_weight[0][0] = MIX_WEIGHT_MAX;
+    settings.mix_offset[1] = -MIX_WEIGHT_MAX;
+    mixer_compile(&mixer, &settings);
+    mixer_apply(&mixer, in, out_max);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(out_max, out_clamped, NUM_CHANNELS);
+    TEST_ASSERT_EQUAL_UINT16(ADC_CENTER_VALUE + 1250, out_max[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, out_max[1]);
+}
+
+static void test_mixed_full_deflection_cancels(void) {
+    uint16_t in[NUM_CHANNELS], out[NUM_CHANNELS];
+    custom(MIX_WEIGHT_MAX, 0);
+    mixer_compile(&mixer, &settings);
+    // Half the inputs full high, half full low: +125% and -125% of 2047/2048 cancel
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        in[i] = (i < NUM_CHANNELS / 2) ? ADC_MAX_VALUE : 0;
+    }
+    mixer_apply(&mixer, in, out);
+    for (int o = 0; o < NUM_CHANNELS; o++) {
+        TEST_ASSERT_UINT_WITHIN(NUM_CHANNELS, ADC_CENTER_VALUE, out[o]);
+    }
+}
+
+static void test_random_matrices_match_reference(void) {
+    uint32_t seed = 28;
+    uint16_t in[NUM_CHANNELS], out[NUM_CHANNELS];
+    int8_t weight[NUM_CHANNELS][NUM_CHANNELS];
+    int8_t offset[NUM_CHANNELS];
+    for (int round = 0; round < 200; round++) {
+        settings.mix_preset = MIX_PRESET_CUSTOM;
+        for (int o = 0; o < NUM_CHANNELS; o++) {
+            for (int i = 0; i < NUM_CHANNELS; i++) {
+                seed = seed * 1103515245u + 12345u;
+                // Sparse matrices, as real mixes are: a quarter of the terms set
+                int w = (int)((seed >> 16) % (2 * MIX_WEIGHT_MAX + 1)) - MIX_WEIGHT_MAX;
+                settings.mix_weight[o][i] = ((seed >> 8) & 3) ? 0 : (int8_t)w;
+            }
+            seed = seed * 1103515245u + 12345u;
+            settings.mix_offset[o] = (int8_t)((int)((seed >> 16) % 101) - 50);
+        }
+        mixer_compile(&mixer, &settings);
+        mixer_build_matrix(&settings, weight, offset);
+        for (int frame = 0; frame < 20; frame++) {
+            for (int i = 0; i < NUM_CHANNELS; i++) {
+                seed = seed * 1103515245u + 12345u;
+                // Full deflection half the time
+                uint16_t v = (uint16_t)((seed >> 16) % (ADC_MAX_VALUE + 1));
+                in[i] = ((seed >> 4) & 1) ? v : (((seed >> 5) & 1) ? ADC_MAX_VALUE : 0);
+            }
+            mixer_apply(&mixer, in, out);
+            for (int o = 0; o < NUM_CHANNELS; o++) {
+                // Q15 weights round each term by under 1/4 count
+                TEST_ASSERT_UINT_WITHIN(2, reference(weight, offset, in, o), out[o]);
+            }
+        }
+    }
+}
+
+static void test_tank_preset_saturates_one_side(void) {
+    uint16_t in[NUM_CHANNELS], out[NUM_CHANNELS];
+    settings.mix_preset = MIX_PRESET_TANK;
+    mixer_compile(&mixer, &settings);
+    set_all(in, ADC_CENTER_VALUE);
+    in[0] = ADC_MAX_VALUE;      // Full throttle
+    in[1] = ADC_MAX_VALUE;      // Full right
+    mixer_apply(&mixer, in, out);
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE, out[0]);
+    TEST_ASSERT_EQUAL_UINT16(ADC_CENTER_VALUE, out[1]);
+    for (int o = 2; o < NUM_CHANNELS; o++) {
+        TEST_ASSERT_EQUAL_UINT16(ADC_CENTER_VALUE, out[o]);
+    }
+}
+
+static void test_elevon_preset_reaches_but_does_not_exceed_range(void) {
+    uint16_t in[NUM_CHANNELS], out[NUM_CHANNELS];
+    settings.mix_preset = MIX_PRESET_ELEVON;
+    mixer_compile(&mixer, &settings);
+    set_all(in, ADC_CENTER_VALUE);
+    in[0] = 0;                  // Full pitch
+    in[1] = 0;                  // Full roll
+    mixer_apply(&mixer, in, out);
+    TEST_ASSERT_EQUAL_UINT16(0, out[0]);
+    TEST_ASSERT_EQUAL_UINT16(ADC_CENTER_VALUE, out[1]);
+    in[1] = ADC_MAX_VALUE;
+    mixer_apply(&mixer, in, out);
+    TEST_ASSERT_UINT_WITHIN(1, ADC_CENTER_VALUE, out[0]);
+    TEST_ASSERT_UINT_WITHIN(1, 0, out[1]);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_identity_is_exact);
+    RUN_TEST(test_full_deflection_125_all_channels_saturates);
+    RUN_TEST(test_negative_125_inverts_and_saturates);
+    RUN_TEST(test_worst_case_accumulator_does_not_wrap);
+    RUN_TEST(test_out_of_range_weights_clamp_to_125);
+    RUN_TEST(test_mixed_full_deflection_cancels);
+    RUN_TEST(test_random_matrices_match_reference);
+    RUN_TEST(test_tank_preset_saturates_one_side);
+    RUN_TEST(test_elevon_preset_reaches_but_does_not_exceed_range);
+    return UNITY_END();
+}
@@ -0,0 +1,196 @@
+// Host simulation of the receiver output stage (src/output_stage.c): frames
+// pushed at synthetic arrival times, ticks at the output rate.
+// pio test -e native
+#include <unity.h>
+#include <string.h>
+#include "output_stage.h"
+
+#define RATE_HZ 200
+#define TICK_US (1000000 / RATE_HZ)
+#define FRAME_US 20000                  // 50 Hz frames
+
+static device_settings_t settings;
+static output_stage_t os;
+static uint16_t frame[NUM_CHANNELS];
+static uint16_t out[NUM_CHANNELS];
+
+static void start(bool extrapolate) {
+    settings.output_rate_hz = RATE_HZ;
+    settings.output_extrapolate = extrapolate;
+    output_stage_configure(&os.cfg, &settings);
+    output_stage_reset(&os);
+}
+
+static void push(uint16_t us, uint32_t now_us, uint32_t interval_us) {
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        frame[i] = us;
+    }
+    output_stage_push_frame(&os, frame, now_us, interval_us);
+}
+
+static uint16_t tick(uint32_t now_us) {
+    TEST_ASSERT_TRUE(output_stage_tick(&os, now_us, out));
+    for (int i = 1; i < NUM_CHANNELS; i++) {
+        TEST_ASSERT_EQUAL_UINT16(out[0], out[i]);
+    }
+    return out[0];
+}
+
+void setUp(void) {
+    memset(&settings, 0, sizeof(settings));
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        settings.servo_min[i] = 1000;
+        settings.servo_center[i] = 1500;
+        settings.servo_max[i] = 2000;
+    }
+}
+
+void tearDown(void) {
+}
+
+static void test_no_output_before_first_frame(void) {
+    start(false);
+    TEST_ASSERT_FALSE(output_stage_tick(&os, 0, out));
+    push(1700, 1000, FRAME_US);
+    // The first frame is output as is, without a ramp from zero
+    TEST_ASSERT_EQUAL_UINT16(1700, tick(1000));
+}
+
+static void test_configure_clamps_rate(void) {
+    settings.output_rate_hz = 0;
+    output_stage_configure(&os.cfg, &settings);
+    TEST_ASSERT_EQUAL_UINT16(OUTPUT_RATE_MIN_HZ, os.cfg.rate_hz);
+    settings.output_rate_hz = 1000;
+    output_stage_configure(&os.cfg, &settings);
+    TEST_ASSERT_EQUAL_UINT16(OUTPUT_RATE_MAX_HZ, os.cfg.rate_hz);
+}
+
+static void test_interpolates_over_one_frame_interval(void) {
+    start(false);
+    push(1500, 0, FRAME_US);
+    push(1600, FRAME_US, FRAME_US);
+    // Four ticks per frame: the output walks 1500 -> 1600 in equal steps
+    TEST_ASSERT_EQUAL_UINT16(1500, tick(FRAME_US));
+    TEST_ASSERT_EQUAL_UINT16(1525, tick(FRAME_US + TICK_US));
+    TEST_ASSERT_EQUAL_UINT16(1550, tick(FRAME_US + 2 * TICK_US));
+    TEST_ASSERT_EQUAL_UINT16(1575, tick(FRAME_US + 3 * TICK_US));
+    TEST_ASSERT_EQUAL_UINT16(1600, tick(FRAME_US + 4 * TICK_US));
+    // Without extrapolation a late frame holds the last target
+    TEST_ASSERT_EQUAL_UINT16(1600, tick(FRAME_US + 8 * TICK_US));
+}
+
+static void test_new_frame_continues_from_current_position(void) {
+    start(false);
+    push(1500, 0, FRAME_US);
+    push(1600, FRAME_US, FRAME_US);
+    // A frame arriving halfway starts its segment at 1550, not at 1600
+    push(1400, FRAME_US + FRAME_US / 2, FRAME_US);
+    TEST_ASSERT_EQUAL_UINT16(1550, tick(FRAME_US + FRAME_US / 2));
+    TEST_ASSERT_EQUAL_UINT16(1475, tick(FRAME_US + FRAME_US));
+    TEST_ASSERT_EQUAL_UINT16(1400, tick(FRAME_US + FRAME_US / 2 + FRAME_US));
+}
+
+static void test_extrapolation_capped_at_two_intervals(void) {
+    start(true);
+    push(1500, 0, FRAME_US);
+    push(1600, FRAME_US, FRAME_US);
+    // Frame 3 is lost: the slope continues for one more interval...
+    TEST_ASSERT_EQUAL_UINT16(1650, tick(FRAME_US + FRAME_US * 3 / 2));
+    TEST_ASSERT_EQUAL_UINT16(1700, tick(FRAME_US + 2 * FRAME_US));
+    // ...then holds, however long the gap
+    TEST_ASSERT_EQUAL_UINT16(1700, tick(FRAME_US + 3 * FRAME_US));
+    TEST_ASSERT_EQUAL_UINT16(1700, tick(FRAME_US + 50 * FRAME_US));
+}
+
+static void test_extrapolation_needs_two_frames(void) {
+    start(true);
+    push(1500, 0, FRAME_US);
+    TEST_ASSERT_EQUAL_UINT16(1500, tick(3 * FRAME_US));
+}
+
+static void test_extrapolation_stays_within_servo_limits(void) {
+    start(true);
+    push(1800, 0, FRAME_US);
+    push(1950, FRAME_US, FRAME_US);
+    // The slope would reach 2100 after two intervals
+    TEST_ASSERT_EQUAL_UINT16(2000, tick(FRAME_US + 2 * FRAME_US));
+}
+
+static void test_announced_interval_applies_at_once(void) {
+    start(false);
+    push(1500, 0, 0);
+    push(1600, FRAME_US, 10000);        // Sender switched to 100 Hz
+    TEST_ASSERT_EQUAL_UINT16(1550, tick(FRAME_US + 5000));
+    TEST_ASSERT_EQUAL_UINT16(1600, tick(FRAME_US + 10000));
+}
+
+static void test_measured_interval_converges(void) {
+    start(false);
+    uint32_t t = 0;
+    for (int n = 0; n < 30; n++) {
+        push(1500, t, 0);
+        t += 10000;                     // Unannounced 100 Hz frames
+    }
+    TEST_ASSERT_UINT_WITHIN(100, 10000, os.interval_us);
+    // A long gap counts as at most OUTPUT_FRAME_US_MAX
+    push(1500, t + 5000000, 0);
+    TEST_ASSERT_LESS_OR_EQUAL(OUTPUT_FRAME_US_MAX, os.interval_us);
+}
+
+static void test_slew_limit_per_tick(void) {
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        settings.ch_slew[i] = 1000;     // µs per second: 5 µs per 200 Hz tick
+    }
+    start(false);
+    push(1000, 0, FRAME_US);
+    push(2000, FRAME_US, FRAME_US);
+    uint16_t prev = tick(FRAME_US);
+    int ticks = 0;
+    while (prev < 2000 && ticks < 1000) {
+        uint16_t v = tick(FRAME_US + (uint32_t)(ticks + 1) * TICK_US);
+        TEST_ASSERT_LESS_OR_EQUAL(5, v - prev);
+        prev = v;
+        ticks++;
+    }
+    // 1000 µs at 5 µs per tick: one second
+    TEST_ASSERT_INT_WITHIN(1, RATE_HZ, ticks);
+}
+
+static void test_slew_limit_slower_than_frames(void) {
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        settings.ch_slew[i] = 2000;     // 10 µs per tick
+    }
+    start(false);
+    push(1500, 0, FRAME_US);
+    // A 100 µs step per frame needs 25 µs per tick: the slew limit lags behind
+    uint32_t t = 0;
+    uint16_t us = 1500;
+    uint16_t v = 1500;
+    for (int n = 1; n <= 4; n++) {
+        t += FRAME_US;
+        us += 100;
+        push(us, t, FRAME_US);
+        for (int k = 0; k < FRAME_US / TICK_US; k++) {
+            uint16_t next = tick(t + (uint32_t)k * TICK_US);
+            TEST_ASSERT_LESS_OR_EQUAL(10, next - v);
+            v = next;
+        }
+    }
+    TEST_ASSERT_LESS_THAN(us, v);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_no_output_before_first_frame);
+    RUN_TEST(test_configure_clamps_rate);
+    RUN_TEST(test_interpolates_over_one_frame_interval);
+    RUN_TEST(test_new_frame_continues_from_current_position);
+    RUN_TEST(test_extrapolation_capped_at_two_intervals);
+    RUN_TEST(test_extrapolation_needs_two_frames);
+    RUN_TEST(test_extrapolation_stays_within_servo_limits);
+    RUN_TEST(test_announced_interval_applies_at_once);
+    RUN_TEST(test_measured_interval_converges);
+    RUN_TEST(test_slew_limit_per_tick);
+    RUN_TEST(test_slew_limit_slower_than_frames);
+    return UNITY_END();
+}
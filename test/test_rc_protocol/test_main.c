@@ -0,0 +1,303 @@
+// Host tests for the serial protocol encoders and parsers (src/rc_protocol.c):
+// pio test -e native
+#include <unity.h>
+#include <string.h>
+#include "rc_protocol.h"
+
+// 16 channels at RC_TICKS_CENTER (992 = 0x3E0) packed 11 bits each; the
+// pattern repeats every 8 channels (88 bits = 11 bytes)
+static const uint8_t CENTER_PACKED[22] = {
+    0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C,
+    0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C,
+};
+
+static sbus_parser_t parser;
+
+void setUp(void) {
+    sbus_parser_reset(&parser);
+}
+
+void tearDown(void) {
+}
+
+// Feeds len bytes and returns how many complete frames the parser reported
+static int feed(const uint8_t *bytes, int len) {
+    int frames = 0;
+    for (int i = 0; i < len; i++) {
+        if (sbus_parser_feed(&parser, bytes[i])) {
+            frames++;
+        }
+    }
+    return frames;
+}
+
+static void test_tick_scale_endpoints(void) {
+    TEST_ASSERT_EQUAL_UINT16(RC_TICKS_CENTER, rc_us_to_ticks(1500));
+    TEST_ASSERT_EQUAL_UINT16(988, rc_ticks_to_us(RC_TICKS_MIN));
+    TEST_ASSERT_EQUAL_UINT16(2012, rc_ticks_to_us(RC_TICKS_MAX));
+    TEST_ASSERT_EQUAL_UINT16(0, rc_us_to_ticks(500));
+    TEST_ASSERT_EQUAL_UINT16(2047, rc_us_to_ticks(3000));
+    TEST_ASSERT_EQUAL_UINT16(1500, rc_ticks_to_us(RC_TICKS_CENTER));
+}
+
+static void test_tick_scale_round_trip_within_one_us(void) {
+    for (uint16_t us = 900; us <= 2100; us++) {
+        TEST_ASSERT_UINT_WITHIN(1, us, rc_ticks_to_us(rc_us_to_ticks(us)));
+    }
+}
+
+static void test_pack_11bit_matches_reference_bytes(void) {
+    uint16_t ticks[RC_PROTO_CHANNELS];
+    uint8_t out[22];
+    for (int i = 0; i < RC_PROTO_CHANNELS; i++) {
+        ticks[i] = RC_TICKS_CENTER;
+    }
+    rc_pack_11bit(ticks, out);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(CENTER_PACKED, out, 22);
+}
+
+static void test_pack_11bit_round_trip(void) {
+    uint16_t ticks[RC_PROTO_CHANNELS], back[RC_PROTO_CHANNELS];
+    uint8_t out[22];
+    for (int seed = 0; seed < 64; seed++) {
+        for (int i = 0; i < RC_PROTO_CHANNELS; i++) {
+            ticks[i] = (uint16_t)((seed * 331 + i * 137) & 0x07FF);
+        }
+        rc_pack_11bit(ticks, out);
+        rc_unpack_11bit(out, back);
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(ticks, back, RC_PROTO_CHANNELS);
+    }
+}
+
+static void test_sbus_round_trip(void) {
+    uint16_t us[RC_PROTO_CHANNELS], back[RC_PROTO_CHANNELS];
+    uint8_t frame[SBUS_FRAME_LEN], flags = 0;
+    for (int i = 0; i < RC_PROTO_CHANNELS; i++) {
+        us[i] = (uint16_t)(988 + i * 64);
+    }
+    sbus_encode(us, RC_PROTO_CHANNELS, SBUS_FLAG_FAILSAFE, frame);
+    TEST_ASSERT_EQUAL_HEX8(SBUS_HEADER, frame[0]);
+    TEST_ASSERT_EQUAL_HEX8(SBUS_FLAG_FAILSAFE, frame[23]);
+    TEST_ASSERT_EQUAL_HEX8(SBUS_FOOTER, frame[24]);
+    TEST_ASSERT_TRUE(sbus_decode(frame, back, RC_PROTO_CHANNELS, &flags));
+    TEST_ASSERT_EQUAL_HEX8(SBUS_FLAG_FAILSAFE, flags);
+    for (int i = 0; i < RC_PROTO_CHANNELS; i++) {
+        TEST_ASSERT_UINT_WITHIN(1, us[i], back[i]);
+    }
+}
+
+static void test_sbus_missing_channels_centered(void) {
+    uint16_t us[4] = {1000, 1200, 1800, 2000};
+    uint16_t back[RC_PROTO_CHANNELS];
+    uint8_t frame[SBUS_FRAME_LEN];
+    sbus_encode(us, 4, 0, frame);
+    TEST_ASSERT_TRUE(sbus_decode(frame, back, RC_PROTO_CHANNELS, NULL));
+    for (int i = 4; i < RC_PROTO_CHANNELS; i++) {
+        TEST_ASSERT_EQUAL_UINT16(1500, back[i]);
+    }
+}
+
+static void test_sbus_decode_rejects_bad_header_and_footer(void) {
+    uint16_t us[RC_PROTO_CHANNELS] = {0};
+    uint16_t back[RC_PROTO_CHANNELS];
+    uint8_t frame[SBUS_FRAME_LEN];
+    sbus_encode(us, 0, 0, frame);
+    frame[0] = 0x0E;
+    TEST_ASSERT_FALSE(sbus_decode(frame, back, RC_PROTO_CHANNELS, NULL));
+    frame[0] = SBUS_HEADER;
+    frame[24] = 0x55;
+    TEST_ASSERT_FALSE(sbus_decode(frame, back, RC_PROTO_CHANNELS, NULL));
+    frame[24] = 0x14;                   // SBUS2 telemetry slot footer
+    TEST_ASSERT_TRUE(sbus_decode(frame, back, RC_PROTO_CHANNELS, NULL));
+}
+
+static void test_crsf_crc8_check_value(void) {
+    // CRC-8/DVB-S2 check value over "123456789"
+    TEST_ASSERT_EQUAL_HEX8(0xBC, crsf_crc8((const uint8_t *)"123456789", 9));
+    TEST_ASSERT_EQUAL_HEX8(0x00, crsf_crc8(NULL, 0));
+}
+
+static void test_crsf_rc_frame_layout(void) {
+    uint16_t us[RC_PROTO_CHANNELS];
+    uint8_t frame[CRSF_RC_FRAME_LEN];
+    for (int i = 0; i < RC_PROTO_CHANNELS; i++) {
+        us[i] = 1500;
+    }
+    crsf_encode_rc(us, RC_PROTO_CHANNELS, frame);
+    TEST_ASSERT_EQUAL_HEX8(CRSF_ADDR_FLIGHT_CONTROLLER, frame[0]);
+    TEST_ASSERT_EQUAL_UINT8(CRSF_RC_FRAME_LEN - 2, frame[1]);
+    TEST_ASSERT_EQUAL_HEX8(CRSF_FRAMETYPE_RC_CHANNELS, frame[2]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(CENTER_PACKED, &frame[3], 22);
+    TEST_ASSERT_EQUAL_HEX8(crsf_crc8(&frame[2], CRSF_RC_PAYLOAD_LEN + 1), frame[CRSF_RC_FRAME_LEN - 1]);
+    // The CRC over type, payload and CRC itself comes out zero
+    TEST_ASSERT_EQUAL_HEX8(0x00, crsf_crc8(&frame[2], CRSF_RC_PAYLOAD_LEN + 2));
+}
+
+static void test_crsf_crc_catches_single_bit_errors(void) {
+    uint16_t us[RC_PROTO_CHANNELS];
+    uint8_t frame[CRSF_RC_FRAME_LEN];
+    for (int i = 0; i < RC_PROTO_CHANNELS; i++) {
+        us[i] = (uint16_t)(1000 + i * 61);
+    }
+    crsf_encode_rc(us, RC_PROTO_CHANNELS, frame);
+    for (int byte = 2; byte < CRSF_RC_FRAME_LEN; byte++) {
+        for (int bit = 0; bit < 8; bit++) {
+            frame[byte] ^= (uint8_t)(1u << bit);
+            TEST_ASSERT_NOT_EQUAL(0, crsf_crc8(&frame[2], CRSF_RC_PAYLOAD_LEN + 2));
+            frame[byte] ^= (uint8_t)(1u << bit);
+        }
+    }
+}
+
+static void test_pack_12bit_reference_bytes(void) {
+    const uint16_t even[2] = {0x123, 0x456};
+    const uint8_t even_bytes[3] = {0x23, 0x61, 0x45};
+    const uint16_t odd[3] = {0x123, 0x456, 0xABC};
+    const uint8_t odd_bytes[5] = {0x23, 0x61, 0x45, 0xBC, 0x0A};
+    uint8_t out[5];
+    rc_pack_12bit(even, 2, out);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(even_bytes, out, 3);
+    rc_pack_12bit(odd, 3, out);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(odd_bytes, out, 5);
+}
+
+static void test_pack_12bit_round_trip_all_lengths(void) {
+    uint16_t values[RC_PROTO_CHANNELS], back[RC_PROTO_CHANNELS];
+    uint8_t out[RC_PROTO_CHANNELS * 12 / 8 + 1];
+    for (int n = 1; n <= RC_PROTO_CHANNELS; n++) {
+        for (int i = 0; i < n; i++) {
+            values[i] = (uint16_t)((n * 977 + i * 1531) & 0x0FFF);
+        }
+        // Guard byte past the (n * 12 + 7) / 8 written bytes must stay untouched
+        memset(out, 0xA5, sizeof(out));
+        rc_pack_12bit(values, n, out);
+        int len = (n * 12 + 7) / 8;
+        if (len < (int)sizeof(out)) {
+            TEST_ASSERT_EQUAL_HEX8(0xA5, out[len]);
+        }
+        rc_unpack_12bit(out, n, back);
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(values, back, n);
+    }
+}
+
+static void test_parser_back_to_back_frames(void) {
+    uint16_t us[RC_PROTO_CHANNELS] = {0};
+    uint8_t frame[SBUS_FRAME_LEN];
+    sbus_encode(us, 0, 0, frame);
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(1, feed(frame, SBUS_FRAME_LEN));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, parser.buf, SBUS_FRAME_LEN);
+    }
+}
+
+static void test_parser_skips_leading_garbage(void) {
+    const uint8_t garbage[] = {0x00, 0xFF, 0x55, 0x10, 0x00};
+    uint16_t us[RC_PROTO_CHANNELS] = {0};
+    uint8_t frame[SBUS_FRAME_LEN];
+    sbus_encode(us, 0, 0, frame);
+    TEST_ASSERT_EQUAL_INT(0, feed(garbage, sizeof(garbage)));
+    TEST_ASSERT_EQUAL_INT(1, feed(frame, SBUS_FRAME_LEN));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, parser.buf, SBUS_FRAME_LEN);
+}
+
+static void test_parser_resyncs_after_truncated_frame(void) {
+    // A frame cut short (byte loss on the UART) followed by whole frames: the
+    // parser must drop the fragment and lock onto the next header
+    uint16_t us[RC_PROTO_CHANNELS];
+    uint8_t frame[SBUS_FRAME_LEN];
+    for (int i = 0; i < RC_PROTO_CHANNELS; i++) {
+        us[i] = (uint16_t)(1100 + i * 50);
+    }
+    sbus_encode(us, RC_PROTO_CHANNELS, 0, frame);
+    TEST_ASSERT_EQUAL_INT(0, feed(frame, 12));
+    int frames = feed(frame, SBUS_FRAME_LEN) + feed(frame, SBUS_FRAME_LEN);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, frames);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, parser.buf, SBUS_FRAME_LEN);
+    // Locked again: every following frame is reported
+    TEST_ASSERT_EQUAL_INT(1, feed(frame, SBUS_FRAME_LEN));
+    TEST_ASSERT_EQUAL_INT(1, feed(frame, SBUS_FRAME_LEN));
+}
+
+static void test_parser_resyncs_on_header_byte_inside_payload(void) {
+    // Channel data containing 0x0F bytes: starting on one of them gives a bad
+    // footer, and the parser must walk forward to the real header. CH1 and CH9
+    // start on byte boundaries, so a value of 15 puts 0x0F in the payload.
+    uint16_t ticks[RC_PROTO_CHANNELS];
+    uint8_t frame[SBUS_FRAME_LEN];
+    for (int i = 0; i < RC_PROTO_CHANNELS; i++) {
+        ticks[i] = (i % 8 == 0) ? 15 : RC_TICKS_CENTER;
+    }
+    frame[0] = SBUS_HEADER;
+    rc_pack_11bit(ticks, &frame[1]);
+    frame[23] = 0;
+    frame[24] = SBUS_FOOTER;
+    int headers_inside = 0;
+    for (int i = 1; i < 23; i++) {
+        headers_inside += frame[i] == SBUS_HEADER;
+    }
+    TEST_ASSERT_GREATER_THAN(0, headers_inside);
+
+    // Join the stream mid-frame, right at an inner 0x0F
+    int start = 1;
+    while (frame[start] != SBUS_HEADER) {
+        start++;
+    }
+    TEST_ASSERT_EQUAL_INT(0, feed(&frame[start], SBUS_FRAME_LEN - start));
+    int frames = 0;
+    for (int i = 0; i < 4; i++) {
+        frames += feed(frame, SBUS_FRAME_LEN);
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(3, frames);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, parser.buf, SBUS_FRAME_LEN);
+}
+
+static void test_ppm_encode_pads_frame(void) {
+    uint16_t us[8] = {1000, 1100, 1200, 1300, 1400, 1500, 1600, 1700};
+    uint16_t d[2 * (8 + 1)];
+    int n = ppm_encode(us, 8, PPM_FRAME_US_DEFAULT, d);
+    TEST_ASSERT_EQUAL_INT(2 * (8 + 1), n);
+    uint32_t total = 0;
+    for (int i = 0; i < n; i++) {
+        total += d[i];
+    }
+    TEST_ASSERT_EQUAL_UINT32(PPM_FRAME_US_DEFAULT, total);
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL_UINT16(PPM_PULSE_US, d[2 * i]);
+        TEST_ASSERT_EQUAL_UINT16(us[i], d[2 * i] + d[2 * i + 1]);
+    }
+}
+
+static void test_ppm_decode_limits(void) {
+    uint16_t widths[PPM_MAX_CHANNELS + 1], us[PPM_MAX_CHANNELS];
+    for (int i = 0; i <= PPM_MAX_CHANNELS; i++) {
+        widths[i] = 1500;
+    }
+    TEST_ASSERT_EQUAL_INT(0, ppm_decode(widths, PPM_MIN_CHANNELS - 1, us, PPM_MAX_CHANNELS));
+    TEST_ASSERT_EQUAL_INT(8, ppm_decode(widths, 8, us, PPM_MAX_CHANNELS));
+    TEST_ASSERT_EQUAL_INT(0, ppm_decode(widths, PPM_MAX_CHANNELS + 1, us, PPM_MAX_CHANNELS));
+    widths[3] = PPM_CH_US_MAX + 1;
+    TEST_ASSERT_EQUAL_INT(0, ppm_decode(widths, 8, us, PPM_MAX_CHANNELS));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_tick_scale_endpoints);
+    RUN_TEST(test_tick_scale_round_trip_within_one_us);
+    RUN_TEST(test_pack_11bit_matches_reference_bytes);
+    RUN_TEST(test_pack_11bit_round_trip);
+    RUN_TEST(test_sbus_round_trip);
+    RUN_TEST(test_sbus_missing_channels_centered);
+    RUN_TEST(test_sbus_decode_rejects_bad_header_and_footer);
+    RUN_TEST(test_crsf_crc8_check_value);
+    RUN_TEST(test_crsf_rc_frame_layout);
+    RUN_TEST(test_crsf_crc_catches_single_bit_errors);
+    RUN_TEST(test_pack_12bit_reference_bytes);
+    RUN_TEST(test_pack_12bit_round_trip_all_lengths);
+    RUN_TEST(test_parser_back_to_back_frames);
+    RUN_TEST(test_parser_skips_leading_garbage);
+    RUN_TEST(test_parser_resyncs_after_truncated_frame);
+    RUN_TEST(test_parser_resyncs_on_header_byte_inside_payload);
+    RUN_TEST(test_ppm_encode_pads_frame);
+    RUN_TEST(test_ppm_decode_limits);
+    return UNITY_END();
+}
@@ -0,0 +1,181 @@
+// Host tests for the sender transmit pipeline (src/tx_pipeline.c), including
+// the per-frame power lock accounting sender.c builds on it:
+// pio test -e native
+#include <unity.h>
+#include <string.h>
+#include "tx_pipeline.h"
+
+static tx_pipeline_t tx;
+static int held;                        // POWER_LOCK_TX count, as sender.c keeps it
+static uint32_t rng;
+
+static uint32_t next_rand(void) {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+// The sender's calls, with its lock handling
+static void send(tx_frame_kind_t kind, uint32_t now_us) {
+    held++;
+    tx_pipeline_send(&tx, kind, now_us);
+    held -= tx_pipeline_take_dropped(&tx);
+}
+
+static void refuse(tx_frame_kind_t kind, bool no_mem) {
+    if (tx_pipeline_failed(&tx, kind, no_mem)) {
+        held--;
+    }
+}
+
+static bool callback(uint32_t now_us) {
+    uint32_t lat;
+    bool matched = tx_pipeline_done(&tx, now_us, &lat);
+    tx_pipeline_ready(&tx, now_us);
+    held -= (matched ? 1 : 0) + tx_pipeline_take_dropped(&tx);
+    return matched;
+}
+
+static bool ready(uint32_t now_us) {
+    bool go = tx_pipeline_ready(&tx, now_us);
+    held -= tx_pipeline_take_dropped(&tx);
+    return go;
+}
+
+void setUp(void) {
+    tx_pipeline_init(&tx);
+    held = 0;
+    rng = 11;
+}
+
+void tearDown(void) {
+}
+
+static void test_one_control_frame_in_flight(void) {
+    TEST_ASSERT_TRUE(tx_pipeline_offer(&tx, 0));
+    send(TX_FRAME_CONTROL, 0);
+    TEST_ASSERT_FALSE(tx_pipeline_offer(&tx, 1000));
+    TEST_ASSERT_FALSE(tx_pipeline_offer(&tx, 2000));
+    TEST_ASSERT_EQUAL_UINT32(1, tx.stats.superseded);
+    TEST_ASSERT_EQUAL_UINT32(2, tx.stats.deferred);
+    TEST_ASSERT_TRUE(callback(2500));
+    TEST_ASSERT_TRUE(ready(2500));
+    send(TX_FRAME_CONTROL, 2600);
+    TEST_ASSERT_FALSE(ready(2600));
+    TEST_ASSERT_EQUAL_UINT32(2500, tx.stats.lat_last_us);
+    TEST_ASSERT_EQUAL_INT(1, held);
+}
+
+static void test_event_frames_not_held_back(void) {
+    TEST_ASSERT_TRUE(tx_pipeline_offer(&tx, 0));
+    send(TX_FRAME_CONTROL, 0);
+    send(TX_FRAME_EVENT, 100);
+    send(TX_FRAME_EVENT, 200);
+    TEST_ASSERT_EQUAL_UINT8(3, tx.count);
+    TEST_ASSERT_EQUAL_UINT8(1, tx.control);
+    TEST_ASSERT_EQUAL_UINT32(1, tx.stats.depth[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, tx.stats.depth[2]);
+    TEST_ASSERT_EQUAL_INT(3, held);
+}
+
+static void test_no_mem_keeps_control_frame_pending(void) {
+    TEST_ASSERT_TRUE(tx_pipeline_offer(&tx, 0));
+    send(TX_FRAME_CONTROL, 0);
+    refuse(TX_FRAME_CONTROL, true);
+    TEST_ASSERT_EQUAL_UINT8(0, tx.count);
+    TEST_ASSERT_TRUE(tx.pending);
+    TEST_ASSERT_TRUE(ready(100));
+    send(TX_FRAME_CONTROL, 100);
+    refuse(TX_FRAME_CONTROL, false);
+    TEST_ASSERT_FALSE(tx.pending);
+    TEST_ASSERT_EQUAL_UINT32(1, tx.stats.no_mem);
+    TEST_ASSERT_EQUAL_UINT32(1, tx.stats.errors);
+    TEST_ASSERT_EQUAL_INT(0, held);
+}
+
+static void test_stale_frame_is_written_off_once(void) {
+    TEST_ASSERT_TRUE(tx_pipeline_offer(&tx, 0));
+    send(TX_FRAME_CONTROL, 0);
+    TEST_ASSERT_FALSE(tx_pipeline_offer(&tx, TX_PIPELINE_STALE_US));
+    TEST_ASSERT_EQUAL_UINT8(0, tx_pipeline_take_dropped(&tx));
+    // Past the limit the next check writes it off and reports it
+    TEST_ASSERT_TRUE(tx_pipeline_ready(&tx, TX_PIPELINE_STALE_US + 1));
+    TEST_ASSERT_EQUAL_UINT32(1, tx.stats.lost);
+    TEST_ASSERT_EQUAL_UINT8(1, tx_pipeline_take_dropped(&tx));
+    TEST_ASSERT_EQUAL_UINT8(0, tx_pipeline_take_dropped(&tx));
+    held--;
+    // Its callback after all: nothing to complete, nothing to release
+    TEST_ASSERT_FALSE(callback(TX_PIPELINE_STALE_US + 5000));
+    TEST_ASSERT_EQUAL_INT(0, held);
+    TEST_ASSERT_EQUAL_UINT32(0, tx.stats.completed);
+}
+
+static void test_late_callback_completes_newer_frame(void) {
+    TEST_ASSERT_TRUE(tx_pipeline_offer(&tx, 0));
+    send(TX_FRAME_CONTROL, 0);
+    TEST_ASSERT_TRUE(tx_pipeline_offer(&tx, TX_PIPELINE_STALE_US + 1));  // First one written off
+    held -= tx_pipeline_take_dropped(&tx);
+    send(TX_FRAME_CONTROL, TX_PIPELINE_STALE_US + 1);
+    TEST_ASSERT_EQUAL_INT(1, held);
+    // The late callback of the first frame takes the second record ...
+    TEST_ASSERT_TRUE(callback(TX_PIPELINE_STALE_US + 2000));
+    // ... and the second frame's own callback finds none
+    TEST_ASSERT_FALSE(callback(TX_PIPELINE_STALE_US + 3000));
+    TEST_ASSERT_EQUAL_INT(0, held);
+}
+
+static void test_full_pipeline_pushes_out_oldest(void) {
+    for (int i = 0; i < TX_PIPELINE_SLOTS + 2; i++) {
+        send(TX_FRAME_EVENT, (uint32_t)i * 10);
+    }
+    TEST_ASSERT_EQUAL_UINT8(TX_PIPELINE_SLOTS, tx.count);
+    TEST_ASSERT_EQUAL_UINT32(2, tx.stats.lost);
+    TEST_ASSERT_EQUAL_INT(TX_PIPELINE_SLOTS, held);
+    TEST_ASSERT_EQUAL_UINT32(TX_PIPELINE_SLOTS, tx.stats.depth_max);
+}
+
+static void test_locks_balance_under_random_traffic(void) {
+    // Frames go out, callbacks arrive late, out of step or never; every lock
+    // taken is released exactly once, and only while its record exists
+    uint32_t now = 0;
+    int callbacks_due = 0;
+    for (int step = 0; step < 200000; step++) {
+        now += next_rand() % 3000;
+        uint32_t r = next_rand() % 100;
+        if (r < 30) {
+            if (tx_pipeline_offer(&tx, now)) {
+                send(TX_FRAME_CONTROL, now);
+                if (next_rand() % 100 < 5) {
+                    refuse(TX_FRAME_CONTROL, next_rand() % 2);
+                } else if (next_rand() % 100 < 90) {
+                    callbacks_due++;            // Otherwise its callback never comes
+                }
+            }
+        } else if (r < 40) {
+            send(TX_FRAME_EVENT, now);
+            callbacks_due++;
+        } else if (r < 80 && callbacks_due > 0) {
+            callback(now);
+            callbacks_due--;
+        } else if (r < 85) {
+            callback(now);                      // A callback for a frame written off long ago
+        } else if (ready(now)) {
+            send(TX_FRAME_CONTROL, now);
+            callbacks_due++;
+        }
+        TEST_ASSERT_EQUAL_INT(tx.count, held);
+    }
+    TEST_ASSERT_TRUE(tx.stats.lost > 0);
+    TEST_ASSERT_TRUE(tx.stats.completed > 0);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_one_control_frame_in_flight);
+    RUN_TEST(test_event_frames_not_held_back);
+    RUN_TEST(test_no_mem_keeps_control_frame_pending);
+    RUN_TEST(test_stale_frame_is_written_off_once);
+    RUN_TEST(test_late_callback_completes_newer_frame);
+    RUN_TEST(test_full_pipeline_pushes_out_oldest);
+    RUN_TEST(test_locks_balance_under_random_traffic);
+    return UNITY_END();
+}
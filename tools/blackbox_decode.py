@@ -0,0 +1,263 @@
+#!/usr/bin/env python3
+"""Decode or replay the receiver flight recorder of ESP-NOW radio control.
+
+Input is one of:
+  - the binary dump from GET /api/blackbox,
+  - a serial log with the output of the "blackbox" console command (hex lines
+    between "BLACKBOX BEGIN" and "BLACKBOX END"; the last dump is used),
+  - a raw image of the partition, for a receiver that no longer boots:
+    esptool.py read_flash 0x3a0000 0x60000 blackbox.img
+
+    curl -o blackbox.bin http://192.168.4.1/api/blackbox
+    python3 tools/blackbox_decode.py blackbox.bin                 # sessions summary
+    python3 tools/blackbox_decode.py blackbox.bin -o flight.csv   # every frame and event
+    python3 tools/blackbox_decode.py blackbox.bin --replay --session -1 --speed 2
+
+The CSV has one row per frame (channels in packet units 0..4095, lights, RSSI)
+and per event (start, stop, failsafe, dropped samples, sender frame rate).
+Replay plays a session back in the terminal at the recorded pace.
+"""
+import argparse
+import csv
+import re
+import struct
+import sys
+import time
+
+DUMP_MAGIC = b"RCBX"
+SECTOR_MAGIC = b"RCBB"
+DUMP_HEADER = struct.Struct("<4sBBHHHI")
+SECTOR_HEADER = struct.Struct("<4sBBHII")
+VERSION = 1
+
+# Must match bb_rec_t and bb_event_t in src/blackbox_codec.h
+REC_KEY, REC_TIME, REC_EVENT, REC_DELTA, REC_END = 0x01, 0x02, 0x03, 0x10, 0xFF
+DELTA_LIGHTS, DELTA_RSSI = 0x01, 0x02
+EV_START, EV_STOP, EV_FAILSAFE, EV_DROPPED, EV_RATE = range(1, 6)
+EVENT_NAMES = {EV_START: "start", EV_STOP: "stop", EV_FAILSAFE: "failsafe", EV_DROPPED: "dropped", EV_RATE: "rate"}
+# esp_reset_reason_t, for the start event
+RESET_REASONS = {0: "unknown", 1: "power-on", 2: "external", 3: "software", 4: "panic", 5: "interrupt watchdog",
+                 6: "task watchdog", 7: "watchdog", 8: "deep sleep", 9: "brownout", 10: "SDIO"}
+
+
+def load(path):
+    """Return (num_ch or None, list of sector byte strings)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data.startswith(DUMP_MAGIC) and not data.startswith(SECTOR_MAGIC) and b"BLACKBOX BEGIN" in data:
+        text = data.decode("utf-8", errors="replace")
+        blocks = re.findall(r"BLACKBOX BEGIN\r?\n(.*?)BLACKBOX END", text, re.S)
+        hex_lines = [line.strip() for line in blocks[-1].splitlines()]
+        data = bytes.fromhex("".join(line for line in hex_lines if re.fullmatch(r"[0-9a-fA-F]+", line)))
+    if data.startswith(DUMP_MAGIC):
+        magic, version, num_ch, sector_size, count, _, _ = DUMP_HEADER.unpack_from(data, 0)
+        if version != VERSION:
+            sys.exit("unsupported dump version %d" % version)
+        body = data[DUMP_HEADER.size:]
+        sectors = [body[i:i + sector_size] for i in range(0, len(body) - sector_size + 1, sector_size)]
+        if len(sectors) < count:
+            print("note: %d of %d sectors in the dump (reused while dumping)" % (len(sectors), count), file=sys.stderr)
+        return num_ch, sectors
+    # Raw partition image: every valid sector, in sequence order
+    if len(data) % 4096:
+        sys.exit("%s: not a blackbox dump, serial log or partition image" % path)
+    sectors = [data[i:i + 4096] for i in range(0, len(data), 4096)]
+    sectors = [s for s in sectors if s.startswith(SECTOR_MAGIC)]
+    sectors.sort(key=lambda s: SECTOR_HEADER.unpack_from(s, 0)[4])
+    return None, sectors
+
+
+def varint(buf, pos):
+    value = shift = 0
+    while True:
+        if pos >= len(buf):
+            raise IndexError
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if b < 0x80:
+            return value, pos
+        shift += 7
+
+
+def unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def decode_sector(sector, rows):
+    """Append the sector's frames and events to rows. Returns the header fields."""
+    magic, version, num_ch, _, seq, session = SECTOR_HEADER.unpack_from(sector, 0)
+    if magic != SECTOR_MAGIC or version != VERSION:
+        return None
+    pos = SECTOR_HEADER.size
+    t = None
+    ch = [0] * num_ch
+    lights = rssi = 0
+    try:
+        while pos < len(sector):
+            tag = sector[pos]
+            pos += 1
+            if tag == REC_END:
+                break
+            if tag in (REC_KEY, REC_TIME):
+                (t,) = struct.unpack_from("<I", sector, pos)
+                pos += 4
+                if tag == REC_KEY:
+                    ch = list(struct.unpack_from("<%dH" % num_ch, sector, pos))
+                    pos += 2 * num_ch
+                    lights, rssi = sector[pos], struct.unpack_from("<b", sector, pos + 1)[0]
+                    pos += 2
+                    rows.append({"session": session, "t_ms": t, "type": "frame", "ch": list(ch),
+                                 "lights": lights, "rssi": rssi})
+            elif tag == REC_EVENT:
+                dt, pos = varint(sector, pos)
+                t = (t + dt) & 0xFFFFFFFF
+                event = sector[pos]
+                arg, pos = varint(sector, pos + 1)
+                rows.append({"session": session, "t_ms": t, "type": EVENT_NAMES.get(event, "event %d" % event),
+                             "arg": arg})
+            elif tag & 0xF0 == REC_DELTA and t is not None:
+                dt, pos = varint(sector, pos)
+                t = (t + dt) & 0xFFFFFFFF
+                mask, pos = varint(sector, pos)
+                for i in range(num_ch):
+                    if mask & (1 << i):
+                        d, pos = varint(sector, pos)
+                        ch[i] = (ch[i] + unzigzag(d)) & 0xFFFF
+                if tag & DELTA_LIGHTS:
+                    lights = sector[pos]
+                    pos += 1
+                if tag & DELTA_RSSI:
+                    rssi = struct.unpack_from("<b", sector, pos)[0]
+                    pos += 1
+                rows.append({"session": session, "t_ms": t, "type": "frame", "ch": list(ch),
+                             "lights": lights, "rssi": rssi})
+            else:
+                print("warning: sector %d: bad record 0x%02x at %d, rest skipped" % (seq, tag, pos - 1),
+                      file=sys.stderr)
+                break
+    except (IndexError, TypeError, struct.error):
+        print("warning: sector %d: record cut off at the end" % seq, file=sys.stderr)
+    return num_ch, seq, session
+
+
+def decode(sectors):
+    rows = []
+    num_ch = 0
+    prev_seq = None
+    for sector in sectors:
+        info = decode_sector(sector, rows)
+        if info is None:
+            continue
+        num_ch, seq, _ = info
+        if prev_seq is not None and seq != prev_seq + 1:
+            print("note: sectors %d..%d were overwritten or erased" % (prev_seq + 1, seq - 1), file=sys.stderr)
+        prev_seq = seq
+    return num_ch, rows
+
+
+def sessions(rows):
+    out = {}
+    for row in rows:
+        out.setdefault(row["session"], []).append(row)
+    return [out[k] for k in sorted(out)]
+
+
+def summary(rows):
+    for i, sess in enumerate(sessions(rows)):
+        frames = [r for r in sess if r["type"] == "frame"]
+        t0, t1 = sess[0]["t_ms"], sess[-1]["t_ms"]
+        dur = max((t1 - t0) & 0xFFFFFFFF, 1) / 1000.0
+        print("session %d: %.1f s from %.1f s after boot, %d frames (%.1f Hz)" %
+              (i, dur, t0 / 1000.0, len(frames), len(frames) / dur))
+        if frames:
+            rssi = [f["rssi"] for f in frames]
+            print("  RSSI %d..%d dBm, mean %.1f" % (min(rssi), max(rssi), sum(rssi) / len(rssi)))
+        rates = []
+        for r in sess:
+            if r["type"] == "start":
+                print("  %9.3f s  start (reset: %s)" % ((r["t_ms"] - t0) / 1000.0, RESET_REASONS.get(r["arg"], r["arg"])))
+            elif r["type"] == "failsafe":
+                print("  %9.3f s  %s" % ((r["t_ms"] - t0) / 1000.0, "link lost" if r["arg"] else "link restored"))
+            elif r["type"] == "rate":
+                rates.append(r["arg"])
+            elif r["type"] != "frame":
+                print("  %9.3f s  %s %d" % ((r["t_ms"] - t0) / 1000.0, r["type"], r["arg"]))
+        if rates:
+            print("  frame rate %d..%d Hz, %d changes" % (min(rates), max(rates), len(rates)))
+
+
+def write_csv(rows, num_ch, path):
+    out = open(path, "w", newline="") if path != "-" else sys.stdout
+    w = csv.writer(out)
+    w.writerow(["session", "t_ms", "type"] + ["ch%d" % (i + 1) for i in range(num_ch)] + ["lights", "rssi", "arg"])
+    for r in rows:
+        if r["type"] == "frame":
+            w.writerow([r["session"], r["t_ms"], "frame"] + r["ch"] + [r["lights"], r["rssi"], ""])
+        else:
+            w.writerow([r["session"], r["t_ms"], r["type"]] + [""] * num_ch + ["", "", r["arg"]])
+    if out is not sys.stdout:
+        out.close()
+
+
+def replay(rows, num_ch, speed):
+    """Play frames back at the recorded pace: one bar per channel, redrawn in place."""
+    t_first = rows[0]["t_ms"]
+    start = time.monotonic()
+    print("\n" * (num_ch + 1), end="")
+    rate = 0
+    for r in rows:
+        due = start + ((r["t_ms"] - t_first) & 0xFFFFFFFF) / 1000.0 / speed
+        delay = due - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        stamp = "%8.3f s" % (((r["t_ms"] - t_first) & 0xFFFFFFFF) / 1000.0)
+        if r["type"] == "rate":
+            rate = r["arg"]     # Shown with the frames, too frequent to scroll
+            continue
+        if r["type"] != "frame":
+            # Events scroll above the channel display
+            if r["type"] == "failsafe":
+                text = "link lost" if r["arg"] else "link restored"
+            else:
+                text = "%s %d" % (r["type"], r["arg"])
+            print("\x1b[%dF\x1b[J%s  %s\n" % (num_ch + 1, stamp, text) + "\n" * (num_ch + 1), end="", flush=True)
+            continue
+        lines = ["%s  RSSI %4d dBm  lights %s  %s" % (stamp, r["rssi"], format(r["lights"] & 0xF, "04b")[::-1],
+                                                   "%3d Hz" % rate if rate else "")]
+        for i, v in enumerate(r["ch"]):
+            n = v * 40 // 4095
+            lines.append("ch%-2d %4d |%s%s|" % (i + 1, v, "#" * n, " " * (40 - n)))
+        print("\x1b[%dF" % (num_ch + 1) + "".join("\x1b[2K%s\n" % line for line in lines), end="", flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="dump from /api/blackbox, serial log with a 'blackbox' dump or partition image")
+    parser.add_argument("-o", "--output", help="write frames and events as CSV ('-' for stdout)")
+    parser.add_argument("--replay", action="store_true", help="play a session back in the terminal")
+    parser.add_argument("--session", type=int, default=-1, help="session to replay (index, -1 = newest)")
+    parser.add_argument("--speed", type=float, default=1.0, help="replay speed factor")
+    args = parser.parse_args()
+
+    dump_ch, sectors = load(args.input)
+    num_ch, rows = decode(sectors)
+    num_ch = dump_ch or num_ch
+    if not rows:
+        sys.exit("no records in %s" % args.input)
+    print("%d sectors, %d records" % (len(sectors), len(rows)), file=sys.stderr)
+
+    if args.output:
+        write_csv(rows, num_ch, args.output)
+    elif args.replay:
+        sess = sessions(rows)
+        try:
+            replay(sess[args.session], num_ch, args.speed)
+        except KeyboardInterrupt:
+            print()
+    else:
+        summary(rows)
+
+
+if __name__ == "__main__":
+    main()
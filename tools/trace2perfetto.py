@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Convert an ESP-NOW radio control event trace to Chrome/Perfetto trace JSON.
+
+Input is either the binary dump from GET /api/trace or a serial log that
+contains the output of the "trace" console command (hex lines between
+"TRACE BEGIN" and "TRACE END"; the last dump in the log is used).
+
+    curl -o trace.bin http://192.168.4.1/api/trace
+    python3 tools/trace2perfetto.py trace.bin -o trace.json
+
+Open the result in https://ui.perfetto.dev or chrome://tracing.
+"""
+import argparse
+import json
+import re
+import struct
+import sys
+
+MAGIC = b"RCTR"
+HEADER = struct.Struct("<4sBBHII")
+RECORD = struct.Struct("<IBBH")
+
+# Must match trace_event_t in src/trace.h
+(EV_TX, EV_TX_DONE, EV_RX, EV_DECODE, EV_OUTPUT_APPLIED, EV_FAILSAFE, EV_BUTTON,
+ EV_EVENT_TX, EV_EVENT_ACK, EV_EVENT_RX, EV_RATE) = range(1, 12)
+OUTPUT_NAMES = {0: "direct", 1: "timer"}
+BUTTON_NAMES = {0: "user", 1: "light1", 2: "light2", 3: "light3", 4: "light4"}
+BUTTON_EVENTS = {0: "press", 1: "short", 2: "long", 3: "double"}
+SEND_STATUS = {0: "ok", 1: "fail"}
+
+PID = 1
+TID_RADIO, TID_PIPELINE, TID_LINK, TID_BUTTONS = 1, 2, 3, 4
+THREAD_NAMES = {TID_RADIO: "radio", TID_PIPELINE: "frame pipeline", TID_LINK: "link", TID_BUTTONS: "buttons"}
+
+
+def load_dump(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data.startswith(MAGIC):
+        return data
+    # Serial log: take the last hex block between the markers
+    text = data.decode("utf-8", errors="replace")
+    blocks = re.findall(r"TRACE BEGIN\r?\n(.*?)TRACE END", text, re.S)
+    if not blocks:
+        sys.exit("%s: neither a binary trace nor a log with TRACE BEGIN/END" % path)
+    hex_lines = [line.strip() for line in blocks[-1].splitlines()]
+    return bytes.fromhex("".join(line for line in hex_lines if re.fullmatch(r"[0-9a-fA-F]+", line)))
+
+
+def parse(data):
+    magic, version, record_size, count, dropped, now_us = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != 1 or record_size != RECORD.size:
+        sys.exit("unsupported trace format (magic %r, version %d, record size %d)" % (magic, version, record_size))
+    records = []
+    offset = HEADER.size
+    for _ in range(count):
+        if offset + RECORD.size > len(data):
+            print("warning: dump truncated after %d records" % len(records), file=sys.stderr)
+            break
+        records.append(RECORD.unpack_from(data, offset))
+        offset += RECORD.size
+    return records, dropped, now_us
+
+
+def unwrap(records):
+    """Turn 32-bit µs timestamps into a monotonic timeline starting at 0."""
+    out = []
+    prev = None
+    offset = 0
+    for ts, ev, arg8, arg16 in records:
+        if prev is not None and ts < prev and prev - ts > 1 << 31:
+            offset += 1 << 32
+        prev = ts
+        out.append((ts + offset, ev, arg8, arg16))
+    out.sort(key=lambda r: r[0])
+    if out:
+        t0 = out[0][0]
+        out = [(ts - t0, ev, a8, a16) for ts, ev, a8, a16 in out]
+    return out
+
+
+def convert(records):
+    events = [{"ph": "M", "pid": PID, "name": "process_name", "args": {"name": "esp-radio-control"}}]
+    for tid, name in THREAD_NAMES.items():
+        events.append({"ph": "M", "pid": PID, "tid": tid, "name": "thread_name", "args": {"name": name}})
+
+    def instant(ts, tid, name, args=None, scope="t"):
+        events.append({"ph": "i", "s": scope, "pid": PID, "tid": tid, "ts": ts, "name": name, "args": args or {}})
+
+    def span(start, end, tid, name, args=None):
+        events.append({"ph": "X", "pid": PID, "tid": tid, "ts": start, "dur": max(end - start, 0),
+                       "name": name, "args": args or {}})
+
+    pending_tx = []         # (start, name, args) of sends waiting for their send callback
+    rx_time = {}            # frame sequence -> receive time
+    event_time = {}         # event seq -> first send time
+    for ts, ev, arg8, arg16 in records:
+        if ev == EV_TX:
+            if arg8:
+                instant(ts, TID_RADIO, "tx failed", {"lights": arg16})
+            else:
+                pending_tx.append((ts, "tx", {"lights": arg16}))
+        elif ev == EV_EVENT_TX:
+            event_time.setdefault(arg16, ts)
+            pending_tx.append((ts, "event tx", {"seq": arg16, "send": arg8}))
+        elif ev == EV_TX_DONE:
+            status = SEND_STATUS.get(arg8, str(arg8))
+            if pending_tx:
+                start, name, tx_args = pending_tx.pop(0)
+                span(start, ts, TID_RADIO, name, dict(tx_args, status=status))
+            else:
+                instant(ts, TID_RADIO, "tx_done", {"status": status})
+        elif ev == EV_EVENT_ACK:
+            if arg16 in event_time:
+                span(event_time.pop(arg16), ts, TID_LINK, "event to ack", {"seq": arg16})
+            else:
+                instant(ts, TID_LINK, "event ack", {"seq": arg16})
+        elif ev == EV_EVENT_RX:
+            instant(ts, TID_RADIO, "event rx", {"seq": arg16})
+        elif ev == EV_RX:
+            rssi = arg8 - 256 if arg8 > 127 else arg8
+            rx_time[arg16] = ts
+            instant(ts, TID_RADIO, "rx", {"seq": arg16, "rssi": rssi})
+            events.append({"ph": "C", "pid": PID, "ts": ts, "name": "rssi", "args": {"dBm": rssi}})
+        elif ev == EV_DECODE:
+            if arg16 in rx_time:
+                span(rx_time[arg16], ts, TID_PIPELINE, "rx to decode", {"seq": arg16})
+            else:
+                instant(ts, TID_PIPELINE, "decode", {"seq": arg16})
+        elif ev == EV_OUTPUT_APPLIED:
+            mode = OUTPUT_NAMES.get(arg8, str(arg8))
+            if arg16 in rx_time:
+                span(rx_time.pop(arg16), ts, TID_PIPELINE, "rx to output", {"seq": arg16, "mode": mode})
+            else:
+                instant(ts, TID_PIPELINE, "output", {"seq": arg16, "mode": mode})
+        elif ev == EV_FAILSAFE:
+            instant(ts, TID_LINK, "link lost" if arg8 else "link restored", scope="g")
+        elif ev == EV_RATE:
+            events.append({"ph": "C", "pid": PID, "ts": ts, "name": "frame rate", "args": {"Hz": arg16}})
+        elif ev == EV_BUTTON:
+            instant(ts, TID_BUTTONS, "%s %s" % (BUTTON_NAMES.get(arg8, str(arg8)), BUTTON_EVENTS.get(arg16, str(arg16))))
+        else:
+            instant(ts, TID_RADIO, "event %d" % ev, {"arg8": arg8, "arg16": arg16})
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="binary dump from /api/trace or a serial log with a 'trace' dump")
+    parser.add_argument("-o", "--output", help="output JSON file (default: stdout)")
+    args = parser.parse_args()
+
+    records, dropped, _ = parse(load_dump(args.input))
+    events = convert(unwrap(records))
+    print("%d records, %d overwritten before the dump" % (len(records), dropped), file=sys.stderr)
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, out)
+    if args.output:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()